@@ -36,53 +36,55 @@ sockaddr_in4_t remoteSocket;
 
 void TCP_Demo_Client(void)
 {
-    // create the socket for the TCP Client
-    static tcpTCB_t port65534TCB;
+    // socket of the TCP Client, taken from the pool of the stack
+    static tcpHandle_t port65534Socket = TCP_INVALID_SOCKET;
     
     // create the TX and RX Client's buffers
     static uint8_t rxdataPort65534[RX_BUFFER_SIZE];
     static uint8_t txdataPort65534[TX_BUFFER_SIZE];
     static time_t t_client;
     static time_t socketTimeout;    
+    tcpTCB_t *port65534TCB;
     uint16_t rx_len;
     socketState_t socketState;
     rx_len = 0;    
     
     
-    socketState = TCP_SocketPoll(&port65534TCB);
+    port65534TCB = TCP_SocketPtr(port65534Socket);
+    socketState = TCP_SocketPoll(port65534TCB);
 
     time(&t_client);
 
     switch(socketState)
     {
         case NOT_A_SOCKET:
-           // Inserting and Initializing the socket
-           TCP_SocketInit(&port65534TCB); 
+           // Allocating and Initializing the socket
+           port65534Socket = TCP_SocketAlloc(); 
            
             break;
         case SOCKET_CLOSED:
             // if the socket is closed we will try to connect again
             // try to connect once at 2 seconds
             socketTimeout = t_client + 2;
-            TCP_InsertRxBuffer(&port65534TCB, rxdataPort65534, sizeof(rxdataPort65534));
+            TCP_InsertRxBuffer(port65534TCB, rxdataPort65534, sizeof(rxdataPort65534));
             
             //Connect to the Server
-            TCP_Connect(&port65534TCB, &remoteSocket);
+            TCP_Connect(port65534TCB, &remoteSocket);
           
             break;
         case SOCKET_IN_PROGRESS:
             // if the socket is closed we will try to connect again
             if(t_client >= socketTimeout)
             {
-                TCP_Close(&port65534TCB);
+                TCP_Close(port65534TCB);
             }
             break;
         case SOCKET_CONNECTED:
             // implement an echo client over TCP
             // check if the previous buffer was sent
-            if (TCP_SendDone(&port65534TCB))
+            if (TCP_SendDone(port65534TCB))
             {
-                rx_len = TCP_GetReceivedData(&port65534TCB);
+                rx_len = TCP_GetReceivedData(port65534TCB);
                 // handle the incoming data
                 if(rx_len > 0)
                 {
@@ -93,7 +95,7 @@ void TCP_Demo_Client(void)
                         rxdataPort65534[rx_len] = 0;
                     }
                     // reuse the RX buffer
-                    TCP_InsertRxBuffer(&port65534TCB, rxdataPort65534, sizeof(rxdataPort65534));
+                    TCP_InsertRxBuffer(port65534TCB, rxdataPort65534, sizeof(rxdataPort65534));
                 }
 
                 if(t_client >= socketTimeout)
@@ -101,12 +103,14 @@ void TCP_Demo_Client(void)
                     // send board status message only once at 2 seconds
                     socketTimeout = t_client + 2;                    
                     //send data back to the source
-                    TCP_Send(&port65534TCB, txdataPort65534, strlen(txdataPort65534));
+                    TCP_Send(port65534TCB, txdataPort65534, strlen(txdataPort65534));
                 }
             }
             break;
         case SOCKET_CLOSING:
-            TCP_SocketRemove(&port65534TCB);
+            // give the socket back to the pool
+            TCP_SocketFree(port65534Socket);
+            port65534Socket = TCP_INVALID_SOCKET;
             break;
         default:
             break;
@@ -42,6 +42,7 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
+#include <ctype.h>
 #include "dns_client.h"
 #include "udpv4.h"
 
@@ -167,10 +168,42 @@ void DNS_Query(const char *str)
 
 }
 
+/**
+ * Compare a DNS name in the received frame with a dotted host name
+ * The name is read in place from the RX buffer, DNS names are not case sensitive
+ * @param offset  frame offset of the first label length byte
+ * @param name    host name, e.g. "www.example.com"
+ * @return true if they are equal
+ */
+static bool DNS_NameMatch(uint16_t offset, const char *name)
+{
+    uint8_t labelLength;
+
+    labelLength = UDP_Peek8(offset++);
+    while(labelLength)
+    {
+        while(labelLength--)
+        {
+            // a host name shorter than the label must not be read past its end
+            if((*name == '\0') || (tolower((uint8_t)*name++) != tolower(UDP_Peek8(offset++))))
+            {
+                return false;
+            }
+        }
+        labelLength = UDP_Peek8(offset++);
+        if(labelLength && (*name++ != '.'))
+        {
+            return false;
+        }
+    }
+    return (*name == '\0');
+}
+
 void DNS_Handler(int16_t length)    // jira:M8TS-608
 {
     uint16_t  v;
-    unsigned char dnsR[255];
+    ethRxView_t nameView;
+    bool nameFound = false;
     uint16_t answer, authorityRR;
     uint32_t ipAddress;
     uint32_t ttl;
@@ -196,17 +229,14 @@ void DNS_Handler(int16_t length)    // jira:M8TS-608
 
            if(length > 0)
             {
+                // the name is compared in place, remember where it starts
+                UDP_GetRxView(&nameView);
+                nameFound = true;
                 while((nameLen=UDP_Read8())!= 0x00)
                 {
-                    while(nameLen--)
-                    {
-                        dnsR[lock] = UDP_Read8();
-                        lock++;
-                    }
-                    dnsR[lock] = '.';
-                    lock++;
+                    UDP_Skip(nameLen);
+                    lock += nameLen + 1;
                 }
-                dnsR[lock-1] ='\0';
 
                 UDP_Read32();
                length -= lock + 5;
@@ -249,7 +279,7 @@ void DNS_Handler(int16_t length)    // jira:M8TS-608
         }
         for(i = 0; i < ARRAYSIZE(dnsCache);i++)
         {
-            if(strcmp(entryPointer->dnsName, (char *)dnsR) == 0)   // jira:M8TS-608
+            if(nameFound && entryPointer->dnsName && DNS_NameMatch(nameView.offset, entryPointer->dnsName))   // jira:M8TS-608
             {
                 // the entry_pointer is now pointing to the oldest entry
                 // replace the entry with the received data
@@ -40,6 +40,7 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 #include <stdint.h>
 #include <stdio.h>
 #include <stddef.h>
+#include <string.h>
 #include "network.h"
 #include "ipv4.h"
 #include "icmp.h"
@@ -66,7 +67,13 @@ uint32_t remoteIpv4Address;
  *  Callback to TCP protocol to deliver the TCP packets
  */
 extern void TCP_Recv(uint32_t, uint16_t);
-static uint8_t getHeaderLen(void);   //jira: CAE_MCU8-5737
+#ifdef ENABLE_NETWORK_STATS
+static networkPath_t IPV4_StatsPath(uint8_t protocol);
+static uint16_t ipv4Drops[IPV4_DROP_COUNT];
+#define IPV4_CountDrop(reason)  ipv4Drops[reason]++
+#else
+#define IPV4_CountDrop(reason)
+#endif
 
 void IPV4_Init(void)
 {
@@ -105,128 +112,192 @@ uint16_t IPV4_PseudoHeaderChecksum(uint16_t payloadLen)
     return cksm;
 }
 
-//jira: CAE_MCU8-5737
-static uint8_t getHeaderLen(void)
+/**
+ * Check if a destination address is this host, a broadcast or a joined multicast group
+ * @param dstAddress
+ * @return
+ */
+static bool IPV4_IsForUs(uint32_t dstAddress)
 {
-    uint16_t rxptr;
-    uint8_t  header_len = 0;
-    rxptr = ETH_GetReadPtr();
-    header_len = ETH_Read8() & 0x0fu;
-    ETH_SetRxByteCount(ETH_GetRxByteCount()+1);
-    ETH_SetReadPtr(rxptr);
-    return (uint8_t)(header_len<<2) ;
-    
+    // jira:M8TS-608
+    return (dstAddress == ipdb_getAddress()) || (dstAddress == IPV4_ZERO_ADDRESS) ||
+           (dstAddress == SPECIAL_IPV4_BROADCAST_ADDRESS) ||
+           ((ipdb_getAddress()|CLASS_A_IPV4_REVERSE_BROADCAST_MASK) == dstAddress) ||                  // jira: MCU8CC-6949
+           ((ipdb_getAddress()|CLASS_B_IPV4_REVERSE_BROADCAST_MASK) == dstAddress) ||
+           ((ipdb_getAddress()|CLASS_C_IPV4_REVERSE_BROADCAST_MASK) == dstAddress) ||
+           Network_IsMulticastMember(dstAddress);
 }
+
 error_msg IPV4_Packet(void)
 {
     uint16_t cksm = 0;
     uint16_t length = 0;
+    uint16_t hdrStart, rdptr;
+    ethRxView_t view;
     char msg[40];
     uint8_t hdrLen;
 
-    //calculate the IPv4 checksum
-    hdrLen = getHeaderLen();                                 //jira: CAE_MCU8-5737
-    cksm = ETH_RxComputeChecksum(hdrLen, 0);
-    if (cksm != 0)
-    {
-        return IPV4_CHECKSUM_FAILS;
-    }
-    
+    // Read the fixed header and reject what we will not consume before any checksum pass
+    hdrStart = ETH_GetReadPtr();
     ETH_ReadBlock((char *)&ipv4Header, sizeof(ipv4Header_t));
     if(ipv4Header.version != 4)
     {
+        IPV4_CountDrop(IPV4_DROP_VERSION);
         return IP_WRONG_VERSION; // Incorrect version number
     }
 
+    hdrLen = (uint8_t)(ipv4Header.ihl << 2);                   //jira: CAE_MCU8-5737
+    ipv4Header.length = ntohs(ipv4Header.length);
+    if((ipv4Header.ihl < 5) || (ipv4Header.length < hdrLen))
+    {
+        IPV4_CountDrop(IPV4_DROP_HEADER_LENGTH);
+        return INCORRECT_IPV4_HLEN;
+    }
+
     ipv4Header.dstIpAddress = ntohl(ipv4Header.dstIpAddress);
     ipv4Header.srcIpAddress = ntohl(ipv4Header.srcIpAddress);
 
     if(ipv4Header.srcIpAddress == SPECIAL_IPV4_BROADCAST_ADDRESS)
+    {
+        IPV4_CountDrop(IPV4_DROP_SOURCE);
         return DEST_IP_NOT_MATCHED;
+    }
 
-    // jira:M8TS-608
-    if(ipv4Header.dstIpAddress == ipdb_getAddress() || (ipv4Header.dstIpAddress == IPV4_ZERO_ADDRESS)||
-        (ipv4Header.dstIpAddress == SPECIAL_IPV4_BROADCAST_ADDRESS)
-            ||((ipdb_getAddress()|CLASS_A_IPV4_REVERSE_BROADCAST_MASK)== ipv4Header.dstIpAddress)                  // jira: MCU8CC-6949
-                ||((ipdb_getAddress()|CLASS_B_IPV4_REVERSE_BROADCAST_MASK)== ipv4Header.dstIpAddress)
-                    ||((ipdb_getAddress()|CLASS_C_IPV4_REVERSE_BROADCAST_MASK)== ipv4Header.dstIpAddress)
-            || (ipv4Header.dstIpAddress == ALL_HOST_MULTICAST_ADDRESS))
+    if(!IPV4_IsForUs(ipv4Header.dstIpAddress))
     {
-        ipv4Header.length = ntohs(ipv4Header.length);
-
-        hdrLen = (uint8_t)(ipv4Header.ihl << 2);
+        IPV4_CountDrop(IPV4_DROP_NOT_FOR_US);
+        return DEST_IP_NOT_MATCHED;
+    }
 
-        if(ipv4Header.ihl < 5)
-            return INCORRECT_IPV4_HLEN;
+    length = ipv4Header.length - hdrLen;
 
-        if (ipv4Header.ihl > 5)                                      //jira: CAE_MCU8-5737
-        {
-            //Do not process the IPv4 Options field
-            ETH_Dump((uint16_t)(hdrLen - sizeof(ipv4Header_t)));
-        }
-        
-        switch((ipProtocolNumbers)ipv4Header.protocol)
-        {
-            case ICMP_TCPIP:
-                {
-                    // calculate and check the ICMP checksum
-                    logMsg("IPv4 RX ICMP", LOG_INFO, LOG_DEST_CONSOLE);
-                    if(ipv4Header.dstIpAddress == IPV4_ZERO_ADDRESS)     // jira:M8TS-608
-                    {
-                        return DEST_IP_NOT_MATCHED;
-                    }
-                    length = ipv4Header.length - hdrLen;
-                    cksm = ETH_RxComputeChecksum(length, 0);
-
-                    if (cksm == 0)
-                    {
-                        ICMP_Receive(&ipv4Header);
-                    }
-                    else
-                    {
-                        sprintf(msg, "icmp wrong cksm : %x",cksm);
-                        logMsg(msg, LOG_INFO, LOG_DEST_CONSOLE);
-                        return ICMP_CHECKSUM_FAILS;
-                    }
-                }
-                break;
-            case UDP_TCPIP:
-                // check the UDP header checksum                
-                logMsg("IPv4 RX UDP", LOG_INFO, LOG_DEST_CONSOLE);
-                length = ipv4Header.length - hdrLen;
-                cksm = IPV4_PseudoHeaderChecksum(length);//Calculate pseudo header checksum
-                cksm = ETH_RxComputeChecksum(length, cksm); //1's complement of pseudo header checksum + 1's complement of UDP header, data
-                UDP_Receive(cksm);
-                break;
-            case TCP_TCPIP:
-                // accept only uni cast TCP packets
-                // check the TCP header checksum
-                logMsg("IPv4 RX TCP", LOG_INFO, LOG_DEST_CONSOLE);
-                length = ipv4Header.length - hdrLen;
-                cksm = IPV4_PseudoHeaderChecksum(length);
-                cksm = ETH_RxComputeChecksum(length, cksm);
-
-                // accept only packets with valid CRC Header
-                if (cksm == 0 && (ipv4Header.dstIpAddress != SPECIAL_IPV4_BROADCAST_ADDRESS) && (ipv4Header.dstIpAddress != IPV4_ZERO_ADDRESS))                
+    // protocol and port filters
+    switch((ipProtocolNumbers)ipv4Header.protocol)
+    {
+        case ICMP_TCPIP:
+            if(ipv4Header.dstIpAddress == IPV4_ZERO_ADDRESS)     // jira:M8TS-608
+            {
+                IPV4_CountDrop(IPV4_DROP_NOT_FOR_US);
+                return DEST_IP_NOT_MATCHED;
+            }
+            break;
+        case UDP_TCPIP:
+            // broadcasts and multicasts to a closed port are dropped silently,
+            // unicasts still get the port unreachable from UDP_Receive
+            if(ipv4Header.dstIpAddress != ipdb_getAddress())
+            {
+                ETH_GetRxView(&view);
+                if(!UDP_IsPortOpen(ETH_Peek16(view.offset + (hdrLen - sizeof(ipv4Header_t)) + offsetof(udpHeader_t, dstPort))))
                 {
-                    remoteIpv4Address = ipv4Header.srcIpAddress;
-                    TCP_Recv(remoteIpv4Address, length);
-                }else{
-                    logMsg("IPv4 RX bad TCP chksm",LOG_DEBUG,LOG_DEST_CONSOLE);
+                    IPV4_CountDrop(IPV4_DROP_NO_LISTENER);
+                    return PORT_NOT_AVAILABLE;
                 }
-                break;
-            default:
-                ETH_Dump(ipv4Header.length);
-                break;
-        }
-        return SUCCESS;
+            }
+            break;
+        case TCP_TCPIP:
+            // accept only uni cast TCP packets
+            if((ipv4Header.dstIpAddress == SPECIAL_IPV4_BROADCAST_ADDRESS) || (ipv4Header.dstIpAddress == IPV4_ZERO_ADDRESS) ||
+               ((ipv4Header.dstIpAddress & 0xF0000000) == 0xE0000000))
+            {
+                IPV4_CountDrop(IPV4_DROP_NOT_FOR_US);
+                return DEST_IP_NOT_MATCHED;
+            }
+            break;
+        default:
+            IPV4_CountDrop(IPV4_DROP_PROTOCOL);
+            ETH_Dump(ipv4Header.length);
+            return SUCCESS;
     }
-    else
+
+    // calculate the IPv4 header checksum
+    rdptr = ETH_GetReadPtr();
+    ETH_SetReadPtr(hdrStart);
+    cksm = ETH_RxComputeChecksum(hdrLen, 0);
+    ETH_SetReadPtr(rdptr);
+    if (cksm != 0)
     {
-        return DEST_IP_NOT_MATCHED;
+        IPV4_CountDrop(IPV4_DROP_HEADER_CHECKSUM);
+        return IPV4_CHECKSUM_FAILS;
+    }
+
+    if (ipv4Header.ihl > 5)                                      //jira: CAE_MCU8-5737
+    {
+        //Do not process the IPv4 Options field
+        ETH_Dump((uint16_t)(hdrLen - sizeof(ipv4Header_t)));
+    }
+
+    Network_CountRx(IPV4_StatsPath(ipv4Header.protocol), sizeof(ethernetFrame_t) + ipv4Header.length);
+
+    switch((ipProtocolNumbers)ipv4Header.protocol)
+    {
+        case ICMP_TCPIP:
+            // calculate and check the ICMP checksum
+            logMsg("IPv4 RX ICMP", LOG_INFO, LOG_DEST_CONSOLE);
+            cksm = ETH_RxComputeChecksum(length, 0);
+
+            if (cksm == 0)
+            {
+                ICMP_Receive(&ipv4Header);
+            }
+            else
+            {
+                sprintf(msg, "icmp wrong cksm : %x",cksm);
+                logMsg(msg, LOG_INFO, LOG_DEST_CONSOLE);
+                IPV4_CountDrop(IPV4_DROP_PAYLOAD_CHECKSUM);
+                return ICMP_CHECKSUM_FAILS;
+            }
+            break;
+        case UDP_TCPIP:
+            // check the UDP header checksum                
+            logMsg("IPv4 RX UDP", LOG_INFO, LOG_DEST_CONSOLE);
+            cksm = IPV4_PseudoHeaderChecksum(length);//Calculate pseudo header checksum
+            cksm = ETH_RxComputeChecksum(length, cksm); //1's complement of pseudo header checksum + 1's complement of UDP header, data
+            switch(UDP_Receive(cksm))
+            {
+                case UDP_CHECKSUM_FAILS:
+                    IPV4_CountDrop(IPV4_DROP_PAYLOAD_CHECKSUM);
+                    break;
+                case PORT_NOT_AVAILABLE:
+                    IPV4_CountDrop(IPV4_DROP_NO_LISTENER);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case TCP_TCPIP:
+            // check the TCP header checksum
+            logMsg("IPv4 RX TCP", LOG_INFO, LOG_DEST_CONSOLE);
+            cksm = IPV4_PseudoHeaderChecksum(length);
+            cksm = ETH_RxComputeChecksum(length, cksm);
+
+            // accept only packets with valid CRC Header
+            if (cksm == 0)
+            {
+                remoteIpv4Address = ipv4Header.srcIpAddress;
+                TCP_Recv(remoteIpv4Address, length);
+            }else{
+                logMsg("IPv4 RX bad TCP chksm",LOG_DEBUG,LOG_DEST_CONSOLE);
+                IPV4_CountDrop(IPV4_DROP_PAYLOAD_CHECKSUM);
+            }
+            break;
+        default:
+            break;
     }
+    return SUCCESS;
 }
 
+#ifdef ENABLE_NETWORK_STATS
+const uint16_t *IPV4_GetDropCounters(void)
+{
+    return ipv4Drops;
+}
+
+void IPV4_ResetDropCounters(void)
+{
+    memset(ipv4Drops, 0, sizeof(ipv4Drops));
+}
+#endif
+
 error_msg IPv4_Start(uint32_t destAddress, ipProtocolNumbers protocol)
 {
     error_msg ret = ERROR;
@@ -278,6 +349,9 @@ error_msg IPv4_Start(uint32_t destAddress, ipProtocolNumbers protocol)
             ipv4Header.srcIpAddress = ipdb_getAddress();
             ipv4Header.dstIpAddress = destAddress;
             ipv4Header.protocol = protocol;
+
+            // the upper layer checksum runs over the bytes written from here on
+            ETH_TxChecksumReset();
         }
     }
     return ret;
@@ -287,18 +361,32 @@ error_msg IPV4_Send(uint16_t payloadLength)
 {
     uint16_t totalLength;
     uint16_t cksm;
+    uint32_t sum;
     error_msg ret;
 
     totalLength = 20 + payloadLength;
+
+    // The header written by IPv4_Start is known, compute its checksum without reading it back
+    sum = 0x4500u + totalLength + 0xAA55u + 0x4000u + ((uint16_t)IPv4_TTL << 8) + ipv4Header.protocol;
+    sum += (uint16_t)(ipv4Header.srcIpAddress >> 16) + (uint16_t)ipv4Header.srcIpAddress;
+    sum += (uint16_t)(ipv4Header.dstIpAddress >> 16) + (uint16_t)ipv4Header.dstIpAddress;
+    sum = (sum & 0x0FFFF) + (sum>>16);
+    sum = (sum & 0x0FFFF) + (sum>>16);
+    cksm = (uint16_t)~sum;
+    cksm = htons(cksm);
+
     totalLength = ntohs(totalLength);
 
     //Insert IPv4 Total Length
     ETH_Insert((char *)&totalLength, 2, sizeof(ethernetFrame_t) + offsetof(ipv4Header_t, length));
 
-    cksm = ETH_TxComputeChecksum(sizeof(ethernetFrame_t),sizeof(ipv4Header_t),0);
     //Insert Ipv4 Header Checksum
     ETH_Insert((char *)&cksm, 2, sizeof(ethernetFrame_t) + offsetof(ipv4Header_t,headerCksm));
     ret = ETH_Send();
+    if(ret == SUCCESS || ret == TX_QUEUED)
+    {
+        Network_CountTx(IPV4_StatsPath(ipv4Header.protocol), sizeof(ethernetFrame_t) + 20 + payloadLength);
+    }
 
     return ret;
 }
@@ -307,3 +395,20 @@ uint16_t IPV4_GetDatagramLength(void)
 {
     return ((ipv4Header.length) - sizeof(ipv4Header_t));
 }
+
+#ifdef ENABLE_NETWORK_STATS
+static networkPath_t IPV4_StatsPath(uint8_t protocol)
+{
+    switch((ipProtocolNumbers)protocol)
+    {
+        case ICMP_TCPIP:
+            return NET_PATH_ICMP;
+        case UDP_TCPIP:
+            return NET_PATH_UDP;
+        case TCP_TCPIP:
+            return NET_PATH_TCP;
+        default:
+            return NET_PATH_OTHER;
+    }
+}
+#endif
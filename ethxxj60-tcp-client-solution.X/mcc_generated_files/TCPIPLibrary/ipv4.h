@@ -46,6 +46,7 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 */
 #include <stdbool.h>
 #include "tcpip_types.h"
+#include "tcpip_config.h"
 #include "physical_layer_interface.h"
 
 
@@ -57,6 +58,20 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
   Section: Data Types Definitions
 */
 
+// Reasons for dropping a received IPv4 datagram, index of IPV4_GetDropCounters()
+typedef enum
+{
+    IPV4_DROP_VERSION = 0,          // not IPv4
+    IPV4_DROP_HEADER_LENGTH,        // header or total length invalid
+    IPV4_DROP_SOURCE,               // broadcast source address
+    IPV4_DROP_NOT_FOR_US,           // destination is not this host, or not allowed for the protocol
+    IPV4_DROP_PROTOCOL,             // protocol not supported
+    IPV4_DROP_NO_LISTENER,          // UDP port not open
+    IPV4_DROP_HEADER_CHECKSUM,      // IPv4 header checksum failed
+    IPV4_DROP_PAYLOAD_CHECKSUM,     // ICMP, UDP or TCP checksum failed
+    IPV4_DROP_COUNT
+} ipv4DropReason_t;
+
 /**
   Section: DHCP Client Functions
  */
@@ -121,4 +136,19 @@ error_msg IPV4_Send(uint16_t payloadLength);
  */
 
 uint16_t IPV4_GetDatagramLength(void);
+
+#ifdef ENABLE_NETWORK_STATS
+/**Get the receive drop counters.
+ * The datagrams are filtered on address, protocol and UDP port before any
+ * checksum is computed; the counters tell at which step they were dropped.
+ *
+ * @return
+ *      Table of IPV4_DROP_COUNT counters indexed by ipv4DropReason_t
+ */
+const uint16_t *IPV4_GetDropCounters(void);
+
+/**Clear the receive drop counters.
+ */
+void IPV4_ResetDropCounters(void);
+#endif
 #endif
@@ -902,6 +902,7 @@ void LLDP_Packet(void)
 void txFrame(void)
 {
     error_msg ret;
+    uint16_t length;
     mac48Address_t destMac;
     uint8_t i,orVal;
     orVal = 0;
@@ -918,7 +919,12 @@ void txFrame(void)
    if(ret==SUCCESS)
    {
         constrInfoLLDPDU();
+        length = ETH_GetByteCount() - 1; // less the transmit control byte
         ret=ETH_Send();
+        if(ret == SUCCESS || ret == TX_QUEUED)
+        {
+            Network_CountTx(NET_PATH_LLDP, length);
+        }
    }
 
 }
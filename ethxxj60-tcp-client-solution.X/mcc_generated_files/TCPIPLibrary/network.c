@@ -53,6 +53,7 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 #include "ipv4.h"
 #include "tcpv4.h"
 #include "rtcc.h"
+#include "timer_wheel.h"
 #include "physical_layer_interface.h"
 #include "log.h"
 #include "lldp.h"
@@ -64,9 +65,18 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 #define logMsg(msg, msgSeverity, msgLogDest)
 #endif
 
-time_t arpTimer;
+static netTimer_t lldpTimer;
 static void Network_SaveStartPosition(void);
+static void Network_ReadFrame(void);
 uint16_t networkStartPosition;
+#ifdef ENABLE_NETWORK_STATS
+static networkPathStats_t networkStats[NET_PATH_COUNT];
+static networkRxStats_t networkRxStats;
+#endif
+static uint32_t multicastGroups[NETWORK_MULTICAST_GROUPS];
+
+static void Network_UpdateRxFilter(void);
+static void Network_MulticastMac(uint32_t group, mac48Address_t *mac);
 
 const char *network_errors[] = { "ERROR","SUCCESS","LINK_NOT_FOUND","BUFFER_BUSY",
                              "TX_LOGIC_NOT_IDLE","MAC_NOT_FOUND",
@@ -79,20 +89,41 @@ const char *network_errors[] = { "ERROR","SUCCESS","LINK_NOT_FOUND","BUFFER_BUSY
 void Network_Init(void)
 {
     ETH_Init();
+#ifdef ENABLE_NETWORK_STATS
+    Network_ResetStats();
+#endif
+    memset(multicastGroups, 0, sizeof(multicastGroups));
+    Network_UpdateRxFilter();
+    rtcc_init();
+    timersInit();   // before the protocols start their timers
     ARPV4_Init();
     IPV4_Init();
     DHCP_init();
     TCP_Init();
-    rtcc_init();
     Network_WaitForLink();
-    timersInit();
     LOG_Init();
 }
 
+/** Timer wheel handler for the LLDP transmit timers, runs every second.
+ *
+ * @param context
+ *      not used
+ *
+ * @return
+ *      None
+ */
+static void Network_LldpTimer(void *context)
+{
+    LLDP_DecTTR();
+    setLLDPTick();
+    TIMER_Start(&lldpTimer, RTCC_TICKS_PER_SECOND);
+}
+
 void timersInit()
 {
-    time(&arpTimer);
-    arpTimer += 10;  
+    TIMER_WheelInit();
+    TIMER_Setup(&lldpTimer, Network_LldpTimer, NULL);
+    TIMER_Start(&lldpTimer, RTCC_TICKS_PER_SECOND);
 }
 
 void Network_WaitForLink(void)
@@ -102,74 +133,206 @@ void Network_WaitForLink(void)
 
 void Network_Manage(void)
 {
-    time_t now;
-    static time_t nowPv = 0;
-
     ETH_EventHandler();
     Network_Read(); // handle any packets that have arrived...
-    DHCP_Manage(); // update the DHCP status every second
 
-    // manage any outstanding timeouts
-    time(&now);
-    if(now >= arpTimer)
+    // run the expired ARP, DHCP, LLDP and TCP timers
+    TIMER_Service();
+    TCP_Update();
+}
+
+void Network_Read(void)
+{
+    uint8_t frames = 0;
+
+    // drain the frames waiting in the RX buffer, bounded so the other tasks still run
+    while(ETH_packetReady() && (frames < NETWORK_RX_BUDGET))
     {
-        ARPV4_Update();
-        arpTimer = now + 10;
-    }    
-    if(now > nowPv) // at least 1 second has elapsed
+        Network_ReadFrame();
+        frames++;
+        ETH_CheckRxPending(); // latch the next frame without waiting for the event handler
+    }
+
+#ifdef ENABLE_NETWORK_STATS
+    if(frames)
     {
-        // is defined as a minimum of 1 seconds in RFC973
-        TCP_Update();  // handle timeouts
-        LLDP_DecTTR();
-        setLLDPTick();
+        networkRxStats.readCalls++;
+        networkRxStats.frames += frames;
+        networkRxStats.framesLastCall = frames;
+        if(frames > networkRxStats.framesPerCallMax)
+        {
+            networkRxStats.framesPerCallMax = frames;
+        }
+        if(ETH_packetReady())
+        {
+            networkRxStats.budgetExhausted++;
+        }
     }
-    nowPv = now;
+#endif
 }
 
-void Network_Read(void)
+static void Network_ReadFrame(void)
 {
     ethernetFrame_t header;
     char debug_str[80];
+    uint16_t frameLength;
 
-    if(ETH_packetReady())
+    ETH_NextPacketUpdate();
+    frameLength = ETH_GetRxByteCount();
+    ETH_ReadBlock((char *)&header, sizeof(header));
+    header.id.type = ntohs(header.id.type); // reverse the type field
+    Network_SaveStartPosition();
+    switch (header.id.type)
     {
-        ETH_NextPacketUpdate();
-        ETH_ReadBlock((char *)&header, sizeof(header));
-        header.id.type = ntohs(header.id.type); // reverse the type field
-        Network_SaveStartPosition();
-        switch (header.id.type)
-        {
-            case ETHERTYPE_VLAN:
-                logMsg("VLAN Packet Dropped", LOG_INFO, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
-                break;
-            case ETHERTYPE_ARP:
-                logMsg("RX ARPV4 Packet", LOG_INFO, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
-                ARPV4_Packet();
-                break;
-            case ETHERTYPE_IPV4:
-                logMsg("RX IPV4 Packet", LOG_INFO, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
-                IPV4_Packet();
-                break;
-            case ETHERTYPE_LLDP:
-                logMsg("LLDP Packet Received", LOG_INFO, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
-                LLDP_Packet();
-                break;                
-            default:
+        case ETHERTYPE_VLAN:
+            logMsg("VLAN Packet Dropped", LOG_INFO, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
+            Network_CountRx(NET_PATH_OTHER, frameLength);
+            break;
+        case ETHERTYPE_ARP:
+            logMsg("RX ARPV4 Packet", LOG_INFO, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
+            Network_CountRx(NET_PATH_ARP, frameLength);
+            ARPV4_Packet();
+            break;
+        case ETHERTYPE_IPV4:
+            logMsg("RX IPV4 Packet", LOG_INFO, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
+            if(IPV4_Packet() == DEST_IP_NOT_MATCHED)
+            {
+#ifdef ENABLE_NETWORK_STATS
+                networkRxStats.rxNotForUs++;
+#endif
+            }
+            break;
+        case ETHERTYPE_LLDP:
+            logMsg("LLDP Packet Received", LOG_INFO, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
+            Network_CountRx(NET_PATH_LLDP, frameLength);
+            LLDP_Packet();
+            break;                
+        default:
+            {
+                long t = header.id.type;
+                Network_CountRx(NET_PATH_OTHER, frameLength);
+                if(t < 0x05dc) // this is a length field
                 {
-                    long t = header.id.type;
-                    if(t < 0x05dc) // this is a length field
-                    {
-                        sprintf(debug_str,"802.3 length 0x%04lX",t);                    
-                    }
-                    else
-                        sprintf(debug_str,"802.3 type 0x%04lX",t);
-
-                    logMsg(debug_str, LOG_INFO, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
+                    sprintf(debug_str,"802.3 length 0x%04lX",t);                    
                 }
-                break;
-        }        
-        ETH_Flush();
+                else
+                    sprintf(debug_str,"802.3 type 0x%04lX",t);
+
+                logMsg(debug_str, LOG_INFO, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
+            }
+            break;
+    }        
+    ETH_Flush();
+}
+
+/**
+ * Program the MAC hash filter with the multicast addresses in use
+ */
+static void Network_UpdateRxFilter(void)
+{
+#ifdef NETWORK_MULTICAST_FILTER
+    // LLDP may use any of its three reserved addresses
+    static const uint8_t lldpAddressEnd[] = {0x00, 0x03, 0x0E};
+    mac48Address_t mac = {0x01, 0x80, 0xC2, 0x00, 0x00, 0x00};
+    uint8_t index;
+
+    ETH_HashTableClear();
+    for(index = 0; index < sizeof(lldpAddressEnd); index++)
+    {
+        mac.mac_array[5] = lldpAddressEnd[index];
+        ETH_HashTableAdd(&mac);
+    }
+
+    Network_MulticastMac(ALL_HOST_MULTICAST_ADDRESS, &mac);
+    ETH_HashTableAdd(&mac);
+    for(index = 0; index < NETWORK_MULTICAST_GROUPS; index++)
+    {
+        if(multicastGroups[index])
+        {
+            Network_MulticastMac(multicastGroups[index], &mac);
+            ETH_HashTableAdd(&mac);
+        }
+    }
+
+    ETH_SetRxFilter((ETH_GetRxFilter() & (uint8_t)~ETH_FILTER_MULTICAST) | ETH_FILTER_HASH);
+#endif
+}
+
+/**
+ * Map an IPv4 multicast group to its MAC address (01:00:5E and the low 23 bits)
+ */
+static void Network_MulticastMac(uint32_t group, mac48Address_t *mac)
+{
+    mac->mac_array[0] = 0x01;
+    mac->mac_array[1] = 0x00;
+    mac->mac_array[2] = 0x5E;
+    mac->mac_array[3] = (uint8_t)(group >> 16) & 0x7F;
+    mac->mac_array[4] = (uint8_t)(group >> 8);
+    mac->mac_array[5] = (uint8_t)group;
+}
+
+error_msg Network_JoinMulticast(uint32_t group)
+{
+    uint8_t index;
+    uint8_t freeIndex = NETWORK_MULTICAST_GROUPS;
+
+    if((group & 0xF0000000) != 0xE0000000)
+    {
+        return ERROR;
     }
+
+    for(index = 0; index < NETWORK_MULTICAST_GROUPS; index++)
+    {
+        if(multicastGroups[index] == group)
+        {
+            return SUCCESS;
+        }
+        if((multicastGroups[index] == 0) && (freeIndex == NETWORK_MULTICAST_GROUPS))
+        {
+            freeIndex = index;
+        }
+    }
+
+    if(freeIndex == NETWORK_MULTICAST_GROUPS)
+    {
+        return BUFFER_BUSY;
+    }
+    multicastGroups[freeIndex] = group;
+    Network_UpdateRxFilter();
+    return SUCCESS;
+}
+
+void Network_LeaveMulticast(uint32_t group)
+{
+    uint8_t index;
+
+    for(index = 0; index < NETWORK_MULTICAST_GROUPS; index++)
+    {
+        if(multicastGroups[index] == group)
+        {
+            multicastGroups[index] = 0;
+            // the hash table bits may be shared, build it again
+            Network_UpdateRxFilter();
+        }
+    }
+}
+
+bool Network_IsMulticastMember(uint32_t group)
+{
+    uint8_t index;
+
+    if(group == ALL_HOST_MULTICAST_ADDRESS)
+    {
+        return true;
+    }
+    for(index = 0; index < NETWORK_MULTICAST_GROUPS; index++)
+    {
+        if((group != 0) && (multicastGroups[index] == group))
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
 static void Network_SaveStartPosition(void)
@@ -180,4 +343,50 @@ static void Network_SaveStartPosition(void)
 uint16_t Network_GetStartPosition(void)
 {    
     return networkStartPosition;
-}
\ No newline at end of file
+}
+
+#ifdef ENABLE_NETWORK_STATS
+void Network_CountRx(networkPath_t path, uint16_t frameLength)
+{
+    if(path < NET_PATH_COUNT)
+    {
+        networkStats[path].rxPackets++;
+        networkStats[path].rxBytes += frameLength;
+    }
+}
+
+void Network_CountTx(networkPath_t path, uint16_t frameLength)
+{
+    if(path < NET_PATH_COUNT)
+    {
+        networkStats[path].txPackets++;
+        networkStats[path].txBytes += frameLength;
+    }
+}
+
+const networkPathStats_t *Network_GetStats(networkPath_t path)
+{
+    if(path < NET_PATH_COUNT)
+    {
+        return &networkStats[path];
+    }
+    return NULL;
+}
+
+const networkRxStats_t *Network_GetRxStats(void)
+{
+    const ethStats_t *ethStats = ETH_GetStats();
+
+    networkRxStats.rxOverflow = ethStats->rxOverflow;
+    networkRxStats.rxMulticast = ethStats->rxMulticast;
+    networkRxStats.rxBroadcast = ethStats->rxBroadcast;
+    return &networkRxStats;
+}
+
+void Network_ResetStats(void)
+{
+    memset(networkStats, 0, sizeof(networkStats));
+    memset(&networkRxStats, 0, sizeof(networkRxStats));
+    IPV4_ResetDropCounters();
+}
+#endif
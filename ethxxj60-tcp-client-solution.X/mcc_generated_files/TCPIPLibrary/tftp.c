@@ -141,7 +141,6 @@ void TFTP_Handler(int16_t length)   // jira:M8TS-608
 {
     uint8_t opcode;
     char data[100];
-    char recv_buffer[100];
     uint16_t block_size;
     int v;
     
@@ -176,8 +175,6 @@ void TFTP_Handler(int16_t length)   // jira:M8TS-608
                         while(length > 0)
                         {    
                             v = (length>100)?100:length; // One block of data is 1344 bytes long (0-1343). Transferred using 100 bytes buffer
-                            memset(data,0,sizeof(data));    
-                            memset(recv_buffer,0,sizeof(recv_buffer)); 
                             UDP_ReadBlock(data, (uint16_t)v);   //jira: CAE_MCU8-5647
                             Process_TFTP_Data(tftp_last_address, data, (uint16_t)v);  //jira: CAE_MCU8-5647
                             tftp_last_address = tftp_last_address + (uint16_t)v;   //jira: CAE_MCU8-5647
@@ -0,0 +1,144 @@
+/**
+ Timer Wheel Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    timer_wheel.h
+
+  Summary:
+    Header file for the protocol timers.
+
+  Description:
+    This header file provides the API for the millisecond protocol timers.
+    The timers are kept in a hierarchical timer wheel, starting and stopping
+    a timer does not depend on the number of running timers.
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#ifndef TIMER_WHEEL_H
+#define	TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef void (*netTimerHandler_t)(void *context);
+
+typedef struct netTimer
+{
+    struct netTimer *next;          // next timer in the same wheel slot
+    struct netTimer **link;         // pointer that points to this timer, NULL when the timer is stopped
+    uint32_t expires;               // tick (ms) when the timer expires
+    netTimerHandler_t handler;      // called from TIMER_Service() when the timer expires
+    void *context;                  // passed to the handler
+} netTimer_t;
+
+/*Initialize the Timer Wheel
+ * Removes all timers from the wheel and synchronizes it with the millisecond
+ * tick of rtcc.c. Call it before any timer is started.
+ *
+ * @param None
+ *
+ * @param return
+ *      Nothing
+ */
+void TIMER_WheelInit(void);
+
+/*Prepare a Timer
+ * Sets the handler of a timer and marks it stopped. Every timer must be
+ * prepared once before it is started.
+ *
+ * @param timer
+ *      pointer to the timer, owned by the caller
+ *
+ * @param handler
+ *      function called when the timer expires
+ *
+ * @param context
+ *      value passed to the handler
+ *
+ * @param return
+ *      Nothing
+ */
+void TIMER_Setup(netTimer_t *timer, netTimerHandler_t handler, void *context);
+
+/*Start a Timer
+ * (Re)starts the timer to expire after the given number of milliseconds.
+ * A running timer is moved to the new expiration time.
+ *
+ * @param timer
+ *      pointer to a timer prepared with TIMER_Setup
+ *
+ * @param ms
+ *      delay in milliseconds, at least 1
+ *
+ * @param return
+ *      Nothing
+ */
+void TIMER_Start(netTimer_t *timer, uint32_t ms);
+
+/*Stop a Timer
+ * The handler will not be called. Stopping a stopped timer has no effect.
+ *
+ * @param timer
+ *      pointer to the timer
+ *
+ * @param return
+ *      Nothing
+ */
+void TIMER_Stop(netTimer_t *timer);
+
+/*Check a Timer
+ *
+ * @param timer
+ *      pointer to the timer
+ *
+ * @param return
+ *      true if the timer is running
+ */
+bool TIMER_IsRunning(netTimer_t *timer);
+
+/*Service the Timer Wheel
+ * Advances the wheel up to the current millisecond tick and calls the
+ * handlers of the expired timers. It is called from Network_Manage().
+ *
+ * @param None
+ *
+ * @param return
+ *      Nothing
+ */
+void TIMER_Service(void);
+
+/*Number of Running Timers
+ *
+ * @param None
+ *
+ * @param return
+ *      number of timers in the wheel
+ */
+uint16_t TIMER_GetRunningCount(void);
+
+#endif	/* TIMER_WHEEL_H */
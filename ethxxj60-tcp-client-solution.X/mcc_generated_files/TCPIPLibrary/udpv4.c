@@ -102,9 +102,9 @@ error_msg UDP_Send(void)
     ETH_Insert((char *)&udpLength, 2, sizeof(ethernetFrame_t) + sizeof(ipv4Header_t) + offsetof(udpHeader_t,length));
     udpLength = htons(udpLength);
     
-    // add the UDP header checksum
-    cksm = udpLength + UDP_TCPIP;
-    cksm = ETH_TxComputeChecksum(sizeof(ethernetFrame_t) + sizeof(ipv4Header_t) - 8, udpLength + 8, cksm);
+    // add the UDP header checksum, the length field was written as 0 so add it here
+    ETH_TxChecksumAdd(udpLength);
+    cksm = ETH_TxChecksumGet(IPV4_PseudoHeaderChecksum(udpLength));
 
     // if the computed checksum is "0" set it to 0xFFFF
     if (cksm == 0){
@@ -118,6 +118,27 @@ error_msg UDP_Send(void)
     return ret;
 }
 
+/**
+ * Check if a UDP port has a handler
+ * @param port  destination port
+ * @return true if UDP_Receive() would deliver the datagram
+ */
+bool UDP_IsPortOpen(uint16_t port)
+{
+    udp_table_iterator_t  hptr;
+
+    hptr = udp_table_getIterator();
+    while(hptr != NULL)
+    {
+        if(hptr->portNumber == port)
+        {
+            return true;
+        }
+        hptr = udp_table_nextEntry(hptr);
+    }
+    return false;
+}
+
 error_msg UDP_Receive(uint16_t udpcksm) // catch all UDP packets and dispatch them to the appropriate callback
 {
     error_msg ret = ERROR;
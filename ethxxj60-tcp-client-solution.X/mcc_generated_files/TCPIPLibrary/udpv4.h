@@ -65,6 +65,11 @@ extern ipv4Header_t ipv4Header; // re evaluate this dependancy sometime
 #define   UDP_Read16()                ETH_Read16()
 #define   UDP_Read24()                ETH_Read24()
 #define   UDP_Read32()                ETH_Read32()
+#define   UDP_Skip(length)            ETH_Skip(length)
+#define   UDP_GetRxView(view)         ETH_GetRxView(view)
+#define   UDP_Peek8(offset)           ETH_Peek8(offset)
+#define   UDP_Peek16(offset)          ETH_Peek16(offset)
+#define   UDP_PeekBlock(data,offset,length) ETH_PeekBlock(data,offset,length)
 #define   UDP_Write8(data)            ETH_Write8(data)
 #define   UDP_Write16(data)           ETH_Write16(data)
 #define   UDP_Write24(data)           ETH_Write24(data)
@@ -82,6 +87,7 @@ extern ipv4Header_t ipv4Header; // re evaluate this dependancy sometime
 error_msg UDP_Start(uint32_t destIP, uint16_t srcPort, uint16_t dstPort);
 error_msg UDP_Send(void);
 error_msg UDP_Receive(uint16_t udpcksm);
+bool UDP_IsPortOpen(uint16_t port);
 void udp_test(int len);
 
 
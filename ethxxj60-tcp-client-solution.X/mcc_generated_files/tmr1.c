@@ -65,11 +65,11 @@ void TMR1_Initialize(void)
 {
     //Set the Timer to the options selected in the GUI
 	
-	// TMR1H 1; 
-		TMR1H = 0x01;
+	// TMR1H 245; 
+		TMR1H = 0xF5;
 	
-	// TMR1L 176; 
-		TMR1L = 0xB0;
+	// TMR1L 212; 
+		TMR1L = 0xD4;
 
     // Load the TMR value to reload variable
     timer1ReloadVal=TMR1;
@@ -150,7 +150,7 @@ void TMR1_ISR(void)
     PIR1bits.TMR1IF = 0;    
     TMR1_WriteTimer(timer1ReloadVal);
 
-    // callback function - called every 41th pass
+    // callback function - called every pass (1 ms)
     if (++CountCallBack >= TMR1_INTERRUPT_TICKER_FACTOR)
     {
         // ticker function call
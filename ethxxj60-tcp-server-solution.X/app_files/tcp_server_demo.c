@@ -31,76 +31,95 @@
                             /* TCP Demo */
 /*******************************************************************************/
 
+#define ECHO_CLIENTS    2   // clients served at the same time on port 7
+#define ECHO_KEEPALIVE_IDLE     60u // seconds without data before a silent client is probed
+#define ECHO_KEEPALIVE_INTERVAL 10u // seconds between the probes
+#define ECHO_KEEPALIVE_PROBES   3u  // unanswered probes that free the socket
+
 //Implement an echo server over TCP
 void TCP_Demo_EchoServer(void)
 {
-    // Create the socket for the TCP Server
-    static tcpTCB_t port7TCB;
-   
+    // Sockets from the pool of the stack: the listening socket and one for each client
+    static tcpHandle_t port7Socket = TCP_INVALID_SOCKET;
+    static tcpHandle_t echoSocket[ECHO_CLIENTS] = {TCP_INVALID_SOCKET, TCP_INVALID_SOCKET};
+    static tcpBacklogEntry_t port7Backlog[ECHO_CLIENTS];
 
-    // Create the TX and RX Server's buffers
-    static uint8_t rxdataPort7[20];
-    static uint8_t txdataPort7[20];
+    // Create the TX and RX rings for each client
+    static uint8_t rxdataEcho[ECHO_CLIENTS][20];
+    static uint8_t txdataEcho[ECHO_CLIENTS][20];
+    uint8_t echoBuffer[20];
 
-    uint16_t rxLen, txLen, i;
-    socketState_t socket_state;
+    tcpTCB_t *port7TCB;
+    tcpTCB_t *echoTCB;
+    uint16_t rxLen, txLen;
+    uint8_t i;
 
-    // Check the status of the Socket
-    socket_state = TCP_SocketPoll(&port7TCB);
-//    -	NOT_A_SOCKET? ? the socket was not initialized
+    // Check the status of the listening Socket
+//    -	NOT_A_SOCKET? ? the socket is not allocated (or was taken back by the stack)
 //    - SOCKET_CLOSED? ? the socket is initialized but is closed
-//    - SOCKET_CONNECTED? ? the socket is connected and the data can be exchanged with remote machine
-
-    switch(socket_state)
+//    - SOCKET_IN_PROGRESS? ? the socket listens, the clients wait in the backlog
+    port7TCB = TCP_SocketPtr(port7Socket);
+    switch(TCP_SocketPoll(port7TCB))
     {
         case NOT_A_SOCKET:
-            // Inserting and Initializing the socket
-            
-         TCP_SocketInit(&port7TCB);   
+            // Take a socket from the pool, it is initialized
+            port7Socket = TCP_SocketAlloc();
             break;
         case SOCKET_CLOSED:
-
             // Configure the local port
-         TCP_Bind(&port7TCB,7);   
+            TCP_Bind(port7TCB, 7);
 
-          
-            //  Add receive buffer 
-            TCP_InsertRxBuffer(&port7TCB, rxdataPort7,sizeof(rxdataPort7));
+            // Keep listening and queue the new clients
+            TCP_SetBacklog(port7TCB, port7Backlog, ECHO_CLIENTS);
 
             //  Start the TCP server: Listen on port
-            TCP_Listen(&port7TCB);
-
-           
+            TCP_Listen(port7TCB);
             break;
-        case SOCKET_CONNECTED:
-            // check if the buffer was sent, if yes we can send another buffer
-            if(TCP_SendDone(&port7TCB))
-            {
-                // check to see  if there are any received data
-                rxLen = TCP_GetRxLength(&port7TCB);
-                if(rxLen > 0)
-                {
-                    rxLen = TCP_GetReceivedData(&port7TCB);
-
-                    //simulate some buffer processing
-                    for(i = 0; i < rxLen; i++)
-                    {
-                        txdataPort7[i] = rxdataPort7[i];
-                    }
+        default:
+            break;
+    }
 
-                    // reuse the RX buffer
-                    TCP_InsertRxBuffer(&port7TCB, rxdataPort7, sizeof(rxdataPort7));
-                    txLen = rxLen;
+    for(i = 0; i < ECHO_CLIENTS; i++)
+    {
+        echoTCB = TCP_SocketPtr(echoSocket[i]);
+        switch(TCP_SocketPoll(echoTCB))
+        {
+            case NOT_A_SOCKET:
+                echoSocket[i] = TCP_SocketAlloc();
+                break;
+            case SOCKET_CLOSED:
+                //  Add the receive and transmit rings, then take a waiting client
+                TCP_InsertRxRing(echoTCB, rxdataEcho[i], sizeof(rxdataEcho[i]));
+                TCP_InsertTxBuffer(echoTCB, txdataEcho[i], sizeof(txdataEcho[i]));
+#ifdef TCP_ENABLE_KEEPALIVE
+                // a client that vanished without closing must not keep the socket
+                TCP_SetKeepAlive(echoTCB, ECHO_KEEPALIVE_IDLE, ECHO_KEEPALIVE_INTERVAL, ECHO_KEEPALIVE_PROBES);
+#endif
+                TCP_Accept(port7TCB, echoTCB);
+                break;
+            case SOCKET_CONNECTED:
+                // take only what fits in the TX ring, the rest waits in the RX ring
+                txLen = TCP_GetTxFree(echoTCB);
+                if(txLen > sizeof(echoBuffer))
+                {
+                    txLen = sizeof(echoBuffer);
+                }
 
+                // reading frees RX ring space, the socket announces the new window
+                rxLen = TCP_Read(echoTCB, echoBuffer, txLen);
+                if(rxLen > 0)
+                {
                     // Send data back to the Source
-                    TCP_Send(&port7TCB,txdataPort7,txLen);
-                    
+                    TCP_Write(echoTCB, echoBuffer, rxLen);
                 }
-            }
-            break;
-        default:
-            // we should not end up here
-            break;
+                break;
+            case SOCKET_CLOSING:
+                // the client left or stopped answering, give the socket back to the pool
+                TCP_SocketFree(echoSocket[i]);
+                echoSocket[i] = TCP_INVALID_SOCKET;
+                break;
+            default:
+                break;
+        }
     }
 }
-
@@ -50,6 +50,10 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 /* Port 0 is N/A in both UDP and TCP */
 uint16_t portUnreachable = 0;
 
+/* Type/code and checksum of the echo request being answered */
+static uint16_t echoRequestTypeCode;
+static uint16_t echoRequestChecksum;
+
 /**
  * ICMP packet receive
  * @param ipv4_header
@@ -69,6 +73,8 @@ error_msg ICMP_Receive(ipv4Header_t *ipv4Hdr)
         case UNASSIGNED_ECHO_TYPE_CODE_REQUEST_1:
         case UNASSIGNED_ECHO_TYPE_CODE_REQUEST_2:
         {            
+            echoRequestTypeCode = ntohs(icmpHdr.typeCode);
+            echoRequestChecksum = ntohs(icmpHdr.checksum);
             ret = ICMP_EchoReply(ipv4Hdr);
         }
         break;
@@ -108,7 +114,7 @@ error_msg ICMP_EchoReply(ipv4Header_t *ipv4Hdr)
     ret = IPv4_Start(ipv4Hdr->srcIpAddress, ipv4Hdr->protocol);
     if(ret == SUCCESS)
     {
-        uint16_t icmp_cksm_start;
+        uint32_t sum;
         uint16_t ipv4PayloadLength = ipv4Hdr->length - sizeof(ipv4Header_t);
 
         ipv4PayloadLength = ipv4Hdr->length - (uint16_t)(ipv4Hdr->ihl << 2);
@@ -123,10 +129,15 @@ error_msg ICMP_EchoReply(ipv4Header_t *ipv4Hdr)
         ret = ETH_Copy(ipv4PayloadLength - sizeof(icmpHeader_t) - 4);
         if(ret==SUCCESS) // copy can timeout in heavy network situations like flood ping
         {
-            // compute a checksum over the ICMP payload
-            cksm = sizeof(ethernetFrame_t) + sizeof(ipv4Header_t);
-            icmp_cksm_start = sizeof(ethernetFrame_t) + sizeof(ipv4Header_t);
-            cksm = ETH_TxComputeChecksum(icmp_cksm_start, ipv4PayloadLength, 0);
+            // The reply only differs from the request in the type/code, so update the
+            // request checksum (RFC 1624) instead of computing it over the ICMP payload
+            sum = (uint16_t)~echoRequestChecksum;
+            sum += (uint16_t)~echoRequestTypeCode;
+            sum += ECHO_REPLY;
+            sum = (sum & 0x0FFFF) + (sum>>16);
+            sum = (sum & 0x0FFFF) + (sum>>16);
+            cksm = (uint16_t)~sum;
+            cksm = htons(cksm);
             ETH_Insert((char *)&cksm,sizeof(cksm),sizeof(ethernetFrame_t) + sizeof(ipv4Header_t) + offsetof(icmpHeader_t,checksum));
             ret = IPV4_Send(ipv4PayloadLength);
         }
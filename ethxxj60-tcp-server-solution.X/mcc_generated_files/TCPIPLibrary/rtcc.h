@@ -25,10 +25,14 @@
 
 #include <time.h>
 #include <stdint.h>
+#include <stdbool.h>
+
+#define RTCC_TICKS_PER_SECOND   1000u   // rtcc_handler() is called every millisecond
 
 void    rtcc_init(void);
 void    rtcc_handler(void);
 void    rtcc_set(time_t *);
+uint32_t rtcc_getTicks(void);
 bool rtcc_isDirty(void);
 time_t rtcc_get(void);
 
@@ -45,6 +45,8 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 */
 #include <stdbool.h>
 #include "tcpip_types.h"
+#include "timer_wheel.h"
+#include "tcpip_config.h"
 
 #define TCP_FIN_FLAG 0x01U
 #define TCP_SYN_FLAG 0x02U
@@ -98,6 +100,59 @@ typedef enum
     TX_BUFF_IN_USE
 }tcpBufferState_t;
 
+typedef struct
+{
+    uint32_t seqno;                 // sequence number of the first byte of the range
+    uint16_t length;                // bytes received in the range
+}tcpOooRange_t;
+
+typedef struct
+{
+    uint16_t start;                 // offset of the first byte from the oldest unacknowledged byte
+    uint16_t end;                   // offset of the byte after the range
+}tcpSackRange_t;
+
+typedef struct
+{
+    uint16_t oooSegments;           // out of order segments kept in the RX buffer
+    uint16_t oooDropped;            // out of order segments dropped: no queue, queue full or outside the window
+    uint16_t oooFilled;             // queued ranges delivered after the missing bytes arrived
+    uint16_t duplicates;            // segments that carried only bytes already received
+    uint32_t bytesReceived;         // payload bytes saved in order in the RX buffer
+    uint32_t ackFrames;             // frames sent with only an ACK
+    uint16_t acksDelayed;           // ACKs sent by the delayed ACK timer
+    uint16_t acksPiggybacked;       // pending ACKs carried by a data or FIN segment
+    uint16_t windowUpdates;         // ACKs sent because TCP_Read() or TCP_InsertRxBuffer() opened the window
+    uint16_t zeroWindows;           // segments that filled the RX buffer
+}tcpRxStats_t;
+
+typedef struct
+{
+    uint16_t dupAcks;               // duplicate ACKs received
+    uint16_t fastRetransmits;       // segments retransmitted after TCP_DUP_ACK_THRESHOLD duplicate ACKs
+    uint16_t partialAcks;           // segments retransmitted after a partial ACK during a recovery
+    uint16_t sackRetransmits;       // holes retransmitted because the remote reported later bytes with SACK
+    uint16_t cwnd;                  // congestion window in bytes
+    uint16_t ssthresh;              // slow start threshold in bytes
+}tcpTxStats_t;
+
+typedef struct
+{
+    uint32_t remoteIP;
+    uint16_t remotePort;
+    uint16_t localPort;             // port of the listening socket
+    uint32_t remoteAck;             // next sequence number expected from the remote
+    uint32_t localSeqno;            // initial sequence number sent in the SYN+ACK
+    uint16_t remoteWnd;
+    uint16_t localWnd;              // window sent in the SYN+ACK
+    uint16_t mss;
+    uint8_t options;                // options agreed in the SYN exchange
+    uint8_t sndScale;               // window scale of the remote
+    uint32_t tsRecent;              // timestamp to echo to the remote
+    uint8_t timeoutsCount;          // SYN+ACK retransmissions left
+    tcp_fsm_states_t fsmState;      // CLOSED (free), SYN_RECEIVED or ESTABLISHED (waits for TCP_Accept)
+}tcpBacklogEntry_t;
+
 typedef struct
 {
     uint16_t localPort;             // this is the local port
@@ -108,52 +163,162 @@ typedef struct
     uint32_t remoteSeqno;
     uint32_t remoteAck;             // last ack packet sent to remote
 
-    uint32_t localSeqno;
-    uint32_t localLastAck;          // last ack number received
+    uint32_t localSeqno;            // next sequence number to send
+    uint32_t localLastAck;          // last ack number received, the oldest unacknowledged byte
+    uint32_t localRecover;          // highest sequence number sent when a retransmission started
 
     uint16_t remoteWnd;             // sender window
+    uint32_t sndWl1;                // sequence number of the segment that set remoteWnd (RFC 793 SND.WL1)
+    uint32_t sndWl2;                // ACK number of that segment (SND.WL2)
     uint16_t localWnd;              // receiver window
     
-    uint16_t mss;
+    uint16_t mss;                   // largest payload of a segment, the timestamps option is already taken off
+
+    // RFC 7323 options, the RX memory is below 64 KB: this stack announces a window scale of 0
+    uint8_t options;                // options agreed in the SYN exchange (window scale, timestamps)
+#ifdef TCP_ENABLE_WINDOW_SCALE
+    uint8_t sndScale;               // the windows received from the remote are shifted left by sndScale
+#endif
+#ifdef TCP_ENABLE_TIMESTAMPS
+    uint32_t tsRecent;              // last timestamp received in order, echoed in each segment
+#endif
 
-    uint8_t *rxBufferStart;
-    uint8_t *rxBufferPtr;           // pointer to write inside the rx buffer
+    uint8_t *rxBufferStart;         // RX memory: the buffer of TCP_InsertRxBuffer() or the ring of TCP_InsertRxRing()
+    uint16_t rxBufferSize;          // size of the RX memory
+    uint16_t rxBufferHead;          // index of the next byte in order (remoteAck)
+    uint16_t rxBufferTail;          // index of the first byte not read by the application
+    uint16_t rxBytes;               // bytes received and not read yet
+    uint32_t localWndEdge;          // right edge of the last advertised window (RFC 1122 receiver SWS avoidance)
     tcpBufferState_t rxBufState;
+    bool rxRing;                    // the RX memory is a ring, the application uses TCP_Read()
+
+#ifdef TCP_ENABLE_OOO_QUEUE
+    // out of order data is stored in the RX buffer after rxBufferHead, the queue keeps its ranges
+    tcpOooRange_t *oooQueue;        // ranges sorted by sequence number, memory owned by the user
+    uint8_t oooQueueSize;           // number of ranges in oooQueue, 0 drops out of order segments
+    uint8_t oooCount;               // ranges in use
+    uint32_t oooLastSeqno;          // first byte of the last out of order segment, its range is the first SACK block
+#endif
+#ifdef TCP_ENABLE_STATS
+    tcpRxStats_t rxStats;
+#endif
+
+    // RFC 1122 delayed ACK
+    netTimer_t ackTimer;            // sends the pending ACK after TCP_DELAYED_ACK_TIMEOUT
+    uint8_t ackPending;             // received segments not acknowledged yet
+
+#ifdef TCP_ENABLE_KEEPALIVE
+    // RFC 1122 keep-alive, finds the connections of a remote that is gone
+    netTimer_t keepAliveTimer;      // idle time, then the time between the probes
+    uint16_t keepAliveIdle;         // seconds without a received segment before the first probe, 0: off
+    uint16_t keepAliveInterval;     // seconds between the probes
+    uint8_t keepAliveCount;         // unanswered probes that close the connection
+    uint8_t keepAliveProbes;        // probes sent since the last received segment
+#endif
 
-    uint8_t *txBufferStart;
-    uint8_t *txBufferPtr;
-    uint16_t bytesToSend;
+    uint8_t *txBufferStart;         // TX memory: the buffer of TCP_Send() or the ring of TCP_InsertTxBuffer()
+    uint16_t txBufferSize;          // size of the TX memory
+    uint16_t txBufferTail;          // index of the first unacknowledged byte (localLastAck)
+    uint16_t bytesToSend;           // bytes not sent yet, they follow the bytes sent
     tcpBufferState_t txBufState;
-    uint16_t bytesSent;
+    uint16_t bytesSent;             // bytes sent and not acknowledged yet
+    bool txRing;                    // the TX memory is a ring, TCP_Write() copies the data to it
+    bool noDelay;                   // send small segments at once, without the Nagle algorithm
     bool payloadSave;
+    bool closePending;              // TCP_Close() waits until the data written before it is acknowledged
+
+    // RFC 5681 congestion control with NewReno fast recovery (RFC 6582)
+    uint16_t cwnd;                  // congestion window in bytes, 0 until the first data is sent
+    uint16_t ssthresh;              // slow start threshold in bytes
+    uint8_t dupAcks;                // duplicate ACKs in a row
+    bool fastRecovery;              // the window is inflated by the duplicate ACKs until localRecover is acknowledged
+
+#ifdef TCP_ENABLE_SACK
+    // RFC 2018 / RFC 6675 SACK scoreboard, the bytes the remote holds after a hole
+    tcpSackRange_t sackBoard[TCP_SACK_SCOREBOARD_SIZE]; // sorted ranges relative to localLastAck
+    uint8_t sackCount;              // ranges in use
+    uint16_t sackRexmitNext;        // offset from localLastAck where the search for the next hole to retransmit starts
+#endif
+#ifdef TCP_ENABLE_STATS
+    tcpTxStats_t txStats;
+#endif
 
     tcp_fsm_states_t fsmState;      // connection state
     tcpEvent_t connectionEvent;
 
+    // listen backlog, the connections wait here until TCP_Accept() moves them to a socket
+    tcpBacklogEntry_t *backlog;     // memory owned by the user, NULL: the listening socket takes the connection
+    uint8_t backlogSize;            // number of entries in backlog
+
     // Linked List Pointers
     void *nextTCB;                  // downstream list pointer
     void *prevTCB;                  // upstream list pointer
+    uint8_t hashIndex;              // slot of the socket in the lookup table
 
-    uint16_t timeout;               // retransmission time-out in seconds
+    netTimer_t timer;               // retransmission time-out, counts ms (TICK_SECOND)
     uint16_t timeoutReloadValue;
     uint8_t timeoutsCount;          // number of retransmissions
+    
+    // RFC 6298 round trip time estimation
+    uint16_t srtt;                  // smoothed round trip time in 1/8 ms
+    uint16_t rttvar;                // round trip time variation in 1/4 ms
+    uint16_t rto;                   // retransmission time-out computed from the RTT in ms
+    uint16_t rttStart;              // time the timed segment was sent, ms
+    uint32_t rttSeqno;              // the ACK for this sequence number ends the measurement
+    bool rttActive;                 // a segment is being timed
+    uint16_t lastRtt;               // last round trip time sample in ms
+    uint16_t rttSamples;            // number of round trip time samples
+    uint16_t retransmits;           // segments retransmitted after a time-out, a partial ACK or duplicate ACKs
     uint8_t flags;                  // save the flags to be used for timeouts
 
     socketState_t socketState;     // socket state to be easy
 }tcpTCB_t;
 
+typedef struct
+{
+    uint16_t srtt;                  // smoothed round trip time in ms
+    uint16_t rttvar;                // round trip time variation in ms
+    uint16_t rto;                   // retransmission time-out in ms
+    uint16_t lastRtt;               // last round trip time sample in ms
+    uint16_t rttSamples;            // number of round trip time samples
+    uint16_t retransmits;           // segments retransmitted after a time-out, a partial ACK or duplicate ACKs
+}tcpRttStats_t;
+
+typedef uint8_t tcpHandle_t;        // handle of a socket of the stack pool: generation (bits 7-4) and pool index (bits 3-0)
+#define TCP_INVALID_SOCKET  (0xFFu)
+
+typedef struct
+{
+    uint8_t size;                   // sockets in the pool, TCP_SOCKET_POOL_SIZE
+    uint8_t inUse;                  // sockets allocated now
+    uint8_t inUseMax;               // highest number of sockets allocated at the same time
+    uint16_t allocations;           // sockets handed out by TCP_SocketAlloc()
+    uint16_t allocFailures;         // TCP_SocketAlloc() calls that found no free socket
+    uint16_t timeWaitReuses;        // allocations served by taking back a socket in TIME_WAIT
+}tcpPoolStats_t;
+
+typedef struct
+{
+    uint16_t synReceived;           // new SYNs received by listening sockets with a backlog
+    uint16_t cacheFull;             // SYNs that found no free backlog entry
+    uint16_t cookiesSent;           // SYN+ACKs sent without a backlog entry
+    uint16_t cookiesAccepted;       // connections that got a backlog entry from the cookie of their ACK
+    uint16_t cookiesRejected;       // ACKs without a backlog entry and with a wrong or expired cookie
+    uint16_t evictions;             // half-open entries given to a connection with a valid cookie
+}tcpSynStats_t;
+
 typedef enum
 {
 TCP_EOP = 0u,        // length = 0   End of Option List,[RFC793]
 TCP_NOP = 1u,        // length = 0   No-Operation,[RFC793]
 TCP_MSS = 2u,        // length = 4   Maximum Segment Size,[RFC793]
+TCP_WIN_SCALE = 3u,  // length = 3   Window Scale,[RFC7323]
+TCP_SACK_PERMITTED = 4u, // length = 2   SACK Permitted,[RFC2018]
+TCP_SACK = 5u,       // length = N   SACK,[RFC2018]
+TCP_TIMESTAMPS = 8u, // length = 10  Timestamps,[RFC7323]
 
 // this options are not implemented
 #ifdef ALL_TCP_HEADER_OPTIONS
-TCP_WIN_SCALE = 3,  // length = 3   Window Scale,[RFC7323]
-TCP_SACK = 4,       // length = 2   SACK Permitted,[RFC2018]
-
-5                   // length = N   SACK,[RFC2018]
 6                   // length = 6   Echo (obsoleted by option 8),[RFC1072][RFC6247]
 7                   // length = 6   Echo Reply (obsoleted by option 8),[RFC1072][RFC6247]
 8                   // length = 10  Timestamps,[RFC7323]
@@ -217,6 +382,7 @@ void TCP_Init(void);
  * Put the socket in the CLOSED state.
  *
  * The user is responsible to manage allocation and releasing of the memory.
+ * At most TCP_SOCKET_HASH_SIZE - 1 sockets can be in the list.
  * 
  * @param tcb_ptr
  *      pointer to the socket/TCB structure
@@ -244,6 +410,71 @@ error_msg TCP_SocketInit(tcpTCB_t *tcb_ptr);   //jira: CAE_MCU8-5647
 error_msg TCP_SocketRemove(tcpTCB_t *tcb_ptr);
 
 
+/** Take a socket from the pool of the stack and initialize it, see
+ * TCP_SocketInit(). The pool has TCP_SOCKET_POOL_SIZE sockets. When all are
+ * allocated, a socket that waits in TIME_WAIT is closed and handed out again;
+ * the old handle of that socket becomes invalid.
+ *
+ * @param None
+ *
+ * @return
+ *      handle of the socket, TCP_INVALID_SOCKET if the pool is empty
+ */
+tcpHandle_t TCP_SocketAlloc(void);
+
+
+/** Give a socket back to the pool. The socket must not be connected: it is
+ * closed, closing (TCP_SocketPoll() returns SOCKET_CLOSED or SOCKET_CLOSING)
+ * or it was already removed with TCP_SocketRemove(). The handle becomes
+ * invalid.
+ *
+ * @param socket
+ *      handle from TCP_SocketAlloc()
+ *
+ * @return
+ *      -1 if the handle is invalid or the socket is in use
+ * @return
+ *       0 if the socket is back in the pool
+ */
+error_msg TCP_SocketFree(tcpHandle_t socket);
+
+
+/** Socket/TCB structure of a pool handle, for the functions of the TCP API.
+ *
+ * @param socket
+ *      handle from TCP_SocketAlloc()
+ *
+ * @return
+ *      pointer to the socket/TCB structure, NULL if the handle is invalid
+ */
+tcpTCB_t *TCP_SocketPtr(tcpHandle_t socket);
+
+
+/** Usage of the socket pool. The RAM needed by the sockets of an application
+ * is inUseMax * sizeof(tcpTCB_t).
+ *
+ * @param None
+ *
+ * @return
+ *      pointer to the pool counters
+ */
+const tcpPoolStats_t *TCP_GetPoolStats(void);
+
+
+#ifdef TCP_ENABLE_KEEPALIVE
+/** Number of connections closed by the keep-alive because the remote did not
+ *  answer the probes. Each of them was reset and shown to the application as
+ *  SOCKET_CLOSING.
+ *
+ * @param None
+ *
+ * @return
+ *      connections reclaimed since TCP_Init()
+ */
+uint16_t TCP_GetKeepAliveReclaims(void);
+#endif
+
+
 /** The function will provide an interface to read the status of the socket.
  *  This function will also check if the pointer is already into the TCB list 
  *  (this means that the socket is "in use"). If the socket is into the TCB list
@@ -293,6 +524,68 @@ error_msg TCP_Bind(tcpTCB_t *tcbPtr, uint16_t port);    //jira: CAE_MCU8-5647
 error_msg TCP_Listen(tcpTCB_t *tcbPtr);    //jira: CAE_MCU8-5647
 
 
+/** Give a listening socket a backlog for concurrent connections.
+ *  Without a backlog the listening socket becomes the connection and the
+ *  port serves one client. With a backlog the socket keeps listening: each
+ *  new client is answered from a backlog entry, with a zero window, and
+ *  waits there until TCP_Accept() moves it to a socket of the application.
+ *  The backlog is also the SYN cache: a SYN takes only an entry, a socket is
+ *  used once the handshake is complete. Without a backlog the half-open
+ *  connections wait in the TCP_SYN_CACHE_SIZE entries of the stack, their
+ *  SYN+ACK has the window of the listening socket. With
+ *  TCP_ENABLE_SYN_COOKIES a full backlog or cache answers the SYN with a
+ *  cookie and a half-open entry is given to the first remote that returns
+ *  a valid one.
+ *  Call it before TCP_Listen().
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @param backlog
+ *      memory for the entries, owned by the user, NULL to remove the backlog
+ *
+ * @param size
+ *      number of entries, the connections that can wait for TCP_Accept()
+ *
+ * @return
+ *      SUCCESS - The backlog was added to the socket
+ * @return
+ *      ERROR - The socket is not in use or it is listening already
+ */
+error_msg TCP_SetBacklog(tcpTCB_t *tcbPtr, tcpBacklogEntry_t *backlog, uint8_t size);
+
+
+/** Counters of the SYN cache: the backlog entries of the listening sockets
+ *  and the SYN cache of the stack keep the half-open connections, a full one
+ *  answers with SYN cookies (TCP_ENABLE_SYN_COOKIES).
+ *
+ * @param None
+ *
+ * @return
+ *      pointer to the counters
+ */
+const tcpSynStats_t *TCP_GetSynStats(void);
+
+
+/** Accept a connection waiting in the backlog of a listening socket.
+ *  The oldest established connection is moved to the new socket, which
+ *  announces its window to the remote. The new socket must be initialized
+ *  and closed, with its buffers inserted, like before TCP_Listen().
+ *
+ * @param listen_ptr
+ *      pointer to the listening socket
+ *
+ * @param tcb_ptr
+ *      pointer to the socket that takes the connection
+ *
+ * @return
+ *      SUCCESS - The socket is connected
+ * @return
+ *      ERROR - No connection is waiting or one of the sockets is not valid
+ */
+error_msg TCP_Accept(tcpTCB_t *listenPtr, tcpTCB_t *tcbPtr);
+
+
 /** Start the client for a particular socket.
  *  
  * @param tcb_ptr
@@ -310,7 +603,9 @@ error_msg TCP_Connect(tcpTCB_t *tcbPtr, sockaddr_in4_t *srvaddr);    //jira: CAE
 
 
 /** Close the TCP connection.
- * This will initiate the Closing sequence for the TCP connection.
+ * This will initiate the Closing sequence for the TCP connection. Data that
+ * is not acknowledged yet is sent first, the FIN follows when the remote
+ * acknowledged the last byte. No data can be written after the call.
  * 
  * @param tcb_ptr
  *      pointer to the socket/TCB structure
@@ -353,6 +648,109 @@ error_msg TCP_Send(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t dataLen);    //jira
 error_msg TCP_SendDone(tcpTCB_t *tcbPtr);    //jira: CAE_MCU8-5647
 
 
+/** Give the socket a TX ring buffer.
+ *  The data of TCP_Write() is copied to the ring and stays there until the
+ *  remote acknowledges it, the application can reuse its own buffers at once.
+ *  Small writes are collected in full segments (Nagle algorithm, see
+ *  TCP_SetNoDelay). With a ring TCP_Send() copies the whole buffer or nothing.
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @param data
+ *      memory of the ring, owned by the user until the socket is closed
+ *
+ * @param data_len
+ *      size of the ring
+ *
+ * @return
+ *      SUCCESS - The ring was added to the socket
+ * @return
+ *      ERROR - The socket is not in use or data is still being sent
+ */
+error_msg TCP_InsertTxBuffer(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t dataLen);
+
+
+/** Copy data to the TX ring of the socket.
+ *  The data is sent as soon as the windows and the Nagle algorithm allow it.
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @param data
+ *      pointer to the data
+ *
+ * @param data_len
+ *      number of bytes to write
+ *
+ * @return
+ *      Number of bytes copied to the ring, less than data_len when the ring
+ *      is full, 0 if the socket is not connected or has no ring
+ */
+uint16_t TCP_Write(tcpTCB_t *tcbPtr, const uint8_t *data, uint16_t dataLen);
+
+
+/** Free space in the TX ring of the socket.
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @return
+ *      Number of bytes that TCP_Write() would accept now
+ */
+uint16_t TCP_GetTxFree(tcpTCB_t *tcbPtr);
+
+
+/** Turn the Nagle algorithm off or on (TCP_NODELAY).
+ *  With the Nagle algorithm a segment smaller than the mss waits in the TX
+ *  ring while sent data is not acknowledged, so small writes are sent
+ *  together. It is on by default and only applies to the TX ring.
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @param noDelay
+ *      true to send each write at once
+ *
+ * @return
+ *      SUCCESS - The option was set
+ * @return
+ *      ERROR - The socket is not in use
+ */
+error_msg TCP_SetNoDelay(tcpTCB_t *tcbPtr, bool noDelay);
+
+
+#ifdef TCP_ENABLE_KEEPALIVE
+/** Turn the keep-alive of the socket on or off (SO_KEEPALIVE).
+ *  When nothing is received for idle seconds on a connection without
+ *  unacknowledged data, the socket sends a probe every interval seconds.
+ *  Any segment from the remote that passes the acceptance test of RFC 793
+ *  stops the probes, one outside the receive window does not. After count unanswered
+ *  probes the connection is reset and the socket goes to SOCKET_CLOSING.
+ *  It is off by default (RFC 1122 4.2.3.6), the setting stays for the
+ *  following connections of the socket.
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @param idle
+ *      seconds without a received segment before the first probe, 0 turns the keep-alive off
+ *
+ * @param interval
+ *      seconds between the probes, at least 1
+ *
+ * @param count
+ *      unanswered probes that close the connection
+ *
+ * @return
+ *      SUCCESS - The option was set
+ * @return
+ *      ERROR - The socket is not in use or interval is 0 with idle above 0
+ */
+error_msg TCP_SetKeepAlive(tcpTCB_t *tcbPtr, uint16_t idle, uint16_t interval, uint8_t count);
+#endif
+
+
 /** Will add the RX buffer to the socket.
  *
  * @param tcb_ptr
@@ -374,7 +772,7 @@ error_msg TCP_InsertRxBuffer(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t dataLen);
 
 /** This function will read the available data from the socket.
  *  The function will provide to the user also the start address of the 
- *  received buffer.
+ *  received buffer. It does not apply to an RX ring, see TCP_Read().
  * 
  * @param tcb_ptr
  *      pointer to the socket/TCB structure 
@@ -386,6 +784,47 @@ error_msg TCP_InsertRxBuffer(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t dataLen);
 int16_t TCP_GetReceivedData(tcpTCB_t *tcbPtr);
 
 
+/** Give the socket an RX ring buffer.
+ *  The socket keeps the ring until it is closed, the application takes the
+ *  data with TCP_Read(). The space freed by each read goes back to the
+ *  window, a window update is sent once the window opens by one mss (or
+ *  half of the ring), so the remote does not stop on a zero window while
+ *  the application keeps reading.
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @param data
+ *      memory of the ring, owned by the user until the socket is closed
+ *
+ * @param data_len
+ *      size of the ring
+ *
+ * @return
+ *      SUCCESS - The ring was added to the socket
+ * @return
+ *      ERROR - The socket is not in use or it has an RX buffer already
+ */
+error_msg TCP_InsertRxRing(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t dataLen);
+
+
+/** Copy received data from the RX ring of the socket.
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @param data
+ *      pointer to the destination buffer
+ *
+ * @param data_len
+ *      size of the destination buffer
+ *
+ * @return
+ *      Number of bytes copied, 0 if no data was received or the socket has no ring
+ */
+uint16_t TCP_Read(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t dataLen);
+
+
 /** This function will check and return the number of available bytes received
  *  on a socket.
  *
@@ -399,8 +838,89 @@ int16_t TCP_GetReceivedData(tcpTCB_t *tcbPtr);
 int16_t TCP_GetRxLength(tcpTCB_t *tcbPtr);
 
 
-/** This function needs to be called periodically in order to handle the
- *  TCP stack timeouts for each available socket.
+/** Read the round trip time estimation of a socket.
+ *  The values are updated once per round trip while data is being sent.
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @param stats
+ *      pointer to the structure that receives the values
+ *
+ * @return
+ *      SUCCESS - The values were copied
+ * @return
+ *      ERROR - The socket is not in use
+ */
+error_msg TCP_GetRttStats(tcpTCB_t *tcbPtr, tcpRttStats_t *stats);
+
+
+#ifdef TCP_ENABLE_STATS
+/** Read the congestion control state and counters of a socket.
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @param stats
+ *      pointer to the structure that receives the values
+ *
+ * @return
+ *      SUCCESS - The values were copied
+ * @return
+ *      ERROR - The socket is not in use
+ */
+error_msg TCP_GetTxStats(tcpTCB_t *tcbPtr, tcpTxStats_t *stats);
+#endif
+
+
+#ifdef TCP_ENABLE_OOO_QUEUE
+/** Give the socket a queue for out of order segments.
+ *  Segments received after a missing one are kept in the free part of the
+ *  RX buffer, the queue records their sequence ranges. When the missing bytes
+ *  arrive the ranges are merged and acknowledged with one ACK. The ranges are
+ *  discarded when the application takes the RX buffer (TCP_GetReceivedData),
+ *  with an RX ring they are kept.
+ *  Each range needs 6 bytes, one range per hole the socket should survive.
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @param queue
+ *      memory for the ranges, owned by the user, NULL to disable the queue
+ *
+ * @param size
+ *      number of ranges in the queue
+ *
+ * @return
+ *      SUCCESS - The queue was added to the socket
+ * @return
+ *      ERROR - The socket is not in use
+ */
+error_msg TCP_SetOooQueue(tcpTCB_t *tcbPtr, tcpOooRange_t *queue, uint8_t size);
+#endif
+
+
+#ifdef TCP_ENABLE_STATS
+/** Read the receive counters of a socket.
+ *
+ * @param tcb_ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @param stats
+ *      pointer to the structure that receives the values
+ *
+ * @return
+ *      SUCCESS - The values were copied
+ * @return
+ *      ERROR - The socket is not in use
+ */
+error_msg TCP_GetRxStats(tcpTCB_t *tcbPtr, tcpRxStats_t *stats);
+#endif
+
+
+/** This function needs to be called periodically in order to vary the
+ *  initial sequence number and the local port of new connections.
+ *  The socket timeouts run from the timer wheel (TIMER_Service).
  *
  * @param
  *      None
@@ -48,6 +48,7 @@
 
 #include "interrupt_manager.h"
 #include "mcc.h"
+#include "TCPIPLibrary/physical_layer_interface.h"
 
 void  INTERRUPT_Initialize (void)
 {
@@ -64,6 +65,10 @@ void __interrupt() INTERRUPT_InterruptManager (void)
         {
             TMR1_ISR();
         } 
+        else if(PIE2bits.ETHIE == 1 && PIR2bits.ETHIF == 1)
+        {
+            ETH_ISR();
+        } 
         else
         {
             //Unhandled Interrupt
@@ -52,11 +52,11 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 volatile ethernetDriver_t ethData;
 
     // Packet write in progress, not ready for transmit
-#define ETH_WRITE_IN_PROGRESS       (0x0001 << 0)
+#define ETH_WRITE_IN_PROGRESS       (0x01 << 0)
     // Packet complete, in queue for transmit
-#define ETH_TX_QUEUED               (0x0001 << 1)
-    // Flag for pool management - free or allocated
-#define ETH_ALLOCATED               (0x0001 << 2)
+#define ETH_TX_QUEUED               (0x01 << 1)
+    // Packet handed to the MAC, waiting for TXIF
+#define ETH_TX_STARTED              (0x01 << 2)
 
 // adjust these parameters for the MAC...
 #define RAMSIZE (8192)
@@ -68,19 +68,52 @@ volatile ethernetDriver_t ethData;
 
 #define MIN_TX_PACKET           (MIN_TX_PACKET_SIZE + TX_STATUS_VECTOR_SIZE)
 #define TX_BUFFER_SIZE          ((MAX_TX_PACKET_SIZE + TX_STATUS_VECTOR_SIZE) << 1)
+// room reserved in the TX ring for a new packet: control byte, max frame and status vector
+#define TX_SLOT_SIZE            (1 + MAX_TX_PACKET_SIZE + TX_STATUS_VECTOR_SIZE)
 
-// typical memory map for the MAC buffers
-#define TXSTART (RAMSIZE - TX_BUFFER_SIZE)
+#define RX_STATUS_VECTOR_SIZE   (6)
+
+// typical memory map for the MAC buffers, the RX/TX boundary can be moved with ETH_SetBufferPartition()
+#define TXSTART (txStart)
 #define TXEND	(RAMSIZE-1)
 #define RXSTART (0)
 #define RXEND	(TXSTART - 1)
 
-#define TX_BUFFER_MID           ((TXSTART) + ((TX_BUFFER_SIZE) >> 1) )
+// Receive filter after ETH_Init(): unicast, CRC, magic packet, multicast and broadcast
+#define ETH_DEFAULT_RX_FILTER   (ETH_FILTER_UNICAST | ETH_FILTER_CRC | ETH_FILTER_MAGIC | ETH_FILTER_MULTICAST | ETH_FILTER_BROADCAST)
+
+// Checksum engine used after ETH_Init(), see ETH_SetChecksumMode()
+#define ETH_DEFAULT_CHECKSUM_MODE   ETH_CHECKSUM_DMA
+
+#ifdef ETH_INTERRUPT_DRIVEN
+// keep ETH_ISR() away from the TX ring while the main line updates it
+#define ETH_IrqDisable()    do{ PIE2bits.ETHIE = 0; } while(0)
+#define ETH_IrqEnable()     do{ PIE2bits.ETHIE = ethIrqEnabled; } while(0)
+#else
+#define ETH_IrqDisable()
+#define ETH_IrqEnable()
+#endif
 
 #define SetBit( bitField, bitMask )     do{ bitField = bitField | bitMask; } while(0)
 #define ClearBit( bitField, bitMask )   do{ bitField = bitField & (~bitMask); } while(0)
 #define CheckBit( bitField, bitMask )   (bool)(bitField & bitMask)
 
+// Start the transmission of the oldest queued packet, from ETH_Send() and ETH_ServiceEvents().
+// A macro and not a function: XC8 duplicates a function called from both the interrupt
+// and the main line (advisory 1510).
+#define ETH_StartQueued() do{ \
+    if( (ethListSize > 0) && CheckBit(txData[txTail].flags, ETH_TX_QUEUED) ) \
+    { \
+        ClearBit( txData[txTail].flags, ETH_TX_QUEUED);     /* txQueued = false */ \
+        SetBit( txData[txTail].flags, ETH_TX_STARTED); \
+        ETXST = txData[txTail].packetStart; \
+        ETXND = txData[txTail].packetEnd; \
+        NOP(); NOP(); \
+        ECON1bits.TXRTS = 1; /* start sending */ \
+        ethStats.txFrames++; \
+    } \
+} while(0)
+
 //#define ETH_packetReady() eth_data.pktReady
 //#define ETH_linkCheck() eth_data.up
 //#define ETH_linkChanged() eth_data.linkChange
@@ -90,19 +123,28 @@ volatile ethernetDriver_t ethData;
 
 uint8_t ethListSize;
 
+// TX ring: packets are written one after the other in the TX buffer and wrap to TXSTART
+// when a max size frame no longer fits before TXEND, so queued frames never have to be moved.
 static txPacket_t txData[MAX_TX_PACKETS];
 
-static txPacket_t  *pHead;
-static txPacket_t  *pTail;
+static uint8_t txHead;              // newest packet, being written or last queued
+static uint8_t txTail;              // oldest packet, next to transmit or in transmission
+static uint16_t txWriteLimit;       // the packet being written must end before this address
+static uint16_t txStart = RAMSIZE - TX_BUFFER_SIZE;
 
-uint16_t errataTemp __at(0xE7E);   // jira:M8TS-608
+static ethStats_t ethStats;
+#ifdef ETH_INTERRUPT_DRIVEN
+static bool ethIrqEnabled;          // ETH_Init() is done, the ethernet interrupt may run
+#endif
+
+static void ETH_BufferInit(void);
+static void ETH_ServiceEvents(void);
 
-error_msg ETH_SendQueued(void);
-error_msg ETH_Shift_Tx_Packets(void);
+uint16_t errataTemp __at(0xE7E);   // jira:M8TS-608
 
 void ETH_PacketListReset(void);
 txPacket_t* ETH_NewPacket(void);
-void ETH_RemovePacket(txPacket_t* packetHandle);
+void ETH_RemovePacket(void);
 
 /******************************** MAC Address *********************************/
 
@@ -129,6 +171,33 @@ inline void ETH_EdataWrite(uint8_t d)
 }
 
 static uint16_t nextPacketPointer;
+static ethChecksumMode_t checksumMode;
+
+// Running one's complement sum of the TX bytes written since ETH_TxChecksumReset()
+static uint32_t txChecksumSum;
+static bool txChecksumOdd;      // the next byte written is the low byte of a 16 bit word
+
+static inline void ETH_TxChecksumAdd8(uint8_t data)
+{
+    if(txChecksumOdd)
+    {
+        txChecksumSum += data;
+    }
+    else
+    {
+        txChecksumSum += (uint16_t)data << 8;
+    }
+    txChecksumOdd = !txChecksumOdd;
+}
+
+static inline void ETH_TxChecksumAdd16(uint16_t data)
+{
+    if(txChecksumOdd)
+    {
+        data = (data >> 8) | (data << 8);
+    }
+    txChecksumSum += data;
+}
 
 // PHY Read and Write Helper functions
 typedef enum{ PHCON1 = 0, PHSTAT1=0x01, PHCON2=0x10, PHSTAT2=0x11, PHIE=0x12, PHIR=0x13, PHLCON=0x14} phyRegister_t;
@@ -163,6 +232,8 @@ typedef union
 }receiveStatusVector_t;
 
 static receiveStatusVector_t rxPacketStatusVector;
+static uint16_t rxFrameStart;       // RX buffer address of the first byte of the current frame
+static uint16_t rxFrameLength;      // length of the current frame without the FCS
 
 /**
  * Initialize Ethernet Controller
@@ -177,9 +248,16 @@ void ETH_Init(void)
     ethData.up = false; // no link
     ethData.linkChange = false;
 
+#ifdef ETH_INTERRUPT_DRIVEN
+    ethIrqEnabled = false;
+    PIE2bits.ETHIE = 0;
+#endif
+
     ETH_PacketListReset();
+    ETH_ResetStats();
 
     ethData.saveRDPT = 0;
+    checksumMode = ETH_DEFAULT_CHECKSUM_MODE;
     // Initialize RX tracking variables and other control state flags
     nextPacketPointer = RXSTART;
     
@@ -225,18 +303,7 @@ void ETH_Init(void)
 #endif
 
 
-    // Set up TX/RX buffer addresses
-    ETXST = TXSTART; 
-    ETXND = TXEND; 
-    ERXST = RXSTART;
-    ERXND = RXEND;
-
-    // Setup EDATA Pointers
-    ERDPT = RXSTART;
-    EWRPT = TXSTART;
-
-    // Setup RXRDRDPT to a dummy value for the first packet
-    ERXRDPT = RXEND;
+    ETH_BufferInit();
     
     MAMXFL  = MAX_TX_PACKET_SIZE;
 
@@ -252,7 +319,8 @@ void ETH_Init(void)
 
     // Configure the receive filter
 //    ERXFCON = 0b10101001; //UCEN,OR,CRCEN,MPEN,BCEN (unicast,crc,magic packet,broadcast)
-    ERXFCON = 0b10101011; //UCEN,OR,CRCEN,MPEN,BCEN (unicast,crc,magic packet,multicast,broadcast)
+    ETH_HashTableClear();
+    ERXFCON = ETH_DEFAULT_RX_FILTER; //UCEN,OR,CRCEN,MPEN,MCEN,BCEN (unicast,crc,magic packet,multicast,broadcast)
 
     // RXEN enabled
     ECON1=0x04;  
@@ -266,8 +334,92 @@ void ETH_Init(void)
     ETH_CheckLinkUp();//TODO: We check link here and then do NOTHING?
 
     // configure ETHERNET IRQ's
-    EIE = 0b01011001;
+    EIE = 0b01011011; // PKTIE, LINKIE, TXIE, TXERIE, RXERIE
     PHY_Write(PHIE,0x0012);
+
+#ifdef ETH_INTERRUPT_DRIVEN
+    ethIrqEnabled = true;
+    PIR2bits.ETHIF = 0;
+    PIE2bits.ETHIE = 1;
+#endif
+}
+
+/**
+ * Program the RX/TX buffer addresses and reset the RX/TX pointers
+ */
+static void ETH_BufferInit(void)
+{
+    // Set up TX/RX buffer addresses
+    ETXST = TXSTART; 
+    ETXND = TXEND; 
+    ERXST = RXSTART;
+    ERXND = RXEND;
+
+    // Setup EDATA Pointers
+    ERDPT = RXSTART;
+    EWRPT = TXSTART;
+
+    // Setup RXRDRDPT to a dummy value for the first packet
+    ERXRDPT = RXEND;
+
+    nextPacketPointer = RXSTART;
+    txWriteLimit = TXSTART;
+}
+
+/**
+ * Move the boundary between the RX and the TX buffer
+ * The TX buffer takes the top txSize bytes of the packet RAM, the RX buffer the rest.
+ * Allowed before ETH_Init() or while the link is down and no frame is queued for transmit;
+ * frames waiting in the RX buffer are dropped.
+ * @param txSize  size of the TX buffer, even
+ * @return SUCCESS, ERROR if the sizes do not hold a max size frame (MAMXFL), BUFFER_BUSY if the buffers are in use
+ */
+error_msg ETH_SetBufferPartition(uint16_t txSize)
+{
+    uint16_t maxFrame = MAMXFL;
+
+    if( (txSize & 0x0001) || (txSize < (1 + maxFrame + TX_STATUS_VECTOR_SIZE)) ||
+        (txSize > (RAMSIZE - (maxFrame + RX_STATUS_VECTOR_SIZE))) )
+    {
+        return ERROR;
+    }
+
+    if( ethData.up || (ethListSize > 0) || ECON1bits.TXRTS )
+    {
+        return BUFFER_BUSY;
+    }
+
+    txStart = RAMSIZE - txSize;
+
+    if( ECON2 & 0x20u ) // ETHEN, the module is already running
+    {
+        ETH_IrqDisable();
+        ECON1bits.RXEN = 0;
+        while(ESTATbits.RXBUSY);
+        while(EPKTCNT)
+        {
+            ECON2 = ECON2 | 0x40u; // PKTDEC
+        }
+        EIRbits.PKTIF = 0;
+        ethData.pktReady = false;
+
+        ETH_PacketListReset();
+        ETH_BufferInit();
+
+        EIEbits.PKTIE = 1;
+        ECON1bits.RXEN = 1;
+        ETH_IrqEnable();
+    }
+    return SUCCESS;
+}
+
+/**
+ * Get the size of the TX buffer, the RX buffer takes the rest of the packet RAM
+ * @return
+ */
+uint16_t ETH_GetBufferPartition(void)
+{
+    return (uint16_t)(RAMSIZE - txStart);
 }
 
 bool ETH_CheckLinkUp()
@@ -288,47 +440,42 @@ bool ETH_CheckLinkUp()
 }
 
 /**
- * Ethernet Event Handler
+ * Handle the TX/RX events that must not wait for the main loop:
+ * start the next queued frame, latch a received packet and count overflows
+ * Called only by ETH_ISR() with ETH_INTERRUPT_DRIVEN and only by ETH_EventHandler() without it,
+ * so XC8 does not have to duplicate it or the functions it calls.
  */
-void ETH_EventHandler(void)
+static void ETH_ServiceEvents(void)
 {
-    // check for the IRQ Flag
-    PIR2bits.ETHIF = 0;
-
-   if (EIRbits.LINKIF) // something about the link changed.... update the link parameters
-    {
-        PHY_Read(PHIR); // clear the link irq
-
-        ethData.linkChange = true;
-        // recheck for the link state.
-        ETH_CheckLinkUp();//TODO: We check link here and then do NOTHING?
-    }
-
     if(EIRbits.RXERIF) // buffer overflow
     {
         EIRbits.RXERIF = 0;
+        ethStats.rxOverflow++;
     }
 
-    if (EIRbits.TXERIF)
-    {
-        EIRbits.TXERIF = 0;
-    }
-
-    if(EIRbits.TXIF) // finished sending a packet
+    // An aborted transmission raises TXERIF, and usually TXIF with it: handle both at once,
+    // while nothing is transmitting, so that the TX reset never hits the next frame
+    if(EIRbits.TXIF || EIRbits.TXERIF) // finished sending a packet, or the MAC aborted it
     {
         EIRbits.TXIF = 0;
-        ETH_RemovePacket(pTail);
-        if( ethListSize > 0 )
+        if(EIRbits.TXERIF) // the frame is dropped
         {
-            if( EWRPT > TX_BUFFER_MID )
-            {
-                // Shift all the queued packets to the start of the TX Buffer
-                ETH_Shift_Tx_Packets();
-            }
+            EIRbits.TXERIF = 0;
+            ethStats.txAborted++;
+            // reset the transmit logic, TXRTS may stay set after an abort
+            ECON1bits.TXRST = 1;
+            ECON1bits.TXRST = 0;
+            ECON1bits.TXRTS = 0;
+            ESTATbits.TXABRT = 0;
+        }
 
-            // Send the next queued packet
-            ETH_SendQueued();
+        if( (ethListSize > 0) && CheckBit(txData[txTail].flags, ETH_TX_STARTED) )
+        {
+            ETH_RemovePacket();
         }
+
+        // Send the next queued packet
+        ETH_StartQueued();
     }
 
     if (EIRbits.PKTIF) // Packet receive buffer has at least 1 unprocessed packet
@@ -341,6 +488,46 @@ void ETH_EventHandler(void)
     }
 }
 
+/**
+ * Ethernet interrupt, called from the interrupt manager on ETHIF
+ * The link change needs slow PHY accesses and is left to ETH_EventHandler()
+ */
+void ETH_ISR(void)
+{
+#ifdef ETH_INTERRUPT_DRIVEN
+    if (EIRbits.LINKIF)
+    {
+        EIEbits.LINKIE = 0; // ETH_EventHandler() clears the flag and enables it again
+    }
+
+    ETH_ServiceEvents();
+#endif
+    PIR2bits.ETHIF = 0;
+}
+
+/**
+ * Ethernet Event Handler, polled from the main loop
+ * Handles the link changes, and all the other MAC events without ETH_INTERRUPT_DRIVEN
+ */
+void ETH_EventHandler(void)
+{
+   if (EIRbits.LINKIF) // something about the link changed.... update the link parameters
+    {
+        PHY_Read(PHIR); // clear the link irq
+
+        ethData.linkChange = true;
+        // recheck for the link state.
+        ETH_CheckLinkUp();//TODO: We check link here and then do NOTHING?
+        EIEbits.LINKIE = 1;
+    }
+
+#ifndef ETH_INTERRUPT_DRIVEN
+    // check for the IRQ Flag
+    PIR2bits.ETHIF = 0;
+    ETH_ServiceEvents();
+#endif
+}
+
 void ETH_NextPacketUpdate()
 {
 
@@ -357,6 +544,241 @@ void ETH_NextPacketUpdate()
 
     // the checksum is 4 bytes.. so my payload is the byte count less 4.
     rxPacketStatusVector.byteCount -= 4; // I don't care about the frame checksum at the end.    
+
+    rxFrameStart = ERDPT;
+    rxFrameLength = rxPacketStatusVector.byteCount;
+
+    if(rxPacketStatusVector.rxBroadcast)
+    {
+        ethStats.rxBroadcast++;
+    }
+    else if(rxPacketStatusVector.rxMulticast)
+    {
+        ethStats.rxMulticast++;
+    }
+}
+
+/**
+ * Translate an offset in the current RX frame into an RX buffer address
+ * @param offset  offset from the first byte of the frame (destination MAC)
+ * @return the address, wrapped at the end of the RX buffer
+ */
+uint16_t ETH_GetRxAddress(uint16_t offset)
+{
+    uint16_t address = rxFrameStart + offset;
+
+    if( address > RXEND )
+    {
+        address -= (RXEND - RXSTART + 1);
+    }
+    return address;
+}
+
+/**
+ * Get the position of the read pointer in the current RX frame
+ * @param view  offset of the read pointer from the start of the frame and the bytes left after it
+ */
+void ETH_GetRxView(ethRxView_t *view)
+{
+    view->length = rxPacketStatusVector.byteCount;
+    view->offset = rxFrameLength - rxPacketStatusVector.byteCount;
+}
+
+/**
+ * Read 1 byte of the current RX frame without moving the read pointer
+ * @param offset  offset from the start of the frame, see ETH_GetRxView()
+ * @return the byte, 0 and ethData.error set past the end of the frame
+ */
+uint8_t ETH_Peek8(uint16_t offset)
+{
+    uint8_t ret = 0;
+
+    if( ETH_PeekBlock(&ret, offset, sizeof(ret)) == sizeof(ret) )
+    {
+        ethData.error = 0;
+    }
+    else
+    {
+        ethData.error = 1;
+    }
+    return ret;
+}
+
+/**
+ * Read 2 bytes of the current RX frame without moving the read pointer
+ * @param offset  offset from the start of the frame, see ETH_GetRxView()
+ * @return the bytes in host order, 0 and ethData.error set past the end of the frame
+ */
+uint16_t ETH_Peek16(uint16_t offset)
+{
+    uint16_t ret;
+
+    ret = (uint16_t)ETH_Peek8(offset) << 8;
+    if( ethData.error == 0 )
+    {
+        ret |= ETH_Peek8(offset + 1);
+    }
+    return ethData.error ? 0 : ret;
+}
+
+/**
+ * Read a block of the current RX frame without moving the read pointer
+ * @param buffer  destination
+ * @param offset  offset from the start of the frame, see ETH_GetRxView()
+ * @param length  bytes to read
+ * @return number of bytes read, less than length at the end of the frame
+ */
+uint16_t ETH_PeekBlock(void *buffer, uint16_t offset, uint16_t length)
+{
+    uint16_t rdptr = ERDPT;
+    uint16_t len = 0;
+    char *p = buffer;
+
+    if( offset >= rxFrameLength )
+    {
+        return 0;
+    }
+    if( length > (rxFrameLength - offset) )
+    {
+        length = rxFrameLength - offset;
+    }
+
+    ERDPT = ETH_GetRxAddress(offset);
+    while( len < length )
+    {
+        *p++ = ETH_EdataRead();
+        len++;
+    }
+    ERDPT = rdptr;
+    return len;
+}
+
+/**
+ * Latch the next received packet when the RX buffer holds one
+ * Lets the reader take the next packet without waiting for ETH_EventHandler()
+ * @return true if a packet is ready to be read
+ */
+bool ETH_CheckRxPending(void)
+{
+    ETH_IrqDisable();
+    if( (ethData.pktReady == false) && (EPKTCNT > 0) )
+    {
+        ethData.pktReady = true;
+        EIEbits.PKTIE = 0; // turn off the packet interrupt until this one is handled.
+    }
+    ETH_IrqEnable();
+    return ethData.pktReady;
+}
+
+/**
+ * Select the receive filters, see the ETH_FILTER_ bits
+ * Reception is paused while the filter changes. Program the hash table and the
+ * pattern before they are enabled here.
+ * @param filter  ERXFCON value
+ */
+void ETH_SetRxFilter(uint8_t filter)
+{
+    bool rxEnabled = ECON1bits.RXEN;
+
+    ECON1bits.RXEN = 0;
+    while(ESTATbits.RXBUSY);
+    ERXFCON = filter;
+    ECON1bits.RXEN = rxEnabled;
+}
+
+/**
+ * Get the receive filters in use
+ * @return ERXFCON value
+ */
+uint8_t ETH_GetRxFilter(void)
+{
+    return ERXFCON;
+}
+
+/**
+ * Clear the multicast hash table, the hash filter then rejects all frames
+ */
+void ETH_HashTableClear(void)
+{
+    volatile uint8_t *hashTable = &EHT0;
+    uint8_t index;
+
+    for(index = 0; index < 8; index++)
+    {
+        hashTable[index] = 0;
+    }
+}
+
+/**
+ * Add a destination address to the hash table used by ETH_FILTER_HASH
+ * The MAC hashes bits 28:23 of the CRC-32 of the destination address, so other
+ * addresses with the same hash are received as well.
+ * @param mac  destination address, typically a multicast group
+ */
+void ETH_HashTableAdd(const mac48Address_t *mac)
+{
+    volatile uint8_t *hashTable = &EHT0;
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t index, bit, data;
+
+    for(index = 0; index < sizeof(mac->mac_array); index++)
+    {
+        data = mac->mac_array[index];
+        for(bit = 0; bit < 8; bit++)
+        {
+            if( ((uint8_t)(crc >> 31) ^ data) & 0x01 )
+            {
+                crc = (crc << 1) ^ 0x04C11DB7;
+            }
+            else
+            {
+                crc = crc << 1;
+            }
+            data >>= 1;
+        }
+    }
+
+    // bits 28:26 select the hash table register, bits 25:23 the bit in it
+    index = (uint8_t)(crc >> 26) & 0x07;
+    bit = (uint8_t)(crc >> 23) & 0x07;
+    hashTable[index] |= (uint8_t)(1 << bit);
+}
+
+/**
+ * Program the pattern match filter used by ETH_FILTER_PATTERN
+ * The filter accepts frames whose bytes selected by the mask, in a 64 byte window
+ * starting at offset, have the same checksum as the same bytes of the pattern.
+ * @param offset   frame offset of the window, even
+ * @param mask     8 bytes, bit n of byte m selects window byte 8*m+n
+ * @param pattern  64 bytes, the expected window contents
+ */
+void ETH_SetPatternFilter(uint16_t offset, const uint8_t *mask, const uint8_t *pattern)
+{
+    volatile uint8_t *patternMask = &EPMM0;
+    uint32_t cksm = 0;
+    bool highByte = true;
+    uint8_t index;
+
+    for(index = 0; index < 64; index++)
+    {
+        if( mask[index >> 3] & (1 << (index & 0x07)) )
+        {
+            // the selected bytes are summed as consecutive 16 bit words
+            cksm += highByte ? ((uint16_t)pattern[index] << 8) : pattern[index];
+            highByte = !highByte;
+        }
+    }
+    cksm = (cksm & 0xFFFF) + (cksm >> 16);
+    cksm = (cksm & 0xFFFF) + (cksm >> 16);
+    cksm = ~cksm;
+
+    for(index = 0; index < 8; index++)
+    {
+        patternMask[index] = mask[index];
+    }
+    EPMCSH = (uint8_t)(cksm >> 8);
+    EPMCSL = (uint8_t)cksm;
+    EPMO = offset;
 }
 
 void ETH_ResetReceiver(void)
@@ -565,6 +987,7 @@ uint16_t ETH_ReadBlock(void *buffer, uint16_t length)
 void ETH_Write8(uint8_t data)
 {
     ETH_EdataWrite(data);
+    ETH_TxChecksumAdd8(data);
 }
 
 /**
@@ -575,6 +998,7 @@ void ETH_Write16(uint16_t data)
 {
     ETH_EdataWrite(data >> 8);
     ETH_EdataWrite(data);
+    ETH_TxChecksumAdd16(data);
 }
 
 /**
@@ -586,6 +1010,8 @@ void ETH_Write24(uint32_t data)
     ETH_EdataWrite(data >> 16);
     ETH_EdataWrite(data >>  8);
     ETH_EdataWrite(data);
+    ETH_TxChecksumAdd8(data >> 16);
+    ETH_TxChecksumAdd16(data);
 }
 
 /**
@@ -598,14 +1024,17 @@ void ETH_Write32(uint32_t data)
     ETH_EdataWrite(data >> 16);
     ETH_EdataWrite(data >>  8);
     ETH_EdataWrite(data);
+    ETH_TxChecksumAdd16(data >> 16);
+    ETH_TxChecksumAdd16(data);
 }
 
 uint16_t ETH_WriteString(const char *string)
 {
     uint16_t length = 0;
-    while(*string && (EWRPT < TXEND))
+    while(*string && (EWRPT < txWriteLimit))
     {
-        ETH_EdataWrite(*string++);
+        ETH_EdataWrite(*string);
+        ETH_TxChecksumAdd8(*string++);
         length ++;
     }
     return length;
@@ -621,9 +1050,10 @@ uint16_t ETH_WriteString(const char *string)
 uint16_t ETH_WriteBlock(const char *buffer, uint16_t length)   // jira:M8TS-608
 {
     const char *p = buffer;
-    while(length-- && (EWRPT < TXEND))
+    while(length-- && (EWRPT < txWriteLimit))
     {
-        ETH_EdataWrite(*p++);
+        ETH_EdataWrite(*p);
+        ETH_TxChecksumAdd8(*p++);
     }
     return length;
 }
@@ -635,7 +1065,7 @@ uint16_t ETH_WriteBlock(const char *buffer, uint16_t length)   // jira:M8TS-608
  */
 uint16_t ETH_GetFreeTxBufferSize(void)
 {
-    return (uint16_t)(TXEND - EWRPT);
+    return (uint16_t)(txWriteLimit - EWRPT);
 }
 
 /**
@@ -654,48 +1084,29 @@ error_msg ETH_WriteStart(const mac48Address_t *dest_mac, uint16_t type)
     }
 
     // If the previous packet was not sent/queued, prevent a second packet creation
-    if( pHead != NULL )
-    {
-        if( pHead->flags & ETH_WRITE_IN_PROGRESS )
-        {
-            return BUFFER_BUSY;
-        }
-    }
-
-    if( EWRPT > TX_BUFFER_MID )
+    if( (ethListSize > 0) && CheckBit(txData[txHead].flags, ETH_WRITE_IN_PROGRESS) )
     {
-        // Need to shift all the queued packets to the start of the TX Buffer
-
-        // Check for TX in progress
-        if(ECON1bits.TXRTS)
-        {
-            return TX_LOGIC_NOT_IDLE;
-        }
-
-        // Try to move the queued packets
-        ETH_Shift_Tx_Packets();
-        
-        // Verify if shift
-        if( EWRPT > TX_BUFFER_MID )
-        {
-            return BUFFER_BUSY;
-        }
+        ethStats.txStallWriteBusy++;
+        return BUFFER_BUSY;
     }
 
     // Create new packet and queue it in the TX Buffer
     
     // Initialize a new packet handler. It is automatically placed in the queue
-    ethPacket = (txPacket_t*)ETH_NewPacket();
+    ETH_IrqDisable();
+    ethPacket = ETH_NewPacket();
+    ETH_IrqEnable();
 
     if( ethPacket == NULL )
     {
-        // No more available packets
+        // No more available packets or no room in the TX ring
         return BUFFER_BUSY;
     }
 
     SetBit(ethPacket->flags, ETH_WRITE_IN_PROGRESS);    // writeInProgress = true;
 
     EWRPT = ethPacket->packetStart; 
+    txWriteLimit = ethPacket->packetStart + 1 + MAX_TX_PACKET_SIZE;
 
     ETH_ResetByteCount();
 
@@ -716,6 +1127,8 @@ error_msg ETH_WriteStart(const mac48Address_t *dest_mac, uint16_t type)
     ETH_EdataWrite(((char *)&type)[1]);
     ETH_EdataWrite(((char *)&type)[0]);
 
+    ETH_TxChecksumReset();
+
     return SUCCESS;
 }
 
@@ -725,7 +1138,10 @@ void ETH_TxReset(void) //TODO Test and Fix
     ETXST = TXSTART; 
     EWRPT = TXSTART; 
 
+    ETH_IrqDisable();
     ETH_PacketListReset();
+    ETH_IrqEnable();
+    txWriteLimit = TXSTART;
 }
 
 /**
@@ -734,56 +1150,39 @@ void ETH_TxReset(void) //TODO Test and Fix
  */
 error_msg ETH_Send(void)
 {
-    uint16_t packetEnd = EWRPT - 1;
+    txPacket_t *ethPacket;
 
     if( !ethData.up )
     {
         return LINK_NOT_FOUND;
     }
 
-    if( ethListSize == 0 )
+    ethPacket = &txData[txHead];
+    if( (ethListSize == 0) || !CheckBit(ethPacket->flags, ETH_WRITE_IN_PROGRESS) )
     {
         return BUFFER_BUSY; // This is a false message.
     }
 
-    ClearBit( pHead->flags, ETH_WRITE_IN_PROGRESS);     // writeInProgress = false
-    pHead->packetEnd = packetEnd;
-    SetBit( pHead->flags, ETH_TX_QUEUED);               // txQueued = true
+    ethPacket->packetEnd = EWRPT - 1;
+
+    ETH_IrqDisable();
+    ClearBit( ethPacket->flags, ETH_WRITE_IN_PROGRESS);     // writeInProgress = false
+    SetBit( ethPacket->flags, ETH_TX_QUEUED);               // txQueued = true
     // The packet is prepared to be sent / queued at this time
 
-    if( (ECON1bits.TXRTS) || (ethListSize > 1) )
+    if( !ECON1bits.TXRTS )
     {
-        return TX_QUEUED;
+        ETH_StartQueued();
     }
 
-    return ETH_SendQueued();
-}
-
-
-/**
- * Enqueue the latest written packet and start the transmission of a queued packet
- * @return
- */
-error_msg ETH_SendQueued(void)
-{
-    if( pHead->flags & ETH_TX_QUEUED )
-    {
-            // "Close" the latest written packet and enqueue it
-        ClearBit( pHead->flags, ETH_TX_QUEUED);         // txQueued = false
-
-            // Start transmitting from the tails - the packet first written
-        ETXST = pTail->packetStart;
-        ETXND = pTail->packetEnd;
-
-        NOP(); NOP();
-        ECON1bits.TXRTS = 1; // start sending
-
-        return SUCCESS;
-    }
-    else
+    if( CheckBit(ethPacket->flags, ETH_TX_QUEUED) )
     {
-        return BUFFER_BUSY;
+        ethStats.txBusy++;
+        ETH_IrqEnable();
+        return TX_QUEUED;
     }
+    ETH_IrqEnable();
+    return SUCCESS;
 }
 
 
@@ -796,7 +1195,7 @@ error_msg ETH_SendQueued(void)
 void ETH_Insert(char *data, uint16_t len, uint16_t offset)  // jira:M8TS-608
 {
     uint16_t current_tx_ptr = EWRPT;
-    EWRPT = pHead->packetStart + offset + 1; // we need +1 here because of SFD.
+    EWRPT = txData[txHead].packetStart + offset + 1; // we need +1 here because of SFD.
     while(len--)
     {
         ETH_EdataWrite(*data++);
@@ -810,11 +1209,18 @@ void ETH_Insert(char *data, uint16_t len, uint16_t offset)  // jira:M8TS-608
  */
 void ETH_Dump(uint16_t length)
 {
+    uint16_t rdptr;
+
     length = (rxPacketStatusVector.byteCount <= length) ? rxPacketStatusVector.byteCount : length;
     if (length)
     {
-        //Write new RX tail
-        ERDPT += length;
+        //Write new RX tail, the frame may wrap at the end of the RX buffer
+        rdptr = ERDPT + length;
+        if( rdptr > RXEND )
+        {
+            rdptr -= (RXEND - RXSTART + 1);
+        }
+        ERDPT = rdptr;
         rxPacketStatusVector.byteCount -= length;
     }
 }
@@ -824,6 +1230,8 @@ void ETH_Dump(uint16_t length)
  */
 void ETH_Flush(void)
 {
+    // a TX interrupt in between would see PKTIF and latch this packet again
+    ETH_IrqDisable();
     ethData.pktReady = false;
     // Need to decrement the packet counter
     ECON2 = ECON2 | 0x40u; // PKTDEC  //jira: CAE_MCU8-5647
@@ -839,6 +1247,7 @@ void ETH_Flush(void)
         ERXRDPT = nextPacketPointer - 1;
 
     EIEbits.PKTIE = 1; // turn on the packet interrupt to get the next one.
+    ETH_IrqEnable();
 }
 
 //#define ETH_SIMPLE_COPY
@@ -860,24 +1269,6 @@ error_msg ETH_Copy(uint16_t len)
     return 1;
 }
 
-error_msg ETH_Shift_Tx_Packets(void)
-{
-    uint16_t tmp_len;
-    uint16_t len = ETH_GetByteCount();
-
-    EDMAST  = pTail->packetStart; // setup the source pointer from the current read pointer
-    EDMAND  = pHead->packetEnd;
-
-    tmp_len  = len;
-
-    while(tmp_len--)
-    {
-        asm("movff EDATA,_errataTemp");
-        asm("movff _errataTemp,EDATA");
-    }
-    return 1;
-}
-
 #else
 /**
  * Copy the data from RX Buffer to the TX Buffer using DMA setup
@@ -923,55 +1314,67 @@ error_msg ETH_Copy(uint16_t len)
     RESET(); // reboot for now
     return DMA_TIMEOUT;
 }
+#endif
+
+void ETH_SetChecksumMode(ethChecksumMode_t mode)
+{
+    checksumMode = mode;
+}
+
+ethChecksumMode_t ETH_GetChecksumMode(void)
+{
+    return checksumMode;
+}
 
 /**
- * Copy all the queued packets to the TX Buffer start address using DMA setup
- * @param 
- * @return
+ * Compute the checksum of len bytes starting at start with the DMA checksum engine
+ * The range may wrap around the end of the RX buffer, the DMA follows the RX wrap.
+ * @param start
+ * @param len
+ * @param seed
+ * @param cksm  checksum in the ETH_ComputeChecksum format
+ * @return SUCCESS, or ERROR if the DMA is not available and the software path must be used
  */
-error_msg ETH_Shift_Tx_Packets(void)
+static error_msg ETH_DmaComputeChecksum(uint16_t start, uint16_t len, uint16_t seed, uint16_t *cksm)
 {
     uint16_t timer;
-    uint16_t len = pHead->packetEnd - pTail->packetStart;
+    uint16_t end;
+    uint32_t sum;
 
-    timer = 2 * len;
-    while(ECON1bits.DMAST!=0 && --timer) NOP(); // sit here until DMA is free
-    if(ECON1bits.DMAST==0)
+    if((len == 0) || ECON1bits.DMAST)
     {
-        EDMADST = TXSTART; // setup the destination start pointer
-
-        EDMAST  = pTail->packetStart; // setup the source pointer from the current read pointer
-        EDMAND  = pHead->packetEnd;
-
-        ECON1bits.CSUMEN = 0; // copy mode
-        ECON1bits.DMAST  = 1; // start dma
-        /* sometimes it takes longer to complete if there is heavy network traffic */
-        timer = 40 * len;
-        while(ECON1bits.DMAST!=0 && --timer) NOP(); // sit here until DMA is free
-        if(ECON1bits.DMAST == 0)
-        {
-            // Update the start and end addresses of each packet
-            txPacket_t  *pElem = pHead;
-            uint16_t shiftOffset = pTail->packetStart;
+        return ERROR;
+    }
 
-            while( pElem != NULL )
-            {
-                pElem->packetStart = pElem->packetStart - shiftOffset;
-                pElem->packetEnd = pElem->packetEnd - shiftOffset;
-                pElem = pElem->nextPacket;
-            }
+    end = start + len - 1; // J60 DMA uses an inclusive end pointer
+    if((start <= RXEND) && (end > RXEND))
+    {
+        end = end - (RXEND - RXSTART + 1);
+    }
 
-            // Update the EWRPT
-            EWRPT = TXSTART + len;
-            return SUCCESS;
-        }
+    EDMAST = start;
+    EDMAND = end;
+    ECON1bits.CSUMEN = 1; // checksum mode
+    ECON1bits.DMAST  = 1; // start dma
+    timer = 40 * len;
+    while(ECON1bits.DMAST!=0 && --timer) NOP(); // sit here until DMA is free
+    ECON1bits.CSUMEN = 0;
+    if(ECON1bits.DMAST != 0)
+    {
+        ECON1bits.DMAST = 0;
+        return ERROR;
     }
 
-    // if we are here. the DMA timed out.
-    RESET(); // reboot for now
-    return DMA_TIMEOUT;
+    // EDMACS holds the inverted sum, high byte first; add the seed in one's complement
+    sum = ((uint16_t)EDMACSH << 8) | EDMACSL;
+    sum = (uint16_t)~sum;
+    sum += seed;
+    sum = (sum & 0x0FFFF) + (sum>>16);
+    sum = (sum & 0x0FFFF) + (sum>>16);
+
+    *cksm = (uint16_t)~sum;
+    return SUCCESS;
 }
-#endif
 
 static uint16_t ETH_ComputeChecksum(uint16_t len, uint16_t seed)
 {
@@ -1011,7 +1414,7 @@ static uint16_t ETH_ComputeChecksum(uint16_t len, uint16_t seed)
 }
 
 /**
- * Calculate the TX Checksum - Software Checksum
+ * Calculate the TX Checksum - DMA or Software Checksum
  * @param position
  * @param len
  * @param seed
@@ -1021,17 +1424,23 @@ uint16_t ETH_TxComputeChecksum(uint16_t position, uint16_t len, uint16_t seed)
 {
     uint16_t rxptr;
     uint16_t cksm;
+    uint16_t start;
+
+    start = txData[txHead].packetStart + position + 1; // we need +1 here because of SFD.
 
-    // Save the read pointer starting address
-    rxptr = ERDPT;
+    if((checksumMode == ETH_CHECKSUM_SOFTWARE) || (ETH_DmaComputeChecksum(start, len, seed, &cksm) != SUCCESS))
+    {
+        // Save the read pointer starting address
+        rxptr = ERDPT;
 
-    // position the read pointer for the checksum
-    ERDPT = pHead->packetStart + position + 1; // we need +1 here because of SFD.
+        // position the read pointer for the checksum
+        ERDPT = start;
 
-    cksm = ETH_ComputeChecksum( len, seed);
-    
-    // Restore old read pointer location
-    ERDPT = rxptr;
+        cksm = ETH_ComputeChecksum( len, seed);
+
+        // Restore old read pointer location
+        ERDPT = rxptr;
+    }
 
     cksm = ((cksm & 0xFF00) >> 8) | ((cksm & 0x00FF) << 8);
     // Return the resulting checksum
@@ -1039,7 +1448,49 @@ uint16_t ETH_TxComputeChecksum(uint16_t position, uint16_t len, uint16_t seed)
 }
 
 /**
- * Calculate RX checksum - Software checksum
+ * Start a new running TX checksum at the current write pointer
+ */
+void ETH_TxChecksumReset(void)
+{
+    txChecksumSum = 0;
+    txChecksumOdd = false;
+}
+
+/**
+ * Add a 16 bit word to the running TX checksum, for fields that are filled in later with ETH_Insert
+ * @param data
+ */
+void ETH_TxChecksumAdd(uint16_t data)
+{
+    txChecksumSum += data;
+}
+
+/**
+ * Finish the running TX checksum of the bytes written since ETH_TxChecksumReset()
+ * @param seed
+ * @return the checksum in the ETH_TxComputeChecksum format, ready for ETH_Insert
+ */
+uint16_t ETH_TxChecksumGet(uint16_t seed)
+{
+    uint32_t cksm;
+
+    cksm = txChecksumSum + seed;
+
+    // wrap the checksum
+    while(cksm >> 16)
+    {
+        cksm = (cksm & 0x0FFFF) + (cksm>>16);
+    }
+
+    // invert the number.
+    cksm = (uint16_t)~cksm;
+
+    cksm = ((cksm & 0xFF00) >> 8) | ((cksm & 0x00FF) << 8);
+    return (uint16_t)cksm;
+}
+
+/**
+ * Calculate RX checksum - DMA or Software checksum
  * @param len
  * @param seed
  * @return
@@ -1047,15 +1498,18 @@ uint16_t ETH_TxComputeChecksum(uint16_t position, uint16_t len, uint16_t seed)
 uint16_t ETH_RxComputeChecksum(uint16_t len, uint16_t seed)
 {
     uint16_t rxptr;
-    uint32_t cksm;
+    uint16_t cksm;
 
-    // Save the read pointer starting address
-    rxptr = ERDPT;
+    if((checksumMode == ETH_CHECKSUM_SOFTWARE) || (ETH_DmaComputeChecksum(ERDPT, len, seed, &cksm) != SUCCESS))
+    {
+        // Save the read pointer starting address
+        rxptr = ERDPT;
 
-    cksm = ETH_ComputeChecksum( len, seed);
-    
-    // Restore old read pointer location
-    ERDPT = rxptr;
+        cksm = ETH_ComputeChecksum( len, seed);
+
+        // Restore old read pointer location
+        ERDPT = rxptr;
+    }
     
     // Return the resulting checksum
     cksm = ((cksm & 0xFF00) >> 8) | ((cksm & 0x00FF) << 8);
@@ -1114,6 +1568,10 @@ void ETH_MoveBackReadPtr(uint16_t offset)
     uint16_t rdptr;
     
     rdptr = ERDPT;
+    if( (rdptr - RXSTART) < offset )
+    {
+        rdptr += (RXEND - RXSTART + 1); // the frame wrapped at the end of the RX buffer
+    }
     ERDPT = rdptr - offset;
     ETH_SetRxByteCount(offset);
   
@@ -1177,133 +1635,127 @@ void ETH_SetStatusVectorByteCount(uint16_t bc)
  */
 void ETH_PacketListReset(void)
 {
-    uint16_t index = 0;
-    uint8_t* ptr = (uint8_t*)txData;
-    ethListSize = 0;
+    uint8_t index = 0;
 
-    pHead = NULL;
-    pTail = NULL;
+    ethListSize = 0;
+    txHead = 0;
+    txTail = 0;
 
-    while( index < (MAX_TX_PACKETS * sizeof(txPacket_t)) )
+    while( index < MAX_TX_PACKETS )
     {
-        ptr[index] = 0;
+        txData[index].flags = 0;
         index++;
     }
 }
 
 /**
- * "Allocate" a new packet element and link it into the chained list
+ * "Allocate" the next packet element of the TX ring
+ * The packet gets room for a max size frame after the newest packet, or at TXSTART if
+ * that room would run past TXEND, as long as it does not reach the oldest packet.
  * @param 
- * @return  packet address
+ * @return  packet address, NULL if there is no free element or no room in the TX buffer
  */
 txPacket_t* ETH_NewPacket(void)
 {
-    uint8_t index = 0;
+    uint16_t start;
+    uint16_t tailStart;
 
     if( ethListSize == MAX_TX_PACKETS )
     {
+        ethStats.txStallNoDescriptor++;
         return NULL;
     }
 
-    while( index < MAX_TX_PACKETS )
+    if( ethListSize == 0 )
     {
-        if( CheckBit(txData[index].flags, ETH_ALLOCATED) == false )
-        {
-            txData[index].flags = 0;                        // reset all flags
-            SetBit(txData[index].flags, ETH_ALLOCATED);     // allocated = true - mark the handle as allocated
-
-            txData[index].packetEnd = TXEND;
+        start = TXSTART;
+    }
+    else
+    {
+        start = txData[txHead].packetEnd + 1 + TX_STATUS_VECTOR_SIZE;
 
-            txData[index].prevPacket = NULL;
-            txData[index].nextPacket = pHead;
+        // Try to keep a 2byte alignment
+        if( start & 0x0001 )
+        {
+            ++ start;
+        }
 
-            if( pHead != NULL )
-            {
-                pHead->prevPacket = &txData[index];
-                txData[index].packetStart = pHead->packetEnd + TX_STATUS_VECTOR_SIZE;
-                    
-                // Try to keep a 2byte alignment
-                if( txData[index].packetStart & 0x0001 )
-                {
-                    // Make sure the end of the packet is odd, so the beginning of the next one is even
-                    ++ txData[index].packetStart;
-                }
-            }
-            else
+        tailStart = txData[txTail].packetStart;
+        if( start > tailStart )
+        {
+            // the free room runs up to TXEND, wrap if a max size frame does not fit
+            if( (start > TXEND) || ((TXEND - start) < (TX_SLOT_SIZE - 1)) )
             {
-                txData[index].packetStart = TXSTART;
-                pTail = (txPacket_t*)&txData[index];
+                start = TXSTART;
             }
-
-            pHead = (txPacket_t*)&txData[index];
-
-            ethListSize ++;
-            return &txData[index];
         }
-        index ++;
+        if( (start <= tailStart) && ((tailStart - start) < TX_SLOT_SIZE) )
+        {
+            ethStats.txStallNoSpace++;
+            return NULL;
+        }
+        txHead = (uint8_t)((txHead + 1) % MAX_TX_PACKETS);
     }
 
-    return NULL;
+    txData[txHead].flags = 0;                        // reset all flags
+    txData[txHead].packetStart = start;
+    txData[txHead].packetEnd = start + TX_SLOT_SIZE - TX_STATUS_VECTOR_SIZE - 1;
+
+    ethListSize ++;
+    if( ethListSize > ethStats.txQueueDepthMax )
+    {
+        ethStats.txQueueDepthMax = ethListSize;
+    }
+    return &txData[txHead];
 }
 
 /**
- * Unlink a packet element from the chained list and "deallocate" it
- * @param   packetHandle
+ * Release the oldest packet element of the TX ring
+ * @param
  * @return 
  */
-void ETH_RemovePacket(txPacket_t* pPacket)
+void ETH_RemovePacket(void)
 {
-#ifdef VALIDATE_ALLOCATED_PTR
-    uint8_t index = 0;
-#endif /* VALIDATE_ALLOCATED_PTR */
-
-    if( (pPacket == NULL) || (ethListSize == 0) )
+    if( ethListSize == 0 )
     {
         return;
     }
 
-#ifdef VALIDATE_ALLOCATED_PTR
-    while( index < MAX_TX_PACKETS )
+    txData[txTail].flags = 0;
+    ethListSize --;
+    if( ethListSize > 0 )
     {
-        if( (pPacket == &txData[index]) && (txData[index].allocated == true) )
-        {
-            break;
-        }
-        index ++;
+        txTail = (uint8_t)((txTail + 1) % MAX_TX_PACKETS);
     }
-    if( index == MAX_TX_PACKETS )
+    else
     {
-        return;
+        txTail = txHead;
     }
-#endif  /* VALIDATE_ALLOCATED_PTR */
+}
 
-    // Unlink from the chained list
-    if( pPacket->nextPacket == NULL )
-    {
-        pTail = pPacket->prevPacket;
-        if( pTail != NULL )
-        {
-            pTail->nextPacket = NULL;
-        }
-    }
+/**
+ * Get the driver statistics
+ * @return
+ */
+const ethStats_t *ETH_GetStats(void)
+{
+    ethStats.txQueueDepth = ethListSize;
+    return &ethStats;
+}
 
-    if( pPacket->prevPacket == NULL )
+/**
+ * Clear the driver statistics
+ */
+void ETH_ResetStats(void)
+{
+    uint8_t index = 0;
+    uint8_t* ptr = (uint8_t*)&ethStats;
+
+    ETH_IrqDisable();
+    while( index < sizeof(ethStats) )
     {
-        pHead = pPacket->nextPacket;
-        if( pHead != NULL )
-        {
-            pHead->prevPacket = NULL;
-        }
+        ptr[index] = 0;
+        index++;
     }
-
-    // Deallocate
-    pPacket->flags = 0;
-    pPacket->prevPacket = NULL;
-    pPacket->nextPacket = NULL;
-
-    ethListSize --;
-
-    return;
+    ETH_IrqEnable();
 }
-
-
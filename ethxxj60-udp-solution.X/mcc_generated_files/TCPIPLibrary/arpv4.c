@@ -48,6 +48,7 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 #include "ipv4.h"// needed to know my IP address
 #include "tcpip_config.h"
 #include "ip_database.h"
+#include "timer_wheel.h"
 
 typedef struct
 {
@@ -78,6 +79,8 @@ typedef struct
 mac48Address_t hostMacAddress;
 
 arpMap_t arpMap[ARP_MAP_SIZE]; // maintain a small database of IP address & MAC addresses
+static netTimer_t arpTimer;     // ages the database every ARP_UPDATE_INTERVAL
+static void ARPV4_AgeTimer(void *context);
 
 /**
  * ARP Initialization
@@ -90,6 +93,8 @@ void ARPV4_Init(void)
         ((char *)arpMap)[x] = 0;
     }
     ETH_GetMAC((uint8_t*)&hostMacAddress);    // jira:M8TS-608
+    TIMER_Setup(&arpTimer, ARPV4_AgeTimer, NULL);
+    TIMER_Start(&arpTimer, ARP_UPDATE_INTERVAL);
 }
 
 /**
@@ -168,6 +173,10 @@ error_msg ARPV4_Packet(void)
 
                     
                     ret = ETH_Send(); // remember this could fail to send.
+                    if(ret == SUCCESS || ret == TX_QUEUED)
+                    {
+                        Network_CountTx(NET_PATH_ARP, sizeof(ethernetFrame_t) + sizeof(arpHeader_t));
+                    }
                 }
             }
         }
@@ -193,6 +202,12 @@ void ARPV4_Update(void) // call me every 10 seconds or so and I will age the arp
     }
 }
 
+static void ARPV4_AgeTimer(void *context)
+{
+    ARPV4_Update();
+    TIMER_Start(&arpTimer, ARP_UPDATE_INTERVAL);
+}
+
 /**
  * ARP send Request
  * @param dest_address
@@ -225,6 +240,10 @@ error_msg ARPV4_Request(uint32_t destAddress)
     {
         ETH_WriteBlock((char*)&header,sizeof(arpHeader_t));
         ret = ETH_Send();
+        if(ret == SUCCESS || ret == TX_QUEUED)
+        {
+            Network_CountTx(NET_PATH_ARP, sizeof(ethernetFrame_t) + sizeof(arpHeader_t));
+        }
         if(ret == SUCCESS)
         {
             return MAC_NOT_FOUND;
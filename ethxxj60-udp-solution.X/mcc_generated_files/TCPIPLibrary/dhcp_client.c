@@ -54,6 +54,8 @@ TERMS.
 #include "dhcp_client.h"
 #include "ip_database.h"
 #include "lfsr.h"
+#include "rtcc.h"
+#include "timer_wheel.h"
 
 #ifdef ENABLE_NETWORK_DEBUG
 #define logMsg(msg, msgSeverity, msgLogDest)    logMessage(msg, LOG_DHCP, msgSeverity, msgLogDest)
@@ -71,6 +73,7 @@ TERMS.
 #endif
 
  static mac48Address_t ethMAC;
+static netTimer_t dhcpTimer;
 
 /**
   Section: Enumeration Definition
@@ -203,72 +206,80 @@ bool sendRequest(dhcp_type type)
     return false;
 }
 
+/** Timer wheel handler of the DHCP client, runs every second.
+ *
+ * @param context
+ *      not used
+ *
+ * @return
+ *      None
+ */
+static void DHCP_Timer(void *context)
+{
+    DHCP_Manage();
+    TIMER_Start(&dhcpTimer, RTCC_TICKS_PER_SECOND);
+}
+
 void DHCP_init(void)
 {
     ETH_GetMAC((uint8_t *) &ethMAC);
+    TIMER_Setup(&dhcpTimer, DHCP_Timer, NULL);
+    TIMER_Start(&dhcpTimer, 1);
 }
 
 void DHCP_Manage(void)
 {
-    static time_t managementTimer = 0;    
-    time_t now;
-    now = time(0);
-    
-    if(managementTimer <= now)
+    switch(dhcpState.tmrClientState)
     {
-        switch(dhcpState.tmrClientState)
-        {
-            case INIT_TIMER:
-                dhcpData.t1 = 4;
-                dhcpData.t2 = 2;
-                dhcpState.tmrClientState = WAITFORTIMER;
-                break;
-            case WAITFORTIMER:
-                if(!ETH_CheckLinkUp())
-                {
-                    dhcpData.t1 = 2;
-                    dhcpData.t2 = 4;
-                }
-                if(dhcpData.t1 == 2)
-                {
-                    ipdb_setAddress(0);              
-                    dhcpState.tmrClientState = STARTREQUEST;
-                }
-                else dhcpData.t1 --;
-                if(dhcpData.t2 == 2)
-                {
-                    dhcpState.tmrClientState = STARTDISCOVER;
-                }
-                else dhcpData.t2 --;
-                break;
-            case STARTDISCOVER:
-                if(sendDHCPDISCOVER())
-                {
-                    dhcpData.t2 = 10; // retry in 10 seconds
-                    dhcpData.t1 = LONG_MAX;
-                    dhcpState.rxClientState = SELECTING;
-                    dhcpState.tmrClientState = WAITFORTIMER;                    
-                }
-                break;
-            case STARTREQUEST:
-                if(ETH_CheckLinkUp())
+        case INIT_TIMER:
+            dhcpData.t1 = 4;
+            dhcpData.t2 = 2;
+            dhcpState.tmrClientState = WAITFORTIMER;
+            break;
+        case WAITFORTIMER:
+            if(!ETH_CheckLinkUp())
+            {
+                dhcpData.t1 = 2;
+                dhcpData.t2 = 4;
+            }
+            if(dhcpData.t1 == 2)
+            {
+                ipdb_setAddress(0);              
+                dhcpState.tmrClientState = STARTREQUEST;
+            }
+            else dhcpData.t1 --;
+            if(dhcpData.t2 == 2)
+            {
+                dhcpState.tmrClientState = STARTDISCOVER;
+            }
+            else dhcpData.t2 --;
+            break;
+        case STARTDISCOVER:
+            if(sendDHCPDISCOVER())
+            {
+                dhcpData.t2 = 10; // retry in 10 seconds
+                dhcpData.t1 = LONG_MAX;
+                dhcpState.rxClientState = SELECTING;
+                dhcpState.tmrClientState = WAITFORTIMER;                    
+            }
+            break;
+        case STARTREQUEST:
+            if(ETH_CheckLinkUp())
+            {
+                if(sendDHCPREQUEST())
                 {
-                    if(sendDHCPREQUEST())
-                    {
-                            dhcpData.t1 = 15;
-                        if(dhcpState.rxClientState == BOUND )dhcpState.rxClientState = RENEWLEASE;
-                        else dhcpState.rxClientState = REQUESTING;
-                        dhcpState.tmrClientState = WAITFORTIMER;
-                    }
+                        dhcpData.t1 = 15;
+                    if(dhcpState.rxClientState == BOUND )dhcpState.rxClientState = RENEWLEASE;
+                    else dhcpState.rxClientState = REQUESTING;
+                    dhcpState.tmrClientState = WAITFORTIMER;
                 }
-                break;
-            default:              
-                logMsg("why am I at default", LOG_WARNING, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
-                dhcpState.tmrClientState = INIT_TIMER;
-                break;
-        }
+            }
+            break;
+        default:              
+            logMsg("why am I at default", LOG_WARNING, (LOG_DEST_CONSOLE|LOG_DEST_ETHERNET));
+            dhcpState.tmrClientState = INIT_TIMER;
+            break;
     }
-    managementTimer = now + 1;
 }
 
 void DHCP_Handler(int16_t length)
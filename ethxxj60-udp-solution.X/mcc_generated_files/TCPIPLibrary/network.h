@@ -41,7 +41,9 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 #define	NETWORK_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "tcpip_types.h"
+#include "tcpip_config.h"
 
 #define byteSwap16(a) ((((uint16_t)a & (uint16_t)0xFF00) >> 8) | (((uint16_t)a & (uint16_t)0x00FF) << 8))
 #define byteReverse32(a) ((((uint32_t)a&(uint32_t)0xff000000) >> 24) | \
@@ -67,6 +69,47 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 
 #define convert_hton24(a)  byteReverse24(a)
 
+// Protocol paths tracked by the network statistics
+typedef enum
+{
+    NET_PATH_ARP = 0,
+    NET_PATH_ICMP,
+    NET_PATH_UDP,
+    NET_PATH_TCP,
+    NET_PATH_LLDP,
+    NET_PATH_OTHER,
+    NET_PATH_COUNT
+} networkPath_t;
+
+typedef struct
+{
+    uint32_t rxPackets;     // frames handed to the protocol path
+    uint32_t rxBytes;       // ethernet frame bytes (no FCS) handed to the protocol path
+    uint32_t txPackets;     // frames sent or queued by the protocol path
+    uint32_t txBytes;       // ethernet frame bytes (no FCS) sent or queued by the protocol path
+} networkPathStats_t;
+
+typedef struct
+{
+    uint32_t readCalls;         // Network_Read() calls that found at least one frame
+    uint32_t frames;            // frames handled by Network_Read()
+    uint8_t  framesLastCall;    // frames handled by the last of those calls
+    uint8_t  framesPerCallMax;  // most frames handled by one call
+    uint16_t budgetExhausted;   // calls that stopped at NETWORK_RX_BUDGET with frames still waiting
+    uint16_t rxOverflow;        // RX buffer overflows reported by the driver
+    uint16_t rxMulticast;       // multicast frames accepted by the MAC receive filter
+    uint16_t rxBroadcast;       // broadcast frames accepted by the MAC receive filter
+    uint16_t rxNotForUs;        // frames accepted by the MAC but dropped by the stack as not addressed to this host
+} networkRxStats_t;
+
+#ifdef ENABLE_NETWORK_STATS
+void Network_CountRx(networkPath_t path, uint16_t frameLength);
+void Network_CountTx(networkPath_t path, uint16_t frameLength);
+#else
+#define Network_CountRx(path, frameLength)
+#define Network_CountTx(path, frameLength)
+#endif
+
 
 /*Network Initializer.
  * The function will perform initialization of the network protocols.
@@ -81,7 +124,8 @@ void Network_Init(void);
 
 
 /*Reading Packets.
- * The function will read the packets in the network.
+ * The function will read the packets in the network, up to
+ * NETWORK_RX_BUDGET frames per call.
  * 
  * @param None
  * 
@@ -116,7 +160,85 @@ void Network_Manage(void);
 void Network_WaitForLink(void);
 uint16_t Network_GetStartPosition(void);
 
-void timersInit(void);
+
+/*Join a Multicast Group.
+ * The function will add the group to the MAC hash filter so its frames are received.
+ * 
+ * @param group
+ *      IPv4 multicast address (224.0.0.0 - 239.255.255.255)
+ * 
+ * @param return
+ *      SUCCESS, ERROR if it is not a multicast address, BUFFER_BUSY if the group list is full
+ * 
+ */
+error_msg Network_JoinMulticast(uint32_t group);
+
+
+/*Leave a Multicast Group.
+ * 
+ * @param group
+ *      IPv4 multicast address
+ * 
+ * @param return
+ *      Nothing
+ * 
+ */
+void Network_LeaveMulticast(uint32_t group);
+
+
+/*Check Multicast Membership.
+ * 
+ * @param group
+ *      IPv4 multicast address
+ * 
+ * @param return
+ *      true for the all-hosts group and the joined groups
+ * 
+ */
+bool Network_IsMulticastMember(uint32_t group);
+
+#ifdef ENABLE_NETWORK_STATS
+/*Network Statistics.
+ * The function will return the RX/TX packet and byte counters of a protocol path.
+ * Sampling the counters at two points in time gives the packets/s and bytes/s
+ * of that path.
+ * 
+ * @param path
+ *      Protocol path (NET_PATH_ARP ... NET_PATH_OTHER)
+ * 
+ * @param return
+ *      Pointer to the counters of the path, NULL for an unknown path
+ * 
+ */
+const networkPathStats_t *Network_GetStats(networkPath_t path);
+
+
+/*Network RX Statistics.
+ * The function will return the frames handled per Network_Read() call
+ * and the RX buffer overflows.
+ * 
+ * @param None
+ * 
+ * @param return
+ *      Pointer to the RX counters
+ * 
+ */
+const networkRxStats_t *Network_GetRxStats(void);
+
+
+/*Reset Network Statistics.
+ * The function will clear the counters of all protocol paths.
+ * 
+ * @param None
+ * 
+ * @param return
+ *      Nothing
+ * 
+ */
+void Network_ResetStats(void);
+#endif
+
+void timersInit(void);  // start the timer wheel, called by Network_Init
 
 
 
@@ -60,14 +60,48 @@ typedef struct
 
 typedef struct 
 {
-    uint16_t flags;
+    uint8_t  flags;
     uint16_t packetStart;
     uint16_t packetEnd;
-
-    void    *prevPacket;
-    void    *nextPacket;
 } txPacket_t;
 
+typedef struct
+{
+    uint32_t txFrames;              // frames handed to the MAC for transmission
+    uint16_t txBusy;                // frames that had to wait in the TX ring for a running transmission
+    uint16_t rxOverflow;            // RX buffer overflows (RXERIF), frames were lost
+    uint16_t txAborted;             // transmissions aborted by the MAC (TXERIF), the frames were dropped
+    uint16_t rxMulticast;           // multicast frames accepted by the receive filter
+    uint16_t rxBroadcast;           // broadcast frames accepted by the receive filter
+    uint16_t txStallNoSpace;        // ETH_WriteStart refused: no room for a max size frame in the TX ring
+    uint16_t txStallNoDescriptor;   // ETH_WriteStart refused: all TX packet descriptors in use
+    uint16_t txStallWriteBusy;      // ETH_WriteStart refused: previous frame still being written
+    uint8_t  txQueueDepth;          // frames currently in the TX ring
+    uint8_t  txQueueDepthMax;       // highest number of frames in the TX ring
+} ethStats_t;
+
+typedef struct
+{
+    uint16_t offset;    // read pointer position from the first byte of the RX frame
+    uint16_t length;    // bytes left in the RX frame after the read pointer
+} ethRxView_t;
+
+// receive filters for ETH_SetRxFilter(), the ERXFCON bits
+#define ETH_FILTER_UNICAST      0x80    // frames to the MAC address
+#define ETH_FILTER_AND          0x40    // accept frames that pass all enabled filters, not any of them
+#define ETH_FILTER_CRC          0x20    // reject frames with a bad CRC
+#define ETH_FILTER_PATTERN      0x10    // frames that match the pattern, see ETH_SetPatternFilter()
+#define ETH_FILTER_MAGIC        0x08    // magic packets for the MAC address
+#define ETH_FILTER_HASH         0x04    // frames whose destination is in the hash table, see ETH_HashTableAdd()
+#define ETH_FILTER_MULTICAST    0x02    // all multicast frames
+#define ETH_FILTER_BROADCAST    0x01    // all broadcast frames
+
+typedef enum
+{
+    ETH_CHECKSUM_SOFTWARE = 0,  // read the bytes back through EDATA and add them on the CPU
+    ETH_CHECKSUM_DMA            // use the DMA checksum engine, software if the DMA is busy
+} ethChecksumMode_t;
+
 /******************************** MAC Address *********************************/
 
 typedef union
@@ -95,8 +129,10 @@ extern volatile ethernetDriver_t ethData;
 #define ETH_linkChanged() ethData.linkChange
 
 void ETH_Init(void);            // setup the ethernet and get it running
-void ETH_EventHandler(void);    // Manage the MAC events.  Poll this or put it in the ISR
+void ETH_EventHandler(void);    // Manage the MAC events.  Poll this from the main loop
+void ETH_ISR(void);             // Ethernet interrupt, minimal TX/RX event handling
 void ETH_NextPacketUpdate(void);    // Update the pointers for the next available RX packets
+bool ETH_CheckRxPending(void);  // latch the next RX packet if one is waiting
 void ETH_ResetReceiver(void);   // Reset the receiver
 void ETH_SendSystemReset(void); // Reset the transmitter
 
@@ -107,6 +143,12 @@ uint16_t ETH_Read16(void);               // read 2 bytes and return them in host
 uint32_t ETH_Read24(void);              // read 3 bytes and return them in host order
 uint32_t ETH_Read32(void);               // read 4 bytes and return them in host order
 void ETH_Dump(uint16_t);                 // drop N bytes from a packet (data is lost)
+#define ETH_Skip(length) ETH_Dump(length)  // move the read pointer N bytes forward
+void ETH_GetRxView(ethRxView_t *view);   // read pointer offset and bytes left in the RX frame
+uint8_t ETH_Peek8(uint16_t offset);      // read 1 byte at a frame offset, the read pointer is not moved
+uint16_t ETH_Peek16(uint16_t offset);    // read 2 bytes at a frame offset in host order
+uint16_t ETH_PeekBlock(void *, uint16_t offset, uint16_t length); // read a block at a frame offset
+uint16_t ETH_GetRxAddress(uint16_t offset); // RX buffer address of a frame offset, e.g. as DMA source
 void ETH_Flush(void);                    // drop the rest of this packet and release the buffer
 
 uint16_t ETH_GetFreeTxBufferSize(void);                         // returns the available space size in the TX buffer
@@ -124,6 +166,17 @@ error_msg ETH_Send(void);                                          // Send the T
 
 uint16_t ETH_TxComputeChecksum(uint16_t position, uint16_t len, uint16_t seed); // compute the checksum of len bytes starting with position.
 uint16_t ETH_RxComputeChecksum(uint16_t len, uint16_t seed);
+void ETH_TxChecksumReset(void);                                             // start the running checksum of the written TX bytes
+void ETH_TxChecksumAdd(uint16_t data);                                      // add a word that will be inserted later to the running checksum
+uint16_t ETH_TxChecksumGet(uint16_t seed);                                  // finish the running checksum, same format as ETH_TxComputeChecksum
+void ETH_SetChecksumMode(ethChecksumMode_t mode);                           // select the checksum engine
+ethChecksumMode_t ETH_GetChecksumMode(void);
+
+void ETH_SetRxFilter(uint8_t filter);  // select the receive filters (ETH_FILTER_ bits)
+uint8_t ETH_GetRxFilter(void);
+void ETH_HashTableClear(void);         // remove all addresses from the hash filter
+void ETH_HashTableAdd(const mac48Address_t *mac); // receive this destination with ETH_FILTER_HASH
+void ETH_SetPatternFilter(uint16_t offset, const uint8_t *mask, const uint8_t *pattern); // program ETH_FILTER_PATTERN
 
 void ETH_GetMAC(uint8_t *);            // get the MAC address
 void ETH_SetMAC(uint8_t *);            // set the MAC address
@@ -146,6 +199,10 @@ uint16_t ETH_GetRxByteCount(void);
 bool ETH_CheckLinkUp(void);
 
 void ETH_TxReset(void);
+error_msg ETH_SetBufferPartition(uint16_t txSize); // size the TX buffer, the RX buffer gets the rest of the 8 KB
+uint16_t ETH_GetBufferPartition(void);
+const ethStats_t *ETH_GetStats(void);  // TX queue depth, stall and RX overflow counters
+void ETH_ResetStats(void);
 void ETH_MoveBackReadPtr(uint16_t offset);
 
 #endif	/* PHYSICAL_LAYER_INTERFACE_H */
@@ -29,6 +29,7 @@
 #warning USING TIMER1 FOR TIMEBASE
 
 volatile time_t deviceTime;
+volatile uint32_t deviceTicks;
 volatile bool dirtyTime;
 
 volatile uint16_t seconds_counter;
@@ -40,8 +41,8 @@ volatile uint16_t seconds_counter;
   Description:
     This function configured the basics of a software driven RTCC peripheral.
     It relies upon a periodic TMR1 event to provide time keeping.
-    The Timer 1 clock provides a steady 100kHz time base.
-    0x8000 counts in the TMR1 register will provide a 1HZ tick.
+    Timer 1 overflows every millisecond (RTCC_TICKS_PER_SECOND times
+    per second), deviceTime is incremented once every second.
     CLOCKS_PER_SEC is configured for 1 and all is well.
  
   Precondition:
@@ -60,6 +61,8 @@ volatile uint16_t seconds_counter;
 void rtcc_init(void)
 {
     deviceTime = 1293861600;
+    deviceTicks = 0;
+    seconds_counter = 0;
     TMR1_SetInterruptHandler(rtcc_handler);
 }
 
@@ -68,13 +71,14 @@ void rtcc_init(void)
     void rtcc_handler(void) (TMR1 version)
 
   Summary:
-    maintain deviceTime (seconds) using the LCDIF flag/interrupt.
+    maintain deviceTicks (milliseconds) and deviceTime (seconds).
 
   Description:
-    This function decrements seconds_counter until 0 and then increments deviceTime.
-    seconds_counter reloads with CLOCK_PER_SEC.
+    This function increments deviceTicks and seconds_counter on each call.
+    When seconds_counter reaches RTCC_TICKS_PER_SECOND it restarts from 0
+    and deviceTime is incremented.
     This version of the function uses Timer 1 as the time base.
-    Timer 1 is reloaded with 0x8000 to cause TMR1IF to overflow every second.
+    Timer 1 is reloaded to cause TMR1IF to overflow every millisecond.
  
   Precondition:
     None
@@ -92,7 +96,12 @@ void rtcc_init(void)
 
 void rtcc_handler(void)
 {
-	deviceTime++;
+    deviceTicks++;
+    if(++seconds_counter >= RTCC_TICKS_PER_SECOND)
+    {
+        seconds_counter = 0;
+        deviceTime++;
+    }
 }
 
 
@@ -129,6 +138,44 @@ void rtcc_set(time_t *t)
     deviceTime = *t;
     GIE = gie_val;
 }
+/****************************************************************************
+  Function:
+    uint32_t rtcc_getTicks(void)
+
+  Summary:
+    return the number of milliseconds since rtcc_init.
+
+  Description:
+    This function retrieves the millisecond tick counter used by the
+    protocol timers. Interrupts are disabled during the copy and restored
+    on exit.
+
+  Precondition:
+    None
+
+  Parameters:
+    None
+
+  Returns:
+    uint32_t value of the tick counter, it wraps after about 49 days.
+
+  Remarks:
+    Use differences between two values, they stay correct across the wrap.
+  ***************************************************************************/
+
+uint32_t rtcc_getTicks(void)
+{
+    bool     gie_val;
+    uint32_t ticks;
+
+    gie_val = (bool)GIE;
+    INTERRUPT_GlobalInterruptDisable();
+    ticks = deviceTicks;
+    GIE = gie_val;
+
+    return ticks;
+}
+
 /****************************************************************************
   Function:
     time_t time(time_t *t)
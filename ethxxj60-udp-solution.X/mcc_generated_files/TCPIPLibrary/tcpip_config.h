@@ -56,6 +56,7 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 
 /******************************** ARP Protocol Defines *********************************/
 #define ARP_MAP_SIZE 8
+#define ARP_UPDATE_INTERVAL (10000u)    // ms between two agings of the ARP table
 
 
 /******************************** DHCP Protocol Defines ********************************/
@@ -72,19 +73,63 @@ extern const char dhcpName[];
 /******************************** TCP Protocol Defines *********************************/
 // Define the maximum segment size for the 
 #define TCP_MAX_SEG_SIZE    1460u
-#define TICK_SECOND 1
+#define TICK_SECOND 1000u                                   // TCP timers count milliseconds (rtcc_getTicks)
 
 // TCP Timeout and retransmit numbers
-#define TCP_START_TIMEOUT_VAL           ((unsigned long)TICK_SECOND*2)	// Timeout to retransmit unacked data
+#define TCP_START_TIMEOUT_VAL           ((unsigned long)TICK_SECOND*1)	// Timeout to retransmit unacked data before the first RTT sample (RFC 6298)
+#define TCP_MIN_RTO                     (TICK_SECOND/5u)    // Lower limit of the retransmission timeout computed from the RTT
+#define TCP_MAX_RTO                     (TICK_SECOND*60u)   // Upper limit of the retransmission timeout, also after the backoff
 
 #define TCP_MAX_RETRIES                 (5u)                // Maximum number of retransmission attempts
 #define TCP_MAX_SYN_RETRIES             (3u)                // Smaller than all other retries to reduce SYN flood DoS duration
+#define TCP_SYN_CACHE_SIZE              (0u)                // Half-open connections of the listening sockets without a backlog, 0: the listening socket takes the first SYN
+#define TCP_ENABLE_SYN_COOKIES                              // a full SYN cache or backlog answers SYNs with a SYN cookie (RFC 4987), no state is kept until the ACK
+
+// Largest congestion window: unacknowledged bytes in flight on a connection, the remote window limits it further
+#define TCP_MAX_TX_WINDOW               (4u * TCP_MAX_SEG_SIZE)
+#define TCP_DUP_ACK_THRESHOLD           (3u)                // Duplicate ACKs that start a fast retransmit (RFC 5681)
+#define TCP_DELAYED_ACK_TIMEOUT         (TICK_SECOND/25u)   // Longest delay of the ACK for received data (RFC 1122 allows up to 500 ms)
+#define TCP_DELAYED_ACK_SEGMENTS        (2u)                // Received segments that are acknowledged at once
+
+// Parts of the socket (tcpTCB_t) that an application can leave out to save RAM
+//#define TCP_ENABLE_OOO_QUEUE                              // keep out of order segments (TCP_SetOooQueue), 8 bytes per socket
+//#define TCP_ENABLE_KEEPALIVE                              // probe idle connections (TCP_SetKeepAlive), 18 bytes per socket
+//#define TCP_ENABLE_STATS                                  // receive and congestion counters (TCP_GetRxStats, TCP_GetTxStats), 36 bytes per socket
+
+// TCP options offered in the SYN (RFC 7323), a connection uses them when the remote offers them too
+#define TCP_ENABLE_WINDOW_SCALE                             // the remote may announce windows above 64 KB, they are limited to 64 KB
+#define TCP_ENABLE_TIMESTAMPS                               // RTT sample on each ACK, also for retransmissions; costs 12 bytes per segment
+// Selective acknowledgements (RFC 2018): only the missing bytes are retransmitted. With a TX window of
+// 4 segments the duplicate ACKs already find each loss, SACK pays off from about 16 segments
+// (TCP_MAX_TX_WINDOW), 8 ranges and 24 KB of RX memory, see host/bench/tcpsack.c
+//#define TCP_ENABLE_SACK
+#define TCP_SACK_SCOREBOARD_SIZE        (2u)                // SACKed ranges kept per socket, 4 bytes each; TCP_MAX_TX_WINDOW holds 4 segments: at most 2 ranges
+
+#define TCP_SOCKET_HASH_SIZE            (4u)                // Slots of the socket lookup table, a power of 2 larger than the number of sockets
+#define TCP_SOCKET_POOL_SIZE            (0u)                // Sockets owned by the stack for TCP_SocketAlloc(), at most 15, 0 removes the pool
 
 #define LOCAL_TCP_PORT_START_NUMBER     (1024u)             // define the lower port number to be used as a local port
 #define LOCAL_TCP_PORT_END_NUMBER       (65535u)            // define the highest port number to be used as a local port
 
 /************************ Neighbor Discovery Protocol Defines **************************/
 
+/******************************** Ethernet Driver Defines *********************************/
+// Start queued TX frames and latch RX packets from the ethernet interrupt (ETH_ISR),
+// comment out to handle all MAC events from ETH_EventHandler() in the main loop
+#define ETH_INTERRUPT_DRIVEN
+
+// Maximum number of received frames handled by one Network_Read() call
+#define NETWORK_RX_BUDGET   (4u)
+
+// Receive only the multicast groups in use (all-hosts, LLDP and the groups joined with
+// Network_JoinMulticast) through the MAC hash filter, comment out to receive all multicast
+#define NETWORK_MULTICAST_FILTER
+#define NETWORK_MULTICAST_GROUPS    (4u)
+
+/******************************** Network Statistics Defines *********************************/
+// Per protocol path RX/TX packet and byte counters (see Network_GetStats)
+#define ENABLE_NETWORK_STATS
+
 /******************************** TCP/IP stack debug Defines *********************************/
 
 //#define ENABLE_TCP_DEBUG
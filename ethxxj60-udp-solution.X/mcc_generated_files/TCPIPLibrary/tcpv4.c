@@ -48,10 +48,36 @@ MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TER
 #include "log.h"
 #include "tcpip_config.h"
 #include "icmp.h"
+#include "rtcc.h"
+#include "timer_wheel.h"
+#include "../tmr1.h"
 tcpTCB_t *tcbList;
 socklistsize_t tcbListSize;
 tcpTCB_t *currentTCB;
 
+// open addressing table of the sockets, keyed on remote IP, remote port and local port
+static tcpTCB_t *tcbHash[TCP_SOCKET_HASH_SIZE];
+static tcpTCB_t *lastHitTCB;    // socket of the last received segment
+
+#if TCP_SOCKET_POOL_SIZE > 0
+// sockets owned by the stack, handed out by TCP_SocketAlloc()
+static tcpTCB_t tcbPool[TCP_SOCKET_POOL_SIZE];
+static uint8_t poolFree[TCP_SOCKET_POOL_SIZE];          // stack of the free pool indexes
+static uint8_t poolFreeCount;
+static uint8_t poolGeneration[TCP_SOCKET_POOL_SIZE];    // changes each time the socket is handed out
+static bool poolAllocated[TCP_SOCKET_POOL_SIZE];
+#endif
+static tcpPoolStats_t poolStats;
+#ifdef TCP_ENABLE_KEEPALIVE
+static uint16_t keepAliveReclaims;  // connections closed after unanswered keep-alive probes
+#endif
+static tcpSynStats_t synStats;
+#if TCP_SYN_CACHE_SIZE > 0
+// half-open connections of the listening sockets without a backlog
+static tcpBacklogEntry_t synCache[TCP_SYN_CACHE_SIZE];
+static netTimer_t synCacheTimer;
+#endif
+
 static tcpHeader_t tcpHeader;
 static uint16_t nextAvailablePort;
 static uint32_t nextSequenceNumber;
@@ -59,13 +85,91 @@ static uint32_t nextSequenceNumber;
 static uint32_t receivedRemoteAddress;
 static uint16_t rcvPayloadLen;
 static uint16_t tcpMss = 536;
+static uint8_t tcpWndScale;         // window scale option of the received SYN, TCP_NO_WND_SCALE without it
+static bool tcpTsPresent;           // the received segment carries the timestamps option
+static uint32_t tcpTsVal;
+static uint32_t tcpTsEcr;
+
+// sequence number comparisons that survive the 32 bit wrap
+#define TCP_SEQ_LT(a, b)    ((int32_t)((uint32_t)(a) - (uint32_t)(b)) < 0)
+
+// longer RTT samples are limited to keep the scaled SRTT in 16 bits
+#define TCP_MAX_RTT_SAMPLE  (8000u)
+
+#define TCP_SOCKET_HASH_MASK    (TCP_SOCKET_HASH_SIZE - 1u)
+
+// RFC 7323 options of a connection (options in tcpTCB_t)
+#define TCP_OPT_WND_SCALE       (0x01u)
+#define TCP_OPT_TIMESTAMPS      (0x02u)
+#define TCP_OPT_SACK            (0x04u)
+#ifdef TCP_ENABLE_WINDOW_SCALE
+#define TCP_OFFER_WND_SCALE     TCP_OPT_WND_SCALE
+#else
+#define TCP_OFFER_WND_SCALE     (0u)
+#endif
+#ifdef TCP_ENABLE_TIMESTAMPS
+#define TCP_OFFER_TIMESTAMPS    TCP_OPT_TIMESTAMPS
+#else
+#define TCP_OFFER_TIMESTAMPS    (0u)
+#endif
+#ifdef TCP_ENABLE_SACK
+#define TCP_OFFER_SACK          TCP_OPT_SACK
+#else
+#define TCP_OFFER_SACK          (0u)
+#endif
+#define TCP_OPT_OFFERED         (TCP_OFFER_WND_SCALE | TCP_OFFER_TIMESTAMPS | TCP_OFFER_SACK)
+
+// the sockets keep the window scale and the timestamp only when the stack offers them
+#ifdef TCP_ENABLE_WINDOW_SCALE
+#define TCP_SND_SCALE(tcbPtr)   ((tcbPtr)->sndScale)
+#else
+#define TCP_SND_SCALE(tcbPtr)   (0u)
+#endif
+#ifdef TCP_ENABLE_TIMESTAMPS
+#define TCP_TS_RECENT(tcbPtr)   ((tcbPtr)->tsRecent)
+#else
+#define TCP_TS_RECENT(tcbPtr)   (0ul)
+#endif
+
+// per socket counters, see TCP_GetRxStats() and TCP_GetTxStats()
+#ifdef TCP_ENABLE_STATS
+#define TCP_CountRx(tcbPtr, counter)        ((tcbPtr)->rxStats.counter++)
+#define TCP_CountRxBytes(tcbPtr, length)    ((tcbPtr)->rxStats.bytesReceived += (length))
+#define TCP_CountTx(tcbPtr, counter)        ((tcbPtr)->txStats.counter++)
+#else
+#define TCP_CountRx(tcbPtr, counter)
+#define TCP_CountRxBytes(tcbPtr, length)
+#define TCP_CountTx(tcbPtr, counter)
+#endif
+
+#define TCP_NO_WND_SCALE        (0xFFu)
+#define TCP_MAX_WND_SCALE       (14u)   // larger shifts are taken as 14 (RFC 7323 2.3)
+#define TCP_MSS_OPTION_SIZE     (4u)
+#define TCP_WS_OPTION_SIZE      (4u)    // NOP and window scale
+#define TCP_TS_OPTION_SIZE      (12u)   // 2 NOPs and timestamps
+#define TCP_SACK_PERM_OPTION_SIZE (4u)  // 2 NOPs and SACK permitted
+#define TCP_SACK_OPTION_SIZE    (4u)    // 2 NOPs, kind and length, the blocks follow
+#define TCP_SACK_BLOCK_SIZE     (8u)
+#define TCP_MAX_SACK_BLOCKS     (4u)    // 36 of the 40 option bytes, 3 blocks with the timestamps
+
+static bool tcpSackPermitted;       // the received SYN offers SACK
+#ifdef TCP_ENABLE_SACK
+static tcpOooRange_t tcpSackBlocks[TCP_MAX_SACK_BLOCKS];    // SACK blocks of the received segment
+static uint8_t tcpSackCount;
+#endif
 
-//jira: CAE_MCU8-6056
-static uint16_t tcpDataLength;
-static uint16_t bytesToSendForRetransmit = 0;
-static uint8_t *txBufferPtrForRetransmit;
-static uint32_t localSeqnoForRetransmit;
-static uint32_t lastAckNumber;
+#ifdef TCP_ENABLE_SYN_COOKIES
+// SYN cookie (ISS of the SYN+ACK): hash of the connection (bits 31-4), time slot (bits 3-2), MSS index (bits 1-0)
+#define TCP_COOKIE_HASH_MASK    (0xFFFFFFF0ul)
+#define TCP_COOKIE_SLOT_SHIFT   (2u)
+#define TCP_COOKIE_SLOT_MASK    (0x03u)
+#define TCP_COOKIE_MSS_MASK     (0x03u)
+#define TCP_COOKIE_SLOT_TICKS   (16u)   // a slot is 2^16 ms, a cookie is accepted in its slot and the next one
+static const uint16_t synCookieMss[4] = {536u, 1220u, 1440u, 1460u};
+static uint32_t synCookieEntropy;  // low bits of TMR1 at each received segment
+static uint32_t synCookieSecret[2]; // secret of the current slot and of the previous one, by slot parity
+static uint8_t synCookieSlot[2];    // slot of each secret
+#endif
 
 #ifdef ENABLE_NETWORK_DEBUG
 #define logMsg(msg, msgSeverity, msgLogDest)    logMessage(msg, LOG_KERN, msgSeverity, msgLogDest)  
@@ -75,7 +179,180 @@ static uint32_t lastAckNumber;
 
 static error_msg TCP_FiniteStateMachine(void);  //jira: CAE_MCU8-5647
 
-static error_msg TCP_TimoutRetransmit(void);
+static error_msg TCP_Retransmit(tcpTCB_t *tcbPtr);
+error_msg TCP_PayloadSave(uint16_t len);
+static void TCP_TimerExpired(void *context);
+static void TCP_AckTimerExpired(void *context);
+#ifdef TCP_ENABLE_KEEPALIVE
+static void TCP_KeepAliveExpired(void *context);
+#endif
+#if TCP_SYN_CACHE_SIZE > 0
+static void TCP_SynCacheExpired(void *context);
+#endif
+
+/** Home slot of a connection in the socket lookup table.
+ *
+ * @param remoteIP
+ *      remote IP address, 0 for a listening socket
+ *
+ * @param remotePort
+ *      remote port, 0 for a listening socket
+ *
+ * @param localPort
+ *      local port
+ *
+ * @return
+ *      index in tcbHash
+ */
+static uint8_t TCB_Hash(uint32_t remoteIP, uint16_t remotePort, uint16_t localPort)
+{
+    uint16_t hash;
+
+    hash = (uint16_t)(remoteIP >> 16) ^ (uint16_t)remoteIP ^ remotePort;
+    hash = hash ^ (uint16_t)((localPort << 5) | (localPort >> 11));
+    hash = hash ^ (hash >> 8);
+    return (uint8_t)(hash ^ (hash >> 4)) & (uint8_t)TCP_SOCKET_HASH_MASK;
+}
+
+/** Put a socket in the lookup table under its current remote IP, remote port
+ *  and local port. The caller makes sure that there is a free slot.
+ *
+ * @param ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @return
+ *      None
+ */
+static void TCB_HashAdd(tcpTCB_t *ptr)
+{
+    uint8_t index;
+
+    index = TCB_Hash(ptr->destIP, ptr->destPort, ptr->localPort);
+    while (tcbHash[index] != NULL)
+    {
+        index = (index + 1u) & (uint8_t)TCP_SOCKET_HASH_MASK;
+    }
+    tcbHash[index] = ptr;
+    ptr->hashIndex = index;
+}
+
+/** Take a socket out of the lookup table. The sockets that follow it in the
+ *  probe sequence move back so that no lookup stops at the free slot.
+ *
+ * @param ptr
+ *      pointer to a socket/TCB structure in the table
+ *
+ * @return
+ *      None
+ */
+static void TCB_HashDelete(tcpTCB_t *ptr)
+{
+    uint8_t hole;
+    uint8_t index;
+    uint8_t home;
+    tcpTCB_t *tcbPtr;
+
+    hole = ptr->hashIndex;
+    tcbHash[hole] = NULL;
+    index = hole;
+    for (;;)
+    {
+        index = (index + 1u) & (uint8_t)TCP_SOCKET_HASH_MASK;
+        tcbPtr = tcbHash[index];
+        if (tcbPtr == NULL)
+        {
+            break;
+        }
+        // the socket may move to the hole if its home slot is not between the hole and its slot
+        home = TCB_Hash(tcbPtr->destIP, tcbPtr->destPort, tcbPtr->localPort);
+        if ((uint8_t)((index - home) & TCP_SOCKET_HASH_MASK) >= (uint8_t)((index - hole) & TCP_SOCKET_HASH_MASK))
+        {
+            tcbHash[hole] = tcbPtr;
+            tcbPtr->hashIndex = hole;
+            tcbHash[index] = NULL;
+            hole = index;
+        }
+    }
+    if (lastHitTCB == ptr)
+    {
+        lastHitTCB = NULL;
+    }
+}
+
+/** Search the lookup table for a socket.
+ *
+ * @param remoteIP
+ *      remote IP address, 0 for a listening socket
+ *
+ * @param remotePort
+ *      remote port, 0 for a listening socket
+ *
+ * @param localPort
+ *      local port
+ *
+ * @return
+ *      pointer to the socket, NULL if there is none
+ */
+static tcpTCB_t *TCB_HashFind(uint32_t remoteIP, uint16_t remotePort, uint16_t localPort)
+{
+    uint8_t index;
+    uint8_t count;
+    tcpTCB_t *tcbPtr;
+
+    index = TCB_Hash(remoteIP, remotePort, localPort);
+    for (count = 0; count < TCP_SOCKET_HASH_SIZE; count++)
+    {
+        tcbPtr = tcbHash[index];
+        if (tcbPtr == NULL)
+        {
+            break;
+        }
+        if ((tcbPtr->localPort == localPort) && (tcbPtr->destPort == remotePort) && (tcbPtr->destIP == remoteIP))
+        {
+            return tcbPtr;
+        }
+        index = (index + 1u) & (uint8_t)TCP_SOCKET_HASH_MASK;
+    }
+    return NULL;
+}
+
+/** Check is a pointer to a socket/TCB. If the socket is in its slot of the
+ *  lookup table then it is a valid socket.
+ * 
+ * @param tcbPtr 
+ *      pointer to socket/TCB structure
+ * 
+ * @return
+ *      SUCCESS for a valid socket, ERROR otherwise
+ */
+static error_msg TCB_Check(tcpTCB_t *ptr)   //jira: CAE_MCU8-5647
+{
+    error_msg ret = ERROR;    //jira: CAE_MCU8-5647
+
+    if ((ptr != NULL) && (ptr->hashIndex < TCP_SOCKET_HASH_SIZE) && (tcbHash[ptr->hashIndex] == ptr))
+    {
+        ret = SUCCESS;   //jira: CAE_MCU8-5647
+    }
+    return ret;
+}
+
+/** Move a socket to the slot of its new remote IP, remote port or local port.
+ *  Called each time one of them changes.
+ *
+ * @param ptr
+ *      pointer to the socket/TCB structure
+ *
+ * @return
+ *      None
+ */
+static void TCB_Rehash(tcpTCB_t *ptr)
+{
+    if (TCB_Check(ptr) == SUCCESS)
+    {
+        TCB_HashDelete(ptr);
+        TCB_HashAdd(ptr);
+    }
+}
 
 /** The function will insert a pointer to the new TCB into the TCB pointer list.
  *
@@ -83,10 +360,17 @@ static error_msg TCP_TimoutRetransmit(void);
  *      pointer to the user allocated memory for the TCB structure
  *
  * @return
- *      Status of the function
+ *      ERROR if the socket lookup table is full
  */
-static void TCB_Insert(tcpTCB_t *ptr)
+static error_msg TCB_Insert(tcpTCB_t *ptr)
 {
+    if ((uint8_t)tcbListSize >= (TCP_SOCKET_HASH_SIZE - 1u))
+    {
+        // keep a free slot, a lookup of an unknown connection stops there
+        return ERROR;
+    }
+    TCB_HashAdd(ptr);
+
     // Insert the new TCB at the head of the list.
     // This prevents a list traversal and saves time.
     if(tcbList != NULL)
@@ -98,6 +382,7 @@ static void TCB_Insert(tcpTCB_t *ptr)
     tcbList = ptr;           // put this tcb at the head of the list.
     ptr->prevTCB = NULL;     // make sure that the upstream pointer is empty
     tcbListSize ++;
+    return SUCCESS;
 }
 
 /** The function will remove a pointer to a TCB from the TCB pointer list
@@ -111,16 +396,21 @@ static void TCB_Insert(tcpTCB_t *ptr)
  */
 static void TCB_Remove(tcpTCB_t *ptr)
 {
+    TCB_HashDelete(ptr);
+
     if(tcbListSize > 1)
     {
         // check if this is the first in list
         if(ptr->prevTCB == NULL)
         {
             tcbList = ptr->nextTCB;
-            ((tcpTCB_t *)(ptr->nextTCB))->prevTCB = NULL;
         } else
         {
             ((tcpTCB_t *)(ptr->prevTCB))->nextTCB = ptr->nextTCB;
+        }
+        // the last TCB in the list has no downstream neighbour
+        if(ptr->nextTCB != NULL)
+        {
             ((tcpTCB_t *)(ptr->nextTCB))->prevTCB = ptr->prevTCB;
         }
         tcbListSize --;
@@ -128,6 +418,7 @@ static void TCB_Remove(tcpTCB_t *ptr)
     else if(tcbListSize==1)
     {
         tcbList = NULL;
+        tcbListSize --;
     }
 }
 
@@ -149,222 +440,2198 @@ static void TCB_Reset(tcpTCB_t *tcbPtr)
     tcbPtr->remoteAck = 0;
     tcbPtr->remoteWnd = 0;
 
-    tcbPtr->timeout = 0;
+    TIMER_Stop(&tcbPtr->timer);
     tcbPtr->timeoutReloadValue = 0;
     tcbPtr->timeoutsCount = 0;
     tcbPtr->flags = 0;
+
+    tcbPtr->srtt = 0;
+    tcbPtr->rttvar = 0;
+    tcbPtr->rto = TCP_START_TIMEOUT_VAL;
+    tcbPtr->rttActive = false;
+    tcbPtr->lastRtt = 0;
+    tcbPtr->rttSamples = 0;
+    tcbPtr->retransmits = 0;
     
+#ifdef TCP_ENABLE_OOO_QUEUE
+    tcbPtr->oooCount = 0;
+#endif
+#ifdef TCP_ENABLE_SACK
+    tcbPtr->sackCount = 0;
+    tcbPtr->sackRexmitNext = 0;
+#endif
+
+    TIMER_Stop(&tcbPtr->ackTimer);
+    tcbPtr->ackPending = 0;
+
+#ifdef TCP_ENABLE_KEEPALIVE
+    TIMER_Stop(&tcbPtr->keepAliveTimer);
+    tcbPtr->keepAliveProbes = 0;
+#endif
+
+    tcbPtr->options = 0;
+#ifdef TCP_ENABLE_WINDOW_SCALE
+    tcbPtr->sndScale = 0;
+#endif
+#ifdef TCP_ENABLE_TIMESTAMPS
+    tcbPtr->tsRecent = 0;
+#endif
+
+    tcbPtr->cwnd = 0;
+    tcbPtr->ssthresh = UINT16_MAX;
+    tcbPtr->dupAcks = 0;
+    tcbPtr->fastRecovery = false;
+
     tcbPtr->localPort = 0;
     tcbPtr->bytesSent = 0;
     tcbPtr->payloadSave = false;
+    tcbPtr->closePending = false;
     tcbPtr->socketState = SOCKET_CLOSING;
+    TCB_Rehash(tcbPtr);
 }
 
-/** Check is a pointer to a socket/TCB. If the pointer is in the TCB list
- *  then it is a valid socket.
+/** Internal function of the TCP Stack. Index in the TX memory of the byte
+ *  that follows the first unacknowledged byte by offset bytes.
  * 
- * @param tcbPtr 
- *      pointer to socket/TCB structure
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param offset
+ *      distance from the first unacknowledged byte, at most the TX memory size
  * 
  * @return
- *      None
+ *      index in txBufferStart
  */
-static error_msg TCB_Check(tcpTCB_t *ptr)   //jira: CAE_MCU8-5647
+static uint16_t TCP_TxIndex(tcpTCB_t *tcbPtr, uint16_t offset)
 {
-    tcpTCB_t *tcbPtr;
-    error_msg ret = ERROR;    //jira: CAE_MCU8-5647
-    socklistsize_t count = 0;
-    
-    if((tcbList != NULL) && (ptr != NULL))
+    uint32_t index;
+
+    index = (uint32_t)tcbPtr->txBufferTail + offset;
+    if (index >= tcbPtr->txBufferSize)
     {
-        // search for ptr into the active TCB/sockets list
-        tcbPtr = tcbList;
-        while((tcbPtr != NULL) && (count < tcbListSize))
-        {
-            if (tcbPtr == ptr)
-            {
-                ret = SUCCESS;   //jira: CAE_MCU8-5647
-                break;
-            }
-            else
-            {
-                tcbPtr = tcbPtr->nextTCB;
-                count ++;
-            }
-        }        
+        index = index - tcbPtr->txBufferSize;
     }
-    return ret;
+    return (uint16_t)index;
 }
 
+/** Internal function of the TCP Stack. MSS announced in a SYN: the RX
+ *  memory is split in equal segments of at most TCP_MAX_SEG_SIZE, so a
+ *  full window is filled without a small segment at its end. The window
+ *  holds a lost segment and the TCP_DUP_ACK_THRESHOLD segments after it,
+ *  their duplicate ACKs start the fast retransmit of the remote instead of
+ *  its time-out. The MSS does not go below the default of RFC 1122, 536.
+ * 
+ * @param rxSize
+ *      size of the RX memory, 0 when none is given yet
+ * 
+ * @return
+ *      MSS in bytes
+ */
+static uint16_t TCP_RxMss(uint16_t rxSize)
+{
+    uint16_t segments;
+    uint16_t mss;
+
+    if (rxSize == 0u)
+    {
+        return TCP_MAX_SEG_SIZE;
+    }
+    segments = (uint16_t)((rxSize + TCP_MAX_SEG_SIZE - 1u) / TCP_MAX_SEG_SIZE);
+    if (segments <= TCP_DUP_ACK_THRESHOLD)
+    {
+        segments = TCP_DUP_ACK_THRESHOLD + 1u;
+    }
+    mss = rxSize / segments;
+    return (mss < 536u) ? 536u : mss;
+}
 
-/** Internal function of the TCP Stack to send an TCP packet.
+/** Internal function of the TCP Stack. Smallest increase of the receive
+ *  window worth announcing: one segment of the remote, see TCP_RxMss(), or
+ *  half of the RX memory.
  * 
  * @param tcbPtr
  *      pointer to the socket/TCB structure
  * 
  * @return
- *      true - The buffer was send successfully
- * @return
- *      false - Send buffer fails.
+ *      number of bytes
  */
-static error_msg TCP_Snd(tcpTCB_t *tcbPtr)   //jira: CAE_MCU8-5647
+static uint16_t TCP_RxWndThreshold(tcpTCB_t *tcbPtr)
 {
-    error_msg ret = ERROR;
-    tcpHeader_t txHeader;
-    uint16_t payloadLength;
-    uint16_t cksm;
-    uint8_t *data;
-
-    txHeader.sourcePort = htons(tcbPtr->localPort);
-    txHeader.destPort = htons(tcbPtr->destPort);
+    uint16_t threshold;
 
-    txHeader.sequenceNumber = htonl(tcbPtr->localSeqno);
+    threshold = TCP_RxMss(tcbPtr->rxBufferSize);
+    if (threshold > (tcbPtr->rxBufferSize / 2u))
+    {
+        threshold = tcbPtr->rxBufferSize / 2u;
+    }
+    return threshold;
+}
 
-    txHeader.ackNumber = htonl(tcbPtr->remoteAck); //ask for next packet
+/** Internal function of the TCP Stack. Window to advertise in the next
+ *  segment. With an RX ring the right edge of the window moves only by
+ *  TCP_RxWndThreshold() bytes or more (RFC 1122 4.2.3.3), so the remote
+ *  does not get a small window after each read and the duplicate ACKs of
+ *  a loss keep the same window.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      window in bytes
+ */
+static uint16_t TCP_RxWindow(tcpTCB_t *tcbPtr)
+{
+    uint32_t edge;
+    uint16_t window;
+
+    window = tcbPtr->localWnd;
+    edge = tcbPtr->remoteAck + window;
+    if ((tcbPtr->rxRing == true) && ((tcbPtr->flags & TCP_SYN_FLAG) == 0u)
+        && !TCP_SEQ_LT(tcbPtr->localWndEdge, tcbPtr->remoteAck) && TCP_SEQ_LT(tcbPtr->localWndEdge, edge)
+        && ((edge - tcbPtr->localWndEdge) < TCP_RxWndThreshold(tcbPtr)))
+    {
+        window = (uint16_t)(tcbPtr->localWndEdge - tcbPtr->remoteAck);
+        edge = tcbPtr->localWndEdge;
+    }
+    tcbPtr->localWndEdge = edge;
+    return window;
+}
 
-    txHeader.ns = 0;          // make sure we clean unused fields
-    txHeader.reserved = 0;    // make sure we clean unused fields
-    txHeader.dataOffset = 5;  // We don't support options for now
-    txHeader.windowSize = htons(tcbPtr->localWnd);
-    txHeader.checksum = 0;
-    txHeader.urgentPtr = 0;
+/** Internal function of the TCP Stack. Number of option bytes of a segment:
+ *  a SYN has the MSS and offers the window scale and SACK, with timestamps
+ *  every segment carries them.
+ * 
+ * @param flags
+ *      TCP flags of the segment
+ * 
+ * @param options
+ *      options of the connection, TCP_OPT_ flags
+ * 
+ * @param sackBlocks
+ *      number of SACK blocks, see TCP_SackBlocks()
+ * 
+ * @return
+ *      size of the options, a multiple of 4
+ */
+static uint8_t TCP_OptionsSize(uint8_t flags, uint8_t options, uint8_t sackBlocks)
+{
+    uint8_t size;
 
-    if ((tcbPtr->flags) & (TCP_SYN_FLAG | TCP_RST_FLAG))
+    size = 0;
+    if (flags & TCP_SYN_FLAG)
     {
-        tcpDataLength = 0; // SYN and RST packets doesn't have any payload
-    } 
-    else if(tcbPtr->payloadSave == true)
+        size = TCP_MSS_OPTION_SIZE;
+        if (options & TCP_OPT_WND_SCALE)
+        {
+            size = size + TCP_WS_OPTION_SIZE;
+        }
+        if (options & TCP_OPT_SACK)
+        {
+            size = size + TCP_SACK_PERM_OPTION_SIZE;
+        }
+    }
+    if (options & TCP_OPT_TIMESTAMPS)
     {
-        tcpDataLength = 0;
-    }else
+        size = size + TCP_TS_OPTION_SIZE;
+    }
+    if (sackBlocks > 0)
     {
-        tcpDataLength = tcbPtr->bytesSent;
+        size = size + TCP_SACK_OPTION_SIZE + sackBlocks * TCP_SACK_BLOCK_SIZE;
+    }
+    return size;
+}
 
-        if (tcpDataLength != 0)
+/** Internal function of the TCP Stack. Write the options of a segment after
+ *  the TCP header, see TCP_OptionsSize().
+ * 
+ * @param flags
+ *      TCP flags of the segment
+ * 
+ * @param options
+ *      options of the connection, TCP_OPT_ flags
+ * 
+ * @param rxSize
+ *      size of the RX memory, for the MSS of a SYN
+ * 
+ * @param tsRecent
+ *      timestamp echoed to the remote
+ * 
+ * @return
+ *      None
+ */
+static void TCP_WriteOptions(uint8_t flags, uint8_t options, uint16_t rxSize, uint32_t tsRecent)
+{
+    if (flags & TCP_SYN_FLAG)
+    {
+        ETH_Write8(TCP_MSS);
+        ETH_Write8(4);
+        ETH_Write16(TCP_RxMss(rxSize));
+        if (options & TCP_OPT_WND_SCALE)
         {
-            if(tcbPtr->remoteWnd == 0)
-            {
-                tcbPtr->remoteWnd = 1;
-            }
-            if(tcpDataLength > tcbPtr->remoteWnd)
-            {
-                tcpDataLength = tcbPtr->remoteWnd;
-            }
-
-            if(tcpDataLength > tcbPtr->mss)
-            {
-                tcpDataLength = tcbPtr->mss;
-            }
-            data = tcbPtr->txBufferPtr;
-
-            // update the pointer to the next byte that needs to be sent
-            tcbPtr->txBufferPtr = tcbPtr->txBufferPtr + tcpDataLength;
-            tcbPtr->bytesToSend = tcbPtr->bytesSent - tcpDataLength;
-
-            if (tcbPtr->bytesToSend == 0)
-            {
-                tcbPtr->flags = tcbPtr->flags | TCP_PSH_FLAG;
-            }
+            ETH_Write8(TCP_NOP);
+            ETH_Write8(TCP_WIN_SCALE);
+            ETH_Write8(3);
+            ETH_Write8(0);      // the windows of this stack are not scaled
+        }
+        if (options & TCP_OPT_SACK)
+        {
+            ETH_Write8(TCP_NOP);
+            ETH_Write8(TCP_NOP);
+            ETH_Write8(TCP_SACK_PERMITTED);
+            ETH_Write8(2);
         }
     }
-    //update the TCP Flags
-    txHeader.flags = tcbPtr->flags;
-    payloadLength = sizeof(tcpHeader_t) + tcpDataLength;
-
-    ret = IPv4_Start(tcbPtr->destIP, TCP_TCPIP);
-    if (ret == SUCCESS)
+    if (options & TCP_OPT_TIMESTAMPS)
     {
-        ETH_WriteBlock((char *) &txHeader, sizeof(tcpHeader_t));   //jira: M8TS-608
+        ETH_Write8(TCP_NOP);
+        ETH_Write8(TCP_NOP);
+        ETH_Write8(TCP_TIMESTAMPS);
+        ETH_Write8(10);
+        ETH_Write32(rtcc_getTicks());   // the timestamp clock ticks every ms
+        ETH_Write32(tsRecent);
+    }
+}
+
+#if defined(TCP_ENABLE_SACK) && defined(TCP_ENABLE_OOO_QUEUE)
+/** Internal function of the TCP Stack. Number of SACK blocks for a segment:
+ *  the ACKs without data report the out of order ranges (RFC 2018). Data
+ *  segments carry none, the blocks would take room from the mss.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param dataLength
+ *      payload length of the segment
+ * 
+ * @return
+ *      number of blocks, 0 for no SACK option
+ */
+static uint8_t TCP_SackBlocks(tcpTCB_t *tcbPtr, uint16_t dataLength)
+{
+    uint8_t blocks = 0;
 
-        if (tcpDataLength > 0)
+    if ((tcbPtr->options & TCP_OPT_SACK) && (tcbPtr->oooCount > 0) && (dataLength == 0) &&
+        ((tcbPtr->flags & (TCP_SYN_FLAG | TCP_ACK_FLAG)) == TCP_ACK_FLAG))
+    {
+        blocks = (tcbPtr->options & TCP_OPT_TIMESTAMPS) ? (TCP_MAX_SACK_BLOCKS - 1u) : TCP_MAX_SACK_BLOCKS;
+        if (blocks > tcbPtr->oooCount)
         {
-            ETH_WriteBlock((char *) data, tcpDataLength);   //jira: M8TS-608
+            blocks = tcbPtr->oooCount;
         }
-
-        cksm = payloadLength + TCP_TCPIP;
-        // Calculate the TCP checksum
-        cksm = ETH_TxComputeChecksum(sizeof(ethernetFrame_t) + sizeof(ipv4Header_t) - 8, payloadLength + 8, cksm);
-        ETH_Insert((char *)&cksm, 2, sizeof(ethernetFrame_t) + sizeof(ipv4Header_t) + offsetof(tcpHeader_t,checksum));
-
-        ret = IPV4_Send(payloadLength);        
-//        tcbPtr->txBufferPtr = tcbPtr->txBufferPtr - tcpDataLength;
     }
+    return blocks;
+}
 
-    // The packet wasn't transmitted
-    // Use the timeout to retry again later
-    if (ret != SUCCESS && ret != TX_QUEUED)	// jira: CAE_MCU8-5647, CAE_MCU8-6056
-    {
+/** Internal function of the TCP Stack. Write the SACK option: the range of
+ *  the last out of order segment first, then the other ranges in order.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param blocks
+ *      number of blocks, at most oooCount
+ * 
+ * @return
+ *      None
+ */
+static void TCP_WriteSackBlocks(tcpTCB_t *tcbPtr, uint8_t blocks)
+{
+    tcpOooRange_t *queue = tcbPtr->oooQueue;
+    uint8_t first;
+    uint8_t i;
+
+    first = 0;
+    for (i = 0; i < tcbPtr->oooCount; i++)
+    {
+        if (!TCP_SEQ_LT(tcbPtr->oooLastSeqno, queue[i].seqno) && TCP_SEQ_LT(tcbPtr->oooLastSeqno, queue[i].seqno + queue[i].length))
+        {
+            first = i;
+        }
+    }
+
+    ETH_Write8(TCP_NOP);
+    ETH_Write8(TCP_NOP);
+    ETH_Write8(TCP_SACK);
+    ETH_Write8(2u + blocks * TCP_SACK_BLOCK_SIZE);
+    ETH_Write32(queue[first].seqno);
+    ETH_Write32(queue[first].seqno + queue[first].length);
+    blocks--;
+    for (i = 0; (i < tcbPtr->oooCount) && (blocks > 0); i++)
+    {
+        if (i != first)
+        {
+            ETH_Write32(queue[i].seqno);
+            ETH_Write32(queue[i].seqno + queue[i].length);
+            blocks--;
+        }
+    }
+}
+#else
+#define TCP_SackBlocks(tcbPtr, dataLength)      (0u)
+#endif
+
+/** Internal function of the TCP Stack. Keep the options of the received SYN
+ *  that this stack offers too. The timestamps take 12 bytes of each segment,
+ *  the largest payload is smaller by the same amount (RFC 6691).
+ * 
+ * @param mss
+ *      largest payload of a segment sent to the remote
+ * 
+ * @param options
+ *      options of the connection, TCP_OPT_ flags
+ * 
+ * @param sndScale
+ *      window scale of the remote
+ * 
+ * @param tsRecent
+ *      timestamp to echo to the remote
+ * 
+ * @return
+ *      None
+ */
+static void TCP_SynOptions(uint16_t *mss, uint8_t *options, uint8_t *sndScale, uint32_t *tsRecent)
+{
+    *mss = tcpMss;
+    *options = 0;
+    *sndScale = 0;
+    if ((tcpWndScale != TCP_NO_WND_SCALE) && ((TCP_OPT_OFFERED & TCP_OPT_WND_SCALE) != 0u))
+    {
+        *options = *options | TCP_OPT_WND_SCALE;
+        *sndScale = (tcpWndScale > TCP_MAX_WND_SCALE) ? TCP_MAX_WND_SCALE : tcpWndScale;
+    }
+    if ((tcpSackPermitted == true) && ((TCP_OPT_OFFERED & TCP_OPT_SACK) != 0u))
+    {
+        *options = *options | TCP_OPT_SACK;
+    }
+    if ((tcpTsPresent == true) && ((TCP_OPT_OFFERED & TCP_OPT_TIMESTAMPS) != 0u))
+    {
+        *options = *options | TCP_OPT_TIMESTAMPS;
+        *tsRecent = tcpTsVal;
+        if (*mss > (2u * TCP_TS_OPTION_SIZE))
+        {
+            *mss = *mss - TCP_TS_OPTION_SIZE;
+        }
+    }
+}
+
+/** Internal function of the TCP Stack. TCP_SynOptions() for a socket, it
+ *  keeps the window scale and the timestamp only when they are offered.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_SocketSynOptions(tcpTCB_t *tcbPtr)
+{
+    uint8_t sndScale;
+    uint32_t tsRecent = 0;
+
+    TCP_SynOptions(&tcbPtr->mss, &tcbPtr->options, &sndScale, &tsRecent);
+#ifdef TCP_ENABLE_WINDOW_SCALE
+    tcbPtr->sndScale = sndScale;
+#endif
+#ifdef TCP_ENABLE_TIMESTAMPS
+    tcbPtr->tsRecent = tsRecent;
+#endif
+}
+
+/** Internal function of the TCP Stack. Window of the received segment with
+ *  the window scale of the remote, limited to 64 KB.
+ * 
+ * @param sndScale
+ *      window scale of the remote, 0 for a SYN
+ * 
+ * @return
+ *      window in bytes
+ */
+static uint16_t TCP_ScaledWindow(uint8_t sndScale)
+{
+    uint32_t window;
+
+    window = (uint32_t)ntohs(tcpHeader.windowSize) << sndScale;
+    return (window > UINT16_MAX) ? UINT16_MAX : (uint16_t)window;
+}
+
+/** Internal function of the TCP Stack. Take the send window from the
+ *  received segment and remember the segment for the RFC 793 window update
+ *  check (SND.WL1, SND.WL2).
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param window
+ *      window of the segment in bytes
+ * 
+ * @return
+ *      None
+ */
+static void TCP_RemoteWindowSet(tcpTCB_t *tcbPtr, uint16_t window)
+{
+    tcbPtr->remoteWnd = window;
+    tcbPtr->sndWl1 = tcpHeader.sequenceNumber;
+    tcbPtr->sndWl2 = tcpHeader.ackNumber;
+}
+
+/** Internal function of the TCP Stack to build and send one TCP segment.
+ *  The segment carries the flags saved in the TCB.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param seqno
+ *      sequence number of the segment
+ * 
+ * @param offset
+ *      position of the payload in the TX memory, from the first unacknowledged byte
+ * 
+ * @param dataLength
+ *      payload length, 0 for a segment without data
+ * 
+ * @return
+ *      SUCCESS or TX_QUEUED - The segment was passed to the MAC
+ * @return
+ *      ERROR - There is no room for the segment in the TX buffer
+ */
+static error_msg TCP_SndSegment(tcpTCB_t *tcbPtr, uint32_t seqno, uint16_t offset, uint16_t dataLength)
+{
+    error_msg ret = ERROR;
+    tcpHeader_t txHeader;
+    uint16_t payloadLength;
+    uint16_t cksm;
+    uint16_t index;
+    uint16_t length;
+    uint8_t optionsSize;
+    uint8_t sackBlocks;
+
+    txHeader.sourcePort = htons(tcbPtr->localPort);
+    txHeader.destPort = htons(tcbPtr->destPort);
+
+    txHeader.sequenceNumber = htonl(seqno);
+
+    txHeader.ackNumber = htonl(tcbPtr->remoteAck); //ask for next packet
+
+    txHeader.ns = 0;          // make sure we clean unused fields
+    txHeader.reserved = 0;    // make sure we clean unused fields
+    sackBlocks = TCP_SackBlocks(tcbPtr, dataLength);
+    optionsSize = TCP_OptionsSize(tcbPtr->flags, tcbPtr->options, sackBlocks);
+    txHeader.dataOffset = (sizeof(tcpHeader_t) + optionsSize) >> 2;
+    txHeader.windowSize = htons(TCP_RxWindow(tcbPtr));
+    txHeader.checksum = 0;
+    txHeader.urgentPtr = 0;
+
+    //update the TCP Flags
+    txHeader.flags = tcbPtr->flags;
+    payloadLength = sizeof(tcpHeader_t) + optionsSize + dataLength;
+
+    ret = IPv4_Start(tcbPtr->destIP, TCP_TCPIP);
+    if (ret == SUCCESS)
+    {
+        ETH_WriteBlock((char *) &txHeader, sizeof(tcpHeader_t));   //jira: M8TS-608
+        TCP_WriteOptions(tcbPtr->flags, tcbPtr->options, tcbPtr->rxBufferSize, TCP_TS_RECENT(tcbPtr));
+#if defined(TCP_ENABLE_SACK) && defined(TCP_ENABLE_OOO_QUEUE)
+        if (sackBlocks > 0)
+        {
+            TCP_WriteSackBlocks(tcbPtr, sackBlocks);
+        }
+#endif
+
+        if (dataLength > 0)
+        {
+            // the payload may wrap around the end of the TX ring
+            index = TCP_TxIndex(tcbPtr, offset);
+            length = tcbPtr->txBufferSize - index;
+            if (length > dataLength)
+            {
+                length = dataLength;
+            }
+            ETH_WriteBlock((char *) tcbPtr->txBufferStart + index, length);   //jira: M8TS-608
+            if (length < dataLength)
+            {
+                ETH_WriteBlock((char *) tcbPtr->txBufferStart, dataLength - length);
+            }
+        }
+
+        // Calculate the TCP checksum from the running checksum of the written segment
+        cksm = ETH_TxChecksumGet(IPV4_PseudoHeaderChecksum(payloadLength));
+        ETH_Insert((char *)&cksm, 2, sizeof(ethernetFrame_t) + sizeof(ipv4Header_t) + offsetof(tcpHeader_t,checksum));
+
+        ret = IPV4_Send(payloadLength);        
+    }
+
+    if (((ret == SUCCESS) || (ret == TX_QUEUED)) && (tcbPtr->flags & TCP_ACK_FLAG))
+    {
+        // every segment acknowledges remoteAck, nothing is left to delay
+        if (tcbPtr->ackPending > 0)
+        {
+            if ((dataLength > 0) || (tcbPtr->flags & TCP_FIN_FLAG))
+            {
+                TCP_CountRx(tcbPtr, acksPiggybacked);
+            }
+            tcbPtr->ackPending = 0;
+            TIMER_Stop(&tcbPtr->ackTimer);
+        }
+        if ((dataLength == 0) && (tcbPtr->flags == TCP_ACK_FLAG))
+        {
+            TCP_CountRx(tcbPtr, ackFrames);
+        }
+    }
+    return ret;
+}
+
+/** Internal function of the TCP Stack. Send a segment with only an ACK.
+ *  If there is no room in the TX buffer the ACK stays pending and it is
+ *  tried again on the next millisecond.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      SUCCESS or TX_QUEUED - The ACK was passed to the MAC
+ * @return
+ *      ERROR - The ACK is still pending
+ */
+static error_msg TCP_SndAck(tcpTCB_t *tcbPtr)
+{
+    error_msg ret;
+
+    tcbPtr->flags = TCP_ACK_FLAG;
+    ret = TCP_SndSegment(tcbPtr, tcbPtr->localSeqno, 0, 0);
+    if ((ret != SUCCESS) && (ret != TX_QUEUED))
+    {
+        if (tcbPtr->ackPending == 0)
+        {
+            tcbPtr->ackPending = 1;
+        }
+        TIMER_Start(&tcbPtr->ackTimer, 1);
+    }
+    return ret;
+}
+
+#ifdef TCP_ENABLE_KEEPALIVE
+/** Internal function of the TCP Stack. Start the keep-alive idle time again,
+ *  the remote is alive. Only a connection that can still receive data is
+ *  probed, in the other states the closing handshake has its own time-outs.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_KeepAliveRestart(tcpTCB_t *tcbPtr)
+{
+    tcbPtr->keepAliveProbes = 0;
+    if ((tcbPtr->keepAliveIdle > 0) && (tcbPtr->fsmState == ESTABLISHED))
+    {
+        TIMER_Start(&tcbPtr->keepAliveTimer, (uint32_t)tcbPtr->keepAliveIdle * TICK_SECOND);
+    }
+    else
+    {
+        TIMER_Stop(&tcbPtr->keepAliveTimer);
+    }
+}
+#else
+#define TCP_KeepAliveRestart(tcbPtr)
+#endif
+
+/** Internal function of the TCP Stack. Acceptance test of RFC 793 for the
+ *  received segment, before the state machine takes it. Only an accepted
+ *  segment restarts the keep-alive idle time: an old duplicate or a segment
+ *  outside the window does not show that the remote is still there. In the
+ *  states without keep-alive every segment counts.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      true - the segment starts or ends in the receive window, its ACK is not ahead of the sent data
+ * @return
+ *      false - the segment is dropped or only answered with an ACK
+ */
+static bool TCP_SegmentAccepted(tcpTCB_t *tcbPtr)
+{
+    uint32_t offset;
+
+    if (tcbPtr->fsmState != ESTABLISHED)
+    {
+        return true;
+    }
+    if (tcpHeader.ack && TCP_SEQ_LT(tcbPtr->localSeqno, tcpHeader.ackNumber))
+    {
+        return false;
+    }
+    // with a zero window the segment at the next byte in order still carries a valid ACK
+    offset = tcpHeader.sequenceNumber - tcbPtr->remoteAck;
+    if ((offset == 0) || (offset < tcbPtr->localWnd))
+    {
+        return true;
+    }
+    offset = offset + rcvPayloadLen - 1u;
+    return (rcvPayloadLen > 0) && (offset < tcbPtr->localWnd);
+}
+
+/** Internal function of the TCP Stack to send a TCP packet without payload
+ *  (SYN, FIN, RST or a plain ACK). The data is sent with TCP_SndData().
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      true - The buffer was send successfully
+ * @return
+ *      false - Send buffer fails.
+ */
+static error_msg TCP_Snd(tcpTCB_t *tcbPtr)   //jira: CAE_MCU8-5647
+{
+    error_msg ret;
+
+    ret = TCP_SndSegment(tcbPtr, tcbPtr->localSeqno, 0, 0);
+
+    // The packet wasn't transmitted
+    // Use the timeout to retry again later
+    if (ret != SUCCESS && ret != TX_QUEUED)	// jira: CAE_MCU8-5647, CAE_MCU8-6056
+    {
         // make sure we keep the remaining timeouts and skip this send  that failed
         // try at least once
         tcbPtr->timeoutsCount = tcbPtr->timeoutsCount - 1u; // CAE_MCU8-5749, CAE_MCU8-5647
 
-        if (tcbPtr->timeout == 0)
+        if (!TIMER_IsRunning(&tcbPtr->timer))
+        {
+            TIMER_Start(&tcbPtr->timer, TCP_START_TIMEOUT_VAL);
+        }
+    }
+    else
+    {
+        logMsg("tcp_packet sent",LOG_INFO, LOG_DEST_CONSOLE);
+    }
+
+    return ret;
+}
+
+/** Internal function of the TCP Stack. Send the unsent data from the TX buffer
+ *  as long as the number of unacknowledged bytes stays within the remote window
+ *  and the congestion window. Each segment carries at most mss bytes. With a
+ *  TX ring a last small segment waits for the ACK of the sent data (Nagle).
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_SndData(tcpTCB_t *tcbPtr)
+{
+    uint32_t window;
+    uint16_t length;
+    error_msg ret;
+
+    window = tcbPtr->cwnd;
+    // limited transmit (RFC 3042): each of the first duplicate ACKs lets one new segment out
+    if ((tcbPtr->fastRecovery == false) && (tcbPtr->dupAcks < TCP_DUP_ACK_THRESHOLD))
+    {
+        window = window + (uint32_t)tcbPtr->dupAcks * tcbPtr->mss;
+    }
+    if (window > tcbPtr->remoteWnd)
+    {
+        window = tcbPtr->remoteWnd;
+    }
+
+    while (tcbPtr->bytesToSend > 0)
+    {
+        if (window > tcbPtr->bytesSent)
+        {
+            length = (window - tcbPtr->bytesSent > tcbPtr->mss) ? tcbPtr->mss : (uint16_t)(window - tcbPtr->bytesSent);
+        }
+        else if (tcbPtr->bytesSent == 0)
+        {
+            // the remote window is closed, probe it with one byte
+            length = 1;
+        }
+        else
+        {
+            break;
+        }
+
+        if (length > tcbPtr->bytesToSend)
+        {
+            length = tcbPtr->bytesToSend;
+        }
+        if (length > tcbPtr->mss)
+        {
+            length = tcbPtr->mss;
+        }
+        // don't split the data in small segments while the window is filling up
+        if ((length < tcbPtr->mss) && (length < tcbPtr->bytesToSend) && (tcbPtr->bytesSent > 0))
+        {
+            break;
+        }
+        // Nagle (RFC 896): more data may be written before the ACK arrives
+        if ((length < tcbPtr->mss) && (tcbPtr->bytesSent > 0) && (tcbPtr->txRing == true) && (tcbPtr->noDelay == false))
+        {
+            break;
+        }
+
+        tcbPtr->flags = TCP_ACK_FLAG;
+        if (length == tcbPtr->bytesToSend)
+        {
+            tcbPtr->flags = tcbPtr->flags | TCP_PSH_FLAG;
+        }
+
+        ret = TCP_SndSegment(tcbPtr, tcbPtr->localSeqno, tcbPtr->bytesSent, length);
+        if (ret != SUCCESS && ret != TX_QUEUED)
+        {
+            // no room in the TX buffer, the next ACK or the timeout will continue
+            break;
+        }
+
+        tcbPtr->bytesToSend = tcbPtr->bytesToSend - length;
+        tcbPtr->bytesSent = tcbPtr->bytesSent + length;
+        tcbPtr->localSeqno = tcbPtr->localSeqno + length;
+
+        // time one segment per round trip
+        if (tcbPtr->rttActive == false)
         {
-            tcbPtr->timeout = TCP_START_TIMEOUT_VAL;
+            tcbPtr->rttActive = true;
+            tcbPtr->rttSeqno = tcbPtr->localSeqno;
+            tcbPtr->rttStart = (uint16_t)rtcc_getTicks();
         }
     }
-    else
+
+    // keep the retransmission timer running while there is data to send
+    if (!TIMER_IsRunning(&tcbPtr->timer))
+    {
+        TIMER_Start(&tcbPtr->timer, tcbPtr->timeoutReloadValue);
+    }
+}
+
+/** Internal function of the TCP Stack. Update the smoothed round trip time
+ *  and the retransmission time-out with a new RTT sample (RFC 6298).
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param rtt
+ *      round trip time sample in ms
+ * 
+ * @return
+ *      None
+ */
+static void TCP_RttUpdate(tcpTCB_t *tcbPtr, uint16_t rtt)
+{
+    uint16_t delta;
+    uint32_t rto;
+
+    if (rtt > TCP_MAX_RTT_SAMPLE)
+    {
+        rtt = TCP_MAX_RTT_SAMPLE;
+    }
+    tcbPtr->lastRtt = rtt;
+
+    if (tcbPtr->rttSamples == 0)
+    {
+        // first measurement: SRTT = R, RTTVAR = R/2
+        tcbPtr->srtt = rtt << 3;
+        tcbPtr->rttvar = rtt << 1;
+    }
+    else
+    {
+        // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, SRTT = 7/8 SRTT + 1/8 R
+        if ((tcbPtr->srtt >> 3) > rtt)
+        {
+            delta = (tcbPtr->srtt >> 3) - rtt;
+        }
+        else
+        {
+            delta = rtt - (tcbPtr->srtt >> 3);
+        }
+        tcbPtr->rttvar = tcbPtr->rttvar - (tcbPtr->rttvar >> 2) + delta;
+        tcbPtr->srtt = tcbPtr->srtt - (tcbPtr->srtt >> 3) + rtt;
+    }
+    if (tcbPtr->rttSamples < UINT16_MAX)
+    {
+        tcbPtr->rttSamples++;
+    }
+
+    // RTO = SRTT + max(G, 4 * RTTVAR), the clock granularity G is 1 ms
+    rto = (uint32_t)(tcbPtr->srtt >> 3) + (tcbPtr->rttvar ? tcbPtr->rttvar : 1u);
+    if (rto < TCP_MIN_RTO)
+    {
+        rto = TCP_MIN_RTO;
+    }
+    if (rto > TCP_MAX_RTO)
+    {
+        rto = TCP_MAX_RTO;
+    }
+    tcbPtr->rto = (uint16_t)rto;
+}
+
+/** Internal function of the TCP Stack. Open the congestion window for
+ *  acknowledged bytes: by up to one mss per ACK in slow start, by about one
+ *  mss per round trip in congestion avoidance (RFC 5681). The window is
+ *  limited to TCP_MAX_TX_WINDOW.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param ackedBytes
+ *      number of newly acknowledged bytes
+ * 
+ * @return
+ *      None
+ */
+static void TCP_CwndIncrease(tcpTCB_t *tcbPtr, uint16_t ackedBytes)
+{
+    uint16_t increase;
+
+    if (tcbPtr->cwnd < tcbPtr->ssthresh)
+    {
+        increase = (ackedBytes < tcbPtr->mss) ? ackedBytes : tcbPtr->mss;
+    }
+    else
+    {
+        increase = (uint16_t)(((uint32_t)tcbPtr->mss * tcbPtr->mss) / tcbPtr->cwnd);
+        if (increase == 0)
+        {
+            increase = 1;
+        }
+    }
+
+    if (((uint32_t)tcbPtr->cwnd + increase) > TCP_MAX_TX_WINDOW)
+    {
+        tcbPtr->cwnd = TCP_MAX_TX_WINDOW;
+    }
+    else
+    {
+        tcbPtr->cwnd = tcbPtr->cwnd + increase;
+    }
+}
+
+/** Internal function of the TCP Stack. Halve the slow start threshold after
+ *  a loss: ssthresh = max(FlightSize / 2, 2 * mss).
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_CongestionLoss(tcpTCB_t *tcbPtr)
+{
+    tcbPtr->ssthresh = tcbPtr->bytesSent >> 1;
+    if (tcbPtr->ssthresh < (2u * tcbPtr->mss))
+    {
+        tcbPtr->ssthresh = 2u * tcbPtr->mss;
+    }
+}
+
+#ifdef TCP_ENABLE_SACK
+/** Internal function of the TCP Stack. Add a SACKed range to the scoreboard,
+ *  merge it with the ranges it overlaps or touches. When the scoreboard is
+ *  full the highest range is dropped.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param start
+ *      offset of the first byte from localLastAck
+ * 
+ * @param end
+ *      offset of the byte after the range, at most bytesSent
+ * 
+ * @return
+ *      None
+ */
+static void TCP_SackInsert(tcpTCB_t *tcbPtr, uint16_t start, uint16_t end)
+{
+    tcpSackRange_t *board = tcbPtr->sackBoard;
+    uint8_t i;
+    uint8_t j;
+
+    // first range that ends at or after the new range
+    i = 0;
+    while ((i < tcbPtr->sackCount) && (board[i].end < start))
+    {
+        i++;
+    }
+
+    if ((i < tcbPtr->sackCount) && (board[i].start <= end))
+    {
+        // overlaps or touches range i, grow it and swallow the next ranges it reaches
+        if (start < board[i].start)
+        {
+            board[i].start = start;
+        }
+        j = i;
+        while ((j < tcbPtr->sackCount) && (board[j].start <= end))
+        {
+            if (board[j].end > end)
+            {
+                end = board[j].end;
+            }
+            j++;
+        }
+        board[i].end = end;
+        memmove(&board[i + 1u], &board[j], (size_t)(tcbPtr->sackCount - j) * sizeof(tcpSackRange_t));
+        tcbPtr->sackCount = tcbPtr->sackCount - (j - i - 1u);
+    }
+    else
+    {
+        if (tcbPtr->sackCount >= TCP_SACK_SCOREBOARD_SIZE)
+        {
+            if (i >= tcbPtr->sackCount)
+            {
+                return;
+            }
+            tcbPtr->sackCount--;
+        }
+        memmove(&board[i + 1u], &board[i], (size_t)(tcbPtr->sackCount - i) * sizeof(tcpSackRange_t));
+        board[i].start = start;
+        board[i].end = end;
+        tcbPtr->sackCount++;
+    }
+}
+
+/** Internal function of the TCP Stack. Move the scoreboard with the
+ *  cumulative ACK and add the SACK blocks of the received segment. Blocks
+ *  outside the bytes in flight (D-SACK, old segments) are ignored.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure, localLastAck and bytesSent
+ *      already follow the ACK
+ * 
+ * @param ackedBytes
+ *      number of newly acknowledged bytes
+ * 
+ * @return
+ *      None
+ */
+static void TCP_SackUpdate(tcpTCB_t *tcbPtr, uint16_t ackedBytes)
+{
+    tcpSackRange_t *board = tcbPtr->sackBoard;
+    uint32_t start;
+    uint8_t i;
+    uint8_t j;
+
+    if (ackedBytes > 0)
+    {
+        j = 0;
+        for (i = 0; i < tcbPtr->sackCount; i++)
+        {
+            if (board[i].end > ackedBytes)
+            {
+                board[j].start = (board[i].start > ackedBytes) ? (board[i].start - ackedBytes) : 0u;
+                board[j].end = board[i].end - ackedBytes;
+                j++;
+            }
+        }
+        tcbPtr->sackCount = j;
+        tcbPtr->sackRexmitNext = (tcbPtr->sackRexmitNext > ackedBytes) ? (tcbPtr->sackRexmitNext - ackedBytes) : 0u;
+    }
+
+    for (i = 0; i < tcpSackCount; i++)
+    {
+        start = tcpSackBlocks[i].seqno - tcbPtr->localLastAck;
+        if ((tcpSackBlocks[i].length > 0) && (start < tcbPtr->bytesSent) &&
+            ((start + tcpSackBlocks[i].length) <= tcbPtr->bytesSent))
+        {
+            TCP_SackInsert(tcbPtr, (uint16_t)start, (uint16_t)start + tcpSackBlocks[i].length);
+        }
+    }
+}
+
+/** Internal function of the TCP Stack. Retransmit the next hole: the first
+ *  bytes after sackRexmitNext that the remote does not hold while it holds
+ *  later bytes (RFC 6675). Each hole is sent once per recovery.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      true - A hole was retransmitted
+ * @return
+ *      false - No hole is known or there is no room in the TX buffer
+ */
+static bool TCP_SackRetransmit(tcpTCB_t *tcbPtr)
+{
+    tcpSackRange_t *board = tcbPtr->sackBoard;
+    uint16_t hole;
+    uint16_t length;
+    uint8_t i;
+    error_msg ret;
+
+    hole = tcbPtr->sackRexmitNext;
+    for (i = 0; i < tcbPtr->sackCount; i++)
+    {
+        if (board[i].start <= hole)
+        {
+            // the remote holds these bytes, the hole starts after them
+            if (board[i].end > hole)
+            {
+                hole = board[i].end;
+            }
+        }
+        else
+        {
+            length = board[i].start - hole;
+            if (length > tcbPtr->mss)
+            {
+                length = tcbPtr->mss;
+            }
+            tcbPtr->flags = TCP_ACK_FLAG;
+            tcbPtr->rttActive = false;
+            ret = TCP_SndSegment(tcbPtr, tcbPtr->localLastAck + hole, hole, length);
+            if ((ret == SUCCESS) || (ret == TX_QUEUED))
+            {
+                tcbPtr->sackRexmitNext = hole + length;
+                TCP_CountTx(tcbPtr, sackRetransmits);
+                if (tcbPtr->retransmits < UINT16_MAX)
+                {
+                    tcbPtr->retransmits++;
+                }
+                return true;
+            }
+            return false;
+        }
+    }
+    return false;
+}
+#endif
+
+/** Internal function of the TCP Stack. Count a duplicate ACK. The
+ *  TCP_DUP_ACK_THRESHOLD duplicate ACK retransmits the first unacknowledged
+ *  segment and starts the fast recovery (RFC 6582), each further duplicate ACK
+ *  inflates the congestion window by one mss.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_DupAckReceived(tcpTCB_t *tcbPtr)
+{
+    uint32_t cwnd;
+
+    TCP_CountTx(tcbPtr, dupAcks);
+    if (tcbPtr->dupAcks < UINT8_MAX)
+    {
+        tcbPtr->dupAcks++;
+    }
+
+    if (tcbPtr->fastRecovery == true)
+    {
+        // the duplicate ACK means that one more segment left the network,
+        // with SACK it carries the next hole, else the window grows for new data
+#ifdef TCP_ENABLE_SACK
+        if (TCP_SackRetransmit(tcbPtr) == false)
+#endif
+        {
+            cwnd = (uint32_t)tcbPtr->cwnd + tcbPtr->mss;
+            tcbPtr->cwnd = (cwnd > UINT16_MAX) ? UINT16_MAX : (uint16_t)cwnd;
+        }
+    }
+    else if ((tcbPtr->dupAcks == TCP_DUP_ACK_THRESHOLD) && !TCP_SEQ_LT(tcbPtr->localLastAck, tcbPtr->localRecover))
+    {
+        // no recovery in progress for this data, retransmit without waiting for the time-out
+        TCP_CongestionLoss(tcbPtr);
+        tcbPtr->localRecover = tcbPtr->localSeqno;
+        tcbPtr->fastRecovery = true;
+        TCP_Retransmit(tcbPtr);
+        cwnd = (uint32_t)tcbPtr->ssthresh + TCP_DUP_ACK_THRESHOLD * tcbPtr->mss;
+        tcbPtr->cwnd = (cwnd > UINT16_MAX) ? UINT16_MAX : (uint16_t)cwnd;
+        TCP_CountTx(tcbPtr, fastRetransmits);
+    }
+}
+
+/** Internal function of the TCP Stack. Process the ACK number and the window
+ *  of the received segment: release the acknowledged bytes from the TX buffer,
+ *  update the congestion window and send new data if the windows allow it.
+ *  Duplicate ACKs lead to a fast retransmit. During a recovery each partial
+ *  ACK retransmits the next unacknowledged segment.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_AckReceived(tcpTCB_t *tcbPtr)
+{
+    uint16_t ackedBytes;
+    uint16_t window;
+
+    // the ACK number is between the oldest unacknowledged byte and localSeqno
+    ackedBytes = tcbPtr->bytesSent - (uint16_t)(tcbPtr->localSeqno - tcpHeader.ackNumber);
+    tcbPtr->localLastAck = tcpHeader.ackNumber;
+    window = TCP_ScaledWindow(TCP_SND_SCALE(tcbPtr));
+
+    if (ackedBytes > 0)
+    {
+        tcbPtr->txBufferTail = TCP_TxIndex(tcbPtr, ackedBytes);
+        tcbPtr->bytesSent = tcbPtr->bytesSent - ackedBytes;
+    }
+#ifdef TCP_ENABLE_SACK
+    if (tcbPtr->options & TCP_OPT_SACK)
+    {
+        TCP_SackUpdate(tcbPtr, ackedBytes);
+    }
+#endif
+
+    if (ackedBytes > 0)
+    {
+
+        if ((tcbPtr->options & TCP_OPT_TIMESTAMPS) && (tcpTsPresent == true))
+        {
+            // the remote echoes the send time of the acknowledged data, also after a retransmission (RFC 7323 4.1)
+            tcbPtr->rttActive = false;
+            TCP_RttUpdate(tcbPtr, (uint16_t)(rtcc_getTicks() - tcpTsEcr));
+        }
+        else if ((tcbPtr->rttActive == true) && !TCP_SEQ_LT(tcpHeader.ackNumber, tcbPtr->rttSeqno))
+        {
+            tcbPtr->rttActive = false;
+            TCP_RttUpdate(tcbPtr, (uint16_t)rtcc_getTicks() - tcbPtr->rttStart);
+        }
+
+        // new data was acknowledged, restart the timeout without the backoff
+        tcbPtr->timeoutReloadValue = tcbPtr->rto;
+        TIMER_Start(&tcbPtr->timer, tcbPtr->rto);
+        tcbPtr->timeoutsCount = TCP_MAX_RETRIES;
+
+        if (tcbPtr->fastRecovery == true)
+        {
+            if (TCP_SEQ_LT(tcpHeader.ackNumber, tcbPtr->localRecover))
+            {
+                // partial ACK: deflate by the acknowledged bytes, keep room for the retransmission
+                tcbPtr->cwnd = ((tcbPtr->cwnd > ackedBytes) ? (tcbPtr->cwnd - ackedBytes) : 0u) + tcbPtr->mss;
+            }
+            else
+            {
+                // full ACK: continue with the reduced window
+                tcbPtr->fastRecovery = false;
+                tcbPtr->cwnd = ((tcbPtr->bytesSent + tcbPtr->mss) < tcbPtr->ssthresh) ? (tcbPtr->bytesSent + tcbPtr->mss) : tcbPtr->ssthresh;
+            }
+        }
+        else
+        {
+            TCP_CwndIncrease(tcbPtr, ackedBytes);
+        }
+        tcbPtr->dupAcks = 0;
+    }
+    else if ((tcbPtr->bytesSent > 0) && (rcvPayloadLen == 0) && (window == tcbPtr->remoteWnd))
+    {
+        // duplicate ACK (RFC 5681): data in flight, nothing acknowledged, no payload and the same window
+        TCP_DupAckReceived(tcbPtr);
+    }
+
+    // only a segment newer than the last window update changes the window (RFC 793),
+    // a reordered older segment would bring back a stale window
+    if (TCP_SEQ_LT(tcbPtr->sndWl1, tcpHeader.sequenceNumber) ||
+        ((tcbPtr->sndWl1 == tcpHeader.sequenceNumber) && !TCP_SEQ_LT(tcpHeader.ackNumber, tcbPtr->sndWl2)))
+    {
+        TCP_RemoteWindowSet(tcbPtr, window);
+    }
+
+    if ((tcbPtr->bytesSent == 0) && (tcbPtr->bytesToSend == 0))
+    {
+        // Check if all TX buffer/data was acknowledged
+        if (tcbPtr->txBufState == TX_BUFF_IN_USE)
+        {
+            tcbPtr->txBufState = NO_BUFF;
+        }
+        //stop timeout
+        TIMER_Stop(&tcbPtr->timer);
+        tcbPtr->localRecover = tcbPtr->localLastAck;
+    }
+    else
+    {
+        if (TCP_SEQ_LT(tcbPtr->localLastAck, tcbPtr->localRecover))
+        {
+            if (ackedBytes > 0)
+            {
+                // the segment after the acknowledged one was lost as well,
+                // with SACK it was lost only if the remote holds later bytes
+#ifdef TCP_ENABLE_SACK
+                if (((tcbPtr->options & TCP_OPT_SACK) == 0u) ||
+                    ((TCP_SackRetransmit(tcbPtr) == false) && (tcbPtr->sackRexmitNext == 0)))
+#endif
+                {
+                    TCP_Retransmit(tcbPtr);
+                }
+                TCP_CountTx(tcbPtr, partialAcks);
+            }
+        }
+        else
+        {
+            tcbPtr->localRecover = tcbPtr->localLastAck;
+        }
+        TCP_SndData(tcbPtr);
+    }
+}
+
+/** Internal function of the TCP Stack. Retransmit the oldest unacknowledged
+ *  segment after a timeout. Only one segment is sent, the following segments
+ *  are retransmitted only if the ACKs show that they were lost too.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      true - The segment was send successfully
+ * @return
+ *      false - Send segment fails.
+ */
+static error_msg TCP_Retransmit(tcpTCB_t *tcbPtr)
+{
+    error_msg ret = SUCCESS;
+    uint16_t length;
+
+    if (tcbPtr->bytesSent == 0)
+    {
+        // nothing in flight, the data was not sent yet or the remote window is closed
+        TCP_SndData(tcbPtr);
+    }
+    else
+    {
+        length = tcbPtr->bytesSent;
+        if (length > tcbPtr->mss)
+        {
+            length = tcbPtr->mss;
+        }
+
+        tcbPtr->flags = TCP_ACK_FLAG;
+        if ((length == tcbPtr->bytesSent) && (tcbPtr->bytesToSend == 0))
+        {
+            tcbPtr->flags = tcbPtr->flags | TCP_PSH_FLAG;
+        }
+
+        if (!TCP_SEQ_LT(tcbPtr->localLastAck, tcbPtr->localRecover))
+        {
+            tcbPtr->localRecover = tcbPtr->localSeqno;
+        }
+        // Karn's algorithm: the ACK of a retransmitted segment is not an RTT sample
+        tcbPtr->rttActive = false;
+        ret = TCP_SndSegment(tcbPtr, tcbPtr->localLastAck, 0, length);
+#ifdef TCP_ENABLE_SACK
+        tcbPtr->sackRexmitNext = length;
+#endif
+        if (tcbPtr->retransmits < UINT16_MAX)
+        {
+            tcbPtr->retransmits++;
+        }
+    }
+    return ret;
+}
+
+/** Internal function of the TCP Stack. Copy payload bytes from the
+ *  received frame to the RX memory, after the bytes received in order.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param offset
+ *      distance from the next byte in order, less than localWnd
+ * 
+ * @param len
+ *      number of bytes, offset + len fits in localWnd
+ * 
+ * @return
+ *      None
+ */
+static void TCP_RxSave(tcpTCB_t *tcbPtr, uint16_t offset, uint16_t len)
+{
+    uint32_t index;
+    uint16_t length;
+
+    // the bytes may wrap around the end of the RX ring
+    index = (uint32_t)tcbPtr->rxBufferHead + offset;
+    if (index >= tcbPtr->rxBufferSize)
+    {
+        index = index - tcbPtr->rxBufferSize;
+    }
+    length = tcbPtr->rxBufferSize - (uint16_t)index;
+    if (length > len)
+    {
+        length = len;
+    }
+    ETH_ReadBlock(tcbPtr->rxBufferStart + index, length);
+    if (length < len)
+    {
+        ETH_ReadBlock(tcbPtr->rxBufferStart, len - length);
+    }
+}
+
+/** Internal function of the TCP Stack. Move the end of the in order data
+ *  over bytes already saved in the RX memory.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param length
+ *      number of bytes, at most localWnd
+ * 
+ * @return
+ *      None
+ */
+static void TCP_RxAdvance(tcpTCB_t *tcbPtr, uint16_t length)
+{
+    uint32_t index;
+
+    index = (uint32_t)tcbPtr->rxBufferHead + length;
+    if (index >= tcbPtr->rxBufferSize)
+    {
+        index = index - tcbPtr->rxBufferSize;
+    }
+    tcbPtr->rxBufferHead = (uint16_t)index;
+    tcbPtr->rxBytes = tcbPtr->rxBytes + length;
+    tcbPtr->localWnd = tcbPtr->localWnd - length;
+    if ((tcbPtr->localWnd == 0) && (length > 0))
+    {
+        TCP_CountRx(tcbPtr, zeroWindows);
+    }
+}
+
+#ifdef TCP_ENABLE_OOO_QUEUE
+/** Internal function of the TCP Stack. Add the range of an out of order
+ *  segment to the queue, merged with the ranges it overlaps or touches.
+ *  When the queue is full the range farthest from remoteAck is given up
+ *  for a range closer to it.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param seqno
+ *      sequence number of the first byte
+ * 
+ * @param length
+ *      number of bytes
+ * 
+ * @return
+ *      true - The range is in the queue
+ * @return
+ *      false - The queue is full
+ */
+static bool TCP_OooInsert(tcpTCB_t *tcbPtr, uint32_t seqno, uint16_t length)
+{
+    tcpOooRange_t *queue = tcbPtr->oooQueue;
+    uint32_t end = seqno + length;
+    uint32_t rangeEnd;
+    uint8_t i;
+    uint8_t j;
+
+    // first range that ends at or after the new range
+    i = 0;
+    while ((i < tcbPtr->oooCount) && TCP_SEQ_LT(queue[i].seqno + queue[i].length, seqno))
+    {
+        i++;
+    }
+
+    if ((i < tcbPtr->oooCount) && !TCP_SEQ_LT(end, queue[i].seqno))
+    {
+        // overlaps or touches range i, grow it and swallow the next ranges it reaches
+        if (TCP_SEQ_LT(seqno, queue[i].seqno))
+        {
+            queue[i].seqno = seqno;
+        }
+        rangeEnd = end;
+        j = i;
+        while ((j < tcbPtr->oooCount) && !TCP_SEQ_LT(rangeEnd, queue[j].seqno))
+        {
+            if (TCP_SEQ_LT(rangeEnd, queue[j].seqno + queue[j].length))
+            {
+                rangeEnd = queue[j].seqno + queue[j].length;
+            }
+            j++;
+        }
+        queue[i].length = (uint16_t)(rangeEnd - queue[i].seqno);
+        memmove(&queue[i + 1u], &queue[j], (size_t)(tcbPtr->oooCount - j) * sizeof(tcpOooRange_t));
+        tcbPtr->oooCount = tcbPtr->oooCount - (j - i - 1u);
+    }
+    else
+    {
+        if (tcbPtr->oooCount >= tcbPtr->oooQueueSize)
+        {
+            if (i >= tcbPtr->oooCount)
+            {
+                return false;
+            }
+            // drop the last range, its bytes will be sent again
+            tcbPtr->oooCount--;
+        }
+        memmove(&queue[i + 1u], &queue[i], (size_t)(tcbPtr->oooCount - i) * sizeof(tcpOooRange_t));
+        queue[i].seqno = seqno;
+        queue[i].length = length;
+        tcbPtr->oooCount++;
+    }
+    return true;
+}
+
+/** Internal function of the TCP Stack. Deliver the queued ranges that are
+ *  now contiguous with the received data: move remoteAck, the RX buffer
+ *  pointer and the window over them.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_OooMerge(tcpTCB_t *tcbPtr)
+{
+    uint32_t end;
+    uint16_t length;
+
+    while ((tcbPtr->oooCount > 0) && !TCP_SEQ_LT(tcbPtr->remoteAck, tcbPtr->oooQueue[0].seqno))
+    {
+        end = tcbPtr->oooQueue[0].seqno + tcbPtr->oooQueue[0].length;
+        if (TCP_SEQ_LT(tcbPtr->remoteAck, end))
+        {
+            length = (uint16_t)(end - tcbPtr->remoteAck);
+            TCP_RxAdvance(tcbPtr, length);
+            tcbPtr->remoteAck = end;
+            TCP_CountRx(tcbPtr, oooFilled);
+            TCP_CountRxBytes(tcbPtr, length);
+        }
+        tcbPtr->oooCount--;
+        memmove(&tcbPtr->oooQueue[0], &tcbPtr->oooQueue[1], (size_t)tcbPtr->oooCount * sizeof(tcpOooRange_t));
+    }
+}
+#endif
+
+/** Internal function of the TCP Stack. Store the payload of a segment that
+ *  starts after remoteAck in the RX buffer, at its place in the window, and
+ *  queue its range. A duplicate ACK is sent in all cases, it tells the remote
+ *  which bytes are missing.
+ * 
+ * @param offset
+ *      distance in bytes from remoteAck to the first byte of the payload
+ * 
+ * @param len
+ *      length of the payload received
+ * 
+ * @return
+ *      None
+ */
+static void TCP_OooSave(uint32_t offset, uint16_t len)
+{
+    bool saved = false;
+
+#ifdef TCP_ENABLE_OOO_QUEUE
+    if ((currentTCB->rxBufState == RX_BUFF_IN_USE) && (currentTCB->oooQueueSize > 0) && (offset < currentTCB->localWnd))
+    {
+        // keep only the bytes that fit in the window
+        if (len > (currentTCB->localWnd - (uint16_t)offset))
+        {
+            len = currentTCB->localWnd - (uint16_t)offset;
+        }
+        if (TCP_OooInsert(currentTCB, tcpHeader.sequenceNumber, len))
+        {
+            TCP_RxSave(currentTCB, (uint16_t)offset, len);
+            currentTCB->oooLastSeqno = tcpHeader.sequenceNumber;
+            saved = true;
+        }
+    }
+#endif
+
+    if (saved)
+    {
+        TCP_CountRx(currentTCB, oooSegments);
+    }
+    else
+    {
+        TCP_CountRx(currentTCB, oooDropped);
+    }
+
+    currentTCB->flags = TCP_ACK_FLAG;
+    TCP_Snd(currentTCB);
+}
+
+/** Internal function of the TCP Stack. Sort the payload of an ESTABLISHED
+ *  segment by its sequence number: in order data goes to the RX buffer,
+ *  data already received is skipped and later data is queued.
+ * 
+ * @param len
+ *      length of the payload received
+ * 
+ * @return
+ *      None
+ */
+static void TCP_PayloadReceive(uint16_t len)
+{
+    uint32_t offset;
+
+    offset = tcpHeader.sequenceNumber - currentTCB->remoteAck;
+    if (offset == 0)
+    {
+        currentTCB->remoteSeqno = tcpHeader.sequenceNumber;
+        TCP_PayloadSave(len);
+    }
+    else if ((int32_t)offset > 0)
+    {
+        TCP_OooSave(offset, len);
+    }
+    else if ((uint32_t)(currentTCB->remoteAck - tcpHeader.sequenceNumber) < len)
+    {
+        // retransmission that overlaps the received data, keep only the new bytes
+        offset = currentTCB->remoteAck - tcpHeader.sequenceNumber;
+        ETH_Dump((uint16_t)offset);
+        currentTCB->remoteSeqno = currentTCB->remoteAck;
+        TCP_PayloadSave(len - (uint16_t)offset);
+    }
+    else
+    {
+        // all bytes were received before, our ACK was probably lost
+        TCP_CountRx(currentTCB, duplicates);
+        currentTCB->flags = TCP_ACK_FLAG;
+        TCP_Snd(currentTCB);
+    }
+}
+
+/** Internal function of the TCP Stack. Will copy the TCP packet payload to 
+ * the socket RX buffer. This function will also send the ACK for
+ * the received packet and any ready to be send data.
+ * 
+ * @param len
+ *      length of the payload received
+ * 
+ * @return
+ *      true - The payload was copied to RX buffer successfully
+ * @return
+ *      false - Copying the payload failed.
+ */
+error_msg TCP_PayloadSave(uint16_t len)   //jira: CAE_MCU8-5647
+{
+    error_msg ret = ERROR;   //jira: CAE_MCU8-5647
+    uint16_t buffer_size;
+    uint8_t oooCount;
+
+    // check if we have a valid buffer
+    if (currentTCB->rxBufState == RX_BUFF_IN_USE)
+    {
+        // make sure we have enough space
+        if (currentTCB->localWnd >= len)
+        {
+            buffer_size = len;
+        }else
+        {
+            buffer_size = currentTCB->localWnd;
+        }
+        
+        TCP_RxSave(currentTCB, 0, buffer_size);
+
+        //update the local window to inform the remote of the available space
+        TCP_RxAdvance(currentTCB, buffer_size);
+        currentTCB->remoteAck = currentTCB->remoteSeqno + buffer_size;
+
+        TCP_CountRxBytes(currentTCB, buffer_size);
+
+#ifdef TCP_ENABLE_OOO_QUEUE
+        // the new bytes may close the gap before queued out of order data
+        oooCount = currentTCB->oooCount;
+        TCP_OooMerge(currentTCB);
+#else
+        oooCount = 0;
+#endif
+
+        //prepare to send the ACK and maybe some data if there are any
+        currentTCB->flags = TCP_ACK_FLAG;
+        currentTCB->payloadSave = true;
+
+        // RFC 1122: ACK every second segment at once, delay the others so the
+        // ACK can go out with the reply of the application.
+        // RFC 5681: ACK at once when there are holes or the window is full.
+        currentTCB->ackPending++;
+        if ((currentTCB->ackPending >= TCP_DELAYED_ACK_SEGMENTS) || (oooCount > 0) || (buffer_size < len))
+        {
+            TCP_SndAck(currentTCB);
+        }
+        else if (!TIMER_IsRunning(&currentTCB->ackTimer))
+        {
+            TIMER_Start(&currentTCB->ackTimer, TCP_DELAYED_ACK_TIMEOUT);
+        }
+        currentTCB->payloadSave = false;
+        ret = SUCCESS;    //jira: CAE_MCU8-5647
+    }
+    return ret;
+}
+
+
+/** Internal function of the TCP Stack. Send a segment for a connection
+ *  that waits in a backlog or in the SYN cache, with the window of the
+ *  entry.
+ * 
+ * @param entry
+ *      backlog entry of the connection
+ * 
+ * @param flags
+ *      TCP flags of the segment
+ * 
+ * @return
+ *      SUCCESS or TX_QUEUED - The segment was passed to the MAC
+ * @return
+ *      ERROR - No room in the TX buffer
+ */
+static error_msg TCP_BacklogSnd(tcpBacklogEntry_t *entry, uint8_t flags)
+{
+    error_msg ret;
+    tcpHeader_t txHeader;
+    uint16_t cksm;
+    uint8_t optionsSize;
+
+    txHeader.sourcePort = htons(entry->localPort);
+    txHeader.destPort = htons(entry->remotePort);
+    if (flags & TCP_SYN_FLAG)
+    {
+        txHeader.sequenceNumber = htonl(entry->localSeqno);
+    }
+    else
+    {
+        txHeader.sequenceNumber = htonl(entry->localSeqno + 1u);
+    }
+    txHeader.ackNumber = htonl(entry->remoteAck);
+    txHeader.ns = 0;
+    txHeader.reserved = 0;
+    optionsSize = TCP_OptionsSize(flags, entry->options, 0);
+    txHeader.dataOffset = (sizeof(tcpHeader_t) + optionsSize) >> 2;
+    txHeader.windowSize = htons(entry->localWnd);
+    txHeader.checksum = 0;
+    txHeader.urgentPtr = 0;
+    txHeader.flags = flags;
+
+    ret = IPv4_Start(entry->remoteIP, TCP_TCPIP);
+    if (ret == SUCCESS)
+    {
+        ETH_WriteBlock((char *) &txHeader, sizeof(tcpHeader_t));
+        TCP_WriteOptions(flags, entry->options, entry->localWnd, entry->tsRecent);
+        cksm = ETH_TxChecksumGet(IPV4_PseudoHeaderChecksum(sizeof(tcpHeader_t) + optionsSize));
+        ETH_Insert((char *)&cksm, 2, sizeof(ethernetFrame_t) + sizeof(ipv4Header_t) + offsetof(tcpHeader_t,checksum));
+        ret = IPV4_Send(sizeof(tcpHeader_t) + optionsSize);
+    }
+    return ret;
+}
+
+/** Internal function of the TCP Stack. Entries that keep the connections
+ *  of a listening socket until the handshake is complete: its backlog,
+ *  else the SYN cache of the stack.
+ * 
+ * @param listenPtr
+ *      pointer to the listening socket/TCB structure
+ * 
+ * @param backlog
+ *      receives the first entry
+ * 
+ * @return
+ *      number of entries, 0 when the listening socket takes the connection
+ */
+static uint8_t TCP_BacklogOf(tcpTCB_t *listenPtr, tcpBacklogEntry_t **backlog)
+{
+    if (listenPtr->backlogSize > 0)
+    {
+        *backlog = listenPtr->backlog;
+        return listenPtr->backlogSize;
+    }
+#if TCP_SYN_CACHE_SIZE > 0
+    *backlog = synCache;
+    return TCP_SYN_CACHE_SIZE;
+#else
+    *backlog = NULL;
+    return 0;
+#endif
+}
+
+/** Internal function of the TCP Stack. Give an established connection of
+ *  a backlog entry to a socket and free the entry.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @param entry
+ *      backlog entry in ESTABLISHED
+ * 
+ * @return
+ *      None
+ */
+static void TCP_BacklogAdopt(tcpTCB_t *tcbPtr, tcpBacklogEntry_t *entry)
+{
+    tcbPtr->localPort = entry->localPort;
+    tcbPtr->destIP = entry->remoteIP;
+    tcbPtr->destPort = entry->remotePort;
+    TCB_Rehash(tcbPtr);
+    tcbPtr->localSeqno = entry->localSeqno + 1u;
+    tcbPtr->localLastAck = tcbPtr->localSeqno;
+    tcbPtr->localRecover = tcbPtr->localSeqno;
+    tcbPtr->remoteSeqno = entry->remoteAck;
+    tcbPtr->remoteAck = entry->remoteAck;
+    tcbPtr->remoteWnd = entry->remoteWnd;
+    // the window came with the ACK that completed the handshake
+    tcbPtr->sndWl1 = entry->remoteAck;
+    tcbPtr->sndWl2 = tcbPtr->localSeqno;
+    tcbPtr->mss = entry->mss;
+    tcbPtr->options = entry->options;
+#ifdef TCP_ENABLE_WINDOW_SCALE
+    tcbPtr->sndScale = entry->sndScale;
+#endif
+#ifdef TCP_ENABLE_TIMESTAMPS
+    tcbPtr->tsRecent = entry->tsRecent;
+#endif
+    tcbPtr->connectionEvent = NOP;
+    tcbPtr->fsmState = ESTABLISHED;
+    tcbPtr->socketState = SOCKET_CONNECTED;
+    entry->fsmState = CLOSED;
+    TCP_KeepAliveRestart(tcbPtr);
+
+    if (tcbPtr->localWnd != entry->localWnd)
+    {
+        // the SYN+ACK had another window, a zero one for a connection of a backlog
+        TCP_SndAck(tcbPtr);
+    }
+}
+
+#ifdef TCP_ENABLE_SYN_COOKIES
+/** Internal function of the TCP Stack. Keyed hash of the received segment
+ *  connection for the SYN cookie.
+ * 
+ * @param remoteIsn
+ *      initial sequence number of the remote
+ * 
+ * @param localPort
+ *      port of the listening socket
+ * 
+ * @param slot
+ *      time slot of the cookie
+ * 
+ * @return
+ *      32 bit hash
+ */
+static uint32_t TCP_CookieHash(uint32_t remoteIsn, uint16_t localPort, uint8_t slot)
+{
+    uint32_t hash;
+
+    hash = (synCookieSecret[slot & 1u] ^ receivedRemoteAddress ^ slot) * 0x9E3779B1ul;
+    hash = (hash ^ (hash >> 15) ^ ((uint32_t)tcpHeader.sourcePort << 16) ^ localPort) * 0x85EBCA77ul;
+    hash = (hash ^ (hash >> 13) ^ remoteIsn) * 0xC2B2AE35ul;
+    return hash ^ (hash >> 16);
+}
+
+/** Internal function of the TCP Stack. New secret for the time slot, taken
+ *  from the timer captures mixed since the last one. It replaces the secret
+ *  of two slots ago, the one of the previous slot still checks the cookies
+ *  sent before the slot changed.
+ * 
+ * @param slot
+ *      time slot of the secret
+ * 
+ * @return
+ *      None
+ */
+static void TCP_CookieRekey(uint8_t slot)
+{
+    uint32_t key;
+
+    key = (synCookieEntropy ^ synCookieSecret[(slot + 1u) & 1u] ^ rtcc_getTicks()) * 0x9E3779B1ul;
+    key = (key ^ (key >> 15)) * 0x85EBCA77ul;
+    synCookieSecret[slot & 1u] = key ^ (key >> 13);
+    synCookieSlot[slot & 1u] = slot;
+}
+
+/** Internal function of the TCP Stack. SYN cookie for the received SYN,
+ *  used as the initial sequence number of the SYN+ACK. It keeps the largest
+ *  MSS of synCookieMss[] that the remote accepts.
+ * 
+ * @param localPort
+ *      port of the listening socket
+ * 
+ * @param mss
+ *      largest payload of a segment sent to the remote
+ * 
+ * @return
+ *      the cookie
+ */
+static uint32_t TCP_SynCookie(uint16_t localPort, uint16_t mss)
+{
+    uint8_t index;
+    uint8_t slot;
+
+    index = TCP_COOKIE_MSS_MASK;
+    while ((index > 0) && (synCookieMss[index] > mss))
+    {
+        index--;
+    }
+    slot = (uint8_t)(rtcc_getTicks() >> TCP_COOKIE_SLOT_TICKS);
+    if (synCookieSlot[slot & 1u] != slot)
+    {
+        TCP_CookieRekey(slot);
+    }
+    return (TCP_CookieHash(tcpHeader.sequenceNumber, localPort, slot) & TCP_COOKIE_HASH_MASK) |
+           ((uint32_t)(slot & TCP_COOKIE_SLOT_MASK) << TCP_COOKIE_SLOT_SHIFT) | index;
+}
+
+/** Internal function of the TCP Stack. Check the cookie acknowledged by
+ *  the received ACK.
+ * 
+ * @param localPort
+ *      port of the listening socket
+ * 
+ * @param mss
+ *      receives the MSS kept in the cookie
+ * 
+ * @return
+ *      true - The cookie was sent by this stack in the last two time slots
+ * @return
+ *      false - Wrong or expired cookie
+ */
+static bool TCP_SynCookieCheck(uint16_t localPort, uint16_t *mss)
+{
+    uint32_t cookie;
+    uint8_t slot;
+    uint8_t age;
+
+    cookie = tcpHeader.ackNumber - 1u;
+    slot = (uint8_t)(rtcc_getTicks() >> TCP_COOKIE_SLOT_TICKS);
+    age = (uint8_t)(slot - (uint8_t)(cookie >> TCP_COOKIE_SLOT_SHIFT)) & TCP_COOKIE_SLOT_MASK;
+    if (age > 1u)
+    {
+        return false;
+    }
+    slot = slot - age;
+    if (synCookieSlot[slot & 1u] != slot)
+    {
+        // no cookie was sent in this slot
+        return false;
+    }
+    if ((TCP_CookieHash(tcpHeader.sequenceNumber - 1u, localPort, slot) & TCP_COOKIE_HASH_MASK) != (cookie & TCP_COOKIE_HASH_MASK))
+    {
+        return false;
+    }
+    *mss = synCookieMss[cookie & TCP_COOKIE_MSS_MASK];
+    return true;
+}
+
+/** Internal function of the TCP Stack. Answer a SYN that found no free
+ *  entry with a SYN+ACK that carries a cookie, nothing is saved. The cookie
+ *  keeps only the MSS, the other options are not offered.
+ * 
+ * @param localPort
+ *      port of the listening socket
+ * 
+ * @return
+ *      None
+ */
+static void TCP_CookieSnd(uint16_t localPort)
+{
+    tcpBacklogEntry_t cookieEntry;
+    error_msg ret;
+
+    cookieEntry.remoteIP = receivedRemoteAddress;
+    cookieEntry.remotePort = tcpHeader.sourcePort;
+    cookieEntry.localPort = localPort;
+    cookieEntry.remoteAck = tcpHeader.sequenceNumber + 1u;
+    cookieEntry.localSeqno = TCP_SynCookie(localPort, tcpMss);
+    cookieEntry.localWnd = 0;
+    cookieEntry.options = 0;
+    cookieEntry.tsRecent = 0;
+    ret = TCP_BacklogSnd(&cookieEntry, TCP_SYN_FLAG | TCP_ACK_FLAG);
+    if ((ret == SUCCESS) || (ret == TX_QUEUED))
+    {
+        synStats.cookiesSent++;
+    }
+}
+
+/** Internal function of the TCP Stack. The ACK of a SYN+ACK whose entry is
+ *  gone or never existed: a valid cookie gives the connection a free entry,
+ *  else the half-open entry that waits the longest. A flood fills the
+ *  entries with the half-open connections of spoofed addresses, a real
+ *  remote that loses its entry comes back with its cookie too.
+ * 
+ * @param localPort
+ *      port of the listening socket
+ * 
+ * @param backlog
+ *      entries of the listening socket, see TCP_BacklogOf()
+ * 
+ * @param size
+ *      number of entries
+ * 
+ * @param entry
+ *      free entry, NULL when all are in use
+ * 
+ * @return
+ *      the entry of the established connection, NULL for a wrong cookie
+ */
+static tcpBacklogEntry_t *TCP_CookieAckReceived(uint16_t localPort, tcpBacklogEntry_t *backlog, uint8_t size, tcpBacklogEntry_t *entry)
+{
+    uint16_t mss;
+    uint8_t i;
+
+    if (TCP_SynCookieCheck(localPort, &mss) == false)
+    {
+        synStats.cookiesRejected++;
+        return NULL;
+    }
+
+    if (entry == NULL)
+    {
+        for (i = 0; i < size; i++)
+        {
+            if ((backlog[i].fsmState == SYN_RECEIVED) &&
+                ((entry == NULL) || (backlog[i].timeoutsCount < entry->timeoutsCount)))
+            {
+                entry = &backlog[i];
+            }
+        }
+        if (entry == NULL)
+        {
+            // all entries wait for TCP_Accept(), the remote sends its data again later
+            synStats.cookiesRejected++;
+            return NULL;
+        }
+        synStats.evictions++;
+    }
+
+    logMsg("LISTEN: rx_ack, cookie",LOG_INFO, LOG_DEST_CONSOLE);
+    entry->remoteIP = receivedRemoteAddress;
+    entry->remotePort = tcpHeader.sourcePort;
+    entry->localPort = localPort;
+    entry->remoteAck = tcpHeader.sequenceNumber;
+    entry->localSeqno = tcpHeader.ackNumber - 1u;
+    entry->remoteWnd = ntohs(tcpHeader.windowSize);
+    entry->localWnd = 0;
+    entry->mss = mss;
+    entry->options = 0;
+    entry->sndScale = 0;
+    entry->tsRecent = 0;
+    entry->fsmState = ESTABLISHED;
+    synStats.cookiesAccepted++;
+    return entry;
+}
+#endif
+
+/** Internal function of the TCP Stack. Handle a segment received by a
+ *  listening socket: a SYN takes a free entry of its backlog or of the SYN
+ *  cache and gets a SYN+ACK, the ACK of the SYN+ACK establishes the
+ *  connection, a RST frees the entry. Without free entry the SYN is
+ *  answered with a cookie (TCP_ENABLE_SYN_COOKIES) or dropped, the remote
+ *  sends it again. A listening socket without a backlog takes its
+ *  connection from the SYN cache when the handshake is complete.
+ * 
+ * @param listenPtr
+ *      pointer to the listening socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_BacklogReceive(tcpTCB_t *listenPtr)
+{
+    tcpBacklogEntry_t *backlog;
+    tcpBacklogEntry_t *entry;
+    tcpBacklogEntry_t *freeEntry;
+    netTimer_t *timer;
+    uint8_t size;
+    uint8_t i;
+
+    size = TCP_BacklogOf(listenPtr, &backlog);
+    entry = NULL;
+    freeEntry = NULL;
+    for (i = 0; i < size; i++)
+    {
+        if (backlog[i].fsmState == CLOSED)
+        {
+            if (freeEntry == NULL)
+            {
+                freeEntry = &backlog[i];
+            }
+        }
+        else if ((backlog[i].remoteIP == receivedRemoteAddress) && (backlog[i].remotePort == tcpHeader.sourcePort) &&
+                 (backlog[i].localPort == listenPtr->localPort))
+        {
+            entry = &backlog[i];
+            break;
+        }
+    }
+
+    switch (listenPtr->connectionEvent)
+    {
+        case RCV_SYN:
+            if ((entry == NULL) && (freeEntry != NULL))
+            {
+                logMsg("LISTEN: rx_syn, backlog",LOG_INFO, LOG_DEST_CONSOLE);
+                synStats.synReceived++;
+                entry = freeEntry;
+                entry->remoteIP = receivedRemoteAddress;
+                entry->remotePort = tcpHeader.sourcePort;
+                entry->localPort = listenPtr->localPort;
+                entry->remoteAck = tcpHeader.sequenceNumber + 1u;
+                entry->remoteWnd = ntohs(tcpHeader.windowSize);
+                // without a backlog the listening socket takes the connection, its window can be opened
+                entry->localWnd = (listenPtr->backlogSize > 0) ? 0u : listenPtr->localWnd;
+                TCP_SynOptions(&entry->mss, &entry->options, &entry->sndScale, &entry->tsRecent);
+#ifdef TCP_ENABLE_SYN_COOKIES
+                // a cookie too, the connection can still complete when its entry is taken
+                entry->localSeqno = TCP_SynCookie(entry->localPort, entry->mss);
+#else
+                entry->localSeqno = nextSequenceNumber;
+#endif
+                entry->timeoutsCount = TCP_MAX_SYN_RETRIES;
+                entry->fsmState = SYN_RECEIVED;
+            }
+            else if (entry == NULL)
+            {
+                logMsg("LISTEN: rx_syn, backlog full",LOG_INFO, LOG_DEST_CONSOLE);
+                synStats.synReceived++;
+                synStats.cacheFull++;
+#ifdef TCP_ENABLE_SYN_COOKIES
+                TCP_CookieSnd(listenPtr->localPort);
+#endif
+            }
+            // a retransmitted SYN gets the SYN+ACK again
+            if ((entry != NULL) && (entry->fsmState == SYN_RECEIVED))
+            {
+                TCP_BacklogSnd(entry, TCP_SYN_FLAG | TCP_ACK_FLAG);
+#if TCP_SYN_CACHE_SIZE > 0
+                timer = (listenPtr->backlogSize > 0) ? &listenPtr->timer : &synCacheTimer;
+#else
+                timer = &listenPtr->timer;
+#endif
+                if (!TIMER_IsRunning(timer))
+                {
+                    TIMER_Start(timer, TCP_START_TIMEOUT_VAL);
+                }
+            }
+            break;
+        case RCV_ACK:
+            if (entry != NULL)
+            {
+                if ((entry->fsmState == SYN_RECEIVED) && (tcpHeader.sequenceNumber == entry->remoteAck)
+                    && (tcpHeader.ackNumber == (entry->localSeqno + 1u)))
+                {
+                    entry->remoteWnd = TCP_ScaledWindow(entry->sndScale);
+                    if ((entry->options & TCP_OPT_TIMESTAMPS) && (tcpTsPresent == true))
+                    {
+                        entry->tsRecent = tcpTsVal;
+                    }
+                    entry->fsmState = ESTABLISHED;
+                }
+                else if ((entry->fsmState == ESTABLISHED) && (rcvPayloadLen > 0))
+                {
+                    // window probe, the window is still closed
+                    TCP_BacklogSnd(entry, TCP_ACK_FLAG);
+                }
+            }
+#ifdef TCP_ENABLE_SYN_COOKIES
+            else
+            {
+                entry = TCP_CookieAckReceived(listenPtr->localPort, backlog, size, freeEntry);
+                if ((entry != NULL) && (rcvPayloadLen > 0) && (listenPtr->backlogSize > 0))
+                {
+                    // the data waits for TCP_Accept(), the window is closed
+                    TCP_BacklogSnd(entry, TCP_ACK_FLAG);
+                }
+            }
+#endif
+            break;
+        case RCV_RST:
+        case RCV_RSTACK:
+            if (entry != NULL)
+            {
+                entry->fsmState = CLOSED;
+            }
+            break;
+        default:
+            break;
+    }
+    listenPtr->connectionEvent = NOP;
+
+    if ((entry != NULL) && (entry->fsmState == ESTABLISHED) && (listenPtr->backlogSize == 0))
     {
-        //if the packet was sent increment the Seqno.
-        tcbPtr->localSeqno = tcbPtr->localSeqno + tcpDataLength;
-        logMsg("tcp_packet sent",LOG_INFO, LOG_DEST_CONSOLE);
+        // no backlog: the listening socket becomes the connection
+        logMsg("LISTEN: syn cache, established",LOG_INFO, LOG_DEST_CONSOLE);
+        TCP_BacklogAdopt(listenPtr, entry);
     }
-
-    return ret;
 }
 
-/** Internal function of the TCP Stack. Will copy the TCP packet payload to 
- * the socket RX buffer. This function will also send the ACK for
- * the received packet and any ready to be send data.
+/** Internal function of the TCP Stack. Send the SYN+ACK again for the
+ *  half-open connections of a backlog or of the SYN cache, give them up
+ *  after TCP_MAX_SYN_RETRIES.
  * 
- * @param len
- *      length of the payload received
+ * @param backlog
+ *      first entry
+ * 
+ * @param size
+ *      number of entries
  * 
  * @return
- *      true - The payload was copied to RX buffer successfully
+ *      true - Some connections still wait for the ACK
  * @return
- *      false - Copying the payload failed.
+ *      false - No half-open connections
  */
-error_msg TCP_PayloadSave(uint16_t len)   //jira: CAE_MCU8-5647
+static bool TCP_BacklogRetransmit(tcpBacklogEntry_t *backlog, uint8_t size)
 {
-    error_msg ret = ERROR;   //jira: CAE_MCU8-5647
-    uint16_t buffer_size;
+    bool waiting = false;
+    uint8_t i;
 
-    // check if we have a valid buffer
-    if (currentTCB->rxBufState == RX_BUFF_IN_USE)
+    for (i = 0; i < size; i++)
     {
-        // make sure we have enough space
-        if (currentTCB->localWnd >= len)
-        {
-            buffer_size = len;
-        }else
+        if (backlog[i].fsmState == SYN_RECEIVED)
         {
-            buffer_size = currentTCB->localWnd;
+            if (backlog[i].timeoutsCount == 0)
+            {
+                backlog[i].fsmState = CLOSED;
+            }
+            else
+            {
+                backlog[i].timeoutsCount--;
+                TCP_BacklogSnd(&backlog[i], TCP_SYN_FLAG | TCP_ACK_FLAG);
+                waiting = true;
+            }
         }
-        
-        ETH_ReadBlock(currentTCB->rxBufferPtr, buffer_size);
-        currentTCB->rxBufferPtr =  currentTCB->rxBufferPtr + buffer_size;
-
-        //update the local window to inform the remote of the available space
-        currentTCB->localWnd =  currentTCB->localWnd - buffer_size;
-        currentTCB->remoteAck = currentTCB->remoteSeqno + buffer_size;
+    }
+    return waiting;
+}
 
-        //prepare to send the ACK and maybe some data if there are any
-        currentTCB->flags = TCP_ACK_FLAG;
-        currentTCB->payloadSave = true;
-        
-        TCP_Snd(currentTCB);
-        currentTCB->payloadSave = false;
-        ret = SUCCESS;    //jira: CAE_MCU8-5647
+/** Internal function of the TCP Stack. Retransmission time-out of a
+ *  listening socket with a backlog.
+ * 
+ * @param listenPtr
+ *      pointer to the listening socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_BacklogTimeout(tcpTCB_t *listenPtr)
+{
+    if (TCP_BacklogRetransmit(listenPtr->backlog, listenPtr->backlogSize))
+    {
+        TIMER_Start(&listenPtr->timer, TCP_START_TIMEOUT_VAL);
+    }
+    else
+    {
+        TIMER_Stop(&listenPtr->timer);
     }
-    return ret;
 }
 
+#if TCP_SYN_CACHE_SIZE > 0
+/** Timer wheel handler of the SYN cache retransmission timer.
+ * 
+ * @param context
+ *      not used
+ * 
+ * @return
+ *      None
+ */
+static void TCP_SynCacheExpired(void *context)
+{
+    if (TCP_BacklogRetransmit(synCache, TCP_SYN_CACHE_SIZE))
+    {
+        TIMER_Start(&synCacheTimer, TCP_START_TIMEOUT_VAL);
+    }
+}
+#endif
 
 /** This function will read and parse the OPTIONS field in TCP header.
  *  Each TCP header could have the options field.
- *  we will read only the ones that has SYN or SYN + ACK
- *  for the other TCP headers the options will be skipped.
+ *  The MSS and window scale are read only from SYN or SYN + ACK,
+ *  the timestamps from every segment. Other options will be skipped.
  *
  * @param 
  *      None
@@ -384,103 +2651,192 @@ static error_msg TCP_ParseTCPOptions(void)   //jira: CAE_MCU8-5647
     // Check for the option fields in TCP header
     tcpOptionsSize = (uint16_t)(tcpHeader.dataOffset << 2u) - (uint16_t)sizeof(tcpHeader_t);   //jira: CAE_MCU8-5647
 
-    if (tcpOptionsSize > 0)
+    tcpTsPresent = false;
+#ifdef TCP_ENABLE_SACK
+    tcpSackCount = 0;
+#endif
+    if (tcpHeader.syn)
     {
         // RFC 1122, page 85, Section 4.2.2.6  Maximum Segment Size Option: RFC-793 Section 3.1
         // more explanations in RFC-6691
         tcpMss = 536;
-        // parse the option only for SYN segments
-        if(tcpHeader.syn)
+        tcpWndScale = TCP_NO_WND_SCALE;
+        tcpSackPermitted = false;
+    }
+
+    if (tcpOptionsSize > 0)
+    {
+        while(tcpOptionsSize--)
         {
-            // Parse for the TCP MSS option, if present.
-            while(tcpOptionsSize--)
+            opt = ETH_Read8();
+            switch (opt)
             {
-                opt = ETH_Read8();
-                switch (opt)
-                {
-                    case TCP_EOP:
-                        // End of options.
-                        if (tcpOptionsSize)
-                        {
-                            // dump remaining unused bytes
-                            ETH_Dump(tcpOptionsSize);
-                            tcpOptionsSize = 0;
-                        }
-                        ret = SUCCESS;    //jira: CAE_MCU8-5647
-                        break;
-                    case TCP_NOP:
-                        // NOP option.
-                        break;
-                    case TCP_MSS:
-                        if (tcpOptionsSize >= 3) // at least 3 more bytes
+                case TCP_EOP:
+                    // End of options.
+                    if (tcpOptionsSize)
+                    {
+                        // dump remaining unused bytes
+                        ETH_Dump(tcpOptionsSize);
+                        tcpOptionsSize = 0;
+                    }
+                    ret = SUCCESS;    //jira: CAE_MCU8-5647
+                    break;
+                case TCP_NOP:
+                    // NOP option.
+                    break;
+                case TCP_MSS:
+                    if (tcpOptionsSize >= 3) // at least 3 more bytes
+                    {
+                        opt = ETH_Read8();
+                        if (opt == 0x04)
                         {
-                            opt = ETH_Read8();
-                            if (opt == 0x04)
+                            // An MSS option with the right option length.
+                            // value returned in host endianess, only valid in a SYN
+                            if (tcpHeader.syn)
                             {
-                                // An MSS option with the right option length.
-                                tcpMss = ETH_Read16(); // value returned in host endianess
-                                // Advance to the next option
-                                tcpOptionsSize = tcpOptionsSize - 3;
-
-                                // Limit the mss to the configured TCP_MAX_SEG_SIZE
-                                if (tcpMss > TCP_MAX_SEG_SIZE)
-                                {
-                                    tcpMss = TCP_MAX_SEG_SIZE;
-                                }
-                                // so far so good
-                                ret = SUCCESS;    //jira: CAE_MCU8-5647
-                            }else
+                                tcpMss = ETH_Read16();
+                            }
+                            else
                             {
-                                // Bad option size length
-                                logMsg("tcp_parseopt: bad option size length",LOG_INFO, LOG_DEST_CONSOLE);
-                                // unexpected error
-                                tcpOptionsSize = 0;
-                                ret = ERROR;     //jira: CAE_MCU8-5647
+                                ETH_Dump(2);
                             }
+                            // Advance to the next option
+                            tcpOptionsSize = tcpOptionsSize - 3;
+
+                            // Limit the mss to the configured TCP_MAX_SEG_SIZE
+                            if (tcpMss > TCP_MAX_SEG_SIZE)
+                            {
+                                tcpMss = TCP_MAX_SEG_SIZE;
+                            }
+                            // so far so good
+                            ret = SUCCESS;    //jira: CAE_MCU8-5647
                         }else
                         {
+                            // Bad option size length
+                            logMsg("tcp_parseopt: bad option size length",LOG_INFO, LOG_DEST_CONSOLE);
                             // unexpected error
                             tcpOptionsSize = 0;
                             ret = ERROR;     //jira: CAE_MCU8-5647
                         }
-                        break;
-                    default:
-                        logMsg("tcp_parseopt: other",LOG_INFO, LOG_DEST_CONSOLE);
+                    }else
+                    {
+                        // unexpected error
+                        tcpOptionsSize = 0;
+                        ret = ERROR;     //jira: CAE_MCU8-5647
+                    }
+                    break;
+                case TCP_WIN_SCALE:
+                    // RFC 7323 2.2: kind 3, length 3, shift count, only valid in a SYN
+                    if ((tcpOptionsSize >= 2) && (ETH_Read8() == 3u))
+                    {
                         opt = ETH_Read8();
-                        tcpOptionsSize--;
-
-                        if (opt > 1) // this should be at least 2 to be valid
+                        if (tcpHeader.syn)
+                        {
+                            tcpWndScale = opt;
+                        }
+                        tcpOptionsSize = tcpOptionsSize - 2;
+                        ret = SUCCESS;
+                    }else
+                    {
+                        logMsg("tcp_parseopt: bad window scale",LOG_INFO, LOG_DEST_CONSOLE);
+                        tcpOptionsSize = 0;
+                        ret = ERROR;
+                    }
+                    break;
+                case TCP_SACK_PERMITTED:
+                    // RFC 2018 2: kind 4, length 2, only valid in a SYN
+                    if ((tcpOptionsSize >= 1) && (ETH_Read8() == 2u))
+                    {
+                        if (tcpHeader.syn)
+                        {
+                            tcpSackPermitted = true;
+                        }
+                        tcpOptionsSize = tcpOptionsSize - 1;
+                        ret = SUCCESS;
+                    }else
+                    {
+                        logMsg("tcp_parseopt: bad sack permitted",LOG_INFO, LOG_DEST_CONSOLE);
+                        tcpOptionsSize = 0;
+                        ret = ERROR;
+                    }
+                    break;
+                case TCP_SACK:
+                    // RFC 2018 3: kind 5, length 2 + 8 per block, left and right edge of each block
+                    opt = (tcpOptionsSize >= 1) ? ETH_Read8() : 0u;
+                    if ((opt > 2u) && (((opt - 2u) % TCP_SACK_BLOCK_SIZE) == 0u) && ((uint16_t)(opt - 1u) <= tcpOptionsSize))
+                    {
+                        tcpOptionsSize = tcpOptionsSize - (opt - 1u);
+                        for (opt = (opt - 2u) / TCP_SACK_BLOCK_SIZE; opt > 0u; opt--)
                         {
-                            // adjust for the remaining bytes for the current option
-                            opt = opt - 2u;    //jira: CAE_MCU8-5647
-                            if (opt <= tcpOptionsSize)
+#ifdef TCP_ENABLE_SACK
+                            if (tcpSackCount < TCP_MAX_SACK_BLOCKS)
                             {
-                                // All other options have a length field, so that we easily can skip them.
-                                ETH_Dump(opt);
-                                tcpOptionsSize = tcpOptionsSize - opt;
-                                ret = SUCCESS;    //jira: CAE_MCU8-5647
-                            }else
+                                tcpSackBlocks[tcpSackCount].seqno = ETH_Read32();
+                                tcpSackBlocks[tcpSackCount].length = (uint16_t)(ETH_Read32() - tcpSackBlocks[tcpSackCount].seqno);
+                                tcpSackCount++;
+                            }
+                            else
+#endif
                             {
-                                logMsg("tcp_parseopt: bad option length",LOG_INFO, LOG_DEST_CONSOLE);
-                                // the options are malformed and we don't process them further.
-                                tcpOptionsSize = 0;
-                                ret = ERROR;     //jira: CAE_MCU8-5647
+                                ETH_Dump(TCP_SACK_BLOCK_SIZE);
                             }
+                        }
+                        ret = SUCCESS;
+                    }else
+                    {
+                        logMsg("tcp_parseopt: bad sack",LOG_INFO, LOG_DEST_CONSOLE);
+                        tcpOptionsSize = 0;
+                        ret = ERROR;
+                    }
+                    break;
+                case TCP_TIMESTAMPS:
+                    // RFC 7323 3.2: kind 8, length 10, TSval and TSecr
+                    if ((tcpOptionsSize >= 9) && (ETH_Read8() == 10u))
+                    {
+                        tcpTsVal = ETH_Read32();
+                        tcpTsEcr = ETH_Read32();
+                        tcpTsPresent = true;
+                        tcpOptionsSize = tcpOptionsSize - 9;
+                        ret = SUCCESS;
+                    }else
+                    {
+                        logMsg("tcp_parseopt: bad timestamps",LOG_INFO, LOG_DEST_CONSOLE);
+                        tcpOptionsSize = 0;
+                        ret = ERROR;
+                    }
+                    break;
+                default:
+                    logMsg("tcp_parseopt: other",LOG_INFO, LOG_DEST_CONSOLE);
+                    opt = ETH_Read8();
+                    tcpOptionsSize--;
+
+                    if (opt > 1) // this should be at least 2 to be valid
+                    {
+                        // adjust for the remaining bytes for the current option
+                        opt = opt - 2u;    //jira: CAE_MCU8-5647
+                        if (opt <= tcpOptionsSize)
+                        {
+                            // All other options have a length field, so that we easily can skip them.
+                            ETH_Dump(opt);
+                            tcpOptionsSize = tcpOptionsSize - opt;
+                            ret = SUCCESS;    //jira: CAE_MCU8-5647
                         }else
                         {
-                            logMsg("tcp_parseopt: bad length",LOG_INFO, LOG_DEST_CONSOLE);
-                            // If the length field is zero, the options are malformed
-                            // and we don't process them further.
+                            logMsg("tcp_parseopt: bad option length",LOG_INFO, LOG_DEST_CONSOLE);
+                            // the options are malformed and we don't process them further.
                             tcpOptionsSize = 0;
                             ret = ERROR;     //jira: CAE_MCU8-5647
                         }
-                        break;
-                }
+                    }else
+                    {
+                        logMsg("tcp_parseopt: bad length",LOG_INFO, LOG_DEST_CONSOLE);
+                        // If the length field is zero, the options are malformed
+                        // and we don't process them further.
+                        tcpOptionsSize = 0;
+                        ret = ERROR;     //jira: CAE_MCU8-5647
+                    }
+                    break;
             }
-        }else // jump over the Options from TCP header
-        {
-            ETH_Dump(tcpOptionsSize);
-            ret = SUCCESS;    //jira: CAE_MCU8-5647
         }
     }else
     {
@@ -504,16 +2860,19 @@ static error_msg TCP_ParseTCPOptions(void)   //jira: CAE_MCU8-5647
  */
 void TCP_Recv(uint32_t remoteAddress, uint16_t length)
 {
-    tcpTCB_t *tcbPtr;
-    socklistsize_t count = 0;
+    bool accepted;
 
-    tcbPtr = NULL;
     //make sure we will not reuse old values
     receivedRemoteAddress = 0;
     rcvPayloadLen = 0;
 
     ETH_ReadBlock((char *)&tcpHeader,sizeof(tcpHeader_t));
 
+#ifdef TCP_ENABLE_SYN_COOKIES
+    // the arrival of the segments is not in step with the CPU clock
+    synCookieEntropy = ((synCookieEntropy << 3) | (synCookieEntropy >> 29)) ^ TMR1_ReadTimer();
+#endif
+
     currentTCB = NULL;
 
     // quick check on destination port
@@ -522,19 +2881,19 @@ void TCP_Recv(uint32_t remoteAddress, uint16_t length)
         tcpHeader.sourcePort = ntohs(tcpHeader.sourcePort);
         tcpHeader.destPort = ntohs(tcpHeader.destPort);
         
-        // search for active TCB
-        tcbPtr = tcbList;
-        while((tcbPtr != NULL) && (count < tcbListSize))
+        // the connection of the last segment, else search the connection, else the socket listening on the port
+        currentTCB = lastHitTCB;
+        if ((currentTCB == NULL) || (currentTCB->localPort != tcpHeader.destPort) ||
+            (currentTCB->destPort != tcpHeader.sourcePort) || (currentTCB->destIP != remoteAddress))
         {
-            if (tcpHeader.destPort == tcbPtr->localPort)
+            currentTCB = TCB_HashFind(remoteAddress, tcpHeader.sourcePort, tcpHeader.destPort);
+            if (currentTCB != NULL)
             {
-                currentTCB = tcbPtr;
-                break;
+                lastHitTCB = currentTCB;
             }
             else
             {
-                tcbPtr = tcbPtr->nextTCB;
-                count ++;
+                currentTCB = TCB_HashFind(0, 0, tcpHeader.destPort);
             }
         }
 
@@ -599,7 +2958,46 @@ void TCP_Recv(uint32_t remoteAddress, uint16_t length)
                     tcpHeader.ackNumber = ntohl(tcpHeader.ackNumber);
                     tcpHeader.sequenceNumber = ntohl(tcpHeader.sequenceNumber);
 
-                    TCP_FiniteStateMachine();
+#if TCP_SYN_CACHE_SIZE > 0
+                    if (currentTCB->fsmState == LISTEN)
+#else
+                    if ((currentTCB->fsmState == LISTEN) && (currentTCB->backlogSize > 0))
+#endif
+                    {
+                        // the listening socket stays in LISTEN, the backlog or the SYN cache keeps the connection
+                        TCP_BacklogReceive(currentTCB);
+                        if ((currentTCB->fsmState == ESTABLISHED) && (rcvPayloadLen > 0))
+                        {
+                            // the ACK that completed the handshake of the listening socket carries data
+                            currentTCB->connectionEvent = RCV_ACK;
+                            TCP_FiniteStateMachine();
+                        }
+                    }
+                    else
+                    {
+#ifdef TCP_ENABLE_TIMESTAMPS
+                        // RFC 7323 4.3: echo the timestamp of the oldest segment not acknowledged yet,
+                        // with an ACK pending the last ACK sent is behind remoteAck
+                        if ((currentTCB->options & TCP_OPT_TIMESTAMPS) && (tcpTsPresent == true) &&
+                            (currentTCB->ackPending == 0) && !TCP_SEQ_LT(tcpTsVal, currentTCB->tsRecent) &&
+                            !TCP_SEQ_LT(currentTCB->remoteAck, tcpHeader.sequenceNumber))
+                        {
+                            currentTCB->tsRecent = tcpTsVal;
+                        }
+#endif
+                        accepted = TCP_SegmentAccepted(currentTCB);
+                        TCP_FiniteStateMachine();
+                        if (accepted)
+                        {
+                            TCP_KeepAliveRestart(currentTCB);
+                        }
+                        if ((currentTCB->closePending == true) && (currentTCB->fsmState == ESTABLISHED) &&
+                            (currentTCB->bytesSent == 0) && (currentTCB->bytesToSend == 0))
+                        {
+                            // the last byte written before TCP_Close() is acknowledged, send the FIN now
+                            TCP_Close(currentTCB);
+                        }
+                    }
                 }else
                 {
                     logMsg("pkt dropped: bad options",LOG_INFO, LOG_DEST_CONSOLE);
@@ -623,7 +3021,6 @@ void TCP_Recv(uint32_t remoteAddress, uint16_t length)
  */
 static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
 {
-    uint16_t notAckBytes;
     error_msg ret = ERROR;  //jira: CAE_MCU8-5647
 
     tcp_fsm_states_t nextState = currentTCB->fsmState; // default don't change states
@@ -644,6 +3041,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
 
                     currentTCB->destIP = receivedRemoteAddress;
                     currentTCB->destPort = tcpHeader.sourcePort;
+                    TCB_Rehash(currentTCB);
 
                     // TO DO modify the start seq no to be "random"
                     currentTCB->localLastAck = 0;
@@ -652,12 +3050,12 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                     currentTCB->remoteAck = currentTCB->remoteSeqno + 1; // ask for next packet
 
                     // save data from TCP header
-                    currentTCB->remoteWnd = ntohs(tcpHeader.windowSize);
-                    currentTCB->mss = tcpMss;
+                    TCP_RemoteWindowSet(currentTCB, ntohs(tcpHeader.windowSize));
+                    TCP_SocketSynOptions(currentTCB);
 
                     // create and send a SYN+ACK packet
                     currentTCB->flags =   TCP_SYN_FLAG | TCP_ACK_FLAG;
-                    currentTCB->timeout = TCP_START_TIMEOUT_VAL;
+                    TIMER_Start(&currentTCB->timer, TCP_START_TIMEOUT_VAL);
                     currentTCB->timeoutReloadValue = TCP_START_TIMEOUT_VAL;
                     currentTCB->timeoutsCount = TCP_MAX_SYN_RETRIES;
 
@@ -669,6 +3067,12 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                     nextState = CLOSED;
                     TCB_Reset(currentTCB);
                     break;
+                case TIMEOUT:
+                    if (currentTCB->backlogSize > 0)
+                    {
+                        TCP_BacklogTimeout(currentTCB);
+                    }
+                    break;
                 default:
                     // for all other cases the packet is invalid and will be discarded
                     break;
@@ -684,11 +3088,11 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                     currentTCB->remoteAck = tcpHeader.sequenceNumber + 1; //ask for next packet
 
                     // save data from TCP header
-                    currentTCB->remoteWnd = ntohs(tcpHeader.windowSize);
-                    currentTCB->mss = tcpMss;
+                    TCP_RemoteWindowSet(currentTCB, ntohs(tcpHeader.windowSize));
+                    TCP_SocketSynOptions(currentTCB);
 
                     // create and send a ACK packet
-                    currentTCB->timeout = TCP_START_TIMEOUT_VAL;
+                    TIMER_Start(&currentTCB->timer, TCP_START_TIMEOUT_VAL);
                     currentTCB->timeoutReloadValue = TCP_START_TIMEOUT_VAL;
                     currentTCB->timeoutsCount = TCP_MAX_SYN_RETRIES;
                     currentTCB->flags = TCP_SYN_FLAG | TCP_ACK_FLAG;
@@ -701,7 +3105,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                 case RCV_SYNACK:
                     logMsg("SYN_SENT: rx_synack",LOG_INFO, LOG_DEST_CONSOLE);
 
-                    currentTCB->timeout = 0;
+                    TIMER_Stop(&currentTCB->timer);
 
                     if ((currentTCB->localSeqno + 1) == tcpHeader.ackNumber)
                     {
@@ -714,8 +3118,8 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                         // ask for next packet
                         currentTCB->remoteAck = tcpHeader.sequenceNumber + 1;
 
-                        currentTCB->remoteWnd = ntohs(tcpHeader.windowSize);
-                        currentTCB->mss = tcpMss;
+                        TCP_RemoteWindowSet(currentTCB, ntohs(tcpHeader.windowSize));
+                        TCP_SocketSynOptions(currentTCB);
 
                         if(TCP_Snd(currentTCB) == (TX_QUEUED || SUCCESS))   //jira: CAE_MCU8-5647, CAE_MCU8-6056
                         {
@@ -738,7 +3142,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                 case RCV_ACK:
                     logMsg("SYN_SENT: rx_ack",LOG_INFO, LOG_DEST_CONSOLE);
 
-                    currentTCB->timeout = 0;
+                    TIMER_Stop(&currentTCB->timer);
 
                     if ((currentTCB->localSeqno + 1) == tcpHeader.ackNumber)
                     {
@@ -750,7 +3154,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                         currentTCB->remoteSeqno =  tcpHeader.sequenceNumber;
                         currentTCB->remoteAck = tcpHeader.sequenceNumber + 1; // ask for next packet
 
-                        currentTCB->remoteWnd = ntohs(tcpHeader.windowSize);
+                        TCP_RemoteWindowSet(currentTCB, ntohs(tcpHeader.windowSize));
                         currentTCB->mss = tcpMss;
 
                         nextState = ESTABLISHED;
@@ -823,7 +3227,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                     if (currentTCB->localPort == tcpHeader.destPort)
                     {
                         // stop the current timeout
-                        currentTCB->timeout = 0;
+                        TIMER_Stop(&currentTCB->timer);
 
                         // This is part of simultaneous open
                         // TO DO: Check if the received packet is the one that we expect
@@ -850,7 +3254,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                             {
                                 currentTCB->localSeqno = currentTCB->localSeqno + 1;
                                 // stop the current timeout
-                                currentTCB->timeout = 0;
+                                TIMER_Stop(&currentTCB->timer);
                                 
                                 nextState = ESTABLISHED;
                                 currentTCB->socketState = SOCKET_CONNECTED;
@@ -861,10 +3265,10 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                 case CLOSE:
                     logMsg("SYN_RECEIVED: close",LOG_INFO, LOG_DEST_CONSOLE);
                     // stop the current timeout
-                    currentTCB->timeout = 0;
+                    TIMER_Stop(&currentTCB->timer);
                     // Need to send FIN and go to the FIN_WAIT_1
                     currentTCB->flags = TCP_FIN_FLAG;
-                    currentTCB->timeout = TCP_START_TIMEOUT_VAL;
+                    TIMER_Start(&currentTCB->timer, TCP_START_TIMEOUT_VAL);
                     currentTCB->timeoutReloadValue = TCP_START_TIMEOUT_VAL;
                     currentTCB->timeoutsCount = TCP_MAX_RETRIES;
                     
@@ -883,6 +3287,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                             logMsg("rst seq OK",LOG_INFO, LOG_DEST_CONSOLE);
                             currentTCB->destIP = 0;
                             currentTCB->destPort = 0;
+                            TCB_Rehash(currentTCB);
                             currentTCB->localSeqno = 0;
                             currentTCB->localLastAck = 0;
                             currentTCB->remoteSeqno = 0;
@@ -909,6 +3314,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                         {
                             currentTCB->destIP = 0;
                             currentTCB->destPort = 0;
+                            TCB_Rehash(currentTCB);
                             currentTCB->localSeqno = 0;
                             currentTCB->localLastAck = 0;
                             currentTCB->remoteSeqno = 0;
@@ -932,76 +3338,25 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                     logMsg("ESTABLISHED: rx_ack",LOG_INFO, LOG_DEST_CONSOLE);
                     if (currentTCB->destIP == receivedRemoteAddress)
                     {
-                        // is sequence number OK?
-                        // remote ACK should be equal to header sequence number
-                        // we don't accept out of order packet (not enough memory)
-                        if (currentTCB->remoteAck == tcpHeader.sequenceNumber)
+                        // check the ACK sequence, it should acknowledge only bytes that were sent
+                        if (TCP_SEQ_LT(currentTCB->localSeqno, tcpHeader.ackNumber))
+                        {
+                            // this is a wrong Ack
+                            // ACK a packet that wasn't transmitted
+                        }else
                         {
-                            // This is a ACK packet only
-                            // check the ACK sequence
-                            // check if this is on already received Ack
-                            if (currentTCB->localLastAck < tcpHeader.ackNumber)
+                            // an old ACK (RFC 793: SEG.ACK < SND.UNA) is ignored, the payload is not
+                            if ((uint32_t)(currentTCB->localSeqno - tcpHeader.ackNumber) <= currentTCB->bytesSent)
+                            {
+                                // the ACK is valid also when the segment is out of order
+                                TCP_AckReceived(currentTCB);
+                            }
+
+                            // check if the packet has payload
+                            if(rcvPayloadLen > 0)
                             {
-                                // check how many bytes sent was acknowledged
-                                if ((currentTCB->localSeqno + 1) >= tcpHeader.ackNumber)
-                                {
-                                    notAckBytes = currentTCB->localSeqno - tcpHeader.ackNumber;
-
-                                    // update the pointer for next TX
-                                    currentTCB->txBufferPtr = currentTCB->txBufferPtr - notAckBytes;
-                                    currentTCB->bytesToSend = currentTCB->bytesToSend  + notAckBytes;
-                                    
-                                    currentTCB->localLastAck = tcpHeader.ackNumber - 1;
-                                    currentTCB->localSeqno = tcpHeader.ackNumber;
-                                    if(bytesToSendForRetransmit == 0)
-                                    {
-                                        localSeqnoForRetransmit = currentTCB->localSeqno;
-                                    }
-                                    // Check if all TX buffer/data was acknowledged
-                                    if(currentTCB->bytesToSend == 0) 
-                                    {
-                                        if (currentTCB->txBufState == TX_BUFF_IN_USE)
-                                        {
-                                            currentTCB->txBufState = NO_BUFF;
-                                            //stop timeout
-                                            currentTCB->timeout = 0;
-                                        }
-                                    }                                    
-                                    else
-                                    {       
-                                        if(bytesToSendForRetransmit)	//jira: CAE_MCU8-6056
-                                        {
-                                            currentTCB->txBufferPtr = txBufferPtrForRetransmit;
-                                            currentTCB->bytesSent = bytesToSendForRetransmit;
-                                            currentTCB->localSeqno = localSeqnoForRetransmit;
-                                        }
-                                        else
-                                        {
-                                            currentTCB->bytesSent = currentTCB->bytesToSend;
-                                        }
-                                        currentTCB->timeoutReloadValue = TCP_START_TIMEOUT_VAL;
-                                        currentTCB->timeoutsCount = TCP_MAX_RETRIES;
-                                        TCP_Snd(currentTCB);
-                                        if( (bytesToSendForRetransmit>0) && (lastAckNumber != tcpHeader.ackNumber) )	//jira: CAE_MCU8-6056
-                                        {
-                                            bytesToSendForRetransmit =0;
-                                        }
-                                    }
-
-                                    
-                                    // check if the packet has payload
-                                    if(rcvPayloadLen > 0)
-                                    {
-                                        currentTCB->remoteSeqno =  tcpHeader.sequenceNumber;
-
-                                        // copy the payload to the local buffer
-                                        TCP_PayloadSave(rcvPayloadLen);
-                                    }
-                                }else
-                                {
-                                    // this is a wrong Ack
-                                    // ACK a packet that wasn't transmitted
-                                }
+                                // save it in order, queue it or drop a duplicate
+                                TCP_PayloadReceive(rcvPayloadLen);
                             }
                         }
                     }
@@ -1010,8 +3365,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                     logMsg("ESTABLISHED: close",LOG_INFO, LOG_DEST_CONSOLE);
                     currentTCB->flags = TCP_FIN_FLAG | TCP_ACK_FLAG ;	//jira: M8TS-514, M8TS-538, M8TS-463
                     nextState = FIN_WAIT_1;
-                    currentTCB->timeout = 0;
-                    currentTCB->timeout = TCP_START_TIMEOUT_VAL;
+                    TIMER_Start(&currentTCB->timer, TCP_START_TIMEOUT_VAL);
                     currentTCB->timeoutReloadValue = TCP_START_TIMEOUT_VAL;
                     currentTCB->timeoutsCount = TCP_MAX_RETRIES;
                     TCP_Snd(currentTCB);
@@ -1043,7 +3397,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                             }
 
                             currentTCB->socketState = SOCKET_CLOSING;
-                            currentTCB->timeout = TCP_START_TIMEOUT_VAL;
+                            TIMER_Start(&currentTCB->timer, TCP_START_TIMEOUT_VAL);
                             currentTCB->timeoutReloadValue = TCP_START_TIMEOUT_VAL;
                             currentTCB->timeoutsCount = TCP_MAX_RETRIES;
                             // JUMP over CLOSE_WAIT state and send one packet with FIN + ACK
@@ -1065,7 +3419,23 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                     logMsg("ESTABLISHED:  timeout",LOG_INFO, LOG_DEST_CONSOLE);
                     if (currentTCB->timeoutsCount)
                     {
-                        TCP_TimoutRetransmit();	//jira: CAE_MCU8-6056
+                        if (currentTCB->bytesSent > 0)
+                        {
+                            // RFC 5681: restart with one segment, ssthresh once per loss
+                            if (!TCP_SEQ_LT(currentTCB->localLastAck, currentTCB->localRecover))
+                            {
+                                TCP_CongestionLoss(currentTCB);
+                            }
+                            currentTCB->cwnd = currentTCB->mss;
+                            currentTCB->fastRecovery = false;
+                            currentTCB->dupAcks = 0;
+                            currentTCB->localRecover = currentTCB->localSeqno;
+#ifdef TCP_ENABLE_SACK
+                            // the remote may have dropped the SACKed bytes (RFC 2018 8)
+                            currentTCB->sackCount = 0;
+#endif
+                        }
+                        TCP_Retransmit(currentTCB);
                     }else
                     {
                         // reset the connection if there is no reply
@@ -1100,7 +3470,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                 case RCV_ACK:
                     logMsg("FIN_WAIT_1: rx_ack",LOG_INFO, LOG_DEST_CONSOLE);
                     // stop the current timeout
-                    currentTCB->timeout = TCP_START_TIMEOUT_VAL;
+                    TIMER_Start(&currentTCB->timer, TCP_START_TIMEOUT_VAL);
                     currentTCB->timeoutsCount = 1;
                     nextState = FIN_WAIT_2;
                     break;
@@ -1234,10 +3604,11 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                 case ACTIVE_OPEN:
                     logMsg("CLOSED: active_open",LOG_INFO, LOG_DEST_CONSOLE);
                     // create and send a SYN packet
-                    currentTCB->timeout = TCP_START_TIMEOUT_VAL;
+                    TIMER_Start(&currentTCB->timer, TCP_START_TIMEOUT_VAL);
                     currentTCB->timeoutReloadValue = TCP_START_TIMEOUT_VAL;
                     currentTCB->timeoutsCount = TCP_MAX_SYN_RETRIES;
                     currentTCB->flags = TCP_SYN_FLAG;
+                    currentTCB->options = TCP_OPT_OFFERED;
                     TCP_Snd(currentTCB);
                     nextState = SYN_SENT;
                     ret = SUCCESS;    //jira: CAE_MCU8-5647
@@ -1246,6 +3617,7 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
                     logMsg("CLOSED: passive_open",LOG_INFO, LOG_DEST_CONSOLE);
                     currentTCB->destIP = 0;
                     currentTCB->destPort = 0;
+                    TCB_Rehash(currentTCB);
                     nextState = LISTEN;
                     ret = SUCCESS;    //jira: CAE_MCU8-5647
                     break;
@@ -1262,10 +3634,72 @@ static error_msg TCP_FiniteStateMachine(void)  //jira: CAE_MCU8-5647
 }
 
 
+/** Internal function of the TCP Stack. Mark all the sockets of the pool free.
+ *
+ * @param None
+ *
+ * @return
+ *      None
+ */
+static void TCP_PoolInit(void)
+{
+#if TCP_SOCKET_POOL_SIZE > 0
+    uint8_t index;
+
+    for (index = 0; index < TCP_SOCKET_POOL_SIZE; index++)
+    {
+        poolAllocated[index] = false;
+        poolFree[index] = (uint8_t)(TCP_SOCKET_POOL_SIZE - 1u - index);
+    }
+    poolFreeCount = TCP_SOCKET_POOL_SIZE;
+#endif
+    memset(&poolStats, 0, sizeof(poolStats));
+    poolStats.size = TCP_SOCKET_POOL_SIZE;
+}
+
+#if TCP_SOCKET_POOL_SIZE > 0
+/** Internal function of the TCP Stack. Put a socket back on the free stack of
+ *  the pool, the socket is not in the TCB list.
+ *
+ * @param index
+ *      pool index of an allocated socket
+ *
+ * @return
+ *      None
+ */
+static void TCP_PoolRelease(uint8_t index)
+{
+    poolAllocated[index] = false;
+    poolFree[poolFreeCount] = index;
+    poolFreeCount++;
+    poolStats.inUse--;
+}
+#endif
+
 void TCP_Init(void)
 {
     tcbList = NULL;
     tcbListSize = 0;
+    memset(tcbHash, 0, sizeof(tcbHash));
+    lastHitTCB = NULL;
+    TCP_PoolInit();
+#ifdef TCP_ENABLE_KEEPALIVE
+    keepAliveReclaims = 0;
+#endif
+    memset(&synStats, 0, sizeof(synStats));
+#if TCP_SYN_CACHE_SIZE > 0
+    memset(synCache, 0, sizeof(synCache));     // all entries CLOSED
+    TIMER_Setup(&synCacheTimer, TCP_SynCacheExpired, NULL);
+#endif
+#ifdef TCP_ENABLE_SYN_COOKIES
+    // ETH_Init() waits for the PHY, TMR1 does not stand at the same count after each reset
+    synCookieEntropy = ((uint32_t)TMR1_ReadTimer() << 16) ^ rtcc_getTicks();
+    synCookieSecret[0] = 0;
+    synCookieSecret[1] = 0;
+    // each entry has a slot of the other parity, no secret is valid yet
+    synCookieSlot[0] = 1;
+    synCookieSlot[1] = 0;
+#endif
     nextAvailablePort = LOCAL_TCP_PORT_START_NUMBER;
     nextSequenceNumber = 0;
 }
@@ -1277,6 +3711,11 @@ error_msg TCP_SocketInit(tcpTCB_t *tcbPtr)   //jira: CAE_MCU8-5647
     // verify that this socket is not in the list
     if(TCB_Check(tcbPtr) == ERROR)    //jira: CAE_MCU8-5647
     {
+        TIMER_Setup(&tcbPtr->timer, TCP_TimerExpired, tcbPtr);
+        TIMER_Setup(&tcbPtr->ackTimer, TCP_AckTimerExpired, tcbPtr);
+#ifdef TCP_ENABLE_KEEPALIVE
+        TIMER_Setup(&tcbPtr->keepAliveTimer, TCP_KeepAliveExpired, tcbPtr);
+#endif
         TCB_Reset(tcbPtr);
 
         tcbPtr->localWnd = 0; // here we should put the RX buffer size
@@ -1284,32 +3723,172 @@ error_msg TCP_SocketInit(tcpTCB_t *tcbPtr)   //jira: CAE_MCU8-5647
         tcbPtr->fsmState = CLOSED;
         tcbPtr->connectionEvent = NOP;
         tcbPtr->rxBufferStart = NULL;
+        tcbPtr->rxBufferSize = 0;
+        tcbPtr->rxBytes = 0;
+        tcbPtr->rxRing = false;
         tcbPtr->rxBufState = NO_BUFF;
+#ifdef TCP_ENABLE_OOO_QUEUE
+        tcbPtr->oooQueue = NULL;
+        tcbPtr->oooQueueSize = 0;
+#endif
+        tcbPtr->backlog = NULL;
+        tcbPtr->backlogSize = 0;
+#ifdef TCP_ENABLE_STATS
+        memset(&tcbPtr->rxStats, 0, sizeof(tcpRxStats_t));
+        memset(&tcbPtr->txStats, 0, sizeof(tcpTxStats_t));
+#endif
         tcbPtr->txBufferStart = NULL;
-        tcbPtr->txBufferPtr = NULL;
+        tcbPtr->txBufferSize = 0;
+        tcbPtr->txBufferTail = 0;
+        tcbPtr->txRing = false;
+        tcbPtr->noDelay = false;
+#ifdef TCP_ENABLE_KEEPALIVE
+        tcbPtr->keepAliveIdle = 0;
+        tcbPtr->keepAliveInterval = 0;
+        tcbPtr->keepAliveCount = 0;
+#endif
         tcbPtr->bytesToSend = 0;
         tcbPtr->bytesSent = 0;
         tcbPtr->payloadSave = false;
+        tcbPtr->closePending = false;
         tcbPtr->txBufState = NO_BUFF;
         tcbPtr->socketState = SOCKET_CLOSED;
 
-        TCB_Insert(tcbPtr);
-        ret = SUCCESS;   //jira: CAE_MCU8-5647
+        ret = TCB_Insert(tcbPtr);
+    }
+    return ret;
+}
+
+error_msg TCP_SocketRemove(tcpTCB_t *tcbPtr)    //jira: CAE_MCU8-5647
+{
+    error_msg ret = ERROR;   //jira: CAE_MCU8-5647
+    
+    // verify that this socket is in the Closed State
+    if(TCP_SocketPoll(tcbPtr) == SOCKET_CLOSING)
+    {
+        TIMER_Stop(&tcbPtr->timer);
+        TIMER_Stop(&tcbPtr->ackTimer);
+#ifdef TCP_ENABLE_KEEPALIVE
+        TIMER_Stop(&tcbPtr->keepAliveTimer);
+#endif
+        TCB_Remove(tcbPtr);
+        ret = SUCCESS;    //jira: CAE_MCU8-5647
+    }
+    return ret;
+}
+
+tcpHandle_t TCP_SocketAlloc(void)
+{
+    tcpHandle_t socket = TCP_INVALID_SOCKET;
+#if TCP_SOCKET_POOL_SIZE > 0
+    tcpTCB_t *tcbPtr;
+    uint8_t index;
+
+    if (poolFreeCount == 0)
+    {
+        // all sockets are allocated, take back one that only waits in TIME_WAIT
+        for (index = 0; index < TCP_SOCKET_POOL_SIZE; index++)
+        {
+            tcbPtr = &tcbPool[index];
+            if ((TCB_Check(tcbPtr) == SUCCESS) && (tcbPtr->fsmState == TIME_WAIT))
+            {
+                logMsg("tcp_alloc: reuse TIME_WAIT",LOG_INFO, LOG_DEST_CONSOLE);
+                TCB_Reset(tcbPtr);
+                tcbPtr->fsmState = CLOSED;
+                TCB_Remove(tcbPtr);
+                TCP_PoolRelease(index);
+                poolStats.timeWaitReuses++;
+                break;
+            }
+        }
+    }
+
+    if (poolFreeCount > 0)
+    {
+        index = poolFree[poolFreeCount - 1u];
+        if (TCP_SocketInit(&tcbPool[index]) == SUCCESS)
+        {
+            poolFreeCount--;
+            poolAllocated[index] = true;
+            poolGeneration[index] = (poolGeneration[index] + 1u) & 0x0Fu;
+            socket = (tcpHandle_t)((uint8_t)(poolGeneration[index] << 4) | index);
+
+            poolStats.allocations++;
+            poolStats.inUse++;
+            if (poolStats.inUse > poolStats.inUseMax)
+            {
+                poolStats.inUseMax = poolStats.inUse;
+            }
+        }
+    }
+#endif
+    if (socket == TCP_INVALID_SOCKET)
+    {
+        poolStats.allocFailures++;
+    }
+    return socket;
+}
+
+error_msg TCP_SocketFree(tcpHandle_t socket)
+{
+    error_msg ret = ERROR;
+#if TCP_SOCKET_POOL_SIZE > 0
+    tcpTCB_t *tcbPtr;
+    socketState_t state;
+
+    tcbPtr = TCP_SocketPtr(socket);
+    if (tcbPtr != NULL)
+    {
+        state = TCP_SocketPoll(tcbPtr);
+        if ((state == SOCKET_CLOSED) || (state == SOCKET_CLOSING))
+        {
+            TIMER_Stop(&tcbPtr->timer);
+            TIMER_Stop(&tcbPtr->ackTimer);
+#ifdef TCP_ENABLE_KEEPALIVE
+            TIMER_Stop(&tcbPtr->keepAliveTimer);
+#endif
+            TCB_Remove(tcbPtr);
+            state = NOT_A_SOCKET;
+        }
+        if (state == NOT_A_SOCKET)
+        {
+            TCP_PoolRelease(socket & 0x0Fu);
+            ret = SUCCESS;
+        }
+    }
+#endif
+    return ret;
+}
+
+tcpTCB_t *TCP_SocketPtr(tcpHandle_t socket)
+{
+#if TCP_SOCKET_POOL_SIZE > 0
+    uint8_t index;
+
+    index = socket & 0x0Fu;
+    if ((index < TCP_SOCKET_POOL_SIZE) && (poolAllocated[index] == true) && (poolGeneration[index] == (socket >> 4)))
+    {
+        return &tcbPool[index];
     }
-    return ret;
+#endif
+    return NULL;
 }
 
-error_msg TCP_SocketRemove(tcpTCB_t *tcbPtr)    //jira: CAE_MCU8-5647
+const tcpPoolStats_t *TCP_GetPoolStats(void)
 {
-    error_msg ret = ERROR;   //jira: CAE_MCU8-5647
-    
-    // verify that this socket is in the Closed State
-    if(TCP_SocketPoll(tcbPtr) == SOCKET_CLOSING)
-    {
-        TCB_Remove(tcbPtr);
-        ret = SUCCESS;    //jira: CAE_MCU8-5647
-    }
-    return ret;
+    return &poolStats;
+}
+
+#ifdef TCP_ENABLE_KEEPALIVE
+uint16_t TCP_GetKeepAliveReclaims(void)
+{
+    return keepAliveReclaims;
+}
+#endif
+
+const tcpSynStats_t *TCP_GetSynStats(void)
+{
+    return &synStats;
 }
 
 socketState_t TCP_SocketPoll(tcpTCB_t *socket_ptr)
@@ -1336,6 +3915,7 @@ error_msg TCP_Bind(tcpTCB_t *tcbPtr, uint16_t port)    //jira: CAE_MCU8-5647
     if (TCB_Check(tcbPtr) == SUCCESS)    //jira: CAE_MCU8-5647
     {
         tcbPtr->localPort = port;
+        TCB_Rehash(tcbPtr);
         ret = SUCCESS;   //jira: CAE_MCU8-5647
     }
     return ret;
@@ -1364,6 +3944,47 @@ error_msg TCP_Listen(tcpTCB_t *tcbPtr)    //jira: CAE_MCU8-5647
 }
 
 
+error_msg TCP_SetBacklog(tcpTCB_t *tcbPtr, tcpBacklogEntry_t *backlog, uint8_t size)
+{
+    error_msg ret = ERROR;
+    uint8_t i;
+
+    if ((TCB_Check(tcbPtr) == SUCCESS) && (tcbPtr->fsmState != LISTEN))
+    {
+        tcbPtr->backlog = backlog;
+        tcbPtr->backlogSize = (backlog != NULL) ? size : 0u;
+        for (i = 0; i < tcbPtr->backlogSize; i++)
+        {
+            backlog[i].fsmState = CLOSED;
+        }
+        ret = SUCCESS;
+    }
+    return ret;
+}
+
+error_msg TCP_Accept(tcpTCB_t *listenPtr, tcpTCB_t *tcbPtr)
+{
+    error_msg ret = ERROR;
+    tcpBacklogEntry_t *entry;
+    uint8_t i;
+
+    if ((TCB_Check(listenPtr) == SUCCESS) && (listenPtr->fsmState == LISTEN) && (TCP_SocketPoll(tcbPtr) == SOCKET_CLOSED))
+    {
+        for (i = 0; i < listenPtr->backlogSize; i++)
+        {
+            entry = &listenPtr->backlog[i];
+            if (entry->fsmState == ESTABLISHED)
+            {
+                logMsg("tcp_accept",LOG_INFO, LOG_DEST_CONSOLE);
+                TCP_BacklogAdopt(tcbPtr, entry);
+                ret = SUCCESS;
+                break;
+            }
+        }
+    }
+    return ret;
+}
+
 error_msg TCP_Connect(tcpTCB_t *tcbPtr, sockaddr_in4_t *srvaddr)   //jira: CAE_MCU8-5647
 {
     error_msg ret = ERROR;     //jira: CAE_MCU8-5647
@@ -1377,6 +3998,7 @@ error_msg TCP_Connect(tcpTCB_t *tcbPtr, sockaddr_in4_t *srvaddr)   //jira: CAE_M
             // use a "random" port for the local one
             tcbPtr->localPort = nextAvailablePort++;
         }
+        TCB_Rehash(tcbPtr);
 
         tcbPtr->fsmState = CLOSED;
         tcbPtr->socketState = SOCKET_IN_PROGRESS;
@@ -1397,17 +4019,31 @@ error_msg TCP_Close(tcpTCB_t *tcbPtr)   //jira: CAE_MCU8-5647
 
     logMsg("tcp_close",LOG_INFO, LOG_DEST_CONSOLE);
 
-    if (TCB_Check(tcbPtr) == SUCCESS)    //jira: CAE_MCU8-5647
+    if ((TCB_Check(tcbPtr) == SUCCESS) && (tcbPtr->fsmState == ESTABLISHED) &&
+        ((tcbPtr->bytesSent > 0) || (tcbPtr->bytesToSend > 0)))
+    {
+        // the FIN follows the data, TCP_Recv() closes when the remote acknowledged all of it
+        tcbPtr->closePending = true;
+        ret = SUCCESS;
+    }
+    else if (TCB_Check(tcbPtr) == SUCCESS)    //jira: CAE_MCU8-5647
     {
         tcbPtr->connectionEvent = CLOSE;
-        
+        tcbPtr->closePending = false;
 
         tcbPtr->txBufState = NO_BUFF;
         tcbPtr->rxBufState = NO_BUFF;
-        tcbPtr->txBufferPtr = NULL;
         tcbPtr->txBufferStart = NULL;
-        tcbPtr->rxBufferPtr = NULL;
+        tcbPtr->txBufferSize = 0;
+        tcbPtr->txBufferTail = 0;
+        tcbPtr->txRing = false;
         tcbPtr->rxBufferStart = NULL;
+        tcbPtr->rxBufferSize = 0;
+        tcbPtr->rxBytes = 0;
+        tcbPtr->rxRing = false;
+#ifdef TCP_ENABLE_OOO_QUEUE
+        tcbPtr->oooCount = 0;
+#endif
         tcbPtr->bytesToSend = 0;
         tcbPtr->bytesSent = 0;
         tcbPtr->payloadSave = false;
@@ -1420,29 +4056,68 @@ error_msg TCP_Close(tcpTCB_t *tcbPtr)   //jira: CAE_MCU8-5647
 }
 
 
+/** Internal function of the TCP Stack. Start sending new data on a socket
+ *  with nothing in flight: set the initial congestion window and the
+ *  retransmission timer.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_TxStart(tcpTCB_t *tcbPtr)
+{
+    tcbPtr->localLastAck = tcbPtr->localSeqno;
+    tcbPtr->localRecover = tcbPtr->localSeqno;
+
+    if (tcbPtr->cwnd == 0)
+    {
+        // initial window of RFC 5681
+        tcbPtr->cwnd = (tcbPtr->mss > 2190u) ? (2u * tcbPtr->mss) : ((tcbPtr->mss > 1095u) ? (3u * tcbPtr->mss) : (4u * tcbPtr->mss));
+        if (tcbPtr->cwnd > TCP_MAX_TX_WINDOW)
+        {
+            tcbPtr->cwnd = TCP_MAX_TX_WINDOW;
+        }
+    }
+
+    tcbPtr->txBufState = TX_BUFF_IN_USE;
+
+    TIMER_Start(&tcbPtr->timer, tcbPtr->rto);
+    tcbPtr->timeoutReloadValue = tcbPtr->rto;
+    tcbPtr->timeoutsCount = TCP_MAX_RETRIES;
+}
+
 error_msg TCP_Send(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t dataLen)    //jira: CAE_MCU8-5647
 {
     error_msg ret = ERROR;    //jira: CAE_MCU8-5647
 
     if (TCP_SocketPoll(tcbPtr) == SOCKET_CONNECTED)
     {
-        if (tcbPtr->txBufState == NO_BUFF)
+        if (tcbPtr->txRing == true)
+        {
+            // copy all or nothing to the ring
+            if ((data != NULL) && (TCP_GetTxFree(tcbPtr) >= dataLen))
+            {
+                TCP_Write(tcbPtr, data, dataLen);
+                ret = SUCCESS;
+            }
+        }
+        else if (tcbPtr->txBufState == NO_BUFF)
         {
             if (data != NULL)
             {
                 tcbPtr->txBufferStart = data;
-                tcbPtr->txBufferPtr = tcbPtr->txBufferStart;
+                tcbPtr->txBufferSize = dataLen;
+                tcbPtr->txBufferTail = 0;
                 tcbPtr->bytesToSend = dataLen;
-                tcbPtr->txBufState = TX_BUFF_IN_USE;
-                tcbPtr->bytesSent = dataLen;
-
-                tcbPtr->timeout = TCP_START_TIMEOUT_VAL; 
-                tcbPtr->timeoutReloadValue = TCP_START_TIMEOUT_VAL;
-                tcbPtr->timeoutsCount = TCP_MAX_RETRIES;
+                tcbPtr->bytesSent = 0;
 
-                tcbPtr->flags = TCP_ACK_FLAG;
-
-                TCP_Snd(tcbPtr);
+                if (dataLen > 0)
+                {
+                    TCP_TxStart(tcbPtr);
+                    TCP_SndData(tcbPtr);
+                }
                 ret = SUCCESS;    //jira: CAE_MCU8-5647
             }
         }
@@ -1450,6 +4125,103 @@ error_msg TCP_Send(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t dataLen)    //jira:
     return ret;
 }
 
+error_msg TCP_InsertTxBuffer(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t dataLen)
+{
+    error_msg ret = ERROR;
+
+    if (TCB_Check(tcbPtr) == SUCCESS)
+    {
+        if ((tcbPtr->txBufState == NO_BUFF) && (data != NULL) && (dataLen > 0))
+        {
+            tcbPtr->txBufferStart = data;
+            tcbPtr->txBufferSize = dataLen;
+            tcbPtr->txBufferTail = 0;
+            tcbPtr->bytesToSend = 0;
+            tcbPtr->bytesSent = 0;
+            tcbPtr->txRing = true;
+            ret = SUCCESS;
+        }
+    }
+    return ret;
+}
+
+uint16_t TCP_Write(tcpTCB_t *tcbPtr, const uint8_t *data, uint16_t dataLen)
+{
+    uint16_t index;
+    uint16_t length;
+
+    if ((TCP_SocketPoll(tcbPtr) != SOCKET_CONNECTED) || (tcbPtr->txRing == false) || (data == NULL))
+    {
+        return 0;
+    }
+
+    if (dataLen > TCP_GetTxFree(tcbPtr))
+    {
+        dataLen = TCP_GetTxFree(tcbPtr);
+    }
+    if (dataLen > 0)
+    {
+        if ((tcbPtr->bytesSent == 0) && (tcbPtr->bytesToSend == 0))
+        {
+            TCP_TxStart(tcbPtr);
+        }
+
+        // copy after the unsent data, wrap around the end of the ring
+        index = TCP_TxIndex(tcbPtr, tcbPtr->bytesSent + tcbPtr->bytesToSend);
+        length = tcbPtr->txBufferSize - index;
+        if (length > dataLen)
+        {
+            length = dataLen;
+        }
+        memcpy(tcbPtr->txBufferStart + index, data, length);
+        memcpy(tcbPtr->txBufferStart, data + length, dataLen - length);
+        tcbPtr->bytesToSend = tcbPtr->bytesToSend + dataLen;
+
+        TCP_SndData(tcbPtr);
+    }
+    return dataLen;
+}
+
+uint16_t TCP_GetTxFree(tcpTCB_t *tcbPtr)
+{
+    uint16_t ret = 0;
+
+    if ((TCB_Check(tcbPtr) == SUCCESS) && (tcbPtr->txRing == true) && (tcbPtr->closePending == false))
+    {
+        ret = tcbPtr->txBufferSize - tcbPtr->bytesSent - tcbPtr->bytesToSend;
+    }
+    return ret;
+}
+
+error_msg TCP_SetNoDelay(tcpTCB_t *tcbPtr, bool noDelay)
+{
+    error_msg ret = ERROR;
+
+    if (TCB_Check(tcbPtr) == SUCCESS)
+    {
+        tcbPtr->noDelay = noDelay;
+        ret = SUCCESS;
+    }
+    return ret;
+}
+
+#ifdef TCP_ENABLE_KEEPALIVE
+error_msg TCP_SetKeepAlive(tcpTCB_t *tcbPtr, uint16_t idle, uint16_t interval, uint8_t count)
+{
+    error_msg ret = ERROR;
+
+    if ((TCB_Check(tcbPtr) == SUCCESS) && ((idle == 0) || (interval > 0)))
+    {
+        tcbPtr->keepAliveIdle = idle;
+        tcbPtr->keepAliveInterval = interval;
+        tcbPtr->keepAliveCount = count;
+        TCP_KeepAliveRestart(tcbPtr);
+        ret = SUCCESS;
+    }
+    return ret;
+}
+#endif
+
 
 error_msg TCP_SendDone(tcpTCB_t *tcbPtr)    //jira: CAE_MCU8-5647
 {
@@ -1465,6 +4237,31 @@ error_msg TCP_SendDone(tcpTCB_t *tcbPtr)    //jira: CAE_MCU8-5647
     return ret;
 }
 
+/** Internal function of the TCP Stack. Announce the window that the
+ *  application opened, when it grows by min(mss, RX memory / 2) or more
+ *  (RFC 1122 4.2.3.3). Without it the remote waits for its persist timer.
+ * 
+ * @param tcbPtr
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_WindowUpdate(tcpTCB_t *tcbPtr)
+{
+    error_msg ret;
+
+    if (((tcbPtr->fsmState == ESTABLISHED) || (tcbPtr->fsmState == FIN_WAIT_1) || (tcbPtr->fsmState == FIN_WAIT_2))
+        && ((int32_t)(tcbPtr->remoteAck + tcbPtr->localWnd - tcbPtr->localWndEdge) >= (int32_t)TCP_RxWndThreshold(tcbPtr)))
+    {
+        ret = TCP_SndAck(tcbPtr);
+        if ((ret == SUCCESS) || (ret == TX_QUEUED))
+        {
+            TCP_CountRx(tcbPtr, windowUpdates);
+        }
+    }
+}
+
 error_msg TCP_InsertRxBuffer(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t data_len)     //jira: CAE_MCU8-5647
 {
     error_msg ret = ERROR;     //jira: CAE_MCU8-5647
@@ -1476,9 +4273,13 @@ error_msg TCP_InsertRxBuffer(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t data_len)
             if (data != NULL)
             {
                 tcbPtr->rxBufferStart = data;
-                tcbPtr->rxBufferPtr = tcbPtr->rxBufferStart;
+                tcbPtr->rxBufferSize = data_len;
+                tcbPtr->rxBufferHead = 0;
+                tcbPtr->rxBufferTail = 0;
+                tcbPtr->rxBytes = 0;
                 tcbPtr->localWnd = data_len;  // update the available receive windows
                 tcbPtr->rxBufState = RX_BUFF_IN_USE;
+                TCP_WindowUpdate(tcbPtr);
                 ret = SUCCESS;    //jira: CAE_MCU8-5647
             }
         }
@@ -1486,6 +4287,53 @@ error_msg TCP_InsertRxBuffer(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t data_len)
     return ret;
 }
 
+error_msg TCP_InsertRxRing(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t dataLen)
+{
+    error_msg ret;
+
+    ret = TCP_InsertRxBuffer(tcbPtr, data, dataLen);
+    if (ret == SUCCESS)
+    {
+        tcbPtr->rxRing = true;
+    }
+    return ret;
+}
+
+uint16_t TCP_Read(tcpTCB_t *tcbPtr, uint8_t *data, uint16_t dataLen)
+{
+    uint16_t length;
+
+    if ((TCB_Check(tcbPtr) != SUCCESS) || (tcbPtr->rxRing == false) || (data == NULL))
+    {
+        return 0;
+    }
+
+    if (dataLen > tcbPtr->rxBytes)
+    {
+        dataLen = tcbPtr->rxBytes;
+    }
+    if (dataLen > 0)
+    {
+        // copy from the oldest byte, wrap around the end of the ring
+        length = tcbPtr->rxBufferSize - tcbPtr->rxBufferTail;
+        if (length > dataLen)
+        {
+            length = dataLen;
+        }
+        memcpy(data, tcbPtr->rxBufferStart + tcbPtr->rxBufferTail, length);
+        memcpy(data + length, tcbPtr->rxBufferStart, dataLen - length);
+        tcbPtr->rxBufferTail = tcbPtr->rxBufferTail + dataLen;
+        if (tcbPtr->rxBufferTail >= tcbPtr->rxBufferSize)
+        {
+            tcbPtr->rxBufferTail = tcbPtr->rxBufferTail - tcbPtr->rxBufferSize;
+        }
+        tcbPtr->rxBytes = tcbPtr->rxBytes - dataLen;
+        tcbPtr->localWnd = tcbPtr->localWnd + dataLen;
+        TCP_WindowUpdate(tcbPtr);
+    }
+    return dataLen;
+}
+
 
 int16_t TCP_GetReceivedData(tcpTCB_t *tcbPtr)
 {
@@ -1493,14 +4341,18 @@ int16_t TCP_GetReceivedData(tcpTCB_t *tcbPtr)
 
     if (TCB_Check(tcbPtr) == SUCCESS)     //jira: CAE_MCU8-5647
     {
-        if (tcbPtr->rxBufState == RX_BUFF_IN_USE)
+        if ((tcbPtr->rxBufState == RX_BUFF_IN_USE) && (tcbPtr->rxRing == false))
         {
-            ret = tcbPtr->rxBufferPtr - tcbPtr->rxBufferStart;
+            ret = (int16_t)tcbPtr->rxBytes;
 
             if (ret != 0)
             {
                 tcbPtr->localWnd = 0;
                 tcbPtr->rxBufState = NO_BUFF;
+#ifdef TCP_ENABLE_OOO_QUEUE
+                // the out of order data stays in the buffer given to the application
+                tcbPtr->oooCount = 0;
+#endif
             }
         }
     }
@@ -1515,18 +4367,77 @@ int16_t TCP_GetRxLength(tcpTCB_t *tcbPtr)
     {
         if (tcbPtr->rxBufState == RX_BUFF_IN_USE)
         {
-            ret = tcbPtr->rxBufferPtr - tcbPtr->rxBufferStart;
+            ret = (int16_t)tcbPtr->rxBytes;
         }
     }
     return ret;
 }
 
-void TCP_Update(void)
+error_msg TCP_GetRttStats(tcpTCB_t *tcbPtr, tcpRttStats_t *stats)
 {
-    tcpTCB_t *tcbPtr;
-    tcbPtr = NULL;
-    int count = 0;
+    error_msg ret = ERROR;
+
+    if ((TCB_Check(tcbPtr) == SUCCESS) && (stats != NULL))
+    {
+        stats->srtt = tcbPtr->srtt >> 3;
+        stats->rttvar = tcbPtr->rttvar >> 2;
+        stats->rto = tcbPtr->rto;
+        stats->lastRtt = tcbPtr->lastRtt;
+        stats->rttSamples = tcbPtr->rttSamples;
+        stats->retransmits = tcbPtr->retransmits;
+        ret = SUCCESS;
+    }
+    return ret;
+}
+
+#ifdef TCP_ENABLE_OOO_QUEUE
+error_msg TCP_SetOooQueue(tcpTCB_t *tcbPtr, tcpOooRange_t *queue, uint8_t size)
+{
+    error_msg ret = ERROR;
+
+    if (TCB_Check(tcbPtr) == SUCCESS)
+    {
+        tcbPtr->oooQueue = queue;
+        tcbPtr->oooQueueSize = (queue != NULL) ? size : 0u;
+        tcbPtr->oooCount = 0;
+        ret = SUCCESS;
+    }
+    return ret;
+}
+#endif
+
+#ifdef TCP_ENABLE_STATS
+error_msg TCP_GetTxStats(tcpTCB_t *tcbPtr, tcpTxStats_t *stats)
+{
+    error_msg ret = ERROR;
+
+    if ((TCB_Check(tcbPtr) == SUCCESS) && (stats != NULL))
+    {
+        *stats = tcbPtr->txStats;
+        stats->cwnd = tcbPtr->cwnd;
+        stats->ssthresh = tcbPtr->ssthresh;
+        ret = SUCCESS;
+    }
+    return ret;
+}
+#endif
+
+#ifdef TCP_ENABLE_STATS
+error_msg TCP_GetRxStats(tcpTCB_t *tcbPtr, tcpRxStats_t *stats)
+{
+    error_msg ret = ERROR;
+
+    if ((TCB_Check(tcbPtr) == SUCCESS) && (stats != NULL))
+    {
+        *stats = tcbPtr->rxStats;
+        ret = SUCCESS;
+    }
+    return ret;
+}
+#endif
 
+void TCP_Update(void)
+{
     // update sequence number and local port number in order to be different
     // for each new connection
     nextSequenceNumber++;
@@ -1538,45 +4449,122 @@ void TCP_Update(void)
         nextAvailablePort = LOCAL_TCP_PORT_START_NUMBER;
     }
     //TO DO also local seq number should be "random"
+}
+
+/** Timer wheel handler of the socket retransmission timer.
+ * 
+ * @param context
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_TimerExpired(void *context)
+{
+    tcpTCB_t *tcbPtr = (tcpTCB_t *)context;
+    uint32_t timeout;
+    int retries;
 
-    tcbPtr = tcbList;
-    while((tcbPtr != NULL) && (count < tcbListSize))
+    logMsg("tcp timeout",LOG_INFO, LOG_DEST_CONSOLE);
+    // MAKE sure we don't overwrite anything else
+    if (tcbPtr->connectionEvent == NOP)
     {
-        if (tcbPtr->timeout > 0)
+        retries = TCP_MAX_RETRIES - tcbPtr->timeoutsCount; // Jira: CAE_MCU8-5772
+        if(retries < 0){
+            retries = 0;
+        }
+        // exponential backoff, limited to TCP_MAX_RTO
+        timeout = (uint32_t)tcbPtr->timeoutReloadValue << retries;
+        if (timeout > TCP_MAX_RTO)
         {
-            logMsg("tcp timeout",LOG_INFO, LOG_DEST_CONSOLE);
-            tcbPtr->timeout = tcbPtr->timeout - 1;
+            timeout = TCP_MAX_RTO;
+        }
+        TIMER_Start(&tcbPtr->timer, timeout);
+        //if not zero
+        if (tcbPtr->timeoutsCount != 0)
+            tcbPtr->timeoutsCount = tcbPtr->timeoutsCount - 1u;  //jira: CAE_MCU8-5647
+        tcbPtr->connectionEvent = TIMEOUT;
+        currentTCB = tcbPtr;
+        TCP_FiniteStateMachine();
+    }
+}
 
-            if (tcbPtr->timeout == 0)
-            {
-                // MAKE sure we don't overwrite anything else
-                if (tcbPtr->connectionEvent == NOP)
-                {
-                    int retries = TCP_MAX_RETRIES - tcbPtr->timeoutsCount; // Jira: CAE_MCU8-5772
-                    if(retries < 0){
-                        retries = 0;
-                    }
-                    tcbPtr->timeout = tcbPtr->timeoutReloadValue << retries; 
-                    //if not zero
-                    if (tcbPtr->timeoutsCount != 0)
-                        tcbPtr->timeoutsCount = tcbPtr->timeoutsCount - 1u;  //jira: CAE_MCU8-5647
-                    tcbPtr->connectionEvent = TIMEOUT;
-                    currentTCB = tcbPtr;
-                    TCP_FiniteStateMachine();
-                }
-            }
+/** Timer wheel handler of the delayed ACK timer.
+ * 
+ * @param context
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_AckTimerExpired(void *context)
+{
+    tcpTCB_t *tcbPtr = (tcpTCB_t *)context;
+    error_msg ret;
+
+    if (tcbPtr->ackPending > 0)
+    {
+        ret = TCP_SndAck(tcbPtr);
+        if ((ret == SUCCESS) || (ret == TX_QUEUED))
+        {
+            TCP_CountRx(tcbPtr, acksDelayed);
         }
-        tcbPtr = tcbPtr->nextTCB;
-        count ++;
     }
 }
 
-static error_msg TCP_TimoutRetransmit(void)	//jira: CAE_MCU8-6056
+#ifdef TCP_ENABLE_KEEPALIVE
+/** Timer wheel handler of the keep-alive timer. Nothing was received for the
+ *  idle time or since the last probe: send the next probe or reset the
+ *  connection when all probes are unanswered.
+ * 
+ * @param context
+ *      pointer to the socket/TCB structure
+ * 
+ * @return
+ *      None
+ */
+static void TCP_KeepAliveExpired(void *context)
 {
-    currentTCB->txBufferPtr -= tcpDataLength;
-    txBufferPtrForRetransmit = currentTCB->txBufferPtr;
-    bytesToSendForRetransmit = tcpDataLength;
-    currentTCB->localSeqno = localSeqnoForRetransmit;
-    lastAckNumber = tcpHeader.ackNumber;
-    return TCP_Snd(currentTCB);
-}
\ No newline at end of file
+    tcpTCB_t *tcbPtr = (tcpTCB_t *)context;
+    error_msg ret;
+
+    if (tcbPtr->fsmState != ESTABLISHED)
+    {
+        return;
+    }
+
+    if (tcbPtr->bytesSent > 0)
+    {
+        // the retransmission time-out resets a remote that does not acknowledge the data
+        TIMER_Start(&tcbPtr->keepAliveTimer, (uint32_t)tcbPtr->keepAliveIdle * TICK_SECOND);
+    }
+    else if (tcbPtr->keepAliveProbes < tcbPtr->keepAliveCount)
+    {
+        // RFC 1122 4.2.3.6: an old sequence number, the remote answers with an ACK
+        logMsg("tcp keep-alive",LOG_INFO, LOG_DEST_CONSOLE);
+        tcbPtr->flags = TCP_ACK_FLAG;
+        ret = TCP_SndSegment(tcbPtr, tcbPtr->localSeqno - 1u, 0, 0);
+        if ((ret == SUCCESS) || (ret == TX_QUEUED))
+        {
+            tcbPtr->keepAliveProbes++;
+            TIMER_Start(&tcbPtr->keepAliveTimer, (uint32_t)tcbPtr->keepAliveInterval * TICK_SECOND);
+        }
+        else
+        {
+            // no room in the TX buffer, try again on the next millisecond
+            TIMER_Start(&tcbPtr->keepAliveTimer, 1);
+        }
+    }
+    else
+    {
+        // the remote is gone, give the socket back to the application
+        logMsg("tcp keep-alive: no reply",LOG_INFO, LOG_DEST_CONSOLE);
+        tcbPtr->flags = TCP_RST_FLAG;
+        TCP_SndSegment(tcbPtr, tcbPtr->localSeqno, 0, 0);
+        tcbPtr->connectionEvent = NOP;
+        tcbPtr->fsmState = CLOSED;
+        TCB_Reset(tcbPtr);
+        keepAliveReclaims++;
+    }
+}
+#endif
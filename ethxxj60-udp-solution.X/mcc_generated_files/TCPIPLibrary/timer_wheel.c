@@ -0,0 +1,246 @@
+/**
+ Timer Wheel implementation
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    timer_wheel.c
+
+  Summary:
+    Millisecond protocol timers.
+
+  Description:
+    This file provides the hierarchical timer wheel used by the protocol timers.
+    Level 0 has one slot per millisecond, each following level has slots
+    TIMER_WHEEL_SLOTS times longer. A timer is put in the lowest level that
+    covers its delay and moves down one level each time the lower level wraps.
+    The wheel follows the millisecond tick of rtcc.c (Timer 1 interrupt), the
+    handlers run from the main loop in TIMER_Service().
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#include <stddef.h>
+#include "timer_wheel.h"
+#include "rtcc.h"
+
+// 4 levels of 16 slots: 16 ms, 256 ms, 4 s and 65 s, longer timers wait in the last slot
+#define TIMER_WHEEL_LEVELS      4u
+#define TIMER_WHEEL_SLOT_BITS   4u
+#define TIMER_WHEEL_SLOTS       (1u << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_MASK        (TIMER_WHEEL_SLOTS - 1u)
+#define TIMER_WHEEL_RANGE       (1ul << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS))
+
+static netTimer_t *timerWheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+static uint32_t wheelTime;          // last tick serviced
+static uint16_t runningTimers;
+
+/** Put a timer in the wheel slot that matches its expiration time.
+ *
+ * @param timer
+ *      pointer to a timer that is not in the wheel
+ *
+ * @return
+ *      None
+ */
+static void TIMER_Insert(netTimer_t *timer)
+{
+    uint32_t delta;
+    uint32_t position;
+    uint8_t level;
+    uint8_t shift;
+    netTimer_t **slot;
+
+    delta = timer->expires - wheelTime;
+    position = timer->expires;
+    level = 0;
+    shift = 0;
+    while ((level < (TIMER_WHEEL_LEVELS - 1u)) && (delta >= (1ul << (shift + TIMER_WHEEL_SLOT_BITS))))
+    {
+        level++;
+        shift = shift + TIMER_WHEEL_SLOT_BITS;
+    }
+    if (delta >= TIMER_WHEEL_RANGE)
+    {
+        // beyond the wheel, wait in the farthest slot and get sorted again from there
+        position = wheelTime + TIMER_WHEEL_RANGE - 1u;
+    }
+
+    slot = &timerWheel[level][(position >> shift) & TIMER_WHEEL_MASK];
+    timer->next = *slot;
+    if (timer->next != NULL)
+    {
+        timer->next->link = &timer->next;
+    }
+    *slot = timer;
+    timer->link = slot;
+}
+
+/** Take a timer out of its wheel slot.
+ *
+ * @param timer
+ *      pointer to a timer in the wheel
+ *
+ * @return
+ *      None
+ */
+static void TIMER_Unlink(netTimer_t *timer)
+{
+    *timer->link = timer->next;
+    if (timer->next != NULL)
+    {
+        timer->next->link = timer->link;
+    }
+    timer->next = NULL;
+    timer->link = NULL;
+}
+
+/** Move the timers of a slot to the lower levels.
+ *
+ * @param level
+ *      wheel level, 1 or higher
+ *
+ * @param index
+ *      slot index in the level
+ *
+ * @return
+ *      None
+ */
+static void TIMER_Cascade(uint8_t level, uint8_t index)
+{
+    netTimer_t *timer;
+
+    while ((timer = timerWheel[level][index]) != NULL)
+    {
+        TIMER_Unlink(timer);
+        TIMER_Insert(timer);
+    }
+}
+
+void TIMER_WheelInit(void)
+{
+    uint8_t level;
+    uint8_t index;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        for (index = 0; index < TIMER_WHEEL_SLOTS; index++)
+        {
+            timerWheel[level][index] = NULL;
+        }
+    }
+    runningTimers = 0;
+    wheelTime = rtcc_getTicks();
+}
+
+void TIMER_Setup(netTimer_t *timer, netTimerHandler_t handler, void *context)
+{
+    timer->next = NULL;
+    timer->link = NULL;
+    timer->expires = 0;
+    timer->handler = handler;
+    timer->context = context;
+}
+
+void TIMER_Start(netTimer_t *timer, uint32_t ms)
+{
+    TIMER_Stop(timer);
+
+    if (ms == 0)
+    {
+        ms = 1;
+    }
+    timer->expires = rtcc_getTicks() + ms;
+    TIMER_Insert(timer);
+    runningTimers++;
+}
+
+void TIMER_Stop(netTimer_t *timer)
+{
+    if (timer->link != NULL)
+    {
+        TIMER_Unlink(timer);
+        runningTimers--;
+    }
+}
+
+bool TIMER_IsRunning(netTimer_t *timer)
+{
+    return (timer->link != NULL);
+}
+
+void TIMER_Service(void)
+{
+    uint32_t now;
+    uint8_t level;
+    uint8_t shift;
+    netTimer_t *timer;
+    netTimer_t **slot;
+
+    now = rtcc_getTicks();
+    while (wheelTime != now)
+    {
+        if (runningTimers == 0)
+        {
+            // nothing to expire, jump to the current tick
+            wheelTime = now;
+            break;
+        }
+        wheelTime++;
+
+        // at the start of each turn of a level, move the next slot of the level above down
+        shift = TIMER_WHEEL_SLOT_BITS;
+        for (level = 1; level < TIMER_WHEEL_LEVELS; level++)
+        {
+            if ((wheelTime & ((1ul << shift) - 1u)) != 0)
+            {
+                break;
+            }
+            TIMER_Cascade(level, (uint8_t)((wheelTime >> shift) & TIMER_WHEEL_MASK));
+            shift = shift + TIMER_WHEEL_SLOT_BITS;
+        }
+
+        slot = &timerWheel[0][wheelTime & TIMER_WHEEL_MASK];
+        while ((timer = *slot) != NULL)
+        {
+            TIMER_Unlink(timer);
+            if (timer->expires == wheelTime)
+            {
+                runningTimers--;
+                // the handler may start the timer again
+                timer->handler(timer->context);
+            }
+            else
+            {
+                TIMER_Insert(timer);
+            }
+        }
+    }
+}
+
+uint16_t TIMER_GetRunningCount(void)
+{
+    return runningTimers;
+}
@@ -60,7 +60,7 @@
 
 #endif
 
-#define TMR1_INTERRUPT_TICKER_FACTOR    41
+#define TMR1_INTERRUPT_TICKER_FACTOR    1
 
 /**
   Section: TMR1 APIs
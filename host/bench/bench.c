@@ -0,0 +1,110 @@
+/**
+  Benchmarks of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    bench.c
+
+  Summary:
+    Common setup of the benchmarks in host/bench.
+
+  Description:
+    See bench.h.
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <xc.h>
+#include "bench.h"
+#include "mcc.h"
+#include "TCPIPLibrary/network.h"
+#include "TCPIPLibrary/ip_database.h"
+
+#define LEASE_TIMEOUT       (10000 * PEER_MS)
+
+static bool failed;
+
+static bool leased(void)
+{
+    return PEER_Leased() && (ipdb_getAddress() == PEER_DEVICE_ADDRESS);
+}
+
+void BENCH_Init(void)
+{
+    J60_Init();
+    PEER_Init(BENCH_LATENCY);
+    PEER_SetTrace(getenv("HOST_TRACE") != NULL);
+
+    SYSTEM_Initialize();
+    INTERRUPT_GlobalInterruptEnable();
+    INTERRUPT_PeripheralInterruptEnable();
+
+    if(!BENCH_Run(leased, LEASE_TIMEOUT))
+    {
+        BENCH_Check(false, "DHCP lease");
+        exit(BENCH_Exit());
+    }
+    // the device learns the MAC address of the peer, the first frame of a benchmark is not held by ARP
+    PEER_ArpRequest();
+    BENCH_Run(NULL, PEER_MS);
+}
+
+bool BENCH_Run(benchPoll_t poll, uint64_t timeout)
+{
+    uint64_t end = J60_Now() + timeout;
+
+    while(J60_Now() < end)
+    {
+        Network_Manage();
+        if(poll && poll())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BENCH_Result(const char *name, double value, const char *unit)
+{
+    printf("%-24s %12.1f %s\n", name, value, unit);
+}
+
+void BENCH_Check(bool condition, const char *what)
+{
+    if(!condition)
+    {
+        printf("check failed: %s\n", what);
+        failed = true;
+    }
+}
+
+int BENCH_Exit(void)
+{
+    printf("%s\n", failed ? "FAILED" : "PASSED");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,92 @@
+/**
+  Benchmarks of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    bench.h
+
+  Summary:
+    Common setup of the benchmarks in host/bench.
+
+  Description:
+    A benchmark replaces host_main.c: it brings the stack up on the MAC model
+    with the link partner, takes the DHCP lease and then drives the stack
+    directly, calling Network_Manage() from BENCH_Run() like the main loop of
+    a project. Results are printed one per line as "name value unit", all
+    times are model time.
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "j60_model.h"
+#include "peer.h"
+
+#define BENCH_LATENCY       (50 * PEER_MS / 1000)  // one way, 50 us
+
+typedef bool (*benchPoll_t)(void);
+
+/**
+ * Start the model, the link partner and the stack, take the DHCP lease and
+ * let the device learn the MAC address of the peer from an ARP request.
+ * Exits with FAILED if the device does not get PEER_DEVICE_ADDRESS.
+ */
+void BENCH_Init(void);
+
+/**
+ * Run the main loop: Network_Manage() then poll, until poll returns true
+ * @param poll     the application of the benchmark, NULL for none
+ * @param timeout  model time, ns
+ * @return true if poll returned true before the timeout
+ */
+bool BENCH_Run(benchPoll_t poll, uint64_t timeout);
+
+/**
+ * Print a result
+ * @param name
+ * @param value
+ * @param unit
+ */
+void BENCH_Result(const char *name, double value, const char *unit);
+
+/**
+ * Print a failed check, the benchmark ends with FAILED
+ * @param condition
+ * @param what
+ */
+void BENCH_Check(bool condition, const char *what);
+
+/**
+ * Print PASSED or FAILED
+ * @return exit code of the benchmark
+ */
+int BENCH_Exit(void);
+
+#endif // BENCH_H
@@ -0,0 +1,156 @@
+/**
+  DNS answer benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    dns.c
+
+  Summary:
+    Matching of DNS answers to the names waiting in the DNS cache.
+
+  Description:
+    The peer is the DNS server leased with DHCP. It answers every query of
+    DNS_Lookup() with the name given for the case, and the bench checks
+    whether the address reached the cache:
+    - the same name in another case must resolve, DNS names are not case
+      sensitive
+    - a label longer than the host name must not resolve, even if it holds
+      a NUL byte and the bytes after the end of the host name in memory
+      match the rest of the label
+
+      make BENCH=dns run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/dns_client.h"
+
+#define DNS_PORT            53
+#define ANSWER_ADDRESS      0x0A000001u
+#define TIMEOUT             (1000 * PEER_MS)
+#define LABELS(labels)      .answer = labels, .answerLength = sizeof(labels) - 1
+
+typedef struct
+{
+    const char *name;       // looked up by the device
+    const char *answer;     // labels of the question in the answer, length bytes included
+    uint8_t answerLength;
+    bool resolves;
+} dnsCase_t;
+
+// the name of the second case ends at "co", the bytes behind it make "com"
+static const char lookupLong[] = "host.example.co\0m";
+
+static const dnsCase_t cases[] =
+{
+    {.name = "Host.Example.com", LABELS("\4hOST\7EXAMPLE\3com"), .resolves = true},
+    {.name = lookupLong, LABELS("\4host\7example\4co\0m"), .resolves = false},
+    {.name = "www.example.com", LABELS("\3www\7example\3com"), .resolves = true},
+};
+
+static const dnsCase_t *current;
+static bool answered;
+
+static void put16(uint8_t *p, uint16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value & 0xFF;
+}
+
+static void dnsServer(const uint8_t *frame, uint16_t length)
+{
+    uint8_t reply[128], *p;
+
+    if((length < 14 + 20 + 8 + 12) || (frame[23] != 17) || (((frame[36] << 8) | frame[37]) != DNS_PORT) || (current == NULL))
+    {
+        return;
+    }
+    memcpy(reply, &frame[42], 2);   // xid
+    put16(reply + 2, 0x8180);       // response, recursion available
+    put16(reply + 4, 1);            // questions
+    put16(reply + 6, 1);            // answers
+    put16(reply + 8, 0);
+    put16(reply + 10, 0);
+    p = reply + 12;
+    memcpy(p, current->answer, current->answerLength);
+    p += current->answerLength;
+    *p++ = 0;
+    put16(p, 1);                    // type A
+    put16(p + 2, 1);                // class IN
+    p += 4;
+    put16(p, 0xC00C);               // name, pointer to the question
+    put16(p + 2, 1);
+    put16(p + 4, 1);
+    put16(p + 6, 0);                // ttl
+    put16(p + 8, 300);
+    put16(p + 10, 4);
+    put16(p + 12, ANSWER_ADDRESS >> 16);
+    put16(p + 14, ANSWER_ADDRESS & 0xFFFF);
+    p += 16;
+    PEER_UdpSend(DNS_PORT, (frame[34] << 8) | frame[35], reply, p - reply);
+    current = NULL;     // one answer per case, later queries of the name stay unanswered
+    answered = true;
+}
+
+static bool answerReceived(void)
+{
+    return answered;
+}
+
+int main(void)
+{
+    uint32_t address;
+    uint8_t resolved = 0;
+    unsigned i;
+
+    BENCH_Init();
+    PEER_SetRxHandler(dnsServer);
+
+    for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        current = &cases[i];
+        answered = false;
+        BENCH_Check(DNS_Lookup(current->name) == 0, "name not cached before the query");
+        BENCH_Check(BENCH_Run(answerReceived, TIMEOUT), "query answered");
+        BENCH_Run(NULL, PEER_MS);
+        address = DNS_Lookup(cases[i].name);
+        printf("%-24s %s\n", cases[i].name, address ? "resolved" : "not resolved");
+        BENCH_Check((address == ANSWER_ADDRESS) == cases[i].resolves, cases[i].name);
+        if(address)
+        {
+            resolved++;
+        }
+        // a name that did not resolve was queried again, that query stays unanswered
+        BENCH_Run(NULL, PEER_MS);
+    }
+    BENCH_Result("names resolved", resolved, "names");
+
+    return BENCH_Exit();
+}
@@ -0,0 +1,237 @@
+/**
+  TCP keep-alive benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    keepalive.c
+
+  Summary:
+    Keep-alive probes of an idle connection and the reset of a connection
+    whose remote is gone.
+
+  Description:
+    The device listens with a keep-alive of KEEPALIVE_IDLE s, probes every
+    KEEPALIVE_INTERVAL s and KEEPALIVE_COUNT probes, the peer connects and
+    stays idle:
+    - while the peer answers, one probe per idle time and no reset
+    - when the peer forgets the connection at a probe, KEEPALIVE_COUNT
+      probes in all, then a reset KEEPALIVE_COUNT intervals after the first
+    - the same while segments with the address and ports of the connection
+      but outside its receive window arrive every SPOOF_PERIOD: they are
+      not accepted and must not keep the connection
+
+      make BENCH=keepalive run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#define SERVER_PORT         7
+#define PEER_PORT           40000
+#define KEEPALIVE_IDLE      2       // s
+#define KEEPALIVE_INTERVAL  1       // s
+#define KEEPALIVE_COUNT     3
+#define IDLE_TIME           (20000 * PEER_MS)
+#define SPOOF_PERIOD        (500 * PEER_MS)
+#define SPOOF_DISTANCE      100000u // bytes beyond the next sequence number of the peer
+#define TIMEOUT             (10000 * PEER_MS)
+
+static tcpTCB_t server;
+static uint8_t rxBuffer[512];
+static peerTcp_t tcp;
+static uint32_t probes;
+static uint64_t firstProbe;
+static uint64_t reset;
+static bool leaveAtProbe;
+static bool spoof;
+static uint64_t nextSpoof;
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return ((uint32_t)get16(p) << 16) | get16(p + 2);
+}
+
+static void put32(uint8_t *p, uint32_t value)
+{
+    p[0] = value >> 24;
+    p[1] = (value >> 16) & 0xFF;
+    p[2] = (value >> 8) & 0xFF;
+    p[3] = value & 0xFF;
+}
+
+// the frames of the device: probes and the reset of the connection
+static void deviceFrame(const uint8_t *frame, uint16_t length)
+{
+    const uint8_t *ip = frame + 14;
+    const uint8_t *header = ip + (ip[0] & 0x0F) * 4;
+    uint16_t dataLength;
+
+    if((get16(frame + 12) != 0x0800) || (ip[9] != 6) || (get16(header) != SERVER_PORT) || (get16(header + 2) != PEER_PORT))
+    {
+        return;
+    }
+    dataLength = get16(ip + 2) - (ip[0] & 0x0F) * 4 - (header[12] >> 4) * 4;
+    if(header[13] & TCP_FLAG_RST)
+    {
+        reset = J60_Now();
+    }
+    else if((dataLength <= 1) && (get32(header + 4) == tcp.rcvNxt - 1))
+    {
+        if(probes++ == 0)
+        {
+            firstProbe = J60_Now();
+        }
+        if(leaveAtProbe && (tcp.state == PEER_TCP_ESTABLISHED))
+        {
+            PEER_TcpRemove(&tcp);
+        }
+    }
+}
+
+// an ACK with the address and ports of the connection, far beyond the receive window
+static void spoofAck(void)
+{
+    uint8_t segment[20] = {0};
+    uint8_t frame[J60_MAX_FRAME];
+
+    segment[0] = PEER_PORT >> 8;
+    segment[1] = PEER_PORT & 0xFF;
+    segment[3] = SERVER_PORT;
+    put32(segment + 4, tcp.sndMax + SPOOF_DISTANCE);
+    put32(segment + 8, tcp.rcvNxt);
+    segment[12] = 5 << 4;
+    segment[13] = TCP_FLAG_ACK;
+    segment[14] = tcp.window >> 8;
+    segment[15] = tcp.window & 0xFF;
+    PEER_Send(frame, PEER_Ipv4Frame(frame, 6, PEER_ADDRESS, segment, sizeof(segment)), 0);
+}
+
+static bool serverPoll(void)
+{
+    switch(TCP_SocketPoll(&server))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(&server);
+            break;
+        case SOCKET_CLOSED:
+            TCP_Bind(&server, SERVER_PORT);
+            TCP_InsertRxBuffer(&server, rxBuffer, sizeof(rxBuffer));
+            TCP_SetKeepAlive(&server, KEEPALIVE_IDLE, KEEPALIVE_INTERVAL, KEEPALIVE_COUNT);
+            TCP_Listen(&server);
+            break;
+        case SOCKET_CLOSING:
+            TCP_SocketRemove(&server);
+            break;
+        default:
+            break;
+    }
+    if(spoof && (J60_Now() >= nextSpoof))
+    {
+        spoofAck();
+        nextSpoof = J60_Now() + SPOOF_PERIOD;
+    }
+    return false;
+}
+
+static bool connected(void)
+{
+    serverPoll();
+    return (tcp.state == PEER_TCP_ESTABLISHED) && (TCP_SocketPoll(&server) == SOCKET_CONNECTED);
+}
+
+static bool resetSent(void)
+{
+    serverPoll();
+    return reset != 0;
+}
+
+static void connect(uint16_t port)
+{
+    BENCH_Run(serverPoll, 10 * PEER_MS);
+    PEER_TcpInit(&tcp, port, SERVER_PORT);
+    BENCH_Check(PEER_TcpConnect(&tcp), "peer connection");
+    BENCH_Check(BENCH_Run(connected, 1000 * PEER_MS), "connected");
+    probes = 0;
+    reset = 0;
+}
+
+static void leave(const char *name)
+{
+    char result[40];
+
+    leaveAtProbe = true;
+    BENCH_Check(BENCH_Run(resetSent, TIMEOUT), "connection reset");
+    snprintf(result, sizeof(result), "%s probes", name);
+    BENCH_Result(result, probes, "probes");
+    snprintf(result, sizeof(result), "%s reset", name);
+    BENCH_Result(result, reset ? (double)(reset - firstProbe) / PEER_MS : 0, "ms after the first probe");
+    BENCH_Check(probes == KEEPALIVE_COUNT, "one probe per interval");
+    BENCH_Check(reset && (reset - firstProbe >= KEEPALIVE_COUNT * KEEPALIVE_INTERVAL * 1000 * PEER_MS) &&
+                (reset - firstProbe < (KEEPALIVE_COUNT * KEEPALIVE_INTERVAL * 1000 + 10) * PEER_MS), "reset after the last interval");
+    BENCH_Run(serverPoll, 10 * PEER_MS);
+    leaveAtProbe = false;
+}
+
+int main(void)
+{
+    uint16_t reclaims;
+
+    BENCH_Init();
+    PEER_SetRxHandler(deviceFrame);
+
+    // the peer answers the probes
+    connect(PEER_PORT);
+    BENCH_Run(serverPoll, IDLE_TIME);
+    BENCH_Result("answered probes", probes, "probes");
+    BENCH_Check((probes >= IDLE_TIME / (KEEPALIVE_IDLE * 1000 * PEER_MS) - 1) && (probes <= IDLE_TIME / (KEEPALIVE_IDLE * 1000 * PEER_MS)),
+                "one probe per idle time");
+    BENCH_Check((reset == 0) && (TCP_SocketPoll(&server) == SOCKET_CONNECTED), "answered probes keep the connection");
+
+    // the peer is gone
+    reclaims = TCP_GetKeepAliveReclaims();
+    probes = 0;
+    leave("peer gone");
+
+    // the peer is gone, segments outside the window keep coming
+    connect(PEER_PORT);
+    BENCH_Run(serverPoll, (KEEPALIVE_IDLE * 1000 - 100) * PEER_MS);
+    spoof = true;
+    leave("out of window acks");
+    spoof = false;
+    BENCH_Check(TCP_GetKeepAliveReclaims() - reclaims == 2, "reclaims counted");
+
+    return BENCH_Exit();
+}
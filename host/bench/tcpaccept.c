@@ -0,0 +1,242 @@
+/**
+  TCP accept benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    tcpaccept.c
+
+  Summary:
+    Clients served by a TCP port when several connect at the same time.
+
+  Description:
+    CLIENTS peers connect to the same port of the device at once and each
+    sends REQUEST_SIZE bytes. The device echoes them:
+    - single: one listening socket that becomes the connection
+    - backlog: a listening socket with a backlog of BACKLOG_SIZE entries
+      and TCP_Accept() to one socket per client
+    The results are the clients echoed within SERVE_TIME, the clients the
+    device reset and the time until the last echo.
+    BACKLOG_SIZE 0 builds the benchmark without the backlog case, for the
+    versions of the stack that do not have TCP_SetBacklog():
+
+      make BENCH=tcpaccept run
+      make BENCH=tcpaccept CFLAGS="-O2 -g -DBACKLOG_SIZE=0" BUILD=build/nobacklog run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#ifndef BACKLOG_SIZE
+#define BACKLOG_SIZE        4
+#endif
+#define CLIENTS             4
+#define SERVER_PORT         8400
+#define PEER_PORT           45000
+#define REQUEST_SIZE        100
+#define SERVE_TIME          (5000 * PEER_MS)
+
+// 0 is the single listening socket, then one socket per client of the backlog
+static tcpTCB_t sockets[1 + CLIENTS];
+static uint8_t rxBuffer[1 + CLIENTS][REQUEST_SIZE];
+static uint8_t txBuffer[1 + CLIENTS][REQUEST_SIZE];
+static bool sending[1 + CLIENTS];
+#if BACKLOG_SIZE > 0
+static tcpTCB_t listener;
+static tcpBacklogEntry_t backlog[BACKLOG_SIZE];
+#endif
+static peerTcp_t tcp[CLIENTS];
+static uint16_t port;
+static uint8_t echoed;
+static uint64_t lastEcho;
+
+static void echo(uint8_t index)
+{
+    tcpTCB_t *socket = &sockets[index];
+    int16_t length;
+
+    if(sending[index] && (TCP_SendDone(socket) == SUCCESS))
+    {
+        sending[index] = false;
+    }
+    if(!sending[index] && (TCP_GetRxLength(socket) > 0))
+    {
+        length = TCP_GetReceivedData(socket);
+        memcpy(txBuffer[index], rxBuffer[index], length);
+        TCP_InsertRxBuffer(socket, rxBuffer[index], sizeof(rxBuffer[index]));
+        sending[index] = (TCP_Send(socket, txBuffer[index], length) == SUCCESS);
+    }
+}
+
+static void singlePoll(void)
+{
+    switch(TCP_SocketPoll(&sockets[0]))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(&sockets[0]);
+            break;
+        case SOCKET_CLOSED:
+            TCP_Bind(&sockets[0], port);
+            TCP_InsertRxBuffer(&sockets[0], rxBuffer[0], sizeof(rxBuffer[0]));
+            TCP_Listen(&sockets[0]);
+            break;
+        case SOCKET_CONNECTED:
+            echo(0);
+            break;
+        default:
+            break;
+    }
+}
+
+#if BACKLOG_SIZE > 0
+static void backlogPoll(void)
+{
+    uint8_t index;
+
+    switch(TCP_SocketPoll(&listener))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(&listener);
+            break;
+        case SOCKET_CLOSED:
+            TCP_Bind(&listener, port);
+            TCP_SetBacklog(&listener, backlog, BACKLOG_SIZE);
+            TCP_Listen(&listener);
+            break;
+        default:
+            break;
+    }
+    for(index = 1; index <= CLIENTS; index++)
+    {
+        switch(TCP_SocketPoll(&sockets[index]))
+        {
+            case NOT_A_SOCKET:
+                TCP_SocketInit(&sockets[index]);
+                break;
+            case SOCKET_CLOSED:
+                TCP_InsertRxBuffer(&sockets[index], rxBuffer[index], sizeof(rxBuffer[index]));
+                TCP_Accept(&listener, &sockets[index]);
+                break;
+            case SOCKET_CONNECTED:
+                echo(index);
+                break;
+            default:
+                break;
+        }
+    }
+}
+#endif
+
+static void count(void)
+{
+    uint8_t index, done = 0;
+    uint16_t offset;
+
+    for(index = 0; index < CLIENTS; index++)
+    {
+        if(tcp[index].received == REQUEST_SIZE)
+        {
+            for(offset = 0; (offset < REQUEST_SIZE) && (tcp[index].rxData[offset] == PEER_Payload(offset)); offset++)
+            {
+            }
+            done += (offset == REQUEST_SIZE) ? 1 : 0;
+        }
+    }
+    if(done > echoed)
+    {
+        echoed = done;
+        lastEcho = J60_Now();
+    }
+}
+
+static bool singleServed(void)
+{
+    singlePoll();
+    count();
+    return echoed == CLIENTS;
+}
+
+#if BACKLOG_SIZE > 0
+static bool backlogServed(void)
+{
+    backlogPoll();
+    count();
+    return echoed == CLIENTS;
+}
+#endif
+
+static void run(const char *name, benchPoll_t server, uint16_t serverPort)
+{
+    uint64_t start;
+    uint8_t index, reset = 0;
+    char result[40];
+
+    port = serverPort;
+    echoed = 0;
+    lastEcho = 0;
+    BENCH_Run(server, 10 * PEER_MS);
+
+    start = J60_Now();
+    for(index = 0; index < CLIENTS; index++)
+    {
+        PEER_TcpInit(&tcp[index], PEER_PORT + serverPort - SERVER_PORT + index, serverPort);
+        BENCH_Check(PEER_TcpConnect(&tcp[index]), "peer connection");
+        PEER_TcpSend(&tcp[index], REQUEST_SIZE);
+    }
+    BENCH_Run(server, SERVE_TIME);
+    for(index = 0; index < CLIENTS; index++)
+    {
+        if(tcp[index].state == PEER_TCP_RESET)
+        {
+            reset++;
+        }
+        PEER_TcpRemove(&tcp[index]);
+    }
+
+    snprintf(result, sizeof(result), "%s echoed", name);
+    BENCH_Result(result, echoed, "clients");
+    snprintf(result, sizeof(result), "%s reset", name);
+    BENCH_Result(result, reset, "clients");
+    snprintf(result, sizeof(result), "%s last echo", name);
+    BENCH_Result(result, echoed ? (double)(lastEcho - start) / PEER_MS : 0, "ms");
+}
+
+int main(void)
+{
+    BENCH_Init();
+
+    run("single", singleServed, SERVER_PORT);
+#if BACKLOG_SIZE > 0
+    run("backlog", backlogServed, SERVER_PORT + CLIENTS);
+    BENCH_Check(echoed == CLIENTS, "all clients echoed with the backlog");
+#endif
+
+    return BENCH_Exit();
+}
@@ -0,0 +1,204 @@
+/**
+  TCP ACK benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    tcpack.c
+
+  Summary:
+    Frames the device sends to acknowledge the data of the peer.
+
+  Description:
+    Upload: the peer sends 64000 bytes to a listening socket of the device
+    at 10 ms RTT. The application takes the 8 KB RX buffer with
+    TCP_GetReceivedData() and gives it back with TCP_InsertRxBuffer(). The
+    result is the number of ACK frames of the device during the upload.
+    Echo: the peer sends REQUESTS requests of REQUEST_SIZE bytes, each one
+    when the answer to the previous one is back, and the application
+    answers each request with TCP_Send() of the same bytes. The result is
+    the number of frames the device sends from the first request to the
+    last answer.
+    The benchmark only uses the socket API of the original stack, so it
+    also runs on older versions of the TCP/IP library:
+
+      make BENCH=tcpack run
+      make PROJECT=<older project directory> BUILD=build/<name> BENCH=tcpack run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#define SERVER_PORT         8100
+#define PEER_PORT           42000
+#define UPLOAD_LENGTH       64000u
+#define REQUESTS            50
+#define REQUEST_SIZE        100
+#define RTT                 10000u  // us
+#define TIMEOUT             (60000 * PEER_MS)
+
+static tcpTCB_t sockets[2];
+static uint8_t rxBuffer[8192];
+static uint8_t txBuffer[8192];
+static tcpTCB_t *server;
+static peerTcp_t tcp;
+static bool echo;
+static bool echoPending;
+static uint32_t received;
+static uint32_t answer;             // bytes the peer waits for
+static uint32_t wrong;
+
+static void serverPoll(void)
+{
+    int16_t length, index;
+
+    switch(TCP_SocketPoll(server))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(server);
+            break;
+        case SOCKET_CLOSED:
+            TCP_Bind(server, SERVER_PORT + (uint16_t)(server - sockets));
+            TCP_InsertRxBuffer(server, rxBuffer, sizeof(rxBuffer));
+            TCP_Listen(server);
+            break;
+        case SOCKET_CONNECTED:
+            if(echoPending && (TCP_SendDone(server) == SUCCESS))
+            {
+                echoPending = false;
+            }
+            if(!echoPending && (TCP_GetRxLength(server) > 0))
+            {
+                length = TCP_GetReceivedData(server);
+                for(index = 0; index < length; index++)
+                {
+                    if(rxBuffer[index] != PEER_Payload(received + index))
+                    {
+                        wrong++;
+                    }
+                }
+                received += length;
+                if(echo)
+                {
+                    memcpy(txBuffer, rxBuffer, length);
+                }
+                // before the answer, which carries the window
+                TCP_InsertRxBuffer(server, rxBuffer, sizeof(rxBuffer));
+                if(echo)
+                {
+                    echoPending = (TCP_Send(server, txBuffer, length) == SUCCESS);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static bool listening(void)
+{
+    serverPoll();
+    return TCP_SocketPoll(server) == SOCKET_CLOSED;
+}
+
+static bool connected(void)
+{
+    serverPoll();
+    return (tcp.state == PEER_TCP_ESTABLISHED) && (TCP_SocketPoll(server) == SOCKET_CONNECTED);
+}
+
+static bool uploaded(void)
+{
+    serverPoll();
+    return received == UPLOAD_LENGTH;
+}
+
+static bool answered(void)
+{
+    serverPoll();
+    return tcp.received == answer;
+}
+
+static void connect(uint8_t index, bool echoServer)
+{
+    server = &sockets[index];
+    echo = echoServer;
+    echoPending = false;
+    received = 0;
+    wrong = 0;
+    BENCH_Run(listening, 10 * PEER_MS);
+
+    PEER_TcpInit(&tcp, PEER_PORT + index, SERVER_PORT + index);
+    BENCH_Check(PEER_TcpConnect(&tcp), "peer connection");
+    BENCH_Check(BENCH_Run(connected, 1000 * PEER_MS), "connected");
+    // the ACK of the handshake is not counted
+    BENCH_Run(NULL, 10 * PEER_MS);
+}
+
+int main(void)
+{
+    uint32_t frames, index;
+    uint8_t request;
+
+    BENCH_Init();
+    PEER_SetLatency((uint64_t)RTT * PEER_MS / 2000);
+
+    connect(0, false);
+    PEER_TcpSend(&tcp, UPLOAD_LENGTH);
+    BENCH_Check(BENCH_Run(uploaded, TIMEOUT), "upload");
+    BENCH_Check(wrong == 0, "data received by the device");
+    BENCH_Result("upload ack frames", tcp.ackFrames, "frames");
+    BENCH_Result("upload ack frames per kB", (double)tcp.ackFrames * 1024 / UPLOAD_LENGTH, "frames");
+    PEER_TcpRemove(&tcp);
+
+    connect(1, true);
+    frames = J60_TxCount();
+    for(request = 0; request < REQUESTS; request++)
+    {
+        answer = (request + 1u) * REQUEST_SIZE;
+        PEER_TcpSend(&tcp, REQUEST_SIZE);
+        BENCH_Check(BENCH_Run(answered, TIMEOUT), "request answered");
+    }
+    // the peer ACKs the last answer
+    BENCH_Run(NULL, 1000 * PEER_MS);
+    for(index = 0; index < answer; index++)
+    {
+        if(tcp.rxData[index] != PEER_Payload(index))
+        {
+            wrong++;
+        }
+    }
+    BENCH_Check(wrong == 0, "requests received by the device and answered");
+    BENCH_Result("echo device frames", J60_TxCount() - frames, "frames");
+    BENCH_Result("echo frames per request", (double)(J60_TxCount() - frames) / REQUESTS, "frames");
+    PEER_TcpRemove(&tcp);
+
+    return BENCH_Exit();
+}
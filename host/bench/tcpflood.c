@@ -0,0 +1,236 @@
+/**
+  TCP SYN flood benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    tcpflood.c
+
+  Summary:
+    Connections of a legitimate client to a port under a flood of spoofed
+    SYNs.
+
+  Description:
+    The peer sends SYNs from random addresses beyond the router and random
+    ports to the device at 0, 10, 100 and 1000 SYN/s; nobody answers the
+    SYN+ACKs. Meanwhile a client of the peer connects ATTEMPTS times, one
+    connection after the other. It resends its SYN every second and gives
+    up after CONNECT_TIME. A connection that is established is closed by
+    the client before the next attempt.
+    The device serves the port with a listening socket that becomes the
+    connection (single), and with a listening socket with a backlog of
+    BACKLOG_SIZE entries and TCP_Accept() (backlog). The results are the
+    attempts established within CONNECT_TIME and within the first second,
+    before the client resends its SYN.
+
+      make BENCH=tcpflood run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#define BACKLOG_SIZE        2
+#define RATES               4
+#define ATTEMPTS            20
+#define SERVER_PORT         8900
+#define PEER_PORT           50000
+#define CONNECT_TIME        (7000 * PEER_MS)
+#define ATTEMPT_GAP         (200 * PEER_MS)
+#define SPOOF_NETWORK       0x0A000000u     // 10.0.0.0/8, reached through the router
+
+static const uint16_t rates[RATES] = {0, 10, 100, 1000};    // spoofed SYN/s
+
+static tcpTCB_t listeners[2 * RATES];
+static tcpTCB_t connections[2 * RATES];  // accepted from the backlog
+static tcpBacklogEntry_t backlog[BACKLOG_SIZE];
+static uint8_t rxBuffer[256];
+static tcpTCB_t *listener;
+static tcpTCB_t *connection;
+static bool useBacklog;
+static uint16_t port;
+static peerTcp_t tcp;
+static uint16_t attempt;
+static uint32_t random = 1;
+static uint64_t synInterval;            // ns, 0 for no flood
+static uint64_t nextSyn;
+
+static void put16(uint8_t *p, uint16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value & 0xFF;
+}
+
+static void put32(uint8_t *p, uint32_t value)
+{
+    put16(p, (uint16_t)(value >> 16));
+    put16(p + 2, (uint16_t)value);
+}
+
+static uint32_t next(void)
+{
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return random;
+}
+
+static void spoofSyn(void)
+{
+    uint8_t segment[20] = {0};
+    uint8_t frame[J60_MAX_FRAME];
+
+    put16(segment, (uint16_t)(1024u + next() % 64000u));
+    put16(segment + 2, port);
+    put32(segment + 4, next());
+    segment[12] = 5 << 4;
+    segment[13] = TCP_FLAG_SYN;
+    put16(segment + 14, 8192);
+    PEER_Send(frame, PEER_Ipv4Frame(frame, 6, SPOOF_NETWORK | (next() & 0x00FFFFFFu), segment, sizeof(segment)), 0);
+}
+
+static void flood(uint64_t now)
+{
+    while(synInterval && (now >= nextSyn))
+    {
+        spoofSyn();
+        nextSyn += synInterval;
+    }
+}
+
+static void socketPoll(tcpTCB_t *socket, bool listen)
+{
+    switch(TCP_SocketPoll(socket))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(socket);
+            break;
+        case SOCKET_CLOSED:
+            TCP_InsertRxBuffer(socket, rxBuffer, sizeof(rxBuffer));
+            if(listen)
+            {
+                TCP_Bind(socket, port);
+                if(useBacklog)
+                {
+                    TCP_SetBacklog(socket, backlog, BACKLOG_SIZE);
+                }
+                TCP_Listen(socket);
+            }
+            else
+            {
+                TCP_Accept(listener, socket);
+            }
+            break;
+        case SOCKET_CLOSING:
+            TCP_SocketRemove(socket);
+            break;
+        default:
+            break;
+    }
+}
+
+static bool established(void)
+{
+    socketPoll(listener, true);
+    if(useBacklog)
+    {
+        socketPoll(connection, false);
+    }
+    return (tcp.state == PEER_TCP_ESTABLISHED) &&
+           (TCP_SocketPoll(useBacklog ? connection : listener) == SOCKET_CONNECTED);
+}
+
+static bool closed(void)
+{
+    established();
+    return TCP_SocketPoll(useBacklog ? connection : listener) != SOCKET_CONNECTED;
+}
+
+static void run(bool withBacklog, uint8_t rate)
+{
+    uint8_t index = (withBacklog ? RATES : 0) + rate;
+    uint16_t accepted = 0, first = 0;
+    uint64_t start;
+    char result[48];
+
+    listener = &listeners[index];
+    connection = &connections[index];
+    useBacklog = withBacklog;
+    port = SERVER_PORT + index;
+    BENCH_Run(established, 10 * PEER_MS);
+    synInterval = rates[rate] ? 1000 * PEER_MS / rates[rate] : 0;
+    nextSyn = J60_Now();
+
+    for(attempt = 0; attempt < ATTEMPTS; attempt++)
+    {
+        PEER_TcpInit(&tcp, PEER_PORT + index * ATTEMPTS + attempt, port);
+        BENCH_Check(PEER_TcpConnect(&tcp), "peer connection");
+        start = J60_Now();
+        if(BENCH_Run(established, CONNECT_TIME))
+        {
+            accepted++;
+            first += (J60_Now() - start < 1000 * PEER_MS) ? 1 : 0;
+            PEER_TcpClose(&tcp);
+            BENCH_Run(closed, 1000 * PEER_MS);
+        }
+        else
+        {
+            PEER_TcpRemove(&tcp);
+        }
+        BENCH_Run(established, ATTEMPT_GAP);
+    }
+    synInterval = 0;
+
+    snprintf(result, sizeof(result), "%s %u SYN/s", withBacklog ? "backlog" : "single", rates[rate]);
+    BENCH_Result(result, 100.0 * accepted / ATTEMPTS, "% established");
+    snprintf(result, sizeof(result), "%s %u SYN/s < 1 s", withBacklog ? "backlog" : "single", rates[rate]);
+    BENCH_Result(result, 100.0 * first / ATTEMPTS, "% established");
+    if(rate == 0)
+    {
+        BENCH_Check(accepted == ATTEMPTS, "every attempt established without a flood");
+    }
+}
+
+int main(void)
+{
+    uint8_t rate;
+
+    BENCH_Init();
+    PEER_SetTickHandler(flood);
+
+    for(rate = 0; rate < RATES; rate++)
+    {
+        run(false, rate);
+    }
+    for(rate = 0; rate < RATES; rate++)
+    {
+        run(true, rate);
+    }
+
+    return BENCH_Exit();
+}
@@ -0,0 +1,229 @@
+/**
+  TCP socket lookup benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    tcplookup.c
+
+  Summary:
+    Time TCP_Recv() and TCP_SocketPoll() take to find a socket among many.
+
+  Description:
+    The device listens on SOCKETS ports and the peer connects to each of
+    them. With 1, 4, 8 and SOCKETS connections open, the device sends
+    RECORD_SIZE bytes on every connection, ROUNDS times, and the peer
+    acknowledges each segment at once: the pure ACKs that reach TCP_Recv()
+    alternate between the connections. Then the application calls
+    TCP_SocketPoll() POLLS times on every socket.
+    The results are the mean time of one TCP_Recv() and one
+    TCP_SocketPoll() call. Unlike the other benchmarks these are host CPU
+    times, not model time: they depend on the PC and vary by a few percent
+    from run to run, compare two versions of the stack on the same PC only.
+    The Makefile links the benchmark with -Wl,--wrap=TCP_Recv, so
+    __wrap_TCP_Recv() below times the calls of ipv4.c.
+    The default of 15 sockets fills the 16 slots of TCP_SOCKET_HASH_SIZE,
+    more sockets need a larger table and more connections of the peer:
+
+      make BENCH=tcplookup run
+      make BENCH=tcplookup UNDEFINE=TCP_SOCKET_HASH_SIZE \
+           CFLAGS="-O2 -g -DTCP_SOCKET_HASH_SIZE=128u -DSOCKETS=100 -DPEER_TCP_MAX=100" run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#ifndef SOCKETS
+#define SOCKETS             15
+#endif
+#define SERVER_PORT         8500
+#define PEER_PORT           46000
+#define RECORD_SIZE         64
+#define ROUNDS              100
+#define POLLS               10000
+#define TIMEOUT             (1000 * PEER_MS)
+
+void __real_TCP_Recv(uint32_t remoteAddress, uint16_t length);
+
+static tcpTCB_t sockets[SOCKETS];
+static uint8_t rxBuffer[SOCKETS][RECORD_SIZE];
+static uint8_t txBuffer[RECORD_SIZE];
+static peerTcp_t tcp[SOCKETS];
+static uint8_t open;                // connections
+static uint8_t current;             // connection of the record
+static bool sending;
+static bool timing;
+static uint32_t recvCalls;
+static uint32_t recvNs[ROUNDS * SOCKETS];
+
+static uint64_t now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
+}
+
+void __wrap_TCP_Recv(uint32_t remoteAddress, uint16_t length)
+{
+    uint64_t start;
+
+    if(!timing || (recvCalls == ROUNDS * SOCKETS))
+    {
+        __real_TCP_Recv(remoteAddress, length);
+        return;
+    }
+    start = now();
+    __real_TCP_Recv(remoteAddress, length);
+    recvNs[recvCalls++] = (uint32_t)(now() - start);
+}
+
+static int compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void serverPoll(uint8_t index)
+{
+    tcpTCB_t *server = &sockets[index];
+
+    switch(TCP_SocketPoll(server))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(server);
+            break;
+        case SOCKET_CLOSED:
+            TCP_Bind(server, SERVER_PORT + index);
+            TCP_InsertRxBuffer(server, rxBuffer[index], sizeof(rxBuffer[index]));
+            TCP_Listen(server);
+            break;
+        default:
+            break;
+    }
+}
+
+static bool listening(void)
+{
+    serverPoll(open);
+    return TCP_SocketPoll(&sockets[open]) == SOCKET_CLOSED;
+}
+
+static bool connected(void)
+{
+    serverPoll(open);
+    return (tcp[open].state == PEER_TCP_ESTABLISHED) && (TCP_SocketPoll(&sockets[open]) == SOCKET_CONNECTED);
+}
+
+static bool recordAcknowledged(void)
+{
+    if(!sending)
+    {
+        sending = (TCP_Send(&sockets[current], txBuffer, sizeof(txBuffer)) == SUCCESS);
+        return false;
+    }
+    if(TCP_SendDone(&sockets[current]) != SUCCESS)
+    {
+        return false;
+    }
+    sending = false;
+    return true;
+}
+
+static void connect(uint8_t count)
+{
+    while(open < count)
+    {
+        BENCH_Check(BENCH_Run(listening, 10 * PEER_MS), "listening");
+        PEER_TcpInit(&tcp[open], PEER_PORT + open, SERVER_PORT + open);
+        BENCH_Check(PEER_TcpConnect(&tcp[open]), "peer connection");
+        BENCH_Check(BENCH_Run(connected, 1000 * PEER_MS), "connected");
+        open++;
+    }
+}
+
+static void measure(uint8_t count)
+{
+    uint32_t round, records = 0;
+    uint64_t start, pollNs;
+    volatile socketState_t state;
+    char result[40];
+
+    connect(count);
+    recvCalls = 0;
+    timing = true;
+    // each ACK is for another connection than the one before
+    for(round = 0; round < ROUNDS; round++)
+    {
+        for(current = 0; current < count; current++)
+        {
+            records += BENCH_Run(recordAcknowledged, TIMEOUT);
+        }
+    }
+    timing = false;
+    BENCH_Check(records == (uint32_t)ROUNDS * count, "records acknowledged");
+    BENCH_Check(recvCalls >= records, "an ACK for every record");
+    qsort(recvNs, recvCalls, sizeof(recvNs[0]), compare);
+
+    start = now();
+    for(round = 0; round < POLLS; round++)
+    {
+        for(current = 0; current < count; current++)
+        {
+            state = TCP_SocketPoll(&sockets[current]);
+        }
+    }
+    pollNs = now() - start;
+    (void)state;
+
+    snprintf(result, sizeof(result), "%u sockets recv median", count);
+    BENCH_Result(result, recvCalls ? recvNs[recvCalls / 2] : 0, "ns");
+    snprintf(result, sizeof(result), "%u sockets poll", count);
+    BENCH_Result(result, (double)pollNs / POLLS / count, "ns");
+}
+
+int main(void)
+{
+    static const uint8_t counts[] = {1, 4, 8, SOCKETS};
+    uint8_t index;
+
+    BENCH_Init();
+
+    for(index = 0; index < sizeof(counts); index++)
+    {
+        if((counts[index] <= SOCKETS) && ((index == 0) || (counts[index] > counts[index - 1])))
+        {
+            measure(counts[index]);
+        }
+    }
+
+    return BENCH_Exit();
+}
@@ -0,0 +1,229 @@
+/**
+  TCP options benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    tcpoptions.c
+
+  Summary:
+    Segments and RTT samples with and without the TCP options.
+
+  Description:
+    At 10 ms RTT:
+    - upload: the peer sends 64000 bytes to the device. The peer takes the
+      MSS from the SYN+ACK of the device, 536 bytes when it has no MSS
+      option. The results are the peer segments and the time.
+    - upload without options: the same, the SYN of the peer has no options.
+    - download: the device sends 16000 and 64000 bytes to the peer, which
+      offers timestamps or not. The results are the segments of the device,
+      the time and the RTT samples of TCP_GetRttStats().
+
+      make BENCH=tcpoptions run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#define SERVER_PORT         8700
+#define PEER_PORT           48000
+#define MAX_LENGTH          64000u
+#define RTT                 10000u  // us
+#define TIMEOUT             (60000 * PEER_MS)
+
+typedef struct
+{
+    const char *name;
+    bool upload;                    // peer to device
+    bool options;                   // MSS option in the SYN of the peer
+    bool timestamps;                // offered by the peer
+    uint32_t length;
+} tcpOptionsCase_t;
+
+static const tcpOptionsCase_t cases[] =
+{
+    {.name = "upload", .upload = true, .options = true, .length = 64000},
+    {.name = "upload no options", .upload = true, .length = 64000},
+    {.name = "download 16k", .options = true, .length = 16000},
+    {.name = "download 16k ts", .options = true, .timestamps = true, .length = 16000},
+    {.name = "download 64k", .options = true, .length = 64000},
+    {.name = "download 64k ts", .options = true, .timestamps = true, .length = 64000},
+};
+
+static tcpTCB_t sockets[sizeof(cases) / sizeof(cases[0])];
+static uint8_t rxBuffer[8192];
+static uint8_t txBuffer[MAX_LENGTH];
+static const tcpOptionsCase_t *current;
+static tcpTCB_t *server;
+static peerTcp_t tcp;
+static uint32_t received;
+static uint32_t wrong;
+static uint64_t started, done;
+
+static bool serverDone(void)
+{
+    int16_t length, index;
+
+    switch(TCP_SocketPoll(server))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(server);
+            break;
+        case SOCKET_CLOSED:
+            TCP_Bind(server, SERVER_PORT + (uint16_t)(current - cases));
+            TCP_InsertRxBuffer(server, rxBuffer, sizeof(rxBuffer));
+            TCP_Listen(server);
+            break;
+        case SOCKET_CONNECTED:
+            if(current->upload)
+            {
+                if(TCP_GetRxLength(server) > 0)
+                {
+                    length = TCP_GetReceivedData(server);
+                    for(index = 0; index < length; index++)
+                    {
+                        if(rxBuffer[index] != PEER_Payload(received + index))
+                        {
+                            wrong++;
+                        }
+                    }
+                    received += length;
+                    TCP_InsertRxBuffer(server, rxBuffer, sizeof(rxBuffer));
+                }
+                if(received == current->length)
+                {
+                    done = J60_Now();
+                    return true;
+                }
+            }
+            else if(started == 0)
+            {
+                if(TCP_Send(server, txBuffer, current->length) == SUCCESS)
+                {
+                    started = J60_Now();
+                }
+            }
+            else if(TCP_SendDone(server) == SUCCESS)
+            {
+                done = J60_Now();
+                return true;
+            }
+            break;
+        default:
+            break;
+    }
+    return false;
+}
+
+static bool listening(void)
+{
+    serverDone();
+    return TCP_SocketPoll(server) == SOCKET_CLOSED;
+}
+
+static bool connected(void)
+{
+    serverDone();
+    return (tcp.state == PEER_TCP_ESTABLISHED) && (TCP_SocketPoll(server) == SOCKET_CONNECTED);
+}
+
+static void run(const tcpOptionsCase_t *optionsCase)
+{
+    tcpRttStats_t rtt;
+    uint64_t time;
+    char result[40];
+
+    current = optionsCase;
+    server = &sockets[optionsCase - cases];
+    received = 0;
+    wrong = 0;
+    started = 0;
+    done = 0;
+    BENCH_Run(listening, 10 * PEER_MS);
+
+    PEER_TcpInit(&tcp, PEER_PORT + (uint16_t)(optionsCase - cases), SERVER_PORT + (uint16_t)(optionsCase - cases));
+    if(!optionsCase->options)
+    {
+        tcp.mss = 0;
+    }
+    tcp.timestamps = optionsCase->timestamps;
+    BENCH_Check(PEER_TcpConnect(&tcp), "peer connection");
+    BENCH_Check(BENCH_Run(connected, 1000 * PEER_MS), "connected");
+    if(optionsCase->upload)
+    {
+        started = J60_Now();
+        PEER_TcpSend(&tcp, optionsCase->length);
+    }
+    BENCH_Check(BENCH_Run(serverDone, TIMEOUT), optionsCase->name);
+    if(optionsCase->upload)
+    {
+        BENCH_Check(wrong == 0, "data received by the device");
+    }
+    else
+    {
+        BENCH_Check((tcp.received == optionsCase->length) && (memcmp(tcp.rxData, txBuffer, optionsCase->length) == 0),
+                    "data received by the peer");
+    }
+
+    time = done ? done - started : 0;
+    snprintf(result, sizeof(result), "%s", optionsCase->name);
+    BENCH_Result(result, (double)time / PEER_MS, "ms");
+    snprintf(result, sizeof(result), "%s segments", optionsCase->name);
+    BENCH_Result(result, optionsCase->upload ? tcp.txSegments : tcp.segments, "segments");
+    if(optionsCase->upload)
+    {
+        snprintf(result, sizeof(result), "%s device mss", optionsCase->name);
+        BENCH_Result(result, tcp.deviceMss, "bytes");
+    }
+    else if(TCP_GetRttStats(server, &rtt) == SUCCESS)
+    {
+        snprintf(result, sizeof(result), "%s rtt samples", optionsCase->name);
+        BENCH_Result(result, rtt.rttSamples, "samples");
+    }
+    PEER_TcpRemove(&tcp);
+}
+
+int main(void)
+{
+    uint32_t index;
+
+    for(index = 0; index < MAX_LENGTH; index++)
+    {
+        txBuffer[index] = (uint8_t)(index * 13 + 7);
+    }
+    BENCH_Init();
+    PEER_SetLatency((uint64_t)RTT * PEER_MS / 2000);
+
+    for(index = 0; index < sizeof(cases) / sizeof(cases[0]); index++)
+    {
+        run(&cases[index]);
+    }
+
+    return BENCH_Exit();
+}
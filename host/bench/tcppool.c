@@ -0,0 +1,145 @@
+/**
+  TCP socket pool benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    tcppool.c
+
+  Summary:
+    Allocation, release and reuse of the sockets of the stack pool.
+
+  Description:
+    The benchmark takes every socket of the TCP_SOCKET_POOL_SIZE pool with
+    TCP_SocketAlloc() and one more, which must fail. A freed handle must no
+    longer give a socket, and the socket comes back under a new handle. A
+    connected socket must not be freed. Then the device closes the
+    connection first, so that its socket waits in TIME_WAIT: with the pool
+    full, TCP_SocketAlloc() must take that socket back under a new handle.
+    The results are the counters of TCP_GetPoolStats().
+
+      make BENCH=tcppool run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#include <stdio.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpip_config.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#define SERVER_PORT         8600
+#define PEER_PORT           47000
+#define TIMEOUT             (1000 * PEER_MS)
+
+static tcpHandle_t handles[TCP_SOCKET_POOL_SIZE];
+static uint8_t rxBuffer[256];
+static tcpTCB_t *server;
+static peerTcp_t tcp;
+
+static bool connected(void)
+{
+    return (tcp.state == PEER_TCP_ESTABLISHED) && (TCP_SocketPoll(server) == SOCKET_CONNECTED);
+}
+
+static bool finReceived(void)
+{
+    return tcp.finReceived;
+}
+
+static bool timeWait(void)
+{
+    return server->fsmState == TIME_WAIT;
+}
+
+static bool valid(tcpHandle_t handle)
+{
+    return (handle != TCP_INVALID_SOCKET) && (TCP_SocketPtr(handle) != NULL);
+}
+
+int main(void)
+{
+    const tcpPoolStats_t *stats = TCP_GetPoolStats();
+    tcpHandle_t handle, last;
+    uint8_t index;
+
+    BENCH_Init();
+
+    // the whole pool, then one more
+    for(index = 0; index < TCP_SOCKET_POOL_SIZE; index++)
+    {
+        handles[index] = TCP_SocketAlloc();
+        BENCH_Check(valid(handles[index]), "socket allocated");
+    }
+    BENCH_Check(TCP_SocketAlloc() == TCP_INVALID_SOCKET, "no socket once the pool is empty");
+
+    // a freed handle is stale, the socket comes back under a new one
+    last = handles[TCP_SOCKET_POOL_SIZE - 1];
+    BENCH_Check(TCP_SocketFree(last) == SUCCESS, "closed socket freed");
+    BENCH_Check(TCP_SocketPtr(last) == NULL, "freed handle stale");
+    BENCH_Check(TCP_SocketPoll(TCP_SocketPtr(last)) == NOT_A_SOCKET, "freed handle not a socket");
+    BENCH_Check(TCP_SocketFree(last) == ERROR, "freed handle not freed again");
+    handle = TCP_SocketAlloc();
+    BENCH_Check(valid(handle) && (handle != last), "socket allocated again under a new handle");
+    BENCH_Check(TCP_SocketPtr(last) == NULL, "old handle still stale");
+    handles[TCP_SOCKET_POOL_SIZE - 1] = handle;
+
+    // a connected socket is not freed
+    server = TCP_SocketPtr(handles[0]);
+    TCP_Bind(server, SERVER_PORT);
+    TCP_InsertRxBuffer(server, rxBuffer, sizeof(rxBuffer));
+    TCP_Listen(server);
+    PEER_TcpInit(&tcp, PEER_PORT, SERVER_PORT);
+    BENCH_Check(PEER_TcpConnect(&tcp), "peer connection");
+    BENCH_Check(BENCH_Run(connected, TIMEOUT), "connected");
+    BENCH_Check(TCP_SocketFree(handles[0]) == ERROR, "connected socket not freed");
+    BENCH_Check(TCP_SocketPtr(handles[0]) == server, "connected socket kept");
+
+    // the device closes first and waits in TIME_WAIT, the full pool takes it back
+    TCP_Close(server);
+    BENCH_Check(BENCH_Run(finReceived, TIMEOUT), "FIN of the device");
+    PEER_TcpClose(&tcp);
+    BENCH_Check(BENCH_Run(timeWait, TIMEOUT), "socket in TIME_WAIT");
+    handle = TCP_SocketAlloc();
+    BENCH_Check(valid(handle) && (TCP_SocketPtr(handle) == server), "TIME_WAIT socket allocated again");
+    BENCH_Check(TCP_SocketPtr(handles[0]) == NULL, "handle of the TIME_WAIT socket stale");
+    BENCH_Check(TCP_SocketPoll(server) == SOCKET_CLOSED, "socket closed for the new handle");
+    handles[0] = handle;
+
+    for(index = 0; index < TCP_SOCKET_POOL_SIZE; index++)
+    {
+        BENCH_Check(TCP_SocketFree(handles[index]) == SUCCESS, "socket freed");
+    }
+    BENCH_Check(stats->inUse == 0, "pool empty");
+    BENCH_Result("pool size", stats->size, "sockets");
+    BENCH_Result("in use max", stats->inUseMax, "sockets");
+    BENCH_Result("allocations", stats->allocations, "sockets");
+    BENCH_Result("alloc failures", stats->allocFailures, "calls");
+    BENCH_Result("time wait reuses", stats->timeWaitReuses, "sockets");
+    BENCH_Check((stats->allocations == TCP_SOCKET_POOL_SIZE + 2u) && (stats->allocFailures == 1u) &&
+                (stats->timeWaitReuses == 1u), "pool counters");
+
+    return BENCH_Exit();
+}
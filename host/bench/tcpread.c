@@ -0,0 +1,273 @@
+/**
+  TCP read benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    tcpread.c
+
+  Summary:
+    Time the device takes to receive a block of data from the peer over TCP
+    with the RX buffer of TCP_InsertRxBuffer() and with the RX ring of
+    TCP_InsertRxRing().
+
+  Description:
+    For each case the peer connects to a listening socket of the device and
+    sends LENGTH bytes. The socket has RX_MEMORY bytes of RX memory and an
+    out of order queue of OOO_QUEUE_SIZE ranges. The application either
+    - swaps the buffer: takes it with TCP_GetReceivedData() and gives it
+      back with TCP_InsertRxBuffer() once it has processed the data, or
+    - reads the ring: TCP_Read() of the bytes it can process now.
+    An application with a rate processes that many bytes per ms, else it
+    keeps up with the data. The segments of the peer are numbered in the
+    order of their first transmission and a lost one is dropped. The time
+    runs from the first segment of the peer to the last byte processed, the
+    peer reports the time it had data and a zero window.
+
+      make BENCH=tcpread run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#define SERVER_PORT         8300
+#define PEER_PORT           44000
+#define LENGTH              64000u
+#define RX_MEMORY           8192u
+#define OOO_QUEUE_SIZE      4
+#define MAX_LOSSES          5
+#define TIMEOUT             (60000 * PEER_MS)
+
+typedef struct
+{
+    const char *name;
+    bool ring;
+    uint32_t rtt;                   // us
+    uint16_t rate;                  // bytes per ms, 0 keeps up
+    uint8_t losses;
+    uint32_t loss[MAX_LOSSES];      // numbers of the lost segments, from 0
+} tcpReadCase_t;
+
+static const tcpReadCase_t cases[] =
+{
+    {.name = "swap", .rtt = 10000},
+    {.name = "ring", .ring = true, .rtt = 10000},
+    {.name = "swap 5 losses", .rtt = 10000, .losses = 5, .loss = {3, 12, 21, 30, 39}},
+    {.name = "ring 5 losses", .ring = true, .rtt = 10000, .losses = 5, .loss = {3, 12, 21, 30, 39}},
+    {.name = "swap 5 losses rtt 50", .rtt = 50000, .losses = 5, .loss = {3, 12, 21, 30, 39}},
+    {.name = "ring 5 losses rtt 50", .ring = true, .rtt = 50000, .losses = 5, .loss = {3, 12, 21, 30, 39}},
+    {.name = "swap 300 B/ms", .rtt = 10000, .rate = 300},
+    {.name = "ring 300 B/ms", .ring = true, .rtt = 10000, .rate = 300},
+    {.name = "swap 1000 B/ms", .rtt = 10000, .rate = 1000},
+    {.name = "ring 1000 B/ms", .ring = true, .rtt = 10000, .rate = 1000},
+};
+
+static tcpTCB_t sockets[sizeof(cases) / sizeof(cases[0])];
+static uint8_t rxMemory[RX_MEMORY];
+static uint8_t data[RX_MEMORY];
+static tcpOooRange_t oooQueue[OOO_QUEUE_SIZE];
+static const tcpReadCase_t *current;
+static tcpTCB_t *server;
+static peerTcp_t tcp;
+static uint32_t sent;            // stream offset after the last new segment of the peer
+static uint32_t segments;        // new segments of the peer
+static uint32_t received;
+static uint32_t wrong;
+static uint16_t held;            // bytes of the swapped buffer still processed
+static uint64_t started;
+static uint64_t busyUntil;       // the application processes the data it took
+
+static int64_t peerSegment(peerTcp_t *peer, uint32_t offset, uint16_t length)
+{
+    uint32_t number;
+    uint8_t index;
+
+    if(started == 0)
+    {
+        started = J60_Now();
+    }
+    // only the first transmission of a segment is lost
+    if(offset < sent)
+    {
+        return 0;
+    }
+    sent = offset + length;
+    number = segments++;
+    for(index = 0; index < current->losses; index++)
+    {
+        if(number == current->loss[index])
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void process(const uint8_t *bytes, uint16_t length)
+{
+    uint16_t index;
+
+    for(index = 0; index < length; index++)
+    {
+        if(bytes[index] != PEER_Payload(received + index))
+        {
+            wrong++;
+        }
+    }
+    received += length;
+    if(current->rate)
+    {
+        busyUntil = J60_Now() + (uint64_t)length * PEER_MS / current->rate;
+    }
+}
+
+static void serverPoll(void)
+{
+    uint16_t length;
+
+    switch(TCP_SocketPoll(server))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(server);
+            break;
+        case SOCKET_CLOSED:
+            TCP_Bind(server, SERVER_PORT + (uint16_t)(current - cases));
+            if(current->ring)
+            {
+                TCP_InsertRxRing(server, rxMemory, sizeof(rxMemory));
+            }
+            else
+            {
+                TCP_InsertRxBuffer(server, rxMemory, sizeof(rxMemory));
+            }
+            TCP_SetOooQueue(server, oooQueue, OOO_QUEUE_SIZE);
+            TCP_Listen(server);
+            break;
+        case SOCKET_CONNECTED:
+            if(J60_Now() < busyUntil)
+            {
+                break;
+            }
+            if(held)
+            {
+                // the swapped buffer is processed, the socket gets it back
+                held = 0;
+                TCP_InsertRxBuffer(server, rxMemory, sizeof(rxMemory));
+            }
+            if(current->ring)
+            {
+                // what the application processes in one ms, or all of it
+                length = TCP_Read(server, data, current->rate ? current->rate : sizeof(data));
+                process(data, length);
+            }
+            else if(TCP_GetRxLength(server) > 0)
+            {
+                length = (uint16_t)TCP_GetReceivedData(server);
+                process(rxMemory, length);
+                held = length;
+                if(current->rate == 0)
+                {
+                    held = 0;
+                    TCP_InsertRxBuffer(server, rxMemory, sizeof(rxMemory));
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static bool listening(void)
+{
+    serverPoll();
+    return TCP_SocketPoll(server) == SOCKET_CLOSED;
+}
+
+static bool connected(void)
+{
+    serverPoll();
+    return (tcp.state == PEER_TCP_ESTABLISHED) && (TCP_SocketPoll(server) == SOCKET_CONNECTED);
+}
+
+static bool receivedAll(void)
+{
+    serverPoll();
+    return (received == LENGTH) && (J60_Now() >= busyUntil);
+}
+
+static void run(const tcpReadCase_t *readCase)
+{
+    uint64_t time;
+    char result[40];
+
+    current = readCase;
+    server = &sockets[readCase - cases];
+    sent = 0;
+    segments = 0;
+    received = 0;
+    wrong = 0;
+    held = 0;
+    started = 0;
+    busyUntil = 0;
+    PEER_SetLatency((uint64_t)readCase->rtt * PEER_MS / 2000);
+    BENCH_Run(NULL, 10 * PEER_MS);
+    BENCH_Run(listening, 10 * PEER_MS);
+
+    PEER_TcpInit(&tcp, PEER_PORT + (uint16_t)(readCase - cases), SERVER_PORT + (uint16_t)(readCase - cases));
+    tcp.txHook = peerSegment;
+    BENCH_Check(PEER_TcpConnect(&tcp), "peer connection");
+    BENCH_Check(BENCH_Run(connected, 1000 * PEER_MS), "connected");
+    PEER_TcpSend(&tcp, LENGTH);
+    BENCH_Check(BENCH_Run(receivedAll, TIMEOUT), readCase->name);
+    BENCH_Check((received == LENGTH) && (wrong == 0), "data received by the device");
+    time = J60_Now() - started;
+
+    snprintf(result, sizeof(result), "%s", readCase->name);
+    BENCH_Result(result, (double)time / PEER_MS, "ms");
+    snprintf(result, sizeof(result), "%s zero wnd", readCase->name);
+    BENCH_Result(result, (double)tcp.zeroWindowNs / PEER_MS, "ms");
+    snprintf(result, sizeof(result), "%s rto", readCase->name);
+    BENCH_Result(result, tcp.timeouts, "timeouts");
+    PEER_TcpRemove(&tcp);
+}
+
+int main(void)
+{
+    uint8_t index;
+
+    BENCH_Init();
+
+    for(index = 0; index < sizeof(cases) / sizeof(cases[0]); index++)
+    {
+        run(&cases[index]);
+    }
+
+    return BENCH_Exit();
+}
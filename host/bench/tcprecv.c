@@ -0,0 +1,259 @@
+/**
+  TCP receive benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    tcprecv.c
+
+  Summary:
+    Time the device takes to receive a block of data from the peer over TCP,
+    with segments of the peer delayed or lost.
+
+  Description:
+    For each case the peer connects to a listening socket of the device and
+    sends the block. The application takes the 8 KB RX buffer (4 KB in the
+    4k case) with TCP_GetReceivedData(), checks the data and gives the
+    buffer back with TCP_InsertRxBuffer(). The time runs from the first segment of the peer
+    to the last byte taken by the application. The segments of the peer are
+    numbered in the order of their first transmission, which is delayed for a
+    late segment and dropped for a lost one. The segment size is the MSS of
+    the device, which depends on the version of the stack.
+    In the echo case the application sends every block it takes back with
+    TCP_Send() before it gives the RX buffer back, so the late segments of
+    the peer carry an ACK older than the ones before them. That case ends
+    when the peer has received the whole block back. A single loss must be
+    repaired by the fast retransmit of the peer, without a time-out.
+    OOO_QUEUE_SIZE is the out of order queue of the socket (TCP_SetOooQueue),
+    0 builds the benchmark without it, for the versions of the stack that do
+    not have it:
+
+      make BENCH=tcprecv run
+      make BENCH=tcprecv CFLAGS="-O2 -g -DOOO_QUEUE_SIZE=0" BUILD=build/noqueue run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#ifndef OOO_QUEUE_SIZE
+#define OOO_QUEUE_SIZE      4
+#endif
+#define SERVER_PORT         8000
+#define PEER_PORT           41000
+#define LENGTH              64000u
+#define RTT                 10000u  // us
+#define LATE_NS             (3 * PEER_MS)
+#define MAX_LOSSES          5
+#define TIMEOUT             (120000 * PEER_MS)
+
+typedef struct
+{
+    const char *name;
+    uint8_t lateEvery;              // every n-th segment is late, 0 for none
+    bool echo;
+    uint8_t losses;
+    uint32_t loss[MAX_LOSSES];      // numbers of the lost segments, from 0
+    uint16_t rxSize;                // RX buffer given to the socket, 0 for all of rxBuffer
+} tcpRecvCase_t;
+
+static const tcpRecvCase_t cases[] =
+{
+    {.name = "clean"},
+    {.name = "1/8 late", .lateEvery = 8},
+    {.name = "one loss", .losses = 1, .loss = {5}},
+    {.name = "4k one loss", .losses = 1, .loss = {5}, .rxSize = 4096},
+    {.name = "5 losses", .losses = 5, .loss = {3, 12, 21, 30, 39}},
+    {.name = "echo", .echo = true},
+    {.name = "echo 1/8 late", .lateEvery = 8, .echo = true},
+};
+
+static tcpTCB_t sockets[sizeof(cases) / sizeof(cases[0])];
+static uint8_t rxBuffer[8192];
+static uint8_t txBuffer[8192];
+#if OOO_QUEUE_SIZE > 0
+static tcpOooRange_t oooQueue[OOO_QUEUE_SIZE];
+#endif
+static const tcpRecvCase_t *current;
+static tcpTCB_t *server;
+static peerTcp_t tcp;
+static uint32_t sent;            // stream offset after the last new segment of the peer
+static uint32_t segments;        // new segments of the peer
+static uint32_t received;
+static uint32_t wrong;
+static bool echoPending;
+static uint64_t started;
+
+static int64_t peerSegment(peerTcp_t *peer, uint32_t offset, uint16_t length)
+{
+    uint32_t number;
+    uint8_t index;
+
+    if(started == 0)
+    {
+        started = J60_Now();
+    }
+    // only the first transmission of a segment is lost or late
+    if(offset < sent)
+    {
+        return 0;
+    }
+    sent = offset + length;
+    number = segments++;
+    for(index = 0; index < current->losses; index++)
+    {
+        if(number == current->loss[index])
+        {
+            return -1;
+        }
+    }
+    if(current->lateEvery && (number % current->lateEvery == 3))
+    {
+        return LATE_NS;
+    }
+    return 0;
+}
+
+static void serverPoll(void)
+{
+    int16_t length, index;
+    uint16_t rxSize = current->rxSize ? current->rxSize : sizeof(rxBuffer);
+
+    switch(TCP_SocketPoll(server))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(server);
+            break;
+        case SOCKET_CLOSED:
+            TCP_Bind(server, SERVER_PORT + (uint16_t)(current - cases));
+            TCP_InsertRxBuffer(server, rxBuffer, rxSize);
+#if OOO_QUEUE_SIZE > 0
+            TCP_SetOooQueue(server, oooQueue, OOO_QUEUE_SIZE);
+#endif
+            TCP_Listen(server);
+            break;
+        case SOCKET_CONNECTED:
+            if(echoPending && (TCP_SendDone(server) == SUCCESS))
+            {
+                echoPending = false;
+            }
+            if(!echoPending && (TCP_GetRxLength(server) > 0))
+            {
+                length = TCP_GetReceivedData(server);
+                for(index = 0; index < length; index++)
+                {
+                    if(rxBuffer[index] != PEER_Payload(received + index))
+                    {
+                        wrong++;
+                    }
+                }
+                received += length;
+                if(current->echo)
+                {
+                    memcpy(txBuffer, rxBuffer, length);
+                    echoPending = (TCP_Send(server, txBuffer, length) == SUCCESS);
+                }
+                TCP_InsertRxBuffer(server, rxBuffer, rxSize);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static bool listening(void)
+{
+    serverPoll();
+    return TCP_SocketPoll(server) == SOCKET_CLOSED;
+}
+
+static bool connected(void)
+{
+    serverPoll();
+    return (tcp.state == PEER_TCP_ESTABLISHED) && (TCP_SocketPoll(server) == SOCKET_CONNECTED);
+}
+
+static bool receivedAll(void)
+{
+    serverPoll();
+    return current->echo ? (tcp.received == LENGTH) : (received == LENGTH);
+}
+
+static void run(const tcpRecvCase_t *recvCase)
+{
+    uint64_t time;
+    char result[40];
+
+    current = recvCase;
+    server = &sockets[recvCase - cases];
+    sent = 0;
+    segments = 0;
+    received = 0;
+    wrong = 0;
+    echoPending = false;
+    started = 0;
+    BENCH_Run(NULL, 10 * PEER_MS);
+    BENCH_Run(listening, 10 * PEER_MS);
+
+    PEER_TcpInit(&tcp, PEER_PORT + (uint16_t)(recvCase - cases), SERVER_PORT + (uint16_t)(recvCase - cases));
+    tcp.txHook = peerSegment;
+    BENCH_Check(PEER_TcpConnect(&tcp), "peer connection");
+    BENCH_Check(BENCH_Run(connected, 1000 * PEER_MS), "connected");
+    PEER_TcpSend(&tcp, LENGTH);
+    BENCH_Check(BENCH_Run(receivedAll, TIMEOUT), recvCase->name);
+    BENCH_Check((received == LENGTH) && (wrong == 0), "data received by the device");
+    time = J60_Now() - started;
+
+    snprintf(result, sizeof(result), "%s", recvCase->name);
+    BENCH_Result(result, (double)time / PEER_MS, "ms");
+    snprintf(result, sizeof(result), "%s retransmits", recvCase->name);
+    BENCH_Result(result, tcp.retransmits, "segments");
+    snprintf(result, sizeof(result), "%s rto", recvCase->name);
+    BENCH_Result(result, tcp.timeouts, "timeouts");
+    if(recvCase->losses == 1)
+    {
+        BENCH_Check(tcp.timeouts == 0, "a single loss recovers without a time-out");
+    }
+    PEER_TcpRemove(&tcp);
+}
+
+int main(void)
+{
+    uint8_t index;
+
+    BENCH_Init();
+    PEER_SetLatency((uint64_t)RTT * PEER_MS / 2000);
+
+    for(index = 0; index < sizeof(cases) / sizeof(cases[0]); index++)
+    {
+        run(&cases[index]);
+    }
+
+    return BENCH_Exit();
+}
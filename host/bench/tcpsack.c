@@ -0,0 +1,325 @@
+/**
+  TCP SACK benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    tcpsack.c
+
+  Summary:
+    Throughput and retransmissions of 64000 byte transfers under random and
+    burst loss, with and without SACK.
+
+  Description:
+    At 10 ms RTT, 64000 bytes go from the peer to the device (upload) and
+    from the device to the peer (download), SEEDS times for each loss rate.
+    The first transmissions of the data segments are lost either at random
+    or in bursts (Gilbert model: after a loss the next segment is lost with
+    50 % probability, the loss rate stays the same); retransmissions and
+    ACKs are not lost. Each point runs once with a peer that offers SACK
+    permitted and once with a peer that does not, so the connection uses
+    SACK or not.
+    The results are the throughput over all the seeds and the retransmitted
+    segments per transfer. The upload uses a receive buffer of RX_BUFFER
+    bytes; a larger transmit window of the device is a configuration of the
+    stack. TCP_ENABLE_SACK is off in tcpip_config.h, the Makefile turns it
+    on for this benchmark. With the default 4 segment window SACK makes no
+    difference, the third line is the configuration where it helps:
+
+      make BENCH=tcpsack run
+      make BENCH=tcpsack CFLAGS="-O2 -g -DRX_BUFFER=24576" BUILD=build/rx24k run
+      make BENCH=tcpsack UNDEFINE="TCP_MAX_TX_WINDOW TCP_SACK_SCOREBOARD_SIZE" \
+           CFLAGS="-O2 -g -DTCP_MAX_TX_WINDOW=23360u -DTCP_SACK_SCOREBOARD_SIZE=8u -DRX_BUFFER=24576 -DSEEDS=40" run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#ifndef RX_BUFFER
+#define RX_BUFFER           8192
+#endif
+#ifndef SEEDS
+#define SEEDS               20
+#endif
+#define SERVER_PORT         8800
+#define PEER_PORT           49000
+#define LENGTH              64000u
+#define RTT                 10000u  // us
+#define OOO_QUEUE_SIZE      4
+#define TIMEOUT             (120000 * PEER_MS)
+
+typedef struct
+{
+    const char *name;
+    bool upload;                    // peer to device
+    bool burst;
+    uint8_t percent;                // loss rate
+} tcpSackCase_t;
+
+static const tcpSackCase_t cases[] =
+{
+    {.name = "up random 1%", .upload = true, .percent = 1},
+    {.name = "up random 5%", .upload = true, .percent = 5},
+    {.name = "up burst 1%", .upload = true, .burst = true, .percent = 1},
+    {.name = "up burst 2%", .upload = true, .burst = true, .percent = 2},
+    {.name = "up burst 5%", .upload = true, .burst = true, .percent = 5},
+    {.name = "up burst 10%", .upload = true, .burst = true, .percent = 10},
+    {.name = "down random 1%", .percent = 1},
+    {.name = "down random 5%", .percent = 5},
+    {.name = "down burst 2%", .burst = true, .percent = 2},
+    {.name = "down burst 5%", .burst = true, .percent = 5},
+};
+
+static tcpTCB_t socket;
+static uint8_t rxBuffer[RX_BUFFER];
+static uint8_t txBuffer[LENGTH];
+static tcpOooRange_t oooQueue[OOO_QUEUE_SIZE];
+static const tcpSackCase_t *current;
+static peerTcp_t tcp;
+static uint16_t connection;         // ports of the transfer
+static uint32_t random;
+static bool lastLost;
+static uint32_t sent;               // offset after the newest data segment
+static uint32_t received;
+static uint32_t wrong;
+static bool sendStarted;
+
+// xorshift32, the same losses on every run
+static uint32_t next(void)
+{
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return random;
+}
+
+// only the first transmission of a segment can be lost: lost retransmissions
+// end the connection after TCP_MAX_RETRIES, a run of them is likely at 50 %
+static bool lose(uint32_t offset, uint16_t length)
+{
+    uint32_t threshold;
+
+    if(offset < sent)
+    {
+        return false;
+    }
+    sent = offset + length;
+    if(current->burst)
+    {
+        // P(loss | no loss) = 0.5 p / (1 - p), P(loss | loss) = 0.5, overall p
+        threshold = lastLost ? 50000u : (uint32_t)(50000u * current->percent / (100u - current->percent));
+    }
+    else
+    {
+        threshold = current->percent * 1000u;
+    }
+    lastLost = (next() % 100000u) < threshold;
+    return lastLost;
+}
+
+static int64_t peerSegment(peerTcp_t *peer, uint32_t offset, uint16_t length)
+{
+    return lose(offset, length) ? -1 : 0;
+}
+
+static bool deviceSegment(peerTcp_t *peer, uint32_t offset, uint16_t length)
+{
+    return lose(offset, length);
+}
+
+static bool serverDone(void)
+{
+    int16_t length, index;
+
+    switch(TCP_SocketPoll(&socket))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(&socket);
+            break;
+        case SOCKET_CLOSED:
+            TCP_Bind(&socket, SERVER_PORT + connection);
+            TCP_InsertRxBuffer(&socket, rxBuffer, sizeof(rxBuffer));
+            TCP_SetOooQueue(&socket, oooQueue, OOO_QUEUE_SIZE);
+            TCP_Listen(&socket);
+            break;
+        case SOCKET_CONNECTED:
+            if(current->upload)
+            {
+                if(TCP_GetRxLength(&socket) > 0)
+                {
+                    length = TCP_GetReceivedData(&socket);
+                    for(index = 0; index < length; index++)
+                    {
+                        if(rxBuffer[index] != PEER_Payload(received + index))
+                        {
+                            wrong++;
+                        }
+                    }
+                    received += length;
+                    TCP_InsertRxBuffer(&socket, rxBuffer, sizeof(rxBuffer));
+                }
+                return received == LENGTH;
+            }
+            if(!sendStarted)
+            {
+                sendStarted = (TCP_Send(&socket, txBuffer, LENGTH) == SUCCESS);
+            }
+            else if(TCP_SendDone(&socket) == SUCCESS)
+            {
+                return true;
+            }
+            break;
+        default:
+            break;
+    }
+    return false;
+}
+
+static bool listening(void)
+{
+    serverDone();
+    return TCP_SocketPoll(&socket) == SOCKET_CLOSED;
+}
+
+static bool connected(void)
+{
+    serverDone();
+    return (tcp.state == PEER_TCP_ESTABLISHED) && (TCP_SocketPoll(&socket) == SOCKET_CONNECTED);
+}
+
+static bool closing(void)
+{
+    return TCP_SocketPoll(&socket) == SOCKET_CLOSING;
+}
+
+// one transfer, returns the time in ns and adds the retransmitted segments
+static uint64_t transfer(bool sack, uint32_t seed, uint32_t *retransmits)
+{
+    tcpRttStats_t rtt;
+    uint64_t started;
+    uint8_t index;
+
+    random = seed * 2654435761u + 1u;
+    for(index = 0; index < 8; index++)
+    {
+        next();
+    }
+    lastLost = false;
+    sent = 0;
+    received = 0;
+    sendStarted = false;
+    connection++;
+    BENCH_Check(BENCH_Run(listening, 10 * PEER_MS), "listening");
+
+    PEER_TcpInit(&tcp, PEER_PORT + connection, SERVER_PORT + connection);
+    tcp.sackPermitted = sack;
+    if(current->upload)
+    {
+        tcp.txHook = peerSegment;
+    }
+    else
+    {
+        tcp.rxHook = deviceSegment;
+    }
+    BENCH_Check(PEER_TcpConnect(&tcp), "peer connection");
+    BENCH_Check(BENCH_Run(connected, 1000 * PEER_MS), "connected");
+    BENCH_Check(tcp.sackOk == sack, "SACK negotiated");
+    started = J60_Now();
+    if(current->upload)
+    {
+        PEER_TcpSend(&tcp, LENGTH);
+    }
+    BENCH_Check(BENCH_Run(serverDone, TIMEOUT), current->name);
+    started = J60_Now() - started;
+    if(current->upload)
+    {
+        *retransmits += tcp.retransmits;
+    }
+    else
+    {
+        BENCH_Check((tcp.received == LENGTH) && (memcmp(tcp.rxData, txBuffer, LENGTH) == 0), "data received by the peer");
+        if(TCP_GetRttStats(&socket, &rtt) == SUCCESS)
+        {
+            *retransmits += rtt.retransmits;
+        }
+    }
+
+    // the peer closes, the device socket is free for the next transfer
+    PEER_TcpClose(&tcp);
+    BENCH_Check(BENCH_Run(closing, 1000 * PEER_MS), "device closed");
+    TCP_SocketRemove(&socket);
+    return started;
+}
+
+static void run(const tcpSackCase_t *sackCase)
+{
+    uint64_t time[2] = {0, 0};
+    uint32_t retransmits[2] = {0, 0};
+    uint32_t seed;
+    uint8_t sack;
+    char result[48];
+
+    current = sackCase;
+    wrong = 0;
+    for(seed = 0; seed < SEEDS; seed++)
+    {
+        for(sack = 0; sack < 2; sack++)
+        {
+            time[sack] += transfer(sack, seed, &retransmits[sack]);
+        }
+    }
+    BENCH_Check(wrong == 0, "data received by the device");
+
+    for(sack = 0; sack < 2; sack++)
+    {
+        snprintf(result, sizeof(result), "%s%s", sackCase->name, sack ? " sack" : "");
+        BENCH_Result(result, (double)LENGTH * SEEDS * 1000 / ((double)time[sack] / PEER_MS) / 1024, "kB/s");
+        snprintf(result, sizeof(result), "%s%s rexmit", sackCase->name, sack ? " sack" : "");
+        BENCH_Result(result, (double)retransmits[sack] / SEEDS, "segments");
+    }
+}
+
+int main(void)
+{
+    uint32_t index;
+
+    for(index = 0; index < LENGTH; index++)
+    {
+        txBuffer[index] = (uint8_t)(index * 13 + 7);
+    }
+    BENCH_Init();
+    PEER_SetLatency((uint64_t)RTT * PEER_MS / 2000);
+
+    for(index = 0; index < sizeof(cases) / sizeof(cases[0]); index++)
+    {
+        run(&cases[index]);
+    }
+
+    return BENCH_Exit();
+}
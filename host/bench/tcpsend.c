@@ -0,0 +1,201 @@
+/**
+  TCP send benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    tcpsend.c
+
+  Summary:
+    Time the device takes to send a block of data to the peer over TCP, for
+    several round trip times, peer windows and lost segments.
+
+  Description:
+    For each case the peer connects to a listening socket of the device,
+    which sends the block with TCP_Send(). The time runs from TCP_Send() to
+    TCP_SendDone(), when the peer has acknowledged every byte, and the peer
+    checks the data. A lost segment is the first transmission of the
+    device segment at that stream offset, dropped by the peer; the case
+    fails when no segment starts at a loss offset.
+    The benchmark only uses the socket API of the original stack, so it
+    also runs on older versions of the TCP/IP library:
+
+      make BENCH=tcpsend run
+      make PROJECT=<older project directory> BUILD=build/<name> BENCH=tcpsend run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#define SERVER_PORT         8000
+#define PEER_PORT           40000
+#define MAX_LOSSES          5
+#define MAX_LENGTH          64000u
+#define TIMEOUT             (60000 * PEER_MS)
+
+typedef struct
+{
+    const char *name;
+    uint32_t rtt;                   // us
+    uint16_t window;                // of the peer
+    uint16_t length;
+    uint8_t losses;
+    uint32_t loss[MAX_LOSSES];      // stream offsets of the lost segments
+} tcpSendCase_t;
+
+static const tcpSendCase_t cases[] =
+{
+    {.name = "lan", .rtt = 100, .window = 8192, .length = 16000},
+    {.name = "rtt 10", .rtt = 10000, .window = 8192, .length = 16000},
+    {.name = "rtt 50", .rtt = 50000, .window = 8192, .length = 16000},
+    {.name = "rtt 50 wnd 1460", .rtt = 50000, .window = 1460, .length = 16000},
+    {.name = "rtt 10 one loss", .rtt = 10000, .window = 8192, .length = 16000, .losses = 1, .loss = {3 * 1460}},
+    // no segment follows the lost one, only the retransmission time-out recovers
+    {.name = "rtt 10 first lost", .rtt = 10000, .window = 8192, .length = 16000, .losses = 1, .loss = {0}},
+    {.name = "rtt 10 last lost", .rtt = 10000, .window = 8192, .length = 16000, .losses = 1, .loss = {10 * 1460}},
+    {.name = "64k rtt 10", .rtt = 10000, .window = 8192, .length = 64000},
+    {.name = "64k rtt 10 one loss", .rtt = 10000, .window = 8192, .length = 64000, .losses = 1, .loss = {20 * 1460}},
+    // both in the same window, the second one is recovered by a partial ACK
+    {.name = "64k rtt 10 two losses", .rtt = 10000, .window = 8192, .length = 64000, .losses = 2,
+     .loss = {20 * 1460, 22 * 1460}},
+    {.name = "64k rtt 50 five losses", .rtt = 50000, .window = 8192, .length = 64000, .losses = 5,
+     .loss = {5 * 1460, 12 * 1460, 20 * 1460, 28 * 1460, 36 * 1460}},
+};
+
+static tcpTCB_t sockets[sizeof(cases) / sizeof(cases[0])];
+static uint8_t rxBuffer[64];
+static uint8_t txBuffer[MAX_LENGTH];
+static const tcpSendCase_t *current;
+static tcpTCB_t *server;
+static peerTcp_t tcp;
+static bool lost[MAX_LOSSES];
+static uint64_t started, done;
+
+static bool dropSegment(peerTcp_t *peer, uint32_t offset, uint16_t length)
+{
+    uint8_t index;
+
+    for(index = 0; index < current->losses; index++)
+    {
+        if(!lost[index] && (offset == current->loss[index]))
+        {
+            lost[index] = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool sendDone(void)
+{
+    switch(TCP_SocketPoll(server))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(server);
+            break;
+        case SOCKET_CLOSED:
+            TCP_Bind(server, SERVER_PORT + (uint16_t)(current - cases));
+            TCP_InsertRxBuffer(server, rxBuffer, sizeof(rxBuffer));
+            TCP_Listen(server);
+            break;
+        case SOCKET_CONNECTED:
+            if(started == 0)
+            {
+                if(TCP_Send(server, txBuffer, current->length) == SUCCESS)
+                {
+                    started = J60_Now();
+                }
+            }
+            else if(TCP_SendDone(server) == SUCCESS)
+            {
+                done = J60_Now();
+                return true;
+            }
+            break;
+        default:
+            break;
+    }
+    return false;
+}
+
+static bool listening(void)
+{
+    sendDone();
+    return TCP_SocketPoll(server) == SOCKET_CLOSED;
+}
+
+static void run(const tcpSendCase_t *sendCase)
+{
+    uint64_t time;
+    char result[40];
+
+    current = sendCase;
+    server = &sockets[sendCase - cases];
+    memset(lost, 0, sizeof(lost));
+    started = 0;
+    done = 0;
+    PEER_SetLatency((uint64_t)sendCase->rtt * PEER_MS / 2000);
+    BENCH_Run(listening, 10 * PEER_MS);
+
+    PEER_TcpInit(&tcp, PEER_PORT + (uint16_t)(sendCase - cases), SERVER_PORT + (uint16_t)(sendCase - cases));
+    tcp.window = sendCase->window;
+    tcp.rxHook = dropSegment;
+    BENCH_Check(PEER_TcpConnect(&tcp), "peer connection");
+    BENCH_Check(BENCH_Run(sendDone, TIMEOUT), sendCase->name);
+    BENCH_Check((tcp.received == sendCase->length) && (memcmp(tcp.rxData, txBuffer, sendCase->length) == 0), "data received by the peer");
+    BENCH_Check(memchr(lost, false, sendCase->losses) == NULL, "segments lost at the loss offsets");
+
+    time = done ? done - started : 0;
+    snprintf(result, sizeof(result), "%s", sendCase->name);
+    BENCH_Result(result, (double)time / PEER_MS, "ms");
+    snprintf(result, sizeof(result), "%s rate", sendCase->name);
+    BENCH_Result(result, time ? (double)sendCase->length * 1000 / ((double)time / PEER_MS) / 1024 : 0, "kB/s");
+    snprintf(result, sizeof(result), "%s segments", sendCase->name);
+    BENCH_Result(result, tcp.segments, "segments");
+    PEER_TcpRemove(&tcp);
+}
+
+int main(void)
+{
+    uint32_t index;
+
+    for(index = 0; index < MAX_LENGTH; index++)
+    {
+        txBuffer[index] = (uint8_t)(index * 13 + 7);
+    }
+    BENCH_Init();
+
+    for(index = 0; index < sizeof(cases) / sizeof(cases[0]); index++)
+    {
+        run(&cases[index]);
+    }
+
+    return BENCH_Exit();
+}
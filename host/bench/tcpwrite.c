@@ -0,0 +1,212 @@
+/**
+  TCP write benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    tcpwrite.c
+
+  Summary:
+    Records per second an application sends over TCP with TCP_Send() and
+    with TCP_Write(), for small records.
+
+  Description:
+    For each case the peer connects to a listening socket of the device and
+    the application sends LENGTH bytes as records of 16 or 256 bytes:
+    - send: one TCP_Send() per record, the next one after TCP_SendDone()
+    - write: TCP_Write() of every record that fits in the TX_RING bytes TX
+      ring, the Nagle algorithm collects them in full segments
+    - nodelay: the same with TCP_SetNoDelay()
+    The time runs from the first record to the last byte received by the
+    peer, which checks the data. The peer has an 8 KB window and ACKs every
+    segment.
+    The close cases, with a 10 ms RTT, call TCP_Close() right after the last
+    TCP_Send() or TCP_Write(), the peer must receive every byte before the
+    FIN.
+
+      make BENCH=tcpwrite run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/tcpv4.h"
+
+#define SERVER_PORT         8200
+#define PEER_PORT           43000
+#define LENGTH              32768u
+#define TX_RING             4096u
+#define TIMEOUT             (60000 * PEER_MS)
+
+typedef enum
+{
+    APP_SEND,
+    APP_WRITE,
+    APP_NODELAY
+} tcpWriteApp_t;
+
+typedef struct
+{
+    const char *name;
+    tcpWriteApp_t app;
+    uint16_t record;
+    uint32_t rtt;                   // us
+    bool close;                     // TCP_Close() after the last record
+} tcpWriteCase_t;
+
+static const tcpWriteCase_t cases[] =
+{
+    {.name = "send 16 rtt 2", .app = APP_SEND, .record = 16, .rtt = 2000},
+    {.name = "send 256 rtt 2", .app = APP_SEND, .record = 256, .rtt = 2000},
+    {.name = "write 16 rtt 2", .app = APP_WRITE, .record = 16, .rtt = 2000},
+    {.name = "write 256 rtt 2", .app = APP_WRITE, .record = 256, .rtt = 2000},
+    {.name = "nodelay 16 rtt 2", .app = APP_NODELAY, .record = 16, .rtt = 2000},
+    {.name = "nodelay 256 rtt 2", .app = APP_NODELAY, .record = 256, .rtt = 2000},
+    {.name = "send 16 rtt 10", .app = APP_SEND, .record = 16, .rtt = 10000},
+    {.name = "send 256 rtt 10", .app = APP_SEND, .record = 256, .rtt = 10000},
+    {.name = "write 16 rtt 10", .app = APP_WRITE, .record = 16, .rtt = 10000},
+    {.name = "write 256 rtt 10", .app = APP_WRITE, .record = 256, .rtt = 10000},
+    {.name = "nodelay 16 rtt 10", .app = APP_NODELAY, .record = 16, .rtt = 10000},
+    {.name = "nodelay 256 rtt 10", .app = APP_NODELAY, .record = 256, .rtt = 10000},
+    {.name = "close send 256", .app = APP_SEND, .record = 256, .rtt = 10000, .close = true},
+    {.name = "close write 256", .app = APP_WRITE, .record = 256, .rtt = 10000, .close = true},
+};
+
+static tcpTCB_t sockets[sizeof(cases) / sizeof(cases[0])];
+static uint8_t rxBuffer[64];
+static uint8_t txRing[TX_RING];
+static uint8_t data[LENGTH];
+static const tcpWriteCase_t *current;
+static tcpTCB_t *server;
+static peerTcp_t tcp;
+static uint32_t written;
+static bool closed;
+static uint64_t started;
+
+static void serverPoll(void)
+{
+    switch(TCP_SocketPoll(server))
+    {
+        case NOT_A_SOCKET:
+            TCP_SocketInit(server);
+            break;
+        case SOCKET_CLOSED:
+            TCP_Bind(server, SERVER_PORT + (uint16_t)(current - cases));
+            TCP_InsertRxBuffer(server, rxBuffer, sizeof(rxBuffer));
+            if(current->app != APP_SEND)
+            {
+                TCP_InsertTxBuffer(server, txRing, sizeof(txRing));
+                TCP_SetNoDelay(server, current->app == APP_NODELAY);
+            }
+            TCP_Listen(server);
+            break;
+        case SOCKET_CONNECTED:
+            if(started == 0)
+            {
+                started = J60_Now();
+            }
+            if(current->app == APP_SEND)
+            {
+                if((written < LENGTH) && ((written == 0) || (TCP_SendDone(server) == SUCCESS)) &&
+                   (TCP_Send(server, &data[written], current->record) == SUCCESS))
+                {
+                    written += current->record;
+                }
+            }
+            else
+            {
+                while((written < LENGTH) && (TCP_GetTxFree(server) >= current->record))
+                {
+                    written += TCP_Write(server, &data[written], current->record);
+                }
+            }
+            if(current->close && (written == LENGTH) && !closed)
+            {
+                closed = (TCP_Close(server) == SUCCESS);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static bool listening(void)
+{
+    serverPoll();
+    return TCP_SocketPoll(server) == SOCKET_CLOSED;
+}
+
+static bool receivedAll(void)
+{
+    serverPoll();
+    return (tcp.received == LENGTH) && (!current->close || tcp.finReceived);
+}
+
+static void run(const tcpWriteCase_t *writeCase)
+{
+    uint64_t time;
+    char result[40];
+
+    current = writeCase;
+    server = &sockets[writeCase - cases];
+    written = 0;
+    closed = false;
+    started = 0;
+    PEER_SetLatency((uint64_t)writeCase->rtt * PEER_MS / 2000);
+    BENCH_Run(listening, 10 * PEER_MS);
+
+    PEER_TcpInit(&tcp, PEER_PORT + (uint16_t)(writeCase - cases), SERVER_PORT + (uint16_t)(writeCase - cases));
+    BENCH_Check(PEER_TcpConnect(&tcp), "peer connection");
+    BENCH_Check(BENCH_Run(receivedAll, TIMEOUT), writeCase->name);
+    BENCH_Check(memcmp(tcp.rxData, data, LENGTH) == 0, "data received by the peer");
+    time = J60_Now() - started;
+
+    snprintf(result, sizeof(result), "%s", writeCase->name);
+    BENCH_Result(result, (double)(LENGTH / writeCase->record) * 1000 / ((double)time / PEER_MS), "records/s");
+    snprintf(result, sizeof(result), "%s segments", writeCase->name);
+    BENCH_Result(result, tcp.segments, "segments");
+    PEER_TcpRemove(&tcp);
+}
+
+int main(void)
+{
+    uint32_t index;
+
+    for(index = 0; index < LENGTH; index++)
+    {
+        data[index] = (uint8_t)(index * 13 + 7);
+    }
+    BENCH_Init();
+
+    for(index = 0; index < sizeof(cases) / sizeof(cases[0]); index++)
+    {
+        run(&cases[index]);
+    }
+
+    return BENCH_Exit();
+}
@@ -0,0 +1,170 @@
+/**
+  TX gap benchmark of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    txgap.c
+
+  Summary:
+    Idle time of the wire between two queued frames, and the recovery from
+    aborted transmissions.
+
+  Description:
+    The application keeps the TX ring full of 512 byte UDP datagrams. For a
+    datagram that UDP_Send() queued behind a running transmission, the time
+    between the end of the previous frame (inter-frame gap included) and its
+    start is the time the driver takes to see TXIF and set TXRTS: ETH_ISR()
+    with ETH_INTERRUPT_DRIVEN, the main loop without it. C code costs no time
+    on the model, so the main loop is run bare and with APP_LOOP_NS of other
+    application work per pass.
+    Then the MAC aborts TX_ABORTS transmissions: each must be counted in
+    ethStats.txAborted and the frames behind it must still be sent.
+
+      make BENCH=txgap run
+      make BENCH=txgap UNDEFINE=ETH_INTERRUPT_DRIVEN run
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "TCPIPLibrary/udpv4.h"
+#include "TCPIPLibrary/physical_layer_interface.h"
+
+#define DATAGRAMS           400
+#define DATAGRAM_SIZE       512
+#define APP_LOOP_NS         (100 * PEER_MS / 1000)   // 100 us
+#define TX_ABORTS           5
+#define TIMEOUT             (5000 * PEER_MS)
+#define DISCARD_PORT        9
+#define PAYLOAD_OFFSET      (14 + 20 + 8)
+
+static uint32_t sent;
+static uint32_t target;
+static uint32_t loopTime;
+static bool queued[DATAGRAMS];  // UDP_Send() returned TX_QUEUED
+
+static bool sendBurst(void)
+{
+    static uint8_t data[DATAGRAM_SIZE];
+
+    // as many datagrams as the TX ring takes, the rest in the next pass
+    while(sent < target)
+    {
+        if(UDP_Start(PEER_ADDRESS, DISCARD_PORT, DISCARD_PORT) != SUCCESS)
+        {
+            break;
+        }
+        memset(data, 0, sizeof(data));
+        memcpy(data, &sent, sizeof(sent));
+        UDP_WriteBlock((char *)data, sizeof(data));
+        queued[sent % DATAGRAMS] = (UDP_Send() == TX_QUEUED);
+        sent++;
+    }
+    if(loopTime)
+    {
+        J60_Advance(loopTime);
+    }
+    return (sent == target) && (ETH_GetStats()->txQueueDepth == 0);
+}
+
+static bool datagram(const j60Frame_t *frame, uint32_t *sequence)
+{
+    if((frame == NULL) || (frame->length < PAYLOAD_OFFSET + sizeof(*sequence)) || (frame->data[23] != 17) ||
+       (((frame->data[36] << 8) | frame->data[37]) != DISCARD_PORT))
+    {
+        return false;
+    }
+    memcpy(sequence, &frame->data[PAYLOAD_OFFSET], sizeof(*sequence));
+    return true;
+}
+
+static void burst(const char *name, uint32_t appLoop)
+{
+    const j60Frame_t *frame, *previous = NULL;
+    uint32_t first, index, sequence, gaps = 0;
+    uint64_t gap, total = 0, longest = 0;
+    char result[40];
+
+    loopTime = appLoop;
+    sent = 0;
+    target = DATAGRAMS;
+    first = J60_TxCount();
+    BENCH_Check(BENCH_Run(sendBurst, TIMEOUT), "burst sent");
+    for(index = first; index < J60_TxCount(); index++)
+    {
+        frame = J60_TxFrame(index);
+        if(!datagram(frame, &sequence))
+        {
+            previous = NULL;
+            continue;
+        }
+        if(previous && queued[sequence])
+        {
+            gap = frame->start - previous->time;
+            total += gap;
+            gaps++;
+            if(gap > longest)
+            {
+                longest = gap;
+            }
+        }
+        previous = frame;
+    }
+    BENCH_Check(gaps > 0, "datagrams queued behind a transmission");
+    snprintf(result, sizeof(result), "%s queued", name);
+    BENCH_Result(result, gaps, "frames");
+    snprintf(result, sizeof(result), "%s tx gap mean", name);
+    BENCH_Result(result, gaps ? (double)total / gaps : 0, "ns");
+    snprintf(result, sizeof(result), "%s tx gap max", name);
+    BENCH_Result(result, (double)longest, "ns");
+}
+
+int main(void)
+{
+    uint32_t aborted, frames;
+
+    BENCH_Init();
+
+    burst("bare loop", 0);
+    burst("100 us loop", APP_LOOP_NS);
+
+    // aborted transmissions
+    loopTime = 0;
+    aborted = ETH_GetStats()->txAborted;
+    frames = J60_TxCount();
+    J60_AbortTx(TX_ABORTS);
+    sent = 0;
+    target = DATAGRAMS / 4;
+    BENCH_Check(BENCH_Run(sendBurst, TIMEOUT), "burst after the aborts sent");
+    BENCH_Result("tx aborted", ETH_GetStats()->txAborted - aborted, "frames");
+    BENCH_Result("tx sent after aborts", J60_TxCount() - frames, "frames");
+    BENCH_Check(ETH_GetStats()->txAborted - aborted == TX_ABORTS, "aborts counted");
+    BENCH_Check(J60_TxCount() - frames == DATAGRAMS / 4 - TX_ABORTS, "frames behind the aborts sent");
+
+    return BENCH_Exit();
+}
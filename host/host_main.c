@@ -0,0 +1,395 @@
+/**
+  Frame injection driver of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    host_main.c
+
+  Summary:
+    Runs the main() of a demo project on the MAC model and drives it from the
+    link partner, then reports the packet and byte rates of every path.
+
+  Description:
+    The main() of the project runs unchanged as FIRMWARE_Main(): it calls
+    SYSTEM_Initialize(), enables the interrupts and loops on Network_Manage()
+    and the demo application. The scenario runs from the tick handler of the
+    link partner while the firmware loops:
+    - lease: the peer answers DHCP and the device takes PEER_DEVICE_ADDRESS
+    - arp:   ARP requests, each sent when the previous reply arrived
+    - icmp:  echo requests of 56, 512 and 1400 bytes, one at a time
+    - udp:   datagrams to the demo port, or to a closed port for the ICMP
+             port unreachable, and the button of the UDP demo
+    - tcp:   16000 bytes echoed by the TCP server demo, or 4000 bytes sent
+             to the TCP client demo once it connected to the peer
+    The rates come from Network_GetStats() sampled at both ends of a step.
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xc.h>
+#include "j60_model.h"
+#include "peer.h"
+#include "TCPIPLibrary/network.h"
+#include "TCPIPLibrary/ip_database.h"
+
+#define LATENCY             (50 * PEER_MS / 1000)  // one way, 50 us
+#define STEP_TIMEOUT        (10000 * PEER_MS)
+#define ARP_REQUESTS        100
+#define ICMP_REQUESTS       150
+#define UDP_DATAGRAMS       100
+#define BUTTON_PRESSES      10
+#define BUTTON_TIME         (5 * PEER_MS)
+#define TCP_ECHO_BYTES      16000u
+#define TCP_CLIENT_BYTES    4000u
+#define ECHO_PORT           7
+#define CLIENT_PORT         65534   // the TCP client demo connects to the peer
+#define UDP_DEMO_PORT       65531
+#define UDP_CLOSED_PORT     9
+
+typedef enum
+{
+    STEP_LEASE = 0,
+    STEP_ARP,
+    STEP_ICMP,
+    STEP_UDP,
+    STEP_TCP,
+    STEP_COUNT
+} step_t;
+
+typedef struct
+{
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+    uint32_t sent;          // requests of the peer
+    uint32_t answered;      // frames of the device counted by the step
+    bool done;
+    bool failed;
+    networkPathStats_t before[NET_PATH_COUNT];
+    networkPathStats_t after[NET_PATH_COUNT];
+} stepResult_t;
+
+void FIRMWARE_Main(void);
+
+static stepResult_t steps[STEP_COUNT] =
+{
+    {.name = "lease"}, {.name = "arp"}, {.name = "icmp"}, {.name = "udp"}, {.name = "tcp"}
+};
+static step_t step;
+static bool waiting;        // for the answer to the last request
+static uint32_t badFrames;
+#ifndef HOST_APP_UDP
+static peerTcp_t tcp;
+#endif
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+#ifdef HOST_APP_TCP_SERVER
+static bool echoMatches(void)
+{
+    uint32_t offset;
+
+    for(offset = 0; offset < tcp.received; offset++)
+    {
+        if(tcp.rxData[offset] != PEER_Payload(offset))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+static void sampleStats(networkPathStats_t *stats)
+{
+    networkPath_t path;
+
+    for(path = NET_PATH_ARP; path < NET_PATH_COUNT; path++)
+    {
+        stats[path] = *Network_GetStats(path);
+    }
+}
+
+static void report(void)
+{
+    static const char *pathNames[NET_PATH_COUNT] = {"arp", "icmp", "udp", "tcp", "lldp", "other"};
+    const j60Stats_t *model = J60_GetStats();
+    stepResult_t *result;
+    networkPath_t path;
+    uint32_t rxPackets, txPackets, rxBytes, txBytes;
+    double seconds;
+    bool failed = (badFrames != 0);
+    uint8_t index;
+
+    printf("%-6s %-6s %9s %8s %10s %8s %10s %10s %12s\n",
+           "step", "path", "time ms", "rx pkts", "rx bytes", "tx pkts", "tx bytes", "pkts/s", "bytes/s");
+    for(index = 0; index < STEP_COUNT; index++)
+    {
+        result = &steps[index];
+        if(!result->done && !result->failed)
+        {
+            continue;
+        }
+        seconds = (double)(result->end - result->start) / 1e9;
+        for(path = NET_PATH_ARP; path < NET_PATH_COUNT; path++)
+        {
+            rxPackets = result->after[path].rxPackets - result->before[path].rxPackets;
+            txPackets = result->after[path].txPackets - result->before[path].txPackets;
+            rxBytes = result->after[path].rxBytes - result->before[path].rxBytes;
+            txBytes = result->after[path].txBytes - result->before[path].txBytes;
+            if(rxPackets + txPackets == 0)
+            {
+                continue;
+            }
+            printf("%-6s %-6s %9.1f %8u %10u %8u %10u %10.0f %12.0f\n",
+                   result->name, pathNames[path], seconds * 1e3, rxPackets, rxBytes, txPackets, txBytes,
+                   (rxPackets + txPackets) / seconds, (rxBytes + txBytes) / seconds);
+        }
+        if(result->failed)
+        {
+            printf("%-6s FAILED after %u requests, %u answers\n", result->name, result->sent, result->answered);
+            failed = true;
+        }
+    }
+    printf("model: %u frames received, %u filtered, %u dropped, %u sent, %u interrupts, %u DMA copies, %u DMA checksums\n",
+           model->rxFrames, model->rxFiltered, model->rxDropped, model->txFrames, model->interrupts,
+           model->dmaCopies, model->dmaChecksums);
+    if(badFrames)
+    {
+        printf("%u frames of the device with a bad checksum\n", badFrames);
+    }
+    printf("%s\n", failed ? "FAILED" : "PASSED");
+    exit(failed ? 1 : 0);
+}
+
+static void nextStep(uint64_t now)
+{
+    stepResult_t *result = &steps[step];
+
+    result->end = now;
+    result->done = !result->failed;
+    sampleStats(result->after);
+    if(result->failed || (++step == STEP_COUNT))
+    {
+        report();
+    }
+    result = &steps[step];
+    result->start = now;
+    sampleStats(result->before);
+    waiting = false;
+}
+
+static void deviceFrame(const uint8_t *frame, uint16_t length)
+{
+    const uint8_t *ip = frame + 14;
+    stepResult_t *result = &steps[step];
+
+    if(!PEER_Verify(frame, length))
+    {
+        badFrames++;
+        return;
+    }
+    switch(step)
+    {
+        case STEP_ARP:
+            if((get16(frame + 12) == 0x0806) && (get16(frame + 20) == 2))
+            {
+                result->answered++;
+                waiting = false;
+            }
+            break;
+        case STEP_ICMP:
+            if((get16(frame + 12) == 0x0800) && (ip[9] == 1) && (ip[20] == 0))
+            {
+                result->answered++;
+                waiting = false;
+            }
+            break;
+        case STEP_UDP:
+            if((get16(frame + 12) == 0x0800) && (ip[9] == 1) && (ip[20] == 3))
+            {
+                result->answered++;     // port unreachable
+                waiting = false;
+            }
+            if((get16(frame + 12) == 0x0800) && (ip[9] == 17) && (get16(ip + 22) == UDP_DEMO_PORT))
+            {
+                result->answered++;     // button of the UDP demo
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void scenario(uint64_t now)
+{
+    static const uint16_t pingSizes[3] = {56, 512, 1400};
+#ifdef HOST_APP_UDP
+    static uint64_t buttonAt;
+#endif
+    stepResult_t *result = &steps[step];
+    uint8_t data[64];
+
+    if(now - result->start > STEP_TIMEOUT)
+    {
+        result->failed = true;
+        nextStep(now);
+        return;
+    }
+    switch(step)
+    {
+        case STEP_LEASE:
+            if(PEER_Leased() && (ipdb_getAddress() == PEER_DEVICE_ADDRESS))
+            {
+                nextStep(now);
+            }
+            break;
+        case STEP_ARP:
+            if(!waiting)
+            {
+                if(result->sent == ARP_REQUESTS)
+                {
+                    nextStep(now);
+                    break;
+                }
+                PEER_ArpRequest();
+                result->sent++;
+                waiting = true;
+            }
+            break;
+        case STEP_ICMP:
+            if(!waiting)
+            {
+                if(result->sent == ICMP_REQUESTS)
+                {
+                    nextStep(now);
+                    break;
+                }
+                PEER_Ping(0x4854, (uint16_t)result->sent, pingSizes[result->sent % 3]);
+                result->sent++;
+                waiting = true;
+            }
+            break;
+        case STEP_UDP:
+#ifdef HOST_APP_UDP
+            // datagrams for UDP_Demo_Recv() every ms, then the button
+            if(result->sent < UDP_DATAGRAMS)
+            {
+                if(now - buttonAt >= PEER_MS)
+                {
+                    buttonAt = now;
+                    memset(data, 'L', sizeof(data));
+                    PEER_UdpSend(UDP_DEMO_PORT, UDP_DEMO_PORT, data, sizeof(data));
+                    result->sent++;
+                }
+            }
+            else if(result->answered < BUTTON_PRESSES)
+            {
+                if(now - buttonAt >= BUTTON_TIME)
+                {
+                    buttonAt = now;
+                    PORTBbits.RB0 = !PORTBbits.RB0;
+                }
+            }
+            else
+            {
+                PORTBbits.RB0 = 1;
+                nextStep(now);
+                report();
+            }
+#else
+            if(!waiting)
+            {
+                if(result->sent == UDP_DATAGRAMS)
+                {
+                    nextStep(now);
+                    break;
+                }
+                memset(data, 'U', sizeof(data));
+                PEER_UdpSend(40000, UDP_CLOSED_PORT, data, (uint16_t)(result->sent % sizeof(data)));
+                result->sent++;
+                waiting = true;
+            }
+#endif
+            break;
+        case STEP_TCP:
+#if defined(HOST_APP_TCP_SERVER)
+            if(tcp.state == PEER_TCP_CLOSED)
+            {
+                PEER_TcpInit(&tcp, 40000, ECHO_PORT);
+                PEER_TcpConnect(&tcp);
+            }
+            else if((tcp.state == PEER_TCP_ESTABLISHED) && (tcp.txTotal == 0))
+            {
+                PEER_TcpSend(&tcp, TCP_ECHO_BYTES);
+                result->sent = TCP_ECHO_BYTES;
+            }
+            else if(tcp.received == TCP_ECHO_BYTES)
+            {
+                result->answered = tcp.received;
+                result->failed = !echoMatches();
+                nextStep(now);
+            }
+#elif defined(HOST_APP_TCP_CLIENT)
+            if(tcp.state == PEER_TCP_CLOSED)
+            {
+                PEER_TcpInit(&tcp, CLIENT_PORT, 0);
+                PEER_TcpListen(&tcp);
+            }
+            else if((tcp.state == PEER_TCP_ESTABLISHED) && (tcp.txTotal == 0))
+            {
+                PEER_TcpSend(&tcp, TCP_CLIENT_BYTES);
+                result->sent = TCP_CLIENT_BYTES;
+            }
+            else if(tcp.txTotal && (tcp.sndUna == tcp.txBase + tcp.txTotal))
+            {
+                result->answered = tcp.txTotal;
+                nextStep(now);
+            }
+#endif
+            break;
+        default:
+            break;
+    }
+}
+
+int main(void)
+{
+    J60_Init();
+    PEER_Init(LATENCY);
+    PEER_SetRxHandler(deviceFrame);
+    PEER_SetTickHandler(scenario);
+    PEER_SetTrace(getenv("HOST_TRACE") != NULL);
+    PORTBbits.RB0 = 1;      // the button of the UDP demo is released
+    FIRMWARE_Main();
+    return 1;
+}
@@ -0,0 +1,20 @@
+/**
+  Host replacement of the XC8 console header
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    conio.h
+
+  Summary:
+    mcc.h includes <conio.h>, printf() of the host C library writes to stdout.
+
+ */
+
+#ifndef CONIO_H
+#define CONIO_H
+
+#include <stdio.h>
+
+#endif // CONIO_H
@@ -0,0 +1,399 @@
+/**
+  Host replacement of the XC8 device header
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    xc.h
+
+  Summary:
+    PIC18F67J60 special function registers for the Linux host build.
+
+  Description:
+    The stack and the MCC drivers include <xc.h> for the special function
+    registers. On the host this header takes its place: plain registers are
+    variables, the registers whose accesses have side effects on the MAC
+    (ECON1, ECON2, EIR, EPKTCNT, the interrupt flags and enables, the MII
+    registers) go through j60_model.c, which first brings the model up to
+    date: it starts a pending DMA or transmission, applies PKTDEC and runs
+    the interrupt manager when an enabled interrupt is pending.
+    EDATA is reached through J60_EdataRead() and J60_EdataWrite(), the host
+    Makefile puts them in place of the inline assembly of the driver. The
+    XC8 bit symbols GIE and RXRST clash with the bitfield names here, the
+    Makefile spells them INTCONbits.GIE and ECON1bits.RXRST.
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#ifndef XC_H
+#define XC_H
+
+#include <stdint.h>
+
+// XC8 keywords and built-ins
+#define __at(address)
+#define __interrupt(...)
+#define asm(code)           J60_Asm(code)
+#define NOP()               do{ } while(0)
+#define CLRWDT()            do{ } while(0)
+#define RESET()             J60_Reset()
+
+void J60_Asm(const char *code);
+void J60_Reset(void);
+uint8_t J60_EdataRead(void);
+void J60_EdataWrite(uint8_t data);
+
+// ETHxxJ60 registers with side effects, see j60_model.c
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t :2;
+        uint8_t RXEN:1;
+        uint8_t TXRTS:1;
+        uint8_t CSUMEN:1;
+        uint8_t DMAST:1;
+        uint8_t RXRST:1;
+        uint8_t TXRST:1;
+    };
+} ECON1bits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t :5;
+        uint8_t ETHEN:1;
+        uint8_t PKTDEC:1;
+        uint8_t AUTOINC:1;
+    };
+} ECON2bits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t RXERIF:1;
+        uint8_t TXERIF:1;
+        uint8_t :1;
+        uint8_t TXIF:1;
+        uint8_t LINKIF:1;
+        uint8_t DMAIF:1;
+        uint8_t PKTIF:1;
+        uint8_t :1;
+    };
+} EIRbits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t RXERIE:1;
+        uint8_t TXERIE:1;
+        uint8_t :1;
+        uint8_t TXIE:1;
+        uint8_t LINKIE:1;
+        uint8_t DMAIE:1;
+        uint8_t PKTIE:1;
+        uint8_t :1;
+    };
+} EIEbits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t PHYRDY:1;
+        uint8_t TXABRT:1;
+        uint8_t RXBUSY:1;
+        uint8_t :3;
+        uint8_t BUFER:1;
+        uint8_t :1;
+    };
+} ESTATbits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t MIIRD:1;
+        uint8_t :7;
+    };
+} MICMDbits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t BUSY:1;
+        uint8_t :7;
+    };
+} MISTATbits_t;
+
+// interrupt control
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t :6;
+        uint8_t PEIE:1;
+        uint8_t GIE:1;
+    };
+} INTCONbits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t TMR1IF:1;
+        uint8_t :7;
+    };
+} PIR1bits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t TMR1IE:1;
+        uint8_t :7;
+    };
+} PIE1bits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t :5;
+        uint8_t ETHIF:1;
+        uint8_t :2;
+    };
+} PIR2bits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t :5;
+        uint8_t ETHIE:1;
+        uint8_t :2;
+    };
+} PIE2bits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t :5;
+        uint8_t ETHIP:1;
+        uint8_t :2;
+    };
+} IPR2bits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t :7;
+        uint8_t IPEN:1;
+    };
+} RCONbits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t TMR1ON:1;
+        uint8_t TMR1CS:1;
+        uint8_t nT1SYNC:1;
+        uint8_t T1OSCEN:1;
+        uint8_t T1CKPS:2;
+        uint8_t T1RUN:1;
+        uint8_t RD16:1;
+    };
+} T1CONbits_t;
+
+// I/O ports, only the bits used by the demos
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t RB0:1;
+        uint8_t :7;
+    };
+} PORTBbits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t :2;
+        uint8_t RF2:1;
+        uint8_t :5;
+    };
+} PORTFbits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t :2;
+        uint8_t LATF2:1;
+        uint8_t :5;
+    };
+} LATFbits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t :2;
+        uint8_t TRISF2:1;
+        uint8_t :5;
+    };
+} TRISFbits_t;
+
+typedef union
+{
+    uint8_t v;
+    struct
+    {
+        uint8_t PCFG:4;
+        uint8_t VCFG:2;
+        uint8_t :2;
+    };
+} ADCON1bits_t;
+
+ECON1bits_t *J60_Econ1(void);
+ECON2bits_t *J60_Econ2(void);
+EIRbits_t *J60_Eir(void);
+EIEbits_t *J60_Eie(void);
+ESTATbits_t *J60_Estat(void);
+volatile uint8_t *J60_Epktcnt(void);
+MICMDbits_t *J60_Micmd(void);
+volatile uint16_t *J60_Mird(void);
+volatile uint16_t *J60_Miwr(void);
+INTCONbits_t *J60_Intcon(void);
+PIR1bits_t *J60_Pir1(void);
+PIE1bits_t *J60_Pie1(void);
+PIR2bits_t *J60_Pir2(void);
+PIE2bits_t *J60_Pie2(void);
+
+#define ECON1bits           (*J60_Econ1())
+#define ECON1               (J60_Econ1()->v)
+#define ECON2bits           (*J60_Econ2())
+#define ECON2               (J60_Econ2()->v)
+#define EIRbits             (*J60_Eir())
+#define EIR                 (J60_Eir()->v)
+#define EIEbits             (*J60_Eie())
+#define EIE                 (J60_Eie()->v)
+#define ESTATbits           (*J60_Estat())
+#define ESTAT               (J60_Estat()->v)
+#define EPKTCNT             (*J60_Epktcnt())
+#define MICMDbits           (*J60_Micmd())
+#define MICMD               (J60_Micmd()->v)
+#define MIRD                (*J60_Mird())
+#define MIWR                (*J60_Miwr())
+#define MIRDL               (((volatile uint8_t *)J60_Mird())[0])
+#define MIRDH               (((volatile uint8_t *)J60_Mird())[1])
+#define MIWRL               (((volatile uint8_t *)J60_Miwr())[0])
+#define MIWRH               (((volatile uint8_t *)J60_Miwr())[1])
+#define INTCONbits          (*J60_Intcon())
+#define INTCON              (J60_Intcon()->v)
+#define PIR1bits            (*J60_Pir1())
+#define PIR1                (J60_Pir1()->v)
+#define PIE1bits            (*J60_Pie1())
+#define PIE1                (J60_Pie1()->v)
+#define PIR2bits            (*J60_Pir2())
+#define PIR2                (J60_Pir2()->v)
+#define PIE2bits            (*J60_Pie2())
+#define PIE2                (J60_Pie2()->v)
+
+// plain registers
+extern volatile uint16_t ERDPT, EWRPT;
+extern volatile uint16_t ETXST, ETXND, ERXST, ERXND, ERXRDPT, ERXWRPT;
+extern volatile uint16_t EDMAST, EDMAND, EDMADST, EDMACS;
+extern volatile uint8_t ERXFCON, EFLOCON;
+extern volatile uint16_t EPAUS;
+extern volatile uint8_t EHT[8], EPMM[8];
+extern volatile uint16_t EPMCS, EPMO;
+extern volatile uint8_t MACON1, MACON3, MACON4, MABBIPG;
+extern volatile uint16_t MAIPG, MAMXFL;
+extern volatile uint8_t MAADR1, MAADR2, MAADR3, MAADR4, MAADR5, MAADR6;
+extern volatile uint8_t MIREGADR;
+extern volatile MISTATbits_t MISTATbits;
+extern volatile uint8_t WREG, OSCCON, OSCTUNE;
+extern volatile uint16_t TMR1;
+extern volatile T1CONbits_t T1CONbits;
+extern volatile RCONbits_t RCONbits;
+extern volatile IPR2bits_t IPR2bits;
+extern volatile uint8_t LATA, LATB, LATC, LATD, LATE, LATG;
+extern volatile uint8_t TRISA, TRISB, TRISC, TRISD, TRISE, TRISG;
+extern volatile uint8_t PORTA, PORTC, PORTD, PORTE, PORTG;
+extern volatile LATFbits_t LATFbits;
+extern volatile TRISFbits_t TRISFbits;
+extern volatile PORTBbits_t PORTBbits;
+extern volatile PORTFbits_t PORTFbits;
+extern volatile ADCON1bits_t ADCON1bits;
+extern volatile uint8_t ADCON0, ADCON2, CMCON, CVRCON;
+
+#define EDMACSL             (((volatile uint8_t *)&EDMACS)[0])
+#define EDMACSH             (((volatile uint8_t *)&EDMACS)[1])
+#define EPMCSL              (((volatile uint8_t *)&EPMCS)[0])
+#define EPMCSH              (((volatile uint8_t *)&EPMCS)[1])
+#define EPMOL               (((volatile uint8_t *)&EPMO)[0])
+#define EPMOH               (((volatile uint8_t *)&EPMO)[1])
+#define EHT0                EHT[0]
+#define EPMM0               EPMM[0]
+#define TMR1L               (((volatile uint8_t *)&TMR1)[0])
+#define TMR1H               (((volatile uint8_t *)&TMR1)[1])
+#define T1CON               (T1CONbits.v)
+#define RCON                (RCONbits.v)
+#define LATF                (LATFbits.v)
+#define TRISF               (TRISFbits.v)
+#define PORTB               (PORTBbits.v)
+#define PORTF               (PORTFbits.v)
+#define ADCON1              (ADCON1bits.v)
+#define MISTAT              (MISTATbits.v)
+
+#endif // XC_H
@@ -0,0 +1,817 @@
+/**
+  ETHxxJ60 MAC model for the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    j60_model.c
+
+  Summary:
+    Packet RAM, RX ring, DMA, transmitter, PHY and interrupt model of the
+    PIC18F97J60 family Ethernet module.
+
+  Description:
+    The model follows the data sheet behaviour the driver depends on:
+    - EDATA reads and writes with AUTOINC, ERDPT wraps from ERXND to ERXST
+    - the RX ring with the next packet pointer, the receive status vector,
+      ERXRDPT as the write limit, EPKTCNT, PKTDEC and the ERXFCON filters
+    - the DMA copy and checksum engine, the copy wraps inside the RX ring
+    - the transmitter: the per packet control byte at ETXST, the frame up to
+      ETXND, the 7 byte transmit status vector after it, TXIF and TXERIF
+    - the PHY registers behind MIREGADR, MIRD and MIWR, PHIR clears on read
+    - TMR1 and the interrupt manager, called when an enabled interrupt is
+      pending and GIE and PEIE are set
+    The firmware only sees the effects of a register write at its next
+    register access, as every access first brings the model up to date.
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xc.h>
+#include "j60_model.h"
+
+#define RAM_MASK            (J60_RAM_SIZE - 1)
+#define MIN_FRAME           60u     // padded by the MAC, without the FCS
+#define FCS_SIZE            4u
+#define RSV_SIZE            6u
+#define TSV_SIZE            7u
+#define WIRE_OVERHEAD       (8u + FCS_SIZE + 12u)  // preamble, FCS, inter-frame gap
+#define MAX_INTERRUPTS      100000u // back to back, the flag is never cleared
+
+// PHY registers and bits
+#define PHSTAT1             0x01
+#define PHSTAT2             0x11
+#define PHIE                0x12
+#define PHIR                0x13
+#define PHSTAT1_LLSTAT      0x0004
+#define PHSTAT2_LSTAT       0x0400
+#define PHIE_PGEIE          0x0002
+#define PHIE_PLNKIE         0x0010
+#define PHIR_PGIF           0x0004
+#define PHIR_PLNKIF         0x0010
+
+// ERXFCON bits
+#define ERXFCON_UCEN        0x80
+#define ERXFCON_ANDOR       0x40
+#define ERXFCON_PMEN        0x10
+#define ERXFCON_MPEN        0x08
+#define ERXFCON_HTEN        0x04
+#define ERXFCON_MCEN        0x02
+#define ERXFCON_BCEN        0x01
+#define ERXFCON_FILTERS     (ERXFCON_UCEN | ERXFCON_PMEN | ERXFCON_MPEN | ERXFCON_HTEN | ERXFCON_MCEN | ERXFCON_BCEN)
+
+#define EIR_IMPLEMENTED     0x7B
+
+void INTERRUPT_InterruptManager(void);
+
+// plain registers, see xc.h
+volatile uint16_t ERDPT, EWRPT;
+volatile uint16_t ETXST, ETXND, ERXST, ERXND, ERXRDPT, ERXWRPT;
+volatile uint16_t EDMAST, EDMAND, EDMADST, EDMACS;
+volatile uint8_t ERXFCON, EFLOCON;
+volatile uint16_t EPAUS;
+volatile uint8_t EHT[8], EPMM[8];
+volatile uint16_t EPMCS, EPMO;
+volatile uint8_t MACON1, MACON3, MACON4, MABBIPG;
+volatile uint16_t MAIPG, MAMXFL;
+volatile uint8_t MAADR1, MAADR2, MAADR3, MAADR4, MAADR5, MAADR6;
+volatile uint8_t MIREGADR;
+volatile MISTATbits_t MISTATbits;
+volatile uint8_t WREG, OSCCON, OSCTUNE;
+volatile uint16_t TMR1;
+volatile T1CONbits_t T1CONbits;
+volatile RCONbits_t RCONbits;
+volatile IPR2bits_t IPR2bits;
+volatile uint8_t LATA, LATB, LATC, LATD, LATE, LATG;
+volatile uint8_t TRISA, TRISB, TRISC, TRISD, TRISE, TRISG;
+volatile uint8_t PORTA, PORTC, PORTD, PORTE, PORTG;
+volatile LATFbits_t LATFbits;
+volatile TRISFbits_t TRISFbits;
+volatile PORTBbits_t PORTBbits;
+volatile PORTFbits_t PORTFbits;
+volatile ADCON1bits_t ADCON1bits;
+volatile uint8_t ADCON0, ADCON2, CMCON, CVRCON;
+
+// registers with side effects, reached through the accessors
+static ECON1bits_t econ1;
+static ECON2bits_t econ2;
+static EIRbits_t eir;
+static EIEbits_t eie;
+static ESTATbits_t estat;
+static volatile uint8_t epktcnt;
+static MICMDbits_t micmd;
+static INTCONbits_t intcon;
+static PIR1bits_t pir1;
+static PIE1bits_t pie1;
+static PIR2bits_t pir2;
+static PIE2bits_t pie2;
+
+static uint8_t ram[J60_RAM_SIZE];
+static volatile uint16_t phy[32];
+static volatile uint16_t phirRead;
+static bool linkPending;
+
+static uint64_t now;
+static uint32_t tmr1Rest;           // ns since the last TMR1 increment
+
+static bool wireTime;
+static bool txActive;
+static uint64_t txEnd;
+static uint8_t txAborts;
+static uint32_t txCount;
+static j60Frame_t txLog[J60_TX_LOG_SIZE];
+static j60TxHandler_t txHandler;
+static j60TimeHandler_t timeHandler;
+static bool inTimeHandler;
+
+static uint16_t rxStartSeen, rxEndSeen;
+static bool inInterrupt;
+static j60Stats_t stats;
+
+static void j60Sync(void);
+
+static uint16_t j60RxNext(uint16_t address)
+{
+    return (address == ERXND) ? ERXST : (uint16_t)((address + 1) & RAM_MASK);
+}
+
+static bool j60InRxRing(uint16_t address)
+{
+    return (address >= ERXST) && (address <= ERXND);
+}
+
+static void j60Elapse(uint64_t ns)
+{
+    uint64_t step, toOverflow;
+    uint32_t tick, count;
+
+    while(ns)
+    {
+        step = ns;
+        tick = (1u << T1CONbits.T1CKPS) * J60_TCY_NS;
+        if(T1CONbits.TMR1ON)
+        {
+            toOverflow = (uint64_t)(0x10000u - TMR1) * tick - tmr1Rest;
+            if(toOverflow < step)
+            {
+                step = toOverflow;
+            }
+        }
+        if(txActive && (txEnd > now) && (txEnd - now < step))
+        {
+            step = txEnd - now;
+        }
+        now += step;
+        ns -= step;
+
+        if(T1CONbits.TMR1ON)
+        {
+            tmr1Rest += (uint32_t)step;
+            count = TMR1 + tmr1Rest / tick;
+            tmr1Rest %= tick;
+            if(count > 0xFFFFu)
+            {
+                pir1.TMR1IF = 1;
+            }
+            TMR1 = (uint16_t)count;
+        }
+        j60Sync();
+        if(timeHandler && !inTimeHandler)
+        {
+            inTimeHandler = true;
+            timeHandler(now);
+            inTimeHandler = false;
+        }
+    }
+}
+
+// one instruction cycle for every register access of the firmware
+static void j60Access(void)
+{
+    j60Elapse(J60_TCY_NS);
+}
+
+static void j60Dma(void)
+{
+    uint16_t source = EDMAST;
+    uint16_t destination = EDMADST;
+    bool wrap = j60InRxRing(EDMAST);
+    uint32_t sum = 0;
+    bool highByte = true;
+    static uint8_t copy[J60_RAM_SIZE];
+    uint16_t length = 0;
+    uint16_t index;
+
+    for(;;)
+    {
+        if(econ1.CSUMEN)
+        {
+            sum += highByte ? ((uint32_t)ram[source] << 8) : ram[source];
+            highByte = !highByte;
+        }
+        else
+        {
+            copy[length++] = ram[source];
+        }
+        if((source == EDMAND) || (length == J60_RAM_SIZE))
+        {
+            break;
+        }
+        source = wrap ? j60RxNext(source) : (uint16_t)((source + 1) & RAM_MASK);
+    }
+
+    if(econ1.CSUMEN)
+    {
+        while(sum >> 16)
+        {
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        }
+        EDMACS = (uint16_t)~sum;
+        stats.dmaChecksums++;
+    }
+    else
+    {
+        wrap = j60InRxRing(destination);
+        for(index = 0; index < length; index++)
+        {
+            ram[destination] = copy[index];
+            destination = wrap ? j60RxNext(destination) : (uint16_t)((destination + 1) & RAM_MASK);
+        }
+        stats.dmaCopies++;
+    }
+    econ1.DMAST = 0;
+    eir.DMAIF = 1;
+}
+
+static void j60TxStart(void)
+{
+    j60Frame_t *frame = &txLog[txCount % J60_TX_LOG_SIZE];
+    uint16_t length = (uint16_t)(ETXND - ETXST);
+    uint16_t index;
+
+    if(length > J60_MAX_FRAME)
+    {
+        length = J60_MAX_FRAME;
+    }
+    // the control byte at ETXST is followed by the frame
+    for(index = 0; index < length; index++)
+    {
+        frame->data[index] = ram[(ETXST + 1 + index) & RAM_MASK];
+    }
+    if(length < MIN_FRAME)
+    {
+        memset(&frame->data[length], 0, MIN_FRAME - length);
+        length = MIN_FRAME;
+    }
+    frame->length = length;
+    frame->start = now;
+    txActive = true;
+    txEnd = now + (wireTime ? (uint64_t)(length + WIRE_OVERHEAD) * J60_BYTE_NS : 0);
+}
+
+static void j60TxDone(void)
+{
+    j60Frame_t *frame = &txLog[txCount % J60_TX_LOG_SIZE];
+    uint16_t tsv = (ETXND + 1) & RAM_MASK;
+    uint8_t index;
+
+    txActive = false;
+    for(index = 0; index < TSV_SIZE; index++)
+    {
+        ram[(tsv + index) & RAM_MASK] = 0;
+    }
+    ram[tsv] = (uint8_t)frame->length;
+    ram[(tsv + 1) & RAM_MASK] = (uint8_t)(frame->length >> 8);
+    if(txAborts)
+    {
+        txAborts--;
+        eir.TXERIF = 1;
+        estat.TXABRT = 1;
+        stats.txAborted++;
+    }
+    else
+    {
+        ram[(tsv + 2) & RAM_MASK] = 0x80;      // transmit done
+        frame->time = now;
+        txCount++;
+        stats.txFrames++;
+        if(txHandler)
+        {
+            txHandler(frame);
+        }
+    }
+    econ1.TXRTS = 0;
+    eir.TXIF = 1;
+}
+
+static void j60Flags(void)
+{
+    estat.PHYRDY = econ2.ETHEN;
+    eir.PKTIF = (epktcnt != 0);
+    eir.LINKIF = linkPending;
+    pir2.ETHIF = ((eir.v & eie.v & EIR_IMPLEMENTED) != 0);
+}
+
+static bool j60InterruptPending(void)
+{
+    j60Flags();
+    return intcon.GIE && intcon.PEIE &&
+           ((pie1.TMR1IE && pir1.TMR1IF) || (pie2.ETHIE && pir2.ETHIF));
+}
+
+static void j60Interrupts(void)
+{
+    uint32_t count = 0;
+
+    while(!inInterrupt && j60InterruptPending())
+    {
+        if(++count > MAX_INTERRUPTS)
+        {
+            fprintf(stderr, "j60: interrupt flag never cleared, PIR1 %02X PIR2 %02X EIR %02X EIE %02X\n",
+                    pir1.v, pir2.v, eir.v, eie.v);
+            abort();
+        }
+        inInterrupt = true;
+        intcon.GIE = 0;
+        stats.interrupts++;
+        INTERRUPT_InterruptManager();
+        intcon.GIE = 1;
+        inInterrupt = false;
+    }
+}
+
+static void j60Sync(void)
+{
+    if((ERXST != rxStartSeen) || (ERXND != rxEndSeen))
+    {
+        // a new RX ring, the hardware write pointer restarts at ERXST
+        rxStartSeen = ERXST;
+        rxEndSeen = ERXND;
+        ERXWRPT = ERXST;
+    }
+    if(econ2.PKTDEC)
+    {
+        econ2.PKTDEC = 0;
+        if(epktcnt)
+        {
+            epktcnt--;
+        }
+    }
+    if(econ1.TXRST)
+    {
+        // the transmit logic is held in reset, a transmission in progress is lost
+        txActive = false;
+        econ1.TXRTS = 0;
+    }
+    if(econ1.DMAST)
+    {
+        j60Dma();
+    }
+    if(econ1.TXRTS && !txActive)
+    {
+        j60TxStart();
+    }
+    if(txActive && (now >= txEnd))
+    {
+        j60TxDone();
+    }
+    j60Interrupts();
+}
+
+static bool j60HashMatch(const uint8_t *destination)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t index, bit, data, pointer;
+
+    for(index = 0; index < 6; index++)
+    {
+        data = destination[index];
+        for(bit = 0; bit < 8; bit++)
+        {
+            crc = (((uint8_t)(crc >> 31) ^ data) & 0x01) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+            data >>= 1;
+        }
+    }
+    pointer = (uint8_t)(crc >> 23) & 0x3F;
+    return (EHT[pointer >> 3] >> (pointer & 0x07)) & 0x01;
+}
+
+static bool j60PatternMatch(const uint8_t *frame, uint16_t length)
+{
+    uint32_t sum = 0;
+    bool highByte = true;
+    uint8_t index;
+
+    if((uint32_t)EPMO + 64 > length)
+    {
+        return false;
+    }
+    for(index = 0; index < 64; index++)
+    {
+        if(EPMM[index >> 3] & (1 << (index & 0x07)))
+        {
+            sum += highByte ? ((uint32_t)frame[EPMO + index] << 8) : frame[EPMO + index];
+            highByte = !highByte;
+        }
+    }
+    while(sum >> 16)
+    {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return (uint16_t)~sum == EPMCS;
+}
+
+static bool j60MagicMatch(const uint8_t *frame, uint16_t length, const uint8_t *mac)
+{
+    uint16_t start, repeat;
+
+    for(start = 14; start + 6 + 16 * 6 <= length; start++)
+    {
+        if(memcmp(&frame[start], "\xFF\xFF\xFF\xFF\xFF\xFF", 6) != 0)
+        {
+            continue;
+        }
+        for(repeat = 0; repeat < 16; repeat++)
+        {
+            if(memcmp(&frame[start + 6 + repeat * 6], mac, 6) != 0)
+            {
+                break;
+            }
+        }
+        if(repeat == 16)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool j60Filter(const uint8_t *frame, uint16_t length)
+{
+    const uint8_t mac[6] = {MAADR1, MAADR2, MAADR3, MAADR4, MAADR5, MAADR6};
+    bool broadcast = (memcmp(frame, "\xFF\xFF\xFF\xFF\xFF\xFF", 6) == 0);
+    bool unicast = (memcmp(frame, mac, 6) == 0);
+    uint8_t enabled = ERXFCON & ERXFCON_FILTERS;
+    uint8_t matched = 0;
+
+    if(enabled == 0)
+    {
+        return true;    // promiscuous
+    }
+    if(unicast)
+    {
+        matched |= ERXFCON_UCEN;
+    }
+    if(broadcast)
+    {
+        matched |= ERXFCON_BCEN;
+    }
+    if((frame[0] & 0x01) && !broadcast)
+    {
+        matched |= ERXFCON_MCEN;
+    }
+    if((enabled & ERXFCON_HTEN) && j60HashMatch(frame))
+    {
+        matched |= ERXFCON_HTEN;
+    }
+    if((enabled & ERXFCON_PMEN) && j60PatternMatch(frame, length))
+    {
+        matched |= ERXFCON_PMEN;
+    }
+    if((enabled & ERXFCON_MPEN) && unicast && j60MagicMatch(frame, length, mac))
+    {
+        matched |= ERXFCON_MPEN;
+    }
+    matched &= enabled;
+    return (ERXFCON & ERXFCON_ANDOR) ? (matched == enabled) : (matched != 0);
+}
+
+void J60_Init(void)
+{
+    memset(&econ1, 0, sizeof(econ1));
+    econ2.v = 0x80;             // AUTOINC
+    eir.v = 0;
+    eie.v = 0;
+    estat.v = 0;
+    epktcnt = 0;
+    intcon.v = 0;
+    pir1.v = 0;
+    pie1.v = 0;
+    pir2.v = 0;
+    pie2.v = 0;
+    memset(ram, 0, sizeof(ram));
+    memset((void *)phy, 0, sizeof(phy));
+    phy[PHSTAT1] = PHSTAT1_LLSTAT;
+    phy[PHSTAT2] = PHSTAT2_LSTAT;
+    linkPending = false;
+    ERXST = 0x0000;
+    ERXND = 0x19FF;
+    ETXST = ETXND = 0;
+    ERDPT = 0x05FA;
+    EWRPT = 0;
+    ERXRDPT = 0x05FA;
+    ERXFCON = 0xA1;             // UCEN, CRCEN, BCEN
+    rxStartSeen = ~ERXST;
+    now = 0;
+    tmr1Rest = 0;
+    wireTime = true;
+    txActive = false;
+    txAborts = 0;
+    txCount = 0;
+    txHandler = NULL;
+    timeHandler = NULL;
+    inTimeHandler = false;
+    inInterrupt = false;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void J60_Advance(uint32_t ns)
+{
+    j60Elapse(ns);
+}
+
+uint64_t J60_Now(void)
+{
+    return now;
+}
+
+bool J60_Receive(const uint8_t *frame, uint16_t length)
+{
+    uint16_t total = length + FCS_SIZE;
+    uint16_t size = ERXND - ERXST + 1;
+    uint16_t free, need, address, next, index;
+    uint8_t header[RSV_SIZE];
+
+    j60Sync();
+    if(!j60Filter(frame, length))
+    {
+        stats.rxFiltered++;
+        return false;
+    }
+    need = RSV_SIZE + total;
+    need += need & 1;
+    free = (ERXRDPT >= ERXWRPT) ? ERXRDPT - ERXWRPT : ERXRDPT + size - ERXWRPT;
+    if(!econ1.RXEN || econ1.RXRST || (need >= free) || (epktcnt == 0xFF))
+    {
+        if(econ1.RXEN)
+        {
+            eir.RXERIF = 1;
+        }
+        stats.rxDropped++;
+        j60Sync();
+        return false;
+    }
+
+    address = ERXWRPT;
+    next = address;
+    for(index = 0; index < need; index++)
+    {
+        next = j60RxNext(next);
+    }
+    header[0] = (uint8_t)next;
+    header[1] = (uint8_t)(next >> 8);
+    header[2] = (uint8_t)total;
+    header[3] = (uint8_t)(total >> 8);
+    header[4] = 0x80;           // received ok
+    header[5] = 0;
+    if(memcmp(frame, "\xFF\xFF\xFF\xFF\xFF\xFF", 6) == 0)
+    {
+        header[5] |= 0x02;
+    }
+    else if(frame[0] & 0x01)
+    {
+        header[5] |= 0x01;
+    }
+    for(index = 0; index < RSV_SIZE; index++)
+    {
+        ram[address] = header[index];
+        address = j60RxNext(address);
+    }
+    for(index = 0; index < total; index++)
+    {
+        ram[address] = (index < length) ? frame[index] : 0;
+        address = j60RxNext(address);
+    }
+    ERXWRPT = next;
+    epktcnt++;
+    stats.rxFrames++;
+    j60Sync();
+    return true;
+}
+
+void J60_SetLink(bool up)
+{
+    if(((phy[PHSTAT2] & PHSTAT2_LSTAT) != 0) == up)
+    {
+        return;
+    }
+    if(up)
+    {
+        phy[PHSTAT2] |= PHSTAT2_LSTAT;
+        phy[PHSTAT1] |= PHSTAT1_LLSTAT;
+    }
+    else
+    {
+        phy[PHSTAT2] &= ~PHSTAT2_LSTAT;
+        phy[PHSTAT1] &= ~PHSTAT1_LLSTAT;
+    }
+    phy[PHIR] |= PHIR_PLNKIF | PHIR_PGIF;
+    linkPending = (phy[PHIE] & (PHIE_PGEIE | PHIE_PLNKIE)) == (PHIE_PGEIE | PHIE_PLNKIE);
+    j60Sync();
+}
+
+void J60_SetWireTime(bool enabled)
+{
+    wireTime = enabled;
+}
+
+void J60_AbortTx(uint8_t count)
+{
+    txAborts = count;
+}
+
+void J60_SetTxHandler(j60TxHandler_t handler)
+{
+    txHandler = handler;
+}
+
+void J60_SetTimeHandler(j60TimeHandler_t handler)
+{
+    timeHandler = handler;
+}
+
+uint32_t J60_TxCount(void)
+{
+    return txCount;
+}
+
+const j60Frame_t *J60_TxFrame(uint32_t index)
+{
+    if((index >= txCount) || (txCount - index > J60_TX_LOG_SIZE))
+    {
+        return NULL;
+    }
+    return &txLog[index % J60_TX_LOG_SIZE];
+}
+
+const j60Stats_t *J60_GetStats(void)
+{
+    return &stats;
+}
+
+// XC8 built-ins and registers, see xc.h
+
+void J60_Asm(const char *code)
+{
+    fprintf(stderr, "j60: no host version of asm(\"%s\")\n", code);
+    abort();
+}
+
+void J60_Reset(void)
+{
+    fprintf(stderr, "j60: RESET() at %llu ns\n", (unsigned long long)now);
+    exit(2);
+}
+
+uint8_t J60_EdataRead(void)
+{
+    uint8_t data;
+
+    j60Access();
+    data = ram[ERDPT & RAM_MASK];
+    if(econ2.AUTOINC)
+    {
+        ERDPT = (ERDPT == ERXND) ? ERXST : (uint16_t)((ERDPT + 1) & RAM_MASK);
+    }
+    stats.edataReads++;
+    return data;
+}
+
+void J60_EdataWrite(uint8_t data)
+{
+    j60Access();
+    ram[EWRPT & RAM_MASK] = data;
+    if(econ2.AUTOINC)
+    {
+        EWRPT = (EWRPT + 1) & RAM_MASK;
+    }
+    stats.edataWrites++;
+}
+
+ECON1bits_t *J60_Econ1(void)
+{
+    j60Access();
+    return &econ1;
+}
+
+ECON2bits_t *J60_Econ2(void)
+{
+    j60Access();
+    return &econ2;
+}
+
+EIRbits_t *J60_Eir(void)
+{
+    j60Access();
+    return &eir;
+}
+
+EIEbits_t *J60_Eie(void)
+{
+    j60Access();
+    return &eie;
+}
+
+ESTATbits_t *J60_Estat(void)
+{
+    j60Access();
+    return &estat;
+}
+
+volatile uint8_t *J60_Epktcnt(void)
+{
+    j60Access();
+    return &epktcnt;
+}
+
+MICMDbits_t *J60_Micmd(void)
+{
+    j60Access();
+    return &micmd;
+}
+
+volatile uint16_t *J60_Mird(void)
+{
+    j60Access();
+    if((MIREGADR & 0x1F) == PHIR)
+    {
+        // reading PHIR clears the PHY interrupt flags
+        phirRead = phy[PHIR];
+        phy[PHIR] = 0;
+        linkPending = false;
+        return &phirRead;
+    }
+    return &phy[MIREGADR & 0x1F];
+}
+
+volatile uint16_t *J60_Miwr(void)
+{
+    j60Access();
+    return &phy[MIREGADR & 0x1F];
+}
+
+INTCONbits_t *J60_Intcon(void)
+{
+    j60Access();
+    return &intcon;
+}
+
+PIR1bits_t *J60_Pir1(void)
+{
+    j60Access();
+    return &pir1;
+}
+
+PIE1bits_t *J60_Pie1(void)
+{
+    j60Access();
+    return &pie1;
+}
+
+PIR2bits_t *J60_Pir2(void)
+{
+    j60Access();
+    j60Flags();
+    return &pir2;
+}
+
+PIE2bits_t *J60_Pie2(void)
+{
+    j60Access();
+    return &pie2;
+}
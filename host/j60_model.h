@@ -0,0 +1,159 @@
+/**
+  ETHxxJ60 MAC model for the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    j60_model.h
+
+  Summary:
+    Packet RAM, RX ring, DMA, transmitter, PHY and interrupt model of the
+    PIC18F97J60 family Ethernet module.
+
+  Description:
+    The stack is built unchanged against host/include/xc.h, whose registers
+    are implemented here. The host program injects frames with J60_Receive(),
+    lets time pass with J60_Advance() and reads the transmitted frames back
+    with J60_TxFrame().
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#ifndef J60_MODEL_H
+#define J60_MODEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define J60_RAM_SIZE        8192u
+#define J60_MAX_FRAME       1536u
+#define J60_TX_LOG_SIZE     1024u   // transmitted frames kept for J60_TxFrame()
+
+#define J60_TCY_NS          96u     // instruction cycle at Fosc = 41.667 MHz
+#define J60_BYTE_NS         800u    // one byte on the 10 Mbit/s wire
+
+typedef struct
+{
+    uint64_t start;                 // ns, TXRTS was set
+    uint64_t time;                  // ns, end of the transmission
+    uint16_t length;                // without the FCS
+    uint8_t data[J60_MAX_FRAME];
+} j60Frame_t;
+
+typedef struct
+{
+    uint32_t rxFrames;              // written to the RX ring
+    uint32_t rxFiltered;            // rejected by ERXFCON
+    uint32_t rxDropped;             // RX disabled, ring full or EPKTCNT at 255
+    uint32_t txFrames;
+    uint32_t txAborted;             // see J60_AbortTx()
+    uint32_t dmaCopies;
+    uint32_t dmaChecksums;
+    uint32_t interrupts;
+    uint32_t edataReads;
+    uint32_t edataWrites;
+} j60Stats_t;
+
+typedef void (*j60TxHandler_t)(const j60Frame_t *frame);
+typedef void (*j60TimeHandler_t)(uint64_t now);
+
+/**
+ * Power on reset of the module and of the interrupt registers, the link is up
+ */
+void J60_Init(void);
+
+/**
+ * Let time pass: TMR1 counts, transmissions end and pending interrupts run
+ * Every register access of the firmware also costs one instruction cycle, so
+ * the busy waits of the driver end.
+ * @param ns  nanoseconds
+ */
+void J60_Advance(uint32_t ns);
+
+/**
+ * @return model time in ns since J60_Init()
+ */
+uint64_t J60_Now(void);
+
+/**
+ * A frame arrives from the wire, the FCS is added by the model
+ * @param frame   destination MAC first
+ * @param length  without the FCS, 14 to J60_MAX_FRAME
+ * @return true if the frame was written to the RX ring
+ */
+bool J60_Receive(const uint8_t *frame, uint16_t length);
+
+/**
+ * Change the link state and raise the PHY link interrupt
+ * @param up
+ */
+void J60_SetLink(bool up);
+
+/**
+ * Transmission time, true by default: a frame occupies the wire for its
+ * preamble, FCS and inter-frame gap at 10 Mbit/s. Without it frames are sent
+ * as soon as TXRTS is set.
+ * @param enabled
+ */
+void J60_SetWireTime(bool enabled);
+
+/**
+ * Abort the next transmissions with TXERIF and ESTAT.TXABRT, as after a late
+ * collision, the frames are not logged
+ * @param count  transmissions to abort
+ */
+void J60_AbortTx(uint8_t count);
+
+/**
+ * Call handler for every transmitted frame, NULL to stop
+ * @param handler
+ */
+void J60_SetTxHandler(j60TxHandler_t handler);
+
+/**
+ * Call handler whenever model time advances, the link partner delivers its
+ * frames and runs its timers from there. The handler is not called again
+ * while it runs.
+ * @param handler
+ */
+void J60_SetTimeHandler(j60TimeHandler_t handler);
+
+/**
+ * @return number of frames transmitted since J60_Init()
+ */
+uint32_t J60_TxCount(void);
+
+/**
+ * @param index  0 to J60_TxCount() - 1, the last J60_TX_LOG_SIZE are kept
+ * @return the frame or NULL if it is not kept
+ */
+const j60Frame_t *J60_TxFrame(uint32_t index);
+
+/**
+ * @return counters of the model
+ */
+const j60Stats_t *J60_GetStats(void);
+
+#endif // J60_MODEL_H
@@ -0,0 +1,1174 @@
+/**
+  Link partner of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    peer.c
+
+  Summary:
+    The other end of the cable: a PC with ARP, a DHCP server, ICMP and UDP
+    helpers and TCP connections, over a 10 Mbit/s link with a latency.
+
+  Description:
+    The TCP connections are a small Reno sender with NewReno partial ACKs and
+    SACK based retransmission, and a receiver that keeps out of order data
+    and sends SACK blocks, enough to drive the device from both sides.
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "peer.h"
+
+#define QUEUE_SIZE          1024
+#define WIRE_OVERHEAD       24u             // preamble, FCS and inter-frame gap
+#define MIN_FRAME           60u
+#define ETH_HEADER          14u
+#define IP_HEADER           20u
+#define TCP_HEADER          20u
+#define LEASE_TIME          3600u           // s
+#define RTO_INITIAL         (200 * PEER_MS)
+#define RTO_MAX             (4000 * PEER_MS)
+#define SYN_RETRY           (1000 * PEER_MS)
+#define PERSIST_TIME        (200 * PEER_MS)
+#define DELAYED_ACK         (40 * PEER_MS)
+
+typedef struct
+{
+    uint64_t due;
+    bool toDevice;
+    uint16_t length;
+    uint8_t data[J60_MAX_FRAME];
+} peerEvent_t;
+
+static peerEvent_t queue[QUEUE_SIZE];
+static uint16_t queueLength;
+static uint64_t nextDue;
+static uint64_t linkFree;
+static uint64_t latency;
+static uint64_t lastTick;
+
+static const uint8_t peerMac[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+static const uint8_t broadcastMac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+static uint8_t deviceMac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+static bool leased;
+
+static peerRxHandler_t rxHandler;
+static peerTickHandler_t tickHandler;
+static bool trace;
+static peerTcp_t *connections[PEER_TCP_MAX];
+static uint32_t issNext = 0x10000;
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, (uint16_t)(v >> 16));
+    put16(p + 2, (uint16_t)v);
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return ((uint32_t)get16(p) << 16) | get16(p + 2);
+}
+
+static uint32_t peerSum(const uint8_t *data, uint16_t length, uint32_t sum)
+{
+    uint16_t index;
+
+    for(index = 0; index < length; index++)
+    {
+        sum += (index & 1) ? data[index] : ((uint32_t)data[index] << 8);
+    }
+    return sum;
+}
+
+static uint16_t peerFold(uint32_t sum)
+{
+    while(sum >> 16)
+    {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return (uint16_t)sum;
+}
+
+static bool seqAfter(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) > 0;
+}
+
+static void peerQueue(const uint8_t *frame, uint16_t length, uint64_t due, bool toDevice)
+{
+    peerEvent_t *event;
+
+    if(queueLength == QUEUE_SIZE)
+    {
+        fprintf(stderr, "peer: queue full, frame lost\n");
+        return;
+    }
+    event = &queue[queueLength++];
+    event->due = due;
+    event->toDevice = toDevice;
+    event->length = length;
+    memcpy(event->data, frame, length);
+    if(due < nextDue)
+    {
+        nextDue = due;
+    }
+}
+
+void PEER_Send(const uint8_t *frame, uint16_t length, uint64_t delay)
+{
+    uint64_t start = J60_Now();
+    uint16_t wire = (length < MIN_FRAME ? MIN_FRAME : length) + WIRE_OVERHEAD;
+
+    if(start < linkFree)
+    {
+        start = linkFree;
+    }
+    linkFree = start + (uint64_t)wire * J60_BYTE_NS;
+    peerQueue(frame, length, linkFree + latency + delay, true);
+}
+
+static uint16_t peerEthHeader(uint8_t *frame, const uint8_t *destination, uint16_t type)
+{
+    memcpy(frame, destination, 6);
+    memcpy(frame + 6, peerMac, 6);
+    put16(frame + 12, type);
+    return ETH_HEADER;
+}
+
+static uint16_t peerIpv4(uint8_t *frame, const uint8_t *mac, uint8_t protocol, uint32_t source, uint32_t destination,
+                         const uint8_t *payload, uint16_t length)
+{
+    uint8_t *ip = frame + peerEthHeader(frame, mac, 0x0800);
+    uint8_t *l4 = ip + IP_HEADER;
+    static uint16_t id;
+    uint16_t field = (protocol == 6) ? 16 : (protocol == 17) ? 6 : 2;
+    uint32_t sum = 0;
+    uint16_t checksum;
+
+    ip[0] = 0x45;
+    ip[1] = 0;
+    put16(ip + 2, IP_HEADER + length);
+    put16(ip + 4, id++);
+    put16(ip + 6, 0x4000);
+    ip[8] = 64;
+    ip[9] = protocol;
+    put16(ip + 10, 0);
+    put32(ip + 12, source);
+    put32(ip + 16, destination);
+    put16(ip + 10, (uint16_t)~peerFold(peerSum(ip, IP_HEADER, 0)));
+
+    memcpy(l4, payload, length);
+    put16(l4 + field, 0);
+    if(protocol != 1)
+    {
+        sum = peerSum(ip + 12, 8, 0) + protocol + length;
+    }
+    checksum = (uint16_t)~peerFold(peerSum(l4, length, sum));
+    if((protocol == 17) && (checksum == 0))
+    {
+        checksum = 0xFFFF;
+    }
+    put16(l4 + field, checksum);
+    return ETH_HEADER + IP_HEADER + length;
+}
+
+uint16_t PEER_Ipv4Frame(uint8_t *frame, uint8_t protocol, uint32_t source, const uint8_t *payload, uint16_t length)
+{
+    return peerIpv4(frame, deviceMac, protocol, source, PEER_DEVICE_ADDRESS, payload, length);
+}
+
+bool PEER_Verify(const uint8_t *frame, uint16_t length)
+{
+    const uint8_t *ip = frame + ETH_HEADER;
+    uint16_t headerLength, total;
+    uint32_t sum = 0;
+
+    if(get16(frame + 12) != 0x0800)
+    {
+        return true;
+    }
+    headerLength = (ip[0] & 0x0F) * 4;
+    total = get16(ip + 2);
+    if((total + ETH_HEADER > length) || (peerFold(peerSum(ip, headerLength, 0)) != 0xFFFF))
+    {
+        return false;
+    }
+    if(ip[9] != 1)
+    {
+        sum = peerSum(ip + 12, 8, 0) + ip[9] + (total - headerLength);
+    }
+    return peerFold(peerSum(ip + headerLength, total - headerLength, sum)) == 0xFFFF;
+}
+
+const uint8_t *PEER_Mac(void)
+{
+    return peerMac;
+}
+
+const uint8_t *PEER_DeviceMac(void)
+{
+    return deviceMac;
+}
+
+bool PEER_Leased(void)
+{
+    return leased;
+}
+
+static void peerArp(uint16_t operation, const uint8_t *mac, uint32_t sender, uint32_t target)
+{
+    uint8_t frame[MIN_FRAME] = {0};
+    uint8_t *arp = frame + peerEthHeader(frame, (operation == 1) ? broadcastMac : mac, 0x0806);
+
+    put16(arp, 1);
+    put16(arp + 2, 0x0800);
+    arp[4] = 6;
+    arp[5] = 4;
+    put16(arp + 6, operation);
+    memcpy(arp + 8, peerMac, 6);
+    put32(arp + 14, sender);
+    memcpy(arp + 18, (operation == 1) ? (const uint8_t *)"\0\0\0\0\0\0" : mac, 6);
+    put32(arp + 24, target);
+    PEER_Send(frame, sizeof(frame), 0);
+}
+
+void PEER_ArpRequest(void)
+{
+    peerArp(1, broadcastMac, PEER_ADDRESS, PEER_DEVICE_ADDRESS);
+}
+
+void PEER_Ping(uint16_t id, uint16_t sequence, uint16_t length)
+{
+    uint8_t icmp[J60_MAX_FRAME];
+    uint8_t frame[J60_MAX_FRAME];
+    uint16_t index;
+
+    icmp[0] = 8;
+    icmp[1] = 0;
+    put16(icmp + 4, id);
+    put16(icmp + 6, sequence);
+    for(index = 0; index < length; index++)
+    {
+        icmp[8 + index] = (uint8_t)(index + sequence);
+    }
+    PEER_Send(frame, PEER_Ipv4Frame(frame, 1, PEER_ADDRESS, icmp, 8 + length), 0);
+}
+
+void PEER_UdpSend(uint16_t sourcePort, uint16_t port, const uint8_t *data, uint16_t length)
+{
+    uint8_t udp[J60_MAX_FRAME];
+    uint8_t frame[J60_MAX_FRAME];
+
+    put16(udp, sourcePort);
+    put16(udp + 2, port);
+    put16(udp + 4, 8 + length);
+    memcpy(udp + 8, data, length);
+    PEER_Send(frame, PEER_Ipv4Frame(frame, 17, PEER_ADDRESS, udp, 8 + length), 0);
+}
+
+static void peerDhcp(const uint8_t *udp, uint16_t length)
+{
+    const uint8_t *bootp = udp + 8;
+    const uint8_t *option = bootp + 240;
+    const uint8_t *end = udp + length;
+    uint8_t reply[300] = {0};
+    uint8_t frame[J60_MAX_FRAME];
+    uint8_t *o;
+    uint8_t type = 0;
+
+    if((length < 8 + 240) || (bootp[0] != 1) || (get32(bootp + 236) != 0x63825363))
+    {
+        return;
+    }
+    while((option < end) && (*option != 255))
+    {
+        if(*option == 0)
+        {
+            option++;
+            continue;
+        }
+        if(option[0] == 53)
+        {
+            type = option[2];
+        }
+        option += 2 + option[1];
+    }
+    if((type != 1) && (type != 3))
+    {
+        return;             // only DISCOVER and REQUEST are answered
+    }
+
+    put16(reply, 67);
+    put16(reply + 2, 68);
+    put16(reply + 4, sizeof(reply));
+    o = reply + 8;
+    o[0] = 2;
+    o[1] = 1;
+    o[2] = 6;
+    memcpy(o + 4, bootp + 4, 4);                // xid
+    put32(o + 16, PEER_DEVICE_ADDRESS);         // yiaddr
+    put32(o + 20, PEER_ADDRESS);                // siaddr
+    memcpy(o + 28, bootp + 28, 16);             // chaddr
+    put32(o + 236, 0x63825363);
+    o += 240;
+    *o++ = 53; *o++ = 1; *o++ = (type == 1) ? 2 : 5;   // OFFER or ACK
+    *o++ = 54; *o++ = 4; put32(o, PEER_ADDRESS); o += 4;
+    *o++ = 51; *o++ = 4; put32(o, LEASE_TIME); o += 4;
+    *o++ = 1; *o++ = 4; put32(o, PEER_SUBNET_MASK); o += 4;
+    *o++ = 3; *o++ = 4; put32(o, PEER_ROUTER_ADDRESS); o += 4;
+    *o++ = 6; *o++ = 4; put32(o, PEER_ADDRESS); o += 4;
+    *o = 255;
+    PEER_Send(frame, peerIpv4(frame, broadcastMac, 17, PEER_ADDRESS, 0xFFFFFFFF, reply, sizeof(reply)), 0);
+    if(type == 3)
+    {
+        leased = true;
+    }
+}
+
+uint8_t PEER_Payload(uint32_t offset)
+{
+    return (uint8_t)(offset * 7 + 3);
+}
+
+static uint16_t peerTcpSendMss(const peerTcp_t *tcp)
+{
+    uint16_t mss = tcp->deviceMss ? tcp->deviceMss : 536;
+
+    return tcp->timestampsOk ? mss - 12 : mss;
+}
+
+static uint8_t peerTcpOptions(peerTcp_t *tcp, uint8_t *o, uint8_t flags)
+{
+    uint8_t length = 0;
+    uint32_t start[8], end[8], base, offset;
+    uint8_t blocks = 0, first = 0, sent, index, max;
+
+    if(flags & TCP_FLAG_SYN)
+    {
+        if(tcp->mss)
+        {
+            o[length++] = 2; o[length++] = 4;
+            put16(o + length, tcp->mss);
+            length += 2;
+        }
+        if(tcp->windowScale >= 0)
+        {
+            o[length++] = 1; o[length++] = 3; o[length++] = 3;
+            o[length++] = (uint8_t)tcp->windowScale;
+        }
+        if(tcp->sackPermitted)
+        {
+            o[length++] = 1; o[length++] = 1; o[length++] = 4; o[length++] = 2;
+        }
+    }
+    if(((flags & TCP_FLAG_SYN) && tcp->timestamps) || (!(flags & TCP_FLAG_SYN) && tcp->timestampsOk))
+    {
+        o[length++] = 1; o[length++] = 1; o[length++] = 8; o[length++] = 10;
+        put32(o + length, (uint32_t)(J60_Now() / PEER_MS) + 7);
+        put32(o + length + 4, tcp->tsRecent);
+        length += 8;
+    }
+    if((flags == TCP_FLAG_ACK) && tcp->sackOk)
+    {
+        // SACK blocks from the received map, the block of the last segment first
+        base = tcp->rcvNxt - tcp->irs - 1;
+        for(offset = base; (offset < tcp->rcvMax) && (offset < PEER_TCP_BUFFER) && (blocks < 8);)
+        {
+            if(!tcp->rxMap[offset])
+            {
+                offset++;
+                continue;
+            }
+            start[blocks] = offset;
+            while((offset < tcp->rcvMax) && (offset < PEER_TCP_BUFFER) && tcp->rxMap[offset])
+            {
+                offset++;
+            }
+            end[blocks] = offset;
+            if((tcp->lastOffset >= start[blocks]) && (tcp->lastOffset < end[blocks]))
+            {
+                first = blocks;
+            }
+            blocks++;
+        }
+        if(blocks)
+        {
+            max = tcp->timestampsOk ? 3 : 4;
+            o[length++] = 1; o[length++] = 1; o[length++] = 5;
+            o[length++] = 2;
+            sent = 0;
+            for(index = 0; (index <= blocks) && (sent < max); index++)
+            {
+                // index 0 is the first block, then the others in order
+                uint8_t block = (index == 0) ? first : index - 1;
+
+                if((index > 0) && (block == first))
+                {
+                    continue;
+                }
+                put32(o + length, tcp->irs + 1 + start[block]);
+                put32(o + length + 4, tcp->irs + 1 + end[block]);
+                length += 8;
+                sent++;
+            }
+            o[length - 8 * sent - 1] = (uint8_t)(2 + 8 * sent);
+            tcp->sackBlocks++;
+        }
+    }
+    return length;
+}
+
+static void peerTcpOutput(peerTcp_t *tcp, uint8_t flags, uint32_t seq, const uint8_t *data, uint16_t length, uint64_t delay)
+{
+    uint8_t segment[J60_MAX_FRAME];
+    uint8_t frame[J60_MAX_FRAME];
+    uint8_t optionLength;
+
+    memset(segment, 0, TCP_HEADER);
+    optionLength = peerTcpOptions(tcp, segment + TCP_HEADER, flags);
+    put16(segment, tcp->port);
+    put16(segment + 2, tcp->devicePort);
+    put32(segment + 4, seq);
+    put32(segment + 8, (flags & TCP_FLAG_ACK) ? tcp->rcvNxt : 0);
+    segment[12] = (uint8_t)(((TCP_HEADER + optionLength) / 4) << 4);
+    segment[13] = flags;
+    put16(segment + 14, tcp->window);
+    if(length)
+    {
+        memcpy(segment + TCP_HEADER + optionLength, data, length);
+    }
+    PEER_Send(frame, PEER_Ipv4Frame(frame, 6, PEER_ADDRESS, segment, TCP_HEADER + optionLength + length), delay);
+}
+
+static void peerTcpAck(peerTcp_t *tcp)
+{
+    peerTcpOutput(tcp, TCP_FLAG_ACK, tcp->sndMax, NULL, 0, 0);
+    tcp->acksSent++;
+    tcp->pendingAcks = 0;
+}
+
+static void peerTcpSegment(peerTcp_t *tcp, uint32_t seq, uint16_t maxLength)
+{
+    uint8_t data[J60_MAX_FRAME];
+    uint32_t offset = seq - tcp->txBase;
+    uint32_t length = tcp->txTotal - offset;
+    int64_t delay = 0;
+    uint16_t index;
+
+    if((offset >= tcp->txTotal) || (length == 0))
+    {
+        return;
+    }
+    if(length > maxLength)
+    {
+        length = maxLength;
+    }
+    for(index = 0; index < length; index++)
+    {
+        data[index] = PEER_Payload(offset + index);
+    }
+    if(seqAfter(seq + length, tcp->sndMax))
+    {
+        tcp->sndMax = seq + length;
+    }
+    tcp->txSegments++;
+    if(tcp->txHook)
+    {
+        delay = tcp->txHook(tcp, offset, (uint16_t)length);
+        if(delay < 0)
+        {
+            return;
+        }
+    }
+    peerTcpOutput(tcp, TCP_FLAG_ACK | TCP_FLAG_PSH, seq, data, (uint16_t)length, (uint64_t)delay);
+}
+
+static void peerTcpRetransmit(peerTcp_t *tcp, uint32_t seq)
+{
+    peerTcpSegment(tcp, seq, peerTcpSendMss(tcp));
+    tcp->rexmitNext = seq + peerTcpSendMss(tcp);
+    tcp->retransmits++;
+}
+
+// SACK sender: retransmit the next hole below the highest SACKed byte
+static bool peerTcpSackHole(peerTcp_t *tcp)
+{
+    uint32_t high = 0, hole, offset;
+
+    for(offset = tcp->sndUna - tcp->txBase; offset < tcp->sndMax - tcp->txBase && offset < PEER_TCP_BUFFER; offset++)
+    {
+        if(tcp->sacked[offset])
+        {
+            high = offset + 1;
+        }
+    }
+    hole = seqAfter(tcp->rexmitNext, tcp->sndUna) ? tcp->rexmitNext - tcp->txBase : tcp->sndUna - tcp->txBase;
+    while((hole < high) && tcp->sacked[hole])
+    {
+        hole++;
+    }
+    if(hole >= high)
+    {
+        return false;
+    }
+    peerTcpRetransmit(tcp, tcp->txBase + hole);
+    tcp->sackRetransmits++;
+    return true;
+}
+
+static void peerTcpSender(peerTcp_t *tcp, uint64_t elapsed)
+{
+    uint64_t now = J60_Now();
+    uint32_t end = tcp->txBase + tcp->txTotal;
+    uint32_t room, length;
+
+    if((tcp->state != PEER_TCP_ESTABLISHED) || (tcp->sndUna == end))
+    {
+        return;
+    }
+    if(tcp->rtoAt && (now >= tcp->rtoAt))
+    {
+        // go back to the first unacknowledged byte
+        tcp->timeouts++;
+        tcp->inRecovery = false;
+        tcp->dupAcks = 0;
+        tcp->sndMax = tcp->sndUna;
+        tcp->rto = (tcp->rto * 2 > RTO_MAX) ? RTO_MAX : tcp->rto * 2;
+        tcp->rtoAt = now + tcp->rto;
+        peerTcpRetransmit(tcp, tcp->sndUna);
+        return;
+    }
+    if(tcp->deviceWindow == 0)
+    {
+        tcp->zeroWindowNs += elapsed;
+        if(!tcp->persistAt)
+        {
+            tcp->persistAt = now + PERSIST_TIME;
+        }
+        if(now >= tcp->persistAt)
+        {
+            tcp->persistAt = 0;
+            peerTcpSegment(tcp, tcp->sndMax, 1);
+        }
+        return;
+    }
+    tcp->persistAt = 0;
+    while((tcp->sndMax != end) && ((uint32_t)(tcp->sndMax - tcp->sndUna) < tcp->deviceWindow))
+    {
+        room = tcp->deviceWindow - (tcp->sndMax - tcp->sndUna);
+        length = end - tcp->sndMax;
+        if(length > peerTcpSendMss(tcp))
+        {
+            length = peerTcpSendMss(tcp);
+        }
+        if(length > room)
+        {
+            // sender silly window avoidance: no small segments unless the
+            // window is half the largest one the device offered
+            if(room < tcp->deviceWindowMax / 2)
+            {
+                break;
+            }
+            length = room;
+        }
+        if(!tcp->rtoAt)
+        {
+            tcp->rtoAt = now + tcp->rto;
+        }
+        peerTcpSegment(tcp, tcp->sndMax, (uint16_t)length);
+    }
+}
+
+static void peerTcpTimers(peerTcp_t *tcp, uint64_t elapsed)
+{
+    uint64_t now = J60_Now();
+
+    if(((tcp->state == PEER_TCP_SYN_SENT) || (tcp->state == PEER_TCP_SYN_RECEIVED)) && (now >= tcp->rtoAt))
+    {
+        tcp->rtoAt = now + SYN_RETRY;
+        peerTcpOutput(tcp, (tcp->state == PEER_TCP_SYN_SENT) ? TCP_FLAG_SYN : TCP_FLAG_SYN | TCP_FLAG_ACK, tcp->iss, NULL, 0, 0);
+        return;
+    }
+    if(tcp->pendingAcks && (now >= tcp->ackAt))
+    {
+        peerTcpAck(tcp);
+    }
+    peerTcpSender(tcp, elapsed);
+}
+
+static void peerTcpSynOptions(peerTcp_t *tcp, const uint8_t *header, uint8_t headerLength)
+{
+    uint8_t index = TCP_HEADER, kind, length;
+    bool sackPermitted = false;
+
+    tcp->deviceMss = 536;
+    tcp->deviceWindowScale = -1;
+    tcp->synOptionLength = headerLength - TCP_HEADER;
+    tcp->timestampsOk = false;
+    while(index < headerLength)
+    {
+        kind = header[index];
+        if(kind == 0)
+        {
+            break;
+        }
+        if(kind == 1)
+        {
+            index++;
+            continue;
+        }
+        length = header[index + 1];
+        if(length < 2)
+        {
+            break;
+        }
+        if(kind == 2)
+        {
+            tcp->deviceMss = get16(header + index + 2);
+        }
+        if(kind == 3)
+        {
+            tcp->deviceWindowScale = (int8_t)header[index + 2];
+        }
+        if(kind == 4)
+        {
+            sackPermitted = true;
+        }
+        if(kind == 8)
+        {
+            tcp->timestampsOk = tcp->timestamps;
+            tcp->tsRecent = get32(header + index + 2);
+        }
+        index += length;
+    }
+    tcp->sackOk = tcp->sackPermitted && sackPermitted;
+    if(tcp->windowScale < 0)
+    {
+        tcp->deviceWindowScale = -1;
+    }
+}
+
+static void peerTcpReceive(peerTcp_t *tcp, const uint8_t *header, uint16_t dataLength)
+{
+    uint8_t headerLength = (header[12] >> 4) * 4;
+    uint8_t flags = header[13];
+    uint32_t seq = get32(header + 4);
+    uint32_t ack = get32(header + 8);
+    uint32_t window = get16(header + 14);
+    const uint8_t *data = header + headerLength;
+    uint32_t offset, index, before, a, z, block;
+    uint8_t option, length;
+    bool duplicate = true;
+
+    if(flags & TCP_FLAG_RST)
+    {
+        tcp->state = PEER_TCP_RESET;
+        return;
+    }
+    if(flags & TCP_FLAG_SYN)
+    {
+        if((tcp->state == PEER_TCP_LISTEN) && !(flags & TCP_FLAG_ACK))
+        {
+            tcp->devicePort = get16(header);
+            peerTcpSynOptions(tcp, header, headerLength);
+            tcp->irs = seq;
+            tcp->rcvNxt = seq + 1;
+            tcp->iss = issNext;
+            issNext += 0x10000;
+            tcp->sndUna = tcp->iss;
+            tcp->sndMax = tcp->iss + 1;
+            tcp->txBase = tcp->iss + 1;
+            tcp->state = PEER_TCP_SYN_RECEIVED;
+            tcp->rtoAt = J60_Now() + SYN_RETRY;
+            peerTcpOutput(tcp, TCP_FLAG_SYN | TCP_FLAG_ACK, tcp->iss, NULL, 0, 0);
+        }
+        else if((tcp->state == PEER_TCP_SYN_SENT) && (flags & TCP_FLAG_ACK) && (ack == tcp->iss + 1))
+        {
+            peerTcpSynOptions(tcp, header, headerLength);
+            tcp->irs = seq;
+            tcp->rcvNxt = seq + 1;
+            tcp->sndUna = ack;
+            tcp->state = PEER_TCP_ESTABLISHED;
+            tcp->deviceWindow = window;
+            tcp->deviceWindowMax = window;
+            tcp->rtoAt = 0;
+            peerTcpAck(tcp);
+        }
+        else if(tcp->state == PEER_TCP_ESTABLISHED)
+        {
+            peerTcpAck(tcp);    // our ACK of the SYN was lost
+        }
+        return;
+    }
+    if(tcp->state == PEER_TCP_SYN_RECEIVED)
+    {
+        if(!(flags & TCP_FLAG_ACK) || (ack != tcp->iss + 1))
+        {
+            return;
+        }
+        tcp->state = PEER_TCP_ESTABLISHED;
+        tcp->sndUna = ack;
+        tcp->rtoAt = 0;
+    }
+    if(tcp->state != PEER_TCP_ESTABLISHED)
+    {
+        return;
+    }
+
+    for(index = TCP_HEADER; index < headerLength;)
+    {
+        option = header[index];
+        if(option == 0)
+        {
+            break;
+        }
+        if(option == 1)
+        {
+            index++;
+            continue;
+        }
+        length = header[index + 1];
+        if(length < 2)
+        {
+            break;
+        }
+        if((option == 5) && tcp->txTotal)
+        {
+            for(block = 0; block < (uint32_t)(length - 2) / 8; block++)
+            {
+                a = get32(header + index + 2 + 8 * block) - tcp->txBase;
+                z = get32(header + index + 6 + 8 * block) - tcp->txBase;
+                for(offset = a; (offset < z) && (offset < PEER_TCP_BUFFER); offset++)
+                {
+                    tcp->sacked[offset] = 1;
+                }
+            }
+        }
+        if(option == 8)
+        {
+            tcp->tsRecent = get32(header + index + 2);
+        }
+        index += length;
+    }
+
+    if(tcp->deviceWindowScale >= 0)
+    {
+        window <<= tcp->deviceWindowScale;
+    }
+    if((flags & TCP_FLAG_ACK) && tcp->txTotal)
+    {
+        tcp->ackFrames++;
+        if(seqAfter(ack, tcp->sndUna) && !seqAfter(ack, tcp->sndMax))
+        {
+            tcp->sndUna = ack;
+            tcp->dupAcks = 0;
+            tcp->rto = RTO_INITIAL;
+            tcp->rtoAt = J60_Now() + tcp->rto;
+            if(tcp->inRecovery)
+            {
+                if(!seqAfter(tcp->recover, ack))
+                {
+                    tcp->inRecovery = false;
+                }
+                else if(!tcp->sackOk || (!peerTcpSackHole(tcp) && !seqAfter(tcp->rexmitNext, tcp->sndUna)))
+                {
+                    peerTcpRetransmit(tcp, tcp->sndUna);    // NewReno partial ACK
+                }
+            }
+        }
+        else if((ack == tcp->sndUna) && (dataLength == 0) && (window == tcp->deviceWindow) && (tcp->sndMax != tcp->sndUna))
+        {
+            if((++tcp->dupAcks == 3) && !tcp->inRecovery)
+            {
+                tcp->inRecovery = true;
+                tcp->recover = tcp->sndMax;
+                peerTcpRetransmit(tcp, tcp->sndUna);
+                tcp->fastRetransmits++;
+            }
+            else if(tcp->inRecovery && tcp->sackOk)
+            {
+                peerTcpSackHole(tcp);
+            }
+        }
+        tcp->deviceWindow = window;
+    }
+    else if(flags & TCP_FLAG_ACK)
+    {
+        tcp->deviceWindow = window;
+    }
+    if(tcp->deviceWindow > tcp->deviceWindowMax)
+    {
+        tcp->deviceWindowMax = tcp->deviceWindow;
+    }
+
+    if(dataLength)
+    {
+        offset = seq - tcp->irs - 1;
+        if(tcp->rxHook && tcp->rxHook(tcp, offset, dataLength))
+        {
+            return;
+        }
+        if(seq == tcp->rcvNxt - 1)
+        {
+            peerTcpAck(tcp);    // keep-alive probe with a garbage byte
+            return;
+        }
+        tcp->segments++;
+        tcp->lastOffset = offset;
+        if(offset + dataLength > tcp->rcvMax)
+        {
+            tcp->rcvMax = offset + dataLength;
+        }
+        for(index = 0; (index < dataLength) && (offset + index < PEER_TCP_BUFFER); index++)
+        {
+            if(!tcp->rxMap[offset + index])
+            {
+                duplicate = false;
+            }
+            tcp->rxMap[offset + index] = 1;
+            tcp->rxData[offset + index] = data[index];
+        }
+        if(duplicate)
+        {
+            tcp->duplicates++;
+        }
+        before = tcp->rcvNxt;
+        while((tcp->rcvNxt - tcp->irs - 1 < PEER_TCP_BUFFER) && tcp->rxMap[tcp->rcvNxt - tcp->irs - 1])
+        {
+            tcp->rcvNxt++;
+        }
+        tcp->received = tcp->rcvNxt - tcp->irs - 1;
+        if((tcp->rcvNxt == before) || (seq != before) || (++tcp->pendingAcks >= tcp->ackEvery))
+        {
+            peerTcpAck(tcp);
+        }
+        else
+        {
+            tcp->ackAt = J60_Now() + DELAYED_ACK;
+        }
+    }
+    else if((seq == tcp->rcvNxt - 1) && !(flags & TCP_FLAG_FIN))
+    {
+        peerTcpAck(tcp);        // keep-alive probe
+    }
+    if((flags & TCP_FLAG_FIN) && (seq + dataLength == tcp->rcvNxt))
+    {
+        tcp->rcvNxt++;
+        tcp->finReceived = true;
+        peerTcpAck(tcp);
+    }
+}
+
+static void peerTcpInput(const uint8_t *frame, uint16_t length)
+{
+    const uint8_t *ip = frame + ETH_HEADER;
+    uint8_t headerLength = (ip[0] & 0x0F) * 4;
+    const uint8_t *header = ip + headerLength;
+    uint16_t dataLength;
+    uint16_t sourcePort = get16(header);
+    uint16_t destinationPort = get16(header + 2);
+    peerTcp_t *tcp;
+    uint8_t index;
+
+    if(get32(ip + 16) != PEER_ADDRESS)
+    {
+        return;
+    }
+    dataLength = get16(ip + 2) - headerLength - (header[12] >> 4) * 4;
+    for(index = 0; index < PEER_TCP_MAX; index++)
+    {
+        tcp = connections[index];
+        if(tcp && (tcp->port == destinationPort) &&
+           ((tcp->devicePort == sourcePort) || (tcp->state == PEER_TCP_LISTEN)))
+        {
+            peerTcpReceive(tcp, header, dataLength);
+            return;
+        }
+    }
+}
+
+static void peerInput(const uint8_t *frame, uint16_t length)
+{
+    const uint8_t *arp = frame + ETH_HEADER;
+    const uint8_t *ip = frame + ETH_HEADER;
+    uint32_t target;
+
+    memcpy(deviceMac, frame + 6, 6);
+    if(rxHandler)
+    {
+        rxHandler(frame, length);
+    }
+    if(get16(frame + 12) == 0x0806)
+    {
+        target = get32(arp + 24);
+        if((get16(arp + 6) == 1) && ((target == PEER_ADDRESS) || (target == PEER_ROUTER_ADDRESS)))
+        {
+            peerArp(2, arp + 8, target, get32(arp + 14));
+        }
+        return;
+    }
+    if(get16(frame + 12) != 0x0800)
+    {
+        return;
+    }
+    if((ip[9] == 17) && (get16(ip + 20 + 2) == 67))
+    {
+        peerDhcp(ip + (ip[0] & 0x0F) * 4, get16(ip + 2) - (ip[0] & 0x0F) * 4);
+    }
+    else if(ip[9] == 6)
+    {
+        peerTcpInput(frame, length);
+    }
+}
+
+static void peerTrace(uint64_t now, const uint8_t *frame, uint16_t length, bool toDevice)
+{
+    const uint8_t *ip = frame + ETH_HEADER;
+    const uint8_t *l4 = ip + (ip[0] & 0x0F) * 4;
+    uint16_t type = get16(frame + 12);
+
+    printf("%10.3f ms %s %4u ", now / 1e6, toDevice ? "peer  >" : "device>", length);
+    if(type == 0x0806)
+    {
+        printf("arp %s\n", (get16(ip + 6) == 1) ? "request" : "reply");
+    }
+    else if(type != 0x0800)
+    {
+        printf("type %04x\n", type);
+    }
+    else if(ip[9] == 6)
+    {
+        printf("tcp %u>%u %c%c%c%c%c seq %u ack %u win %u len %u\n", get16(l4), get16(l4 + 2),
+               (l4[13] & TCP_FLAG_SYN) ? 'S' : '.', (l4[13] & TCP_FLAG_ACK) ? 'A' : '.',
+               (l4[13] & TCP_FLAG_PSH) ? 'P' : '.', (l4[13] & TCP_FLAG_FIN) ? 'F' : '.',
+               (l4[13] & TCP_FLAG_RST) ? 'R' : '.', get32(l4 + 4), get32(l4 + 8), get16(l4 + 14),
+               get16(ip + 2) - (ip[0] & 0x0F) * 4 - (l4[12] >> 4) * 4);
+    }
+    else if(ip[9] == 17)
+    {
+        printf("udp %u>%u len %u\n", get16(l4), get16(l4 + 2), get16(l4 + 4) - 8);
+    }
+    else
+    {
+        printf("ip protocol %u type %u\n", ip[9], l4[0]);
+    }
+}
+
+static void peerTxDone(const j60Frame_t *frame)
+{
+    peerQueue(frame->data, frame->length, frame->time + latency, false);
+}
+
+static void peerTime(uint64_t now)
+{
+    peerEvent_t event;
+    uint16_t index, first;
+    uint64_t elapsed = now - lastTick;
+
+    while(queueLength && (nextDue <= now))
+    {
+        first = 0;
+        for(index = 1; index < queueLength; index++)
+        {
+            if(queue[index].due < queue[first].due)
+            {
+                first = index;
+            }
+        }
+        event = queue[first];
+        memmove(&queue[first], &queue[first + 1], (queueLength - first - 1) * sizeof(peerEvent_t));
+        queueLength--;
+        nextDue = UINT64_MAX;
+        for(index = 0; index < queueLength; index++)
+        {
+            if(queue[index].due < nextDue)
+            {
+                nextDue = queue[index].due;
+            }
+        }
+        if(trace)
+        {
+            peerTrace(now, event.data, event.length, event.toDevice);
+        }
+        if(event.toDevice)
+        {
+            J60_Receive(event.data, event.length);
+        }
+        else
+        {
+            peerInput(event.data, event.length);
+        }
+    }
+    if(elapsed >= PEER_MS / 10)
+    {
+        // the peer runs its timers every 100 us
+        lastTick = now;
+        for(index = 0; index < PEER_TCP_MAX; index++)
+        {
+            if(connections[index])
+            {
+                peerTcpTimers(connections[index], elapsed);
+            }
+        }
+        if(tickHandler)
+        {
+            tickHandler(now);
+        }
+    }
+}
+
+void PEER_Init(uint64_t oneWay)
+{
+    queueLength = 0;
+    nextDue = UINT64_MAX;
+    linkFree = 0;
+    latency = oneWay;
+    lastTick = 0;
+    leased = false;
+    memset(deviceMac, 0xFF, sizeof(deviceMac));
+    memset(connections, 0, sizeof(connections));
+    rxHandler = NULL;
+    tickHandler = NULL;
+    J60_SetTxHandler(peerTxDone);
+    J60_SetTimeHandler(peerTime);
+}
+
+void PEER_SetLatency(uint64_t oneWay)
+{
+    latency = oneWay;
+}
+
+void PEER_SetRxHandler(peerRxHandler_t handler)
+{
+    rxHandler = handler;
+}
+
+void PEER_SetTrace(bool enabled)
+{
+    trace = enabled;
+}
+
+void PEER_SetTickHandler(peerTickHandler_t handler)
+{
+    tickHandler = handler;
+}
+
+void PEER_TcpInit(peerTcp_t *tcp, uint16_t port, uint16_t devicePort)
+{
+    memset(tcp, 0, sizeof(*tcp));
+    tcp->port = port;
+    tcp->devicePort = devicePort;
+    tcp->mss = 1460;
+    tcp->windowScale = -1;
+    tcp->window = 8192;
+    tcp->ackEvery = 1;
+    tcp->rto = RTO_INITIAL;
+    tcp->deviceWindowScale = -1;
+}
+
+static bool peerTcpAdd(peerTcp_t *tcp)
+{
+    uint8_t index;
+
+    for(index = 0; index < PEER_TCP_MAX; index++)
+    {
+        if((connections[index] == NULL) || (connections[index] == tcp))
+        {
+            connections[index] = tcp;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PEER_TcpConnect(peerTcp_t *tcp)
+{
+    if(!peerTcpAdd(tcp))
+    {
+        return false;
+    }
+    tcp->iss = issNext;
+    issNext += 0x10000;
+    tcp->sndUna = tcp->iss;
+    tcp->sndMax = tcp->iss + 1;
+    tcp->txBase = tcp->iss + 1;
+    tcp->state = PEER_TCP_SYN_SENT;
+    tcp->rtoAt = J60_Now() + SYN_RETRY;
+    peerTcpOutput(tcp, TCP_FLAG_SYN, tcp->iss, NULL, 0, 0);
+    return true;
+}
+
+bool PEER_TcpListen(peerTcp_t *tcp)
+{
+    if(!peerTcpAdd(tcp))
+    {
+        return false;
+    }
+    tcp->state = PEER_TCP_LISTEN;
+    return true;
+}
+
+void PEER_TcpSend(peerTcp_t *tcp, uint32_t length)
+{
+    if(tcp->txTotal + length > PEER_TCP_BUFFER)
+    {
+        length = PEER_TCP_BUFFER - tcp->txTotal;
+    }
+    tcp->txTotal += length;
+}
+
+void PEER_TcpClose(peerTcp_t *tcp)
+{
+    peerTcpOutput(tcp, TCP_FLAG_FIN | TCP_FLAG_ACK, tcp->sndMax, NULL, 0, 0);
+    PEER_TcpRemove(tcp);
+}
+
+void PEER_TcpRemove(peerTcp_t *tcp)
+{
+    uint8_t index;
+
+    for(index = 0; index < PEER_TCP_MAX; index++)
+    {
+        if(connections[index] == tcp)
+        {
+            connections[index] = NULL;
+        }
+    }
+    tcp->state = PEER_TCP_CLOSED;
+}
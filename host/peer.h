@@ -0,0 +1,298 @@
+/**
+  Link partner of the Linux host build
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    peer.h
+
+  Summary:
+    The other end of the cable: a PC with ARP, a DHCP server, ICMP and UDP
+    helpers and TCP connections, over a 10 Mbit/s link with a latency.
+
+  Description:
+    Frames for the device wait for the link and the latency before
+    J60_Receive() is called, frames of the device reach the peer after the
+    latency. The peer answers ARP requests for its addresses, leases
+    PEER_DEVICE_ADDRESS over DHCP and runs the TCP connections opened with
+    PEER_TcpConnect() or PEER_TcpListen(). All other frames go to the handler
+    given to PEER_SetRxHandler().
+
+ */
+
+/*
+
+©  [2015] Microchip Technology Inc. and its subsidiaries.  You may use this software
+and any derivatives exclusively with Microchip products.
+
+THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER EXPRESS,
+IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF
+NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE, OR ITS
+INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION WITH ANY OTHER PRODUCTS, OR USE
+IN ANY APPLICATION.
+
+IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL
+OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED
+TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY
+OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S
+TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+
+MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE TERMS.
+
+*/
+
+#ifndef PEER_H
+#define PEER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "j60_model.h"
+
+#define PEER_ADDRESS            0xC0A80026u     // 192.168.0.38, the PC of the demos
+#define PEER_ROUTER_ADDRESS     0xC0A80001u     // 192.168.0.1, answered by the peer as well
+#define PEER_DEVICE_ADDRESS     0xC0A8005Bu     // 192.168.0.91, leased to the device
+#define PEER_SUBNET_MASK        0xFFFFFF00u
+
+#define PEER_MS                 1000000ull      // ns
+#ifndef PEER_TCP_MAX
+#define PEER_TCP_MAX            16              // connections, up to 255
+#endif
+#define PEER_TCP_BUFFER         65536u          // bytes each way, per connection
+
+#define TCP_FLAG_FIN            0x01
+#define TCP_FLAG_SYN            0x02
+#define TCP_FLAG_RST            0x04
+#define TCP_FLAG_PSH            0x08
+#define TCP_FLAG_ACK            0x10
+
+typedef enum
+{
+    PEER_TCP_CLOSED = 0,
+    PEER_TCP_LISTEN,
+    PEER_TCP_SYN_SENT,
+    PEER_TCP_SYN_RECEIVED,
+    PEER_TCP_ESTABLISHED,
+    PEER_TCP_RESET
+} peerTcpState_t;
+
+typedef struct peerTcp peerTcp_t;
+
+struct peerTcp
+{
+    peerTcpState_t state;
+    uint16_t port;                  // of the peer
+    uint16_t devicePort;
+
+    // offered in the SYN or SYN+ACK of the peer, set before connecting
+    uint16_t mss;                   // 0 for no MSS option
+    int8_t windowScale;             // -1 for no window scale option
+    bool sackPermitted;
+    bool timestamps;
+    uint16_t window;                // advertised by the peer, unscaled
+    uint8_t ackEvery;               // in order segments per ACK, 1 by default
+
+    // options of the device
+    uint16_t deviceMss;
+    int8_t deviceWindowScale;       // -1 if not offered
+    bool sackOk;                    // both sides sent SACK permitted
+    bool timestampsOk;
+    uint8_t synOptionLength;        // TCP option bytes of the device SYN or SYN+ACK
+    uint32_t tsRecent;
+
+    // receiver, data of the device
+    uint32_t irs;                   // initial sequence number of the device
+    uint32_t rcvNxt;
+    uint32_t received;              // in order bytes, kept in rxData
+    uint32_t rcvMax;                // highest offset received + 1
+    uint32_t lastOffset;            // of the last data segment, first SACK block
+    uint8_t pendingAcks;
+    uint64_t ackAt;                 // delayed ACK
+    bool finReceived;
+    uint8_t rxMap[PEER_TCP_BUFFER];
+    uint8_t rxData[PEER_TCP_BUFFER];
+
+    // sender, data of the peer, see PEER_Payload()
+    uint32_t iss;
+    uint32_t txBase;                // sequence number of the first data byte
+    uint32_t txTotal;               // bytes queued by PEER_TcpSend()
+    uint32_t sndUna;
+    uint32_t sndMax;                // highest sequence number sent + 1
+    uint32_t deviceWindow;          // scaled
+    uint32_t deviceWindowMax;       // largest deviceWindow so far
+    uint32_t rexmitNext;
+    uint32_t recover;
+    uint8_t dupAcks;
+    bool inRecovery;
+    uint64_t rtoAt;
+    uint64_t persistAt;
+    uint32_t rto;                   // ns
+    uint8_t sacked[PEER_TCP_BUFFER];
+
+    // counters
+    uint32_t segments;              // data segments of the device
+    uint32_t duplicates;            // data segments of the device received before
+    uint32_t acksSent;
+    uint32_t ackFrames;             // ACKs of the device while the peer sends
+    uint32_t txSegments;
+    uint32_t retransmits;
+    uint32_t fastRetransmits;
+    uint32_t sackRetransmits;
+    uint32_t timeouts;
+    uint32_t sackBlocks;            // SACK options sent
+    uint64_t zeroWindowNs;          // time the peer had data and a zero window
+
+    // test hooks
+    // a data segment of the peer, return -1 to drop it or the extra delay in ns
+    int64_t (*txHook)(peerTcp_t *tcp, uint32_t offset, uint16_t length);
+    // a data segment of the device, return true to drop it
+    bool (*rxHook)(peerTcp_t *tcp, uint32_t offset, uint16_t length);
+};
+
+typedef void (*peerRxHandler_t)(const uint8_t *frame, uint16_t length);
+typedef void (*peerTickHandler_t)(uint64_t now);
+
+/**
+ * Connect the peer to the model, after J60_Init()
+ * @param latency  one way, ns
+ */
+void PEER_Init(uint64_t latency);
+
+/**
+ * Change the latency, for the frames queued from now on
+ * @param latency  one way, ns
+ */
+void PEER_SetLatency(uint64_t latency);
+
+/**
+ * @param handler  called with every frame of the device
+ */
+void PEER_SetRxHandler(peerRxHandler_t handler);
+
+/**
+ * @param handler  called whenever time advances, after the peer timers
+ */
+void PEER_SetTickHandler(peerTickHandler_t handler);
+
+/**
+ * Print a line for every frame as it reaches the other side
+ * @param enabled
+ */
+void PEER_SetTrace(bool enabled);
+
+/**
+ * Queue a frame for the device
+ * @param frame
+ * @param length  without the FCS
+ * @param delay   extra ns on top of the link, to reorder frames
+ */
+void PEER_Send(const uint8_t *frame, uint16_t length, uint64_t delay);
+
+/**
+ * @return MAC address of the peer
+ */
+const uint8_t *PEER_Mac(void);
+
+/**
+ * @return MAC address of the device, learnt from its frames
+ */
+const uint8_t *PEER_DeviceMac(void);
+
+/**
+ * @return true once the DHCP server acknowledged the lease of the device
+ */
+bool PEER_Leased(void);
+
+/**
+ * Build an IPv4 frame to the device with the header and L4 checksums
+ * @param frame     J60_MAX_FRAME bytes
+ * @param protocol  1, 6 or 17
+ * @param source    IPv4 address of the sender
+ * @param payload   L4 header and data, the checksum field is filled in
+ * @param length    of the payload
+ * @return frame length
+ */
+uint16_t PEER_Ipv4Frame(uint8_t *frame, uint8_t protocol, uint32_t source, const uint8_t *payload, uint16_t length);
+
+/**
+ * Check the IPv4 header and L4 checksums of a frame of the device
+ * @param frame
+ * @param length
+ * @return true if they are right or the frame is not IPv4
+ */
+bool PEER_Verify(const uint8_t *frame, uint16_t length);
+
+/**
+ * Broadcast an ARP request for PEER_DEVICE_ADDRESS
+ */
+void PEER_ArpRequest(void);
+
+/**
+ * Send an ICMP echo request to the device
+ * @param id
+ * @param sequence
+ * @param length  of the data
+ */
+void PEER_Ping(uint16_t id, uint16_t sequence, uint16_t length);
+
+/**
+ * Send a UDP datagram to the device
+ * @param sourcePort
+ * @param port
+ * @param data
+ * @param length
+ */
+void PEER_UdpSend(uint16_t sourcePort, uint16_t port, const uint8_t *data, uint16_t length);
+
+/**
+ * Data byte sent by the peer at a stream offset
+ * @param offset
+ * @return
+ */
+uint8_t PEER_Payload(uint32_t offset);
+
+/**
+ * Set up a connection with the defaults: MSS 1460, no other option, window
+ * 8192, an ACK for every segment
+ * @param tcp
+ * @param port        of the peer
+ * @param devicePort
+ */
+void PEER_TcpInit(peerTcp_t *tcp, uint16_t port, uint16_t devicePort);
+
+/**
+ * Send the SYN to the device
+ * @param tcp
+ * @return false if PEER_TCP_MAX connections are open
+ */
+bool PEER_TcpConnect(peerTcp_t *tcp);
+
+/**
+ * Wait for a SYN of the device to tcp->port
+ * @param tcp
+ * @return false if PEER_TCP_MAX connections are open
+ */
+bool PEER_TcpListen(peerTcp_t *tcp);
+
+/**
+ * Send length more bytes of PEER_Payload() to the device
+ * @param tcp
+ * @param length  up to PEER_TCP_BUFFER in total
+ */
+void PEER_TcpSend(peerTcp_t *tcp, uint32_t length);
+
+/**
+ * Send a FIN after the data sent so far and forget the connection, the FIN
+ * is not retransmitted
+ * @param tcp
+ */
+void PEER_TcpClose(peerTcp_t *tcp);
+
+/**
+ * Forget the connection without telling the device
+ * @param tcp
+ */
+void PEER_TcpRemove(peerTcp_t *tcp);
+
+#endif // PEER_H